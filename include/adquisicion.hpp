@@ -0,0 +1,80 @@
+/**
+ @file adquisicion.hpp
+ @brief Entrega de la posición de la línea al control, con o sin tarea de adquisición en el núcleo 0.
+ @details Con `-D DOBLE_NUCLEO` una tarea fijada al núcleo 0 lee la barra QTR sin pausa y publica cada
+ posición, con su marca de tiempo, en un `BuzonUltimo` que conserva solo la más reciente. El control
+ (loop() en el núcleo 1) la toma sin esperar al ADC, con a lo sumo un cuadro de antigüedad. Sin la bandera, `lineaActual()` llama a `leerLinea()`.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+#include "muestreo.hpp"
+
+/**
+ @struct MuestraLinea
+ @brief Posición de la línea publicada por la tarea de adquisición.
+ */
+struct MuestraLinea {
+    uint16_t posicion;      ///< Resultado de `leerLinea()` (0 a 7000).
+    uint32_t instante_us;   ///< Marca de tiempo del cuadro de sensores (ver `ultimoCuadro()`).
+    uint16_t crudo[CANT_SENSORES];  ///< Lecturas crudas del cuadro (para la caja negra).
+    bool enLinea;           ///< `lineaDetectada()` del cuadro: false si la barra quedó fuera de la línea.
+};
+
+/**
+ @brief Lanza la tarea de adquisición en el núcleo 0. Llamar después de calibrar los sensores.
+ @details Sin `DOBLE_NUCLEO` no hace nada.
+ @return void
+ */
+void iniciarAdquisicion();
+
+/**
+ @brief Posición de la línea para el tick de control.
+ @details Con `DOBLE_NUCLEO` devuelve la muestra más reciente del buzón (o la última tomada si no
+ llegó ninguna nueva); sin la bandera lee los sensores en el momento.
+ @return uint16_t Posición de la línea (0 a 7000).
+ */
+uint16_t lineaActual();
+
+/**
+ @brief Lecturas crudas del cuadro del que salió la última `lineaActual()` (índice 0 = S8).
+ @details Con `DOBLE_NUCLEO` viajan en la muestra del buzón, así que corresponden siempre a la posición entregada.
+ @return const uint16_t* `CANT_SENSORES` lecturas.
+ */
+const uint16_t* crudoLinea();
+
+/**
+ @brief Marca de tiempo del cuadro del que salió la última `lineaActual()`.
+ @details Con `DOBLE_NUCLEO` viaja en la muestra del buzón: se repite si no llegó una muestra nueva.
+ @return uint32_t `halMicros()` al comenzar la adquisición del cuadro.
+ */
+uint32_t instanteLinea();
+
+/**
+ @brief Indica si el cuadro de la última `lineaActual()` vio la línea.
+ @details Con `DOBLE_NUCLEO` viaja en la muestra del buzón, igual que las lecturas crudas.
+ @return bool false si la posición entregada es el extremo de una línea perdida.
+ */
+bool lineaVisible();
+
+/**
+ @brief Descarta las muestras pendientes para que la próxima `lineaActual()` no use datos viejos.
+ @details Se llama mientras el robot está detenido. Sin `DOBLE_NUCLEO` reinicia la cadena de filtros (ver
+ filtros.hpp), si hay alguna etapa habilitada; con la bandera la tarea de adquisición la mantiene al día.
+ @return void
+ */
+void descartarMuestras();
+
+/**
+ @brief Antigüedad de la última muestra entregada por `lineaActual()` al momento de entregarla.
+ @return uint32_t Microsegundos entre el comienzo de la lectura y su consumo.
+ */
+uint32_t edadLinea();
+
+/**
+ @brief Muestras que el control no llegó a tomar porque la tarea de adquisición publicó una más nueva.
+ @details Con el productor sin pausa son casi todas: es la cantidad de cuadros leídos de más, no una pérdida.
+ @return uint32_t Cantidad acumulada desde `iniciarAdquisicion()`.
+ */
+uint32_t muestrasDescartadas();
@@ -0,0 +1,79 @@
+/**
+ @file anillo_spsc.hpp
+ @brief Anillo sin bloqueos de un productor y un consumidor (SPSC) para pasar datos entre núcleos.
+ @details El productor solo escribe `_cabeza` y el consumidor solo escribe `_cola`. Los contadores
+ corren libres (se enmascaran al indexar), así el anillo usa sus N posiciones. El orden
+ release/acquire garantiza que el consumidor ve el dato completo antes que el índice que lo publica.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include <atomic>
+#include "hal.hpp"
+
+/**
+ @class AnilloSPSC
+ @brief Cola circular de capacidad fija @p N (potencia de 2) sin mutex ni secciones críticas.
+ @tparam T Tipo de dato copiado en cada posición.
+ @tparam N Capacidad del anillo.
+ */
+template <typename T, uint32_t N>
+class AnilloSPSC {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "La capacidad del anillo debe ser potencia de 2");
+
+public:
+    /**
+     @brief Agrega un dato (solo el productor).
+     @return bool false si el anillo está lleno y el dato se descartó.
+     */
+    bool publicar(const T& dato) {
+        uint32_t cabeza = _cabeza.load(std::memory_order_relaxed);
+        if (cabeza - _cola.load(std::memory_order_acquire) == N) return false;
+
+        _datos[cabeza & (N - 1)] = dato;
+        _cabeza.store(cabeza + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     @brief Saca el dato más antiguo (solo el consumidor).
+     @return bool false si el anillo está vacío.
+     */
+    bool consumir(T& dato) {
+        uint32_t cola = _cola.load(std::memory_order_relaxed);
+        if (cola == _cabeza.load(std::memory_order_acquire)) return false;
+
+        dato = _datos[cola & (N - 1)];
+        _cola.store(cola + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     @brief Saca el dato más reciente descartando los anteriores (solo el consumidor).
+     @return bool false si no hubo datos nuevos desde la última lectura.
+     */
+    bool ultimo(T& dato) {
+        uint32_t cola = _cola.load(std::memory_order_relaxed);
+        uint32_t cabeza = _cabeza.load(std::memory_order_acquire);
+        if (cola == cabeza) return false;
+
+        dato = _datos[(cabeza - 1) & (N - 1)];
+        _cola.store(cabeza, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Descarta todo lo publicado hasta ahora (solo el consumidor). */
+    void vaciar() {
+        _cola.store(_cabeza.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /** @brief Datos publicados y todavía no consumidos. */
+    uint32_t disponibles() const {
+        return _cabeza.load(std::memory_order_acquire) - _cola.load(std::memory_order_acquire);
+    }
+
+private:
+    T _datos[N];
+    std::atomic<uint32_t> _cabeza{0};   ///< Próxima posición a escribir (productor).
+    std::atomic<uint32_t> _cola{0};     ///< Próxima posición a leer (consumidor).
+};
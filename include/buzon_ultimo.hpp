@@ -0,0 +1,62 @@
+/**
+ @file buzon_ultimo.hpp
+ @brief Buzón sin bloqueos del último valor (triple buffer) para pasar datos entre núcleos.
+ @details A diferencia de `AnilloSPSC`, el productor nunca encuentra el buzón lleno: cada dato reemplaza al
+ anterior si el consumidor todavía no lo tomó, así que el consumidor siempre lee el más reciente. Hay tres
+ posiciones: la que escribe el productor, la que lee el consumidor y una de intercambio. Publicar y tomar
+ son un `exchange` de la posición propia con la de intercambio; el bit `NUEVO` indica que la de intercambio
+ tiene un dato que el consumidor no vio. El orden acquire/release del `exchange` garantiza que el
+ consumidor ve el dato completo.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include <atomic>
+#include "hal.hpp"
+
+/**
+ @class BuzonUltimo
+ @brief Último valor publicado por un productor para un consumidor, sin mutex ni esperas.
+ @tparam T Tipo de dato copiado en cada posición.
+ */
+template <typename T>
+class BuzonUltimo {
+public:
+    /**
+     @brief Publica un dato (solo el productor).
+     @return bool false si reemplazó a uno que el consumidor no llegó a tomar.
+     */
+    bool publicar(const T& dato) {
+        _datos[_escritura] = dato;
+        uint8_t anterior = _intercambio.exchange(_escritura | NUEVO, std::memory_order_acq_rel);
+        _escritura = anterior & POSICION;
+        return !(anterior & NUEVO);
+    }
+
+    /**
+     @brief Toma el dato más reciente (solo el consumidor).
+     @return bool false si no hubo datos nuevos desde la última lectura.
+     */
+    bool ultimo(T& dato) {
+        if (!(_intercambio.load(std::memory_order_relaxed) & NUEVO)) return false;
+        _lectura = _intercambio.exchange(_lectura, std::memory_order_acq_rel) & POSICION;
+        dato = _datos[_lectura];
+        return true;
+    }
+
+    /** @brief Descarta el dato pendiente, si hay uno (solo el consumidor). */
+    void vaciar() {
+        if (_intercambio.load(std::memory_order_relaxed) & NUEVO) {
+            _lectura = _intercambio.exchange(_lectura, std::memory_order_acq_rel) & POSICION;
+        }
+    }
+
+private:
+    static const uint8_t POSICION = 0x03;   ///< Máscara de la posición en `_intercambio`.
+    static const uint8_t NUEVO = 0x04;      ///< La posición de intercambio tiene un dato sin leer.
+
+    T _datos[3];
+    uint8_t _escritura = 0;                 ///< Posición del productor.
+    uint8_t _lectura = 2;                   ///< Posición del consumidor.
+    std::atomic<uint8_t> _intercambio{1};   ///< Posición de intercambio y bit `NUEVO`.
+};
@@ -5,7 +5,7 @@
  */
 
 #pragma once
-#include <Arduino.h>
+#include "hal.hpp"
 
 #ifndef PITCHES_H
 #define PITCHES_H
@@ -0,0 +1,112 @@
+/**
+ @file caja_negra.hpp
+ @brief Caja negra: registro circular en RAM de los últimos ticks de ACEL, CONTROL y PERDIDO (`-D CAJA_NEGRA`).
+ @details Cada ejecución de ACEL, CONTROL o PERDIDO guarda las lecturas crudas de la barra, `position`, los
+ términos P, I y D, las velocidades de los motores, el estado y las entradas `SETPOINT`/`RUN`. El registro
+ es una estructura de arrays con el tipo más angosto de cada campo (29 bytes por tick, sin relleno), así
+ que `CAJA_NEGRA_TICKS` = 2048 ocupa ~58 KB de la RAM interna (~12 s de CONTROL con `TIEMPO_TIMER` de 6 ms).
+ Al entrar en STOP se congela: lo que llevó a la parada queda guardado hasta el próximo RUN, y estando en
+ STOP se vuelca en CSV por serial al recibir 'c'. El volcado debe pedirse antes de volver a arrancar,
+ porque la entrada en ACEL desde STOP la rearma.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+#include "muestreo.hpp"
+
+#ifndef CAJA_NEGRA_TICKS
+  /** @brief Ticks guardados (potencia de 2); se cambia con `-D CAJA_NEGRA_TICKS=...`. */
+  #define CAJA_NEGRA_TICKS 2048
+#endif
+
+static_assert(CAJA_NEGRA_TICKS >= 2 && (CAJA_NEGRA_TICKS & (CAJA_NEGRA_TICKS - 1)) == 0,
+              "CAJA_NEGRA_TICKS debe ser potencia de 2");
+
+/** @brief Los términos del PID se guardan en 1/16 de unidad de velocidad (±2047%). */
+static const uint8_t CAJA_Q_TERMINOS = 4;
+
+/**
+ @struct CajaNegra
+ @brief Almacenamiento de la caja negra: un array por campo, indexados por tick.
+ */
+struct CajaNegra {
+    uint16_t crudo[CANT_SENSORES][CAJA_NEGRA_TICKS];   ///< Lecturas crudas por sensor (índice 0 = S8).
+    uint16_t posicion[CAJA_NEGRA_TICKS];               ///< `position`.
+    uint16_t dt_us[CAJA_NEGRA_TICKS];                  ///< Tiempo desde el registro anterior (satura en 65535).
+    int16_t  p[CAJA_NEGRA_TICKS];                      ///< Término proporcional (Q4).
+    int16_t  i[CAJA_NEGRA_TICKS];                      ///< Término integral (Q4).
+    int16_t  d[CAJA_NEGRA_TICKS];                      ///< Término derivativo (Q4).
+    int8_t   motorIzq[CAJA_NEGRA_TICKS];               ///< `motorSpeedIzq` aplicado (%).
+    int8_t   motorDer[CAJA_NEGRA_TICKS];               ///< `motorSpeedDer` aplicado (%).
+    uint8_t  banderas[CAJA_NEGRA_TICKS];               ///< Estado (bits 0-1), SETPOINT (bit 2) y RUN (bit 3).
+};
+
+/**
+ @struct RegistroCaja
+ @brief Un tick de la caja negra, ya desempaquetado.
+ */
+struct RegistroCaja {
+    uint16_t crudo[CANT_SENSORES];
+    uint16_t posicion;
+    uint16_t dt_us;
+    float p, i, d;
+    int8_t motorIzq, motorDer;
+    uint8_t estado;
+    bool setpoint, run;
+};
+
+/**
+ @brief Guarda el tick actual: lecturas de `crudoLinea()`, términos de `terminosPid()` y las banderas. No hace nada si está congelada.
+ @param estado Estado que ejecutó el tick (A, C o P).
+ @param posicion Posición usada en el tick.
+ @param motorIzq Velocidad aplicada al motor izquierdo.
+ @param motorDer Velocidad aplicada al motor derecho.
+ @return void
+ */
+void registrarCajaNegra(uint8_t estado, uint16_t posicion, int32_t motorIzq, int32_t motorDer);
+
+/**
+ @brief Deja de registrar hasta `rearmarCajaNegra()`. Se llama al entrar en STOP.
+ @return void
+ */
+void congelarCajaNegra();
+
+/**
+ @brief Descarta lo registrado y vuelve a registrar. Se llama al pasar de STOP a ACEL.
+ @return void
+ */
+void rearmarCajaNegra();
+
+/** @brief true entre `congelarCajaNegra()` y `rearmarCajaNegra()`. */
+bool cajaNegraCongelada();
+
+/**
+ @brief Ticks guardados (a lo sumo `CAJA_NEGRA_TICKS`).
+ @return uint32_t Cantidad.
+ */
+uint32_t registrosCajaNegra();
+
+/**
+ @brief Lee un tick guardado.
+ @param indice 0 = el más viejo, `registrosCajaNegra()` - 1 = el último antes de congelar.
+ @return RegistroCaja Tick desempaquetado.
+ */
+RegistroCaja leerCajaNegra(uint32_t indice);
+
+/**
+ @brief Vuelca los ticks guardados en CSV, del más viejo al más nuevo.
+ @details Las dos primeras líneas (`# calMinimo,...` y `# calMaximo,...`) llevan la calibración de la barra,
+ necesaria para reproducir el registro (ver `test/reproductor.cpp`). Los términos del PID se escriben
+ con 4 decimales, exactos en Q4.
+ @param escribir Recibe cada línea (con su fin de línea); nullptr escribe por serial.
+ @return void
+ */
+void volcarCajaNegra(void (*escribir)(const char* linea) = nullptr);
+
+/**
+ @brief Atiende un pedido por serial en STOP: 'c' vuelca la caja negra.
+ @param c Caracter recibido.
+ @return void
+ */
+void comandoCajaNegra(char c);
@@ -4,7 +4,7 @@
  @author Legion de Ohm
  */
 #pragma once
-#include <Arduino.h>
+#include "hal.hpp"
 #include "sensores.hpp"
 
 // ============================
@@ -72,6 +72,132 @@ extern const uint8_t S1; ///< Pin sensor 1 (Extremo).
 #endif
 
 
+// ===================================
+// TRAZAS DE TIEMPO - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def TRAZAS
+ @brief Habilita los puntos de traza del tick de control y sus histogramas (ver trazas.hpp). Macro que ejecuta el código 'x' si TRAZAS está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D TRAZAS` en `platformio.ini`.
+ */
+#ifdef TRAZAS
+  #define traza(x) x
+#else
+  #define traza(x)
+#endif
+
+
+// ===================================
+// TELEMETRIA BINARIA - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def TELEMETRIA
+ @brief Habilita el flujo binario de tramas del tick por serial (ver telemetria.hpp). Macro que ejecuta el código 'x' si TELEMETRIA está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D TELEMETRIA` en `platformio.ini`.
+ */
+#ifdef TELEMETRIA
+  #define telemetria(x) x
+#else
+  #define telemetria(x)
+#endif
+
+
+// ===================================
+// CAJA NEGRA - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def CAJA_NEGRA
+ @brief Habilita el registro en RAM de los últimos ticks, congelado al entrar en STOP (ver caja_negra.hpp). Macro que ejecuta el código 'x' si CAJA_NEGRA está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D CAJA_NEGRA` en `platformio.ini`.
+ */
+#ifdef CAJA_NEGRA
+  #define caja(x) x
+#else
+  #define caja(x)
+#endif
+
+
+// ===================================
+// OBSERVADOR DE LA LINEA - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def OBSERVADOR
+ @brief Habilita el observador alfa-beta de la línea (ver observador.hpp): la FSM le pasa cada cuadro y el término D del PID usa la velocidad estimada. Macro que ejecuta el código 'x' si OBSERVADOR está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D OBSERVADOR` en `platformio.ini`. Está desactivado por defecto: en el simulador las vueltas salen ~0.5% más lentas que con la diferencia finita (ver README).
+ */
+#ifdef OBSERVADOR
+  #define obs(x) x
+#else
+  #define obs(x)
+#endif
+
+
+// ===================================
+// GOBERNADOR DE VELOCIDAD - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def GOBERNADOR
+ @brief Habilita el gobernador de velocidad (ver gobernador.hpp): la velocidad base de CONTROL sigue al error y a su variación en vez de ser `baseSpeed`. Macro que ejecuta el código 'x' si GOBERNADOR está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D GOBERNADOR` en `platformio.ini`.
+ */
+#ifdef GOBERNADOR
+  #define gob(x) x
+#else
+  #define gob(x)
+#endif
+
+
+// ===================================
+// MAPA DE LA PISTA - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def MAPA_PISTA
+ @brief Habilita el mapa de la pista (ver mapa.hpp): la primera vuelta graba la curvatura y las siguientes usan la velocidad planificada, que frena antes de cada curva. Macro que ejecuta el código 'x' si MAPA_PISTA está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D MAPA_PISTA` en `platformio.ini`.
+ */
+#ifdef MAPA_PISTA
+  #define mapa(x) x
+#else
+  #define mapa(x)
+#endif
+
+
+// ===================================
+// GANANCIAS POR VELOCIDAD - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def PID_BANDAS
+ @brief Habilita la tabla de ganancias por velocidad (ver `programarGanancias()` en pid.hpp): en cada tick de CONTROL Kp, Ki y Kd se interpolan entre las bandas del perfil según la velocidad base. Macro que ejecuta el código 'x' si PID_BANDAS está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D PID_BANDAS` en `platformio.ini`.
+ */
+#ifdef PID_BANDAS
+  #define bandas(x) x
+#else
+  #define bandas(x)
+#endif
+
+
+// ===================================
+// OPCIONES DEL PID - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def PID_OPCIONES
+ @brief Habilita las opciones del PID de cada perfil (ver `PerfilCorredor` en pid.hpp): anti-windup por integración condicional o retrocálculo según la saturación real de los motores, tope de la integral y derivada sobre la medición. Macro que ejecuta el código 'x' si PID_OPCIONES está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D PID_OPCIONES` en `platformio.ini`.
+ */
+#ifdef PID_OPCIONES
+  #define opciones(x) x
+#else
+  #define opciones(x)
+#endif
+
+
+// ===================================
+// SINTONIA POR RELE - CAMBIAR EN PLATFORMIO.INI
+// ===================================
+/**
+ @def SINTONIA_RELE
+ @brief Habilita pedir la sintonía por relé por serial en STOP (ver sintonia.hpp): 'u' mide Ku y Tu en el próximo RUN y los informa; 'U' además aplica las ganancias de Ziegler-Nichols y sigue la carrera, solo con `-D SINTONIA_APLICAR` (sin ella también informa). Macro que ejecuta el código 'x' si SINTONIA_RELE está definido y no deja nada compilado si no lo está. Se activa añadiendo `-D SINTONIA_RELE` en `platformio.ini`.
+ */
+#ifdef SINTONIA_RELE
+  #define sintonia(x) x
+#else
+  #define sintonia(x)
+#endif
+
+
 // ===================================
 // SELECCION DE CORREDOR - CAMBIAR EN PLATFORMIO.INI
 // ===================================
@@ -95,9 +221,14 @@ extern const uint8_t S1; ///< Pin sensor 1 (Extremo).
  @brief Perfil de constantes DIEGO. Valor: 3.
 */
 #define DIEGO     3
+/** 
+ @def SINTONIZADO
+ @brief Perfil generado por el sintonizador automático en `include/perfil_sintonizado.hpp`. Valor: 4.
+*/
+#define SINTONIZADO 4
 /**
  @def CORREDOR
- @brief La macro definida externamente (-D CORREDOR=...) que selecciona el perfil activo. Su valor debe ser uno de los identificadores numéricos definidos arriba (1, 2 o 3).
+ @brief La macro definida externamente (-D CORREDOR=...) que selecciona el perfil activo. Su valor debe ser uno de los identificadores numéricos definidos arriba (1 a 4).
  @attention La compilación fallará si no se define en `platformio.ini` un valor válido para CORREDOR.
  */
 #ifndef CORREDOR
@@ -0,0 +1,102 @@
+/**
+ @file filtros.hpp
+ @brief Filtrado por canal de los cuadros crudos de la barra, en punto fijo, entre la adquisición y la posición.
+ @details La cadena tiene tres etapas, todas elegidas al compilar:
+ - Sobremuestreo: conversiones promediadas por sensor en cada cuadro (`-D FILTRO_SOBREMUESTREO=N`, por
+   defecto 4 como QTRSensors). Está en muestreo.cpp, porque es parte de la adquisición.
+ - Mediana de 3 cuadros por canal (`-D FILTRO_MEDIANA`): descarta picos aislados de una conversión.
+ - IIR de primer orden por canal (`-D FILTRO_IIR=k`): `y += (x - y) / 2^k`, con el estado escalado por 2^k
+   para que la salida llegue exactamente a la entrada (sin zona muerta de redondeo).
+ El cuadro es el array contiguo de 8 canales de `CuadroSensores::crudo` y cada etapa es un lazo sobre él.
+ Sin `FILTRO_MEDIANA` ni `FILTRO_IIR`, `FILTRO_ACTIVO` es false y `leerLinea()` no llama a `filtrarCuadro()`.
+ Las etapas también se pueden usar sueltas (cada una con su estado) para medirlas en host.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+#include "muestreo.hpp"
+
+#ifndef FILTRO_SOBREMUESTREO
+  /** @brief Conversiones promediadas por sensor en cada cuadro; se cambia con `-D FILTRO_SOBREMUESTREO=...`. */
+  #define FILTRO_SOBREMUESTREO 4
+#endif
+
+static_assert(FILTRO_SOBREMUESTREO >= 1 && FILTRO_SOBREMUESTREO <= 16 &&
+              (FILTRO_SOBREMUESTREO & (FILTRO_SOBREMUESTREO - 1)) == 0,
+              "FILTRO_SOBREMUESTREO debe ser 1, 2, 4, 8 o 16 (la suma de 16 conversiones de 12 bits entra en 16 bits)");
+
+#ifndef FILTRO_IIR
+  /** @brief Desplazamiento k del IIR (coeficiente 1/2^k); 0 lo desactiva. Se cambia con `-D FILTRO_IIR=...`. */
+  #define FILTRO_IIR 0
+#endif
+
+static_assert(FILTRO_IIR >= 0 && FILTRO_IIR <= 8, "FILTRO_IIR debe estar entre 0 (sin IIR) y 8");
+
+#ifdef FILTRO_MEDIANA
+  /** @brief Mediana de 3 cuadros habilitada. */
+  constexpr bool FILTRO_MEDIANA_ACTIVA = true;
+#else
+  constexpr bool FILTRO_MEDIANA_ACTIVA = false;
+#endif
+
+/** @brief Alguna etapa entre cuadros habilitada: si es false, `filtrarCuadro()` no se llama. */
+constexpr bool FILTRO_ACTIVO = FILTRO_MEDIANA_ACTIVA || FILTRO_IIR > 0;
+
+/**
+ @struct EtapaMediana
+ @brief Estado de la mediana de 3: los dos cuadros anteriores de cada canal.
+ */
+struct EtapaMediana {
+    uint16_t anterior[CANT_SENSORES];       ///< Cuadro de entrada anterior.
+    uint16_t previo[CANT_SENSORES];         ///< Cuadro de entrada de hace dos pasos.
+    bool cargada;                           ///< false hasta el primer cuadro (que llena el historial).
+};
+
+/**
+ @struct EtapaIir
+ @brief Estado del IIR de primer orden: la salida de cada canal multiplicada por 2^k.
+ */
+struct EtapaIir {
+    uint32_t suma[CANT_SENSORES];           ///< Salida anterior por 2^k (la salida es `suma >> k`).
+    bool cargada;                           ///< false hasta el primer cuadro (que fija el estado sin transitorio).
+};
+
+// ===================================
+// ETAPAS
+// ===================================
+/**
+ @brief Mediana de 3 cuadros por canal, en el lugar.
+ @details El primer cuadro llena el historial y pasa sin cambios. Retrasa un cuadro los flancos.
+ @param etapa Estado de la etapa.
+ @param cuadro Lecturas de entrada y de salida (índice 0 = S8).
+ @return void
+ */
+void pasoMediana(EtapaMediana& etapa, uint16_t *cuadro);
+
+/**
+ @brief IIR de primer orden por canal, en el lugar: `suma += x - (suma >> k)`, salida `suma >> k`.
+ @details Es `y += (x - y) / 2^k` sin perder los bits bajos: con una entrada constante la salida llega a ella
+ exacta. El primer cuadro fija el estado en la entrada.
+ @param etapa Estado de la etapa.
+ @param cuadro Lecturas de entrada y de salida (índice 0 = S8).
+ @param k Desplazamiento (coeficiente 1/2^k, 1 a 8).
+ @return void
+ */
+void pasoIir(EtapaIir& etapa, uint16_t *cuadro, uint8_t k);
+
+// ===================================
+// CADENA CONFIGURADA
+// ===================================
+/**
+ @brief Pasa un cuadro crudo por las etapas habilitadas al compilar (mediana y después IIR), en el lugar.
+ @param cuadro Lecturas crudas de entrada y filtradas de salida (índice 0 = S8).
+ @return void
+ */
+void filtrarCuadro(uint16_t *cuadro);
+
+/**
+ @brief Olvida el historial de la cadena: el próximo cuadro vuelve a cargar cada etapa.
+ @return void
+ */
+void reiniciarFiltro();
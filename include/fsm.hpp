@@ -5,19 +5,90 @@
  */
 
 #pragma once
+#include <stdint.h>
+#include "maquina_estados.hpp"
 
 /**
  @enum estados
  @brief Identificadores de los estados lógicos del seguidor de línea.
  */
 enum estados { 
-    CUALQUIERA = -1,  ///< Estado para transiciones genéricas.
+    CUALQUIERA = RECIBO_CUALQUIERA,  ///< Recibo de las transiciones genéricas.
     S,                ///< Estado STOP: Robot detenido y a la espera.
     A,                ///< Estado ACEL: Fase de arranque o aceleración inicial.
     C,                ///< Estado CONTROL: Fase de seguimiento de línea con PID activo.
+    P,                ///< Estado PERDIDO: Ningún sensor ve la línea; se gira hacia el último lado visto.
+    T,                ///< Estado SINTONIA: Relé en lugar del PID para medir Ku y Tu (ver sintonia.hpp).
     CANT_ESTADOS      ///< Auxiliar para conocer el número total de estados definidos.
 };
 
+/** @brief Entradas de 4 bits: (SINTONIA << 3) | (LINEA_PERDIDA << 2) | (SETPOINT << 1) | RUN (ver `entradaFSM()`). */
+static const uint8_t CANT_ENTRADAS = 16;
+
+// ==================== Descripción de la FSM ====================
+
+/**
+ @brief Transiciones de la FSM; la primera regla que coincide gana.
+ @details Es la única descripción de la máquina: fsm.cpp genera con ella la tabla densa y las pruebas
+ (`test/prueba_fsm.cpp`, `test/Prueba_maquinaEstados.cpp`) la usan tal cual.
+ */
+constexpr Regla reglasFSM[] = {
+    // desde  recibo      hacia         entradas: 1 = RUN, 3 = RUN + SP, 5/7 = RUN sin línea, +8 = sintonía pedida
+    {S,       9,          T},
+    {S,       11,         T},
+    {S,       13,         T},
+    {S,       15,         T},
+    {S,       1,          A},
+    {S,       3,          A},
+    {S,       5,          A},
+    {S,       7,          A},
+    {S,       CUALQUIERA, S},
+
+    {A,       1,          C},
+    {A,       3,          A},
+    {A,       5,          P},
+    {A,       7,          P},
+    {A,       CUALQUIERA, S},       // sin RUN
+
+    {C,       1,          C},
+    {C,       3,          A},
+    {C,       5,          P},
+    {C,       7,          P},
+    {C,       CUALQUIERA, S},       // sin RUN
+
+    {P,       1,          C},       // línea recuperada fuera del setpoint
+    {P,       3,          A},
+    {P,       5,          P},
+    {P,       7,          P},
+    {P,       CUALQUIERA, S},       // sin RUN
+
+    {T,       9,          T},       // midiendo (la línea perdida la termina como fallida)
+    {T,       11,         T},
+    {T,       13,         T},
+    {T,       15,         T},
+    {T,       1,          C},       // terminada con las ganancias aplicadas: sigue la carrera
+    {T,       3,          A},
+    {T,       5,          P},
+    {T,       7,          P},
+    {T,       CUALQUIERA, S},       // sin RUN: solo informaba, falló o STOP
+};
+
+/** @brief Tabla [estado][entrada] resuelta en compilación. */
+constexpr TablaTransiciones<CANT_ESTADOS, CANT_ENTRADAS> tablaFSM = generarTabla<CANT_ESTADOS, CANT_ENTRADAS>(reglasFSM);
+
+static_assert(tablaCompleta(tablaFSM), "Hay combinaciones de estado y entrada sin destino en reglasFSM");
+
+// ==================== Periodos de las acciones ====================
+
+/** @brief Periodo de la acción de STOP: solo espera el botón RUN. */
+static const uint32_t PERIODO_STOP_US = 10000;
+
+/** @brief Periodo de la acción de ACEL: la rampa sube 1% por ejecución (de 50% a maxSpeed en 40 ms). */
+static const uint32_t PERIODO_ACEL_US = 1000;
+
+/** @brief Periodo de la acción de PERDIDO: lee la barra cada milisegundo para retomar la línea apenas aparece. */
+static const uint32_t PERIODO_PERDIDO_US = 1000;
+
 // ==================== Interfaz de la FSM ====================
 
 /**
@@ -27,15 +98,68 @@ enum estados {
  */
 int transicionar(int entrada);
 
+/**
+ @brief Estado actual de la FSM.
+ @return int S, A, C, P o T.
+ */
+int estadoFSM();
+
+/**
+ @brief Entrada de la FSM a partir de las banderas compartidas.
+ @return int (SINTONIA << 3) | (LINEA_PERDIDA << 2) | (SETPOINT << 1) | RUN.
+ */
+int entradaFSM();
+
+/**
+ @brief Periodo declarado de la acción de un estado (STOP, ACEL, CONTROL = `TIEMPO_TIMER`, PERDIDO o SINTONIA).
+ @param estado S, A, C, P o T.
+ @return uint32_t Periodo en microsegundos con el que el planificador ejecuta la acción.
+ */
+uint32_t periodoEstado(int estado);
+
+/**
+ @brief Devuelve la FSM a su condición de arranque (estado STOP, rampa de aceleración en 50%).
+ @details La entrada de STOP corre en el próximo `transicionar()`. Usado por el simulador en host para
+ encadenar carreras independientes.
+ @return void
+ */
+void reiniciarFSM();
+
+/**
+ @brief Fija la velocidad actual de la rampa de ACEL (la próxima ejecución de ACEL la incrementa).
+ @details Usado por el reproductor en host para retomar un registro que empieza a mitad de carrera.
+ @param velocidad Velocidad de la rampa (%).
+ @return void
+ */
+void fijarRampaAcel(int32_t velocidad);
+
 // ==================== Acciones de estado ====================
 
+/**
+ @brief Entrada en STOP: detiene los motores, apaga los LEDs y reinicia la rampa de aceleración.
+ @return void
+ */
+void entrarStop();
+
 /**
  @brief Acción ejecutada durante el estado de parada (S).
- @details Detiene los motores y resetea variables de control si es necesario.
+ @details Descarta las muestras viejas y atiende los pedidos por serial de los módulos de diagnóstico.
  @return void
  */
 void estadoStop();
 
+/**
+ @brief Salida de STOP (arranque de una carrera): rearma la caja negra.
+ @return void
+ */
+void salirStop();
+
+/**
+ @brief Entrada en ACEL: enciende el LED de setpoint.
+ @return void
+ */
+void entrarAcel();
+
 /**
  @brief Acción ejecutada durante la fase de aceleración (A).
  @details Aplica un perfil de velocidad creciente para romper la inercia inicial.
@@ -43,9 +167,56 @@ void estadoStop();
  */
 void estadoAcel();
 
+/**
+ @brief Salida de ACEL: con `GOBERNADOR`, la velocidad base de CONTROL parte de la de la rampa.
+ @return void
+ */
+void salirAcel();
+
+/**
+ @brief Entrada en CONTROL: enciende el LED de modo corredor y apaga el de setpoint.
+ @return void
+ */
+void entrarControl();
+
 /**
  @brief Acción ejecutada durante la fase de control activo (C).
- @details Ejecuta la lectura de sensores, cálculo de PID y ajuste de motores en tiempo real.
+ @details Ejecuta la lectura de sensores, cálculo de PID y ajuste de motores. El planificador la llama cada `TIEMPO_TIMER`.
+ Si la lectura no ve la línea no llama al PID (el integrador no acumula el extremo saturado) y ya gira como PERDIDO.
  @return void
  */
 void estadoControl();
+
+/**
+ @brief Entrada en PERDIDO: apaga los LEDs de estado.
+ @return void
+ */
+void entrarPerdido();
+
+/**
+ @brief Acción ejecutada mientras no se ve la línea (P).
+ @details Lee la barra y gira hacia el lado donde se vio la línea por última vez con las velocidades de
+ búsqueda (`busquedaMotores()`). El PID no se ejecuta: la integral queda congelada hasta volver a CONTROL.
+ @return void
+ */
+void estadoPerdido();
+
+/**
+ @brief Entrada en SINTONIA: empieza el experimento del relé con el PID reiniciado.
+ @return void
+ */
+void entrarSintonia();
+
+/**
+ @brief Acción ejecutada durante la sintonía por relé (T).
+ @details Lee la barra y mueve los motores con `baseSpeed` ± la salida del relé (`releSintonia()`), sin PID.
+ Al terminar baja `SINTONIA`; si solo informaba, o si falló o se perdió la línea, baja también `RUN`.
+ @return void
+ */
+void estadoSintonia();
+
+/**
+ @brief Salida de SINTONIA: aplica las ganancias medidas (si se pidió) e informa el resultado.
+ @return void
+ */
+void salirSintonia();
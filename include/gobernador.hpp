@@ -0,0 +1,44 @@
+/**
+ @file gobernador.hpp
+ @brief Gobernador de velocidad: la velocidad base de CONTROL según el error y su variación.
+ @details Con `-D GOBERNADOR`, `controlMotores()` usa como velocidad base la del gobernador en vez de la
+ constante `baseSpeed`. En cada tick de CONTROL la carga del tick es
+ @f$ c = \min(1, |e| / E_{max} + |\Delta e| / V_{max}) @f$ y la velocidad objetivo va de `rectaGobernador`
+ (carga 0) a `curvaGobernador` (carga 1). La velocidad sigue al objetivo con pendientes limitadas:
+ sube como mucho `subida` %/s y baja como mucho `bajada` %/s (las del perfil, ver `PerfilCorredor`).
+ A diferencia del mapa, que frena antes de la curva, el gobernador frena recién cuando el error crece: por eso
+ su curva es más baja que `velocidadCurva` y la carga llega a 1 con un error chico.
+ Al salir de ACEL arranca en la velocidad de la rampa (que llega a `maxSpeed`), así que no hay un escalón a
+ `baseSpeed`; en PERDIDO queda congelada. Sin la bandera el módulo se compila igual pero la FSM no lo llama.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+/** @brief |error| con el que la carga llega a 1 (la velocidad objetivo es `curvaGobernador`). */
+static const float GOBERNADOR_ERROR_MAX = 1000;
+
+/** @brief |variación del error| por tick de `TIEMPO_TIMER` con la que la carga llega a 1. */
+static const float GOBERNADOR_VARIACION_MAX = 1000;
+
+/**
+ @brief Arranca el gobernador en una velocidad (al salir de ACEL).
+ @details El primer tick después no tiene variación del error (salvo con `OBSERVADOR`, que la estima).
+ @param velocidad Velocidad de partida (%), la de la rampa de ACEL.
+ @return void
+ */
+void iniciarGobernador(float velocidad);
+
+/**
+ @brief Actualiza la velocidad gobernada con la posición del tick.
+ @param pos Posición de la línea (0 a 7000).
+ @return float Velocidad base para `controlMotores()` (%).
+ */
+float gobernarVelocidad(uint16_t pos);
+
+/**
+ @brief Velocidad gobernada del último tick, sin actualizarla.
+ @return float Velocidad base (%).
+ */
+float velocidadGobernada();
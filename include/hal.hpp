@@ -0,0 +1,339 @@
+/**
+ @file hal.hpp
+ @brief Capa de abstracción de hardware (HAL) del seguidor de línea. Declara la interfaz mínima de periféricos que usa el control (GPIO, PWM ledc, ADC y tiempo) para que `fsm.cpp`, `pid.cpp`, `motores.cpp` y `sensores.cpp` no llamen directamente a la API de Arduino/ESP32.
+ @details Existen dos backends:
+ - `hal_esp32.cpp`: implementación sobre el core Arduino-ESP32 (se compila cuando `ARDUINO` está definido).
+ - `hal_host.cpp`: implementación en memoria para Linux (entorno `native` de PlatformIO), con reloj virtual,
+   estado de pines y canales PWM inspeccionable y una fuente de lecturas analógicas configurable.
+ @author Legion de Ohm
+ */
+
+#pragma once
+
+#ifdef ARDUINO
+  #include <Arduino.h>
+
+  /** @brief En el robot hay un único control: el estado del firmware es global. */
+  #define HILO_LOCAL
+#else
+  #include <cstdint>
+  #include <cstdlib>
+  #include <cstdio>
+
+  /** @brief En host no existe IRAM: el atributo de las ISR queda vacío. */
+  #define IRAM_ATTR
+
+  /**
+   @brief Calificador del estado mutable del firmware y de la HAL host.
+   @details En host cada hilo simula su propio robot (ver el sintonizador), por lo que las
+   variables globales del control son locales a cada hilo. En el ESP32 la macro queda vacía.
+   */
+  #define HILO_LOCAL thread_local
+
+  /** @brief Misma definición que la macro `constrain` del core Arduino. */
+  #define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+  /**
+   @class HalSerialHost
+   @brief Sustituto mínimo del objeto `Serial` para que las macros `deb()` compilen en host. Escribe en la salida estándar.
+   */
+  class HalSerialHost {
+  public:
+      void begin(unsigned long baudios) { (void)baudios; }
+      int printf(const char* formato, ...) __attribute__((format(printf, 2, 3)));
+      void println(const char* texto = "") { std::printf("%s\n", texto); }
+      void print(const char* texto) { std::printf("%s", texto); }
+      int available() { return 0; }     ///< En host no hay entrada serial.
+      int read() { return -1; }
+      size_t write(const uint8_t* datos, size_t n) { return std::fwrite(datos, 1, n, stdout); }
+      int availableForWrite() { return 4096; }     ///< La salida estándar nunca se llena.
+  };
+
+  /** @brief Instancia global equivalente a `Serial` en host. */
+  extern HalSerialHost Serial;
+#endif
+
+// ============================
+// GPIO
+// ============================
+/**
+ @enum HalModo
+ @brief Modo de configuración de un pin digital.
+ */
+enum HalModo {
+    HAL_ENTRADA,    ///< Pin configurado como entrada.
+    HAL_SALIDA      ///< Pin configurado como salida.
+};
+
+/**
+ @brief Configura un pin como entrada o salida.
+ @param pin GPIO a configurar.
+ @param modo HAL_ENTRADA o HAL_SALIDA.
+ @return void
+ */
+void halPinModo(uint8_t pin, HalModo modo);
+
+/**
+ @brief Escribe un nivel lógico en un pin de salida.
+ @param pin GPIO de salida.
+ @param nivel true = HIGH, false = LOW.
+ @return void
+ */
+void halEscribirDigital(uint8_t pin, bool nivel);
+
+/**
+ @brief Lee el nivel lógico de un pin de entrada.
+ @param pin GPIO de entrada.
+ @return bool true = HIGH.
+ */
+bool halLeerDigital(uint8_t pin);
+
+/**
+ @brief Asocia una ISR al flanco ascendente de un pin.
+ @param pin GPIO de entrada.
+ @param isr Función de servicio de interrupción.
+ @return void
+ */
+void halInterrupcionPin(uint8_t pin, void (*isr)());
+
+// ============================
+// PWM (LEDC)
+// ============================
+/**
+ @brief Configura un canal PWM con su frecuencia y resolución.
+ @param canal Canal ledc (0-15).
+ @param freq Frecuencia en Hz.
+ @param resolucion Resolución del duty en bits.
+ @return void
+ */
+void halPwmConfigurar(uint8_t canal, uint32_t freq, uint8_t resolucion);
+
+/**
+ @brief Enruta la salida de un canal PWM hacia un pin.
+ @param pin GPIO de salida.
+ @param canal Canal ledc previamente configurado.
+ @return void
+ */
+void halPwmAsociar(uint8_t pin, uint8_t canal);
+
+/**
+ @brief Desvincula un pin de cualquier canal PWM.
+ @param pin GPIO de salida.
+ @return void
+ */
+void halPwmDesasociar(uint8_t pin);
+
+/**
+ @brief Escribe el duty cycle de un canal PWM.
+ @param canal Canal ledc.
+ @param duty Valor de duty en cuentas de la resolución configurada.
+ @return void
+ */
+void halPwmEscribir(uint8_t canal, uint32_t duty);
+
+/**
+ @brief Genera un tono (onda cuadrada al 50%) en un canal PWM.
+ @param canal Canal ledc.
+ @param freq Frecuencia del tono en Hz. 0 silencia la salida.
+ @return void
+ */
+void halPwmTono(uint8_t canal, uint32_t freq);
+
+// ============================
+// TIMER Y TIEMPO
+// ============================
+/**
+ @brief Tiempo transcurrido desde el arranque.
+ @return uint32_t Microsegundos (en host: reloj virtual).
+ */
+uint32_t halMicros();
+
+/**
+ @brief Contador de ciclos de la CPU, para medir tramos cortos.
+ @details En el ESP32 es el registro CCOUNT (da la vuelta cada ~18 s a 240 MHz; las restas de 32 bits lo
+ toleran). En host son nanosegundos del reloj monotónico real: el reloj virtual no avanza mientras corre el firmware.
+ @return uint32_t Cuenta actual.
+ */
+uint32_t halCiclos();
+
+/**
+ @brief Cuentas de `halCiclos()` por microsegundo.
+ @return uint32_t Frecuencia de la CPU en MHz (1000 en host).
+ */
+uint32_t halCiclosPorUs();
+
+/**
+ @brief Duerme hasta un instante de `halMicros()`, cediendo la CPU mientras tanto.
+ @details En el ESP32 bloquea la tarea con un `esp_timer` de un disparo y una notificación, así el
+ núcleo queda en la tarea IDLE; las esperas muy cortas se completan activamente. En host avanza el
+ reloj virtual. Si el instante ya pasó, vuelve enseguida.
+ @param instante_us Instante de despertar (aritmética modular de 32 bits).
+ @return void
+ */
+void halDormirHasta(uint32_t instante_us);
+
+/**
+ @brief Espera bloqueante.
+ @param ms Milisegundos a esperar (en host solo avanza el reloj virtual).
+ @return void
+ */
+void halDelay(uint32_t ms);
+
+// ============================
+// ADC
+// ============================
+/**
+ @brief Realiza una conversión analógica en el pin indicado.
+ @param pin GPIO con función ADC.
+ @return uint16_t Lectura cruda del ADC (12 bits en ESP32).
+ */
+uint16_t halLeerAnalogico(uint8_t pin);
+
+/**
+ @struct HalMuestraAdc
+ @brief Conversión entregada por el ADC continuo, etiquetada con el pin de origen.
+ */
+struct HalMuestraAdc {
+    uint8_t pin;        ///< GPIO convertido.
+    uint16_t valor;     ///< Lectura cruda (12 bits).
+};
+
+/**
+ @brief Arranca la conversión continua por DMA de un grupo de pines del ADC1.
+ @details Los pines se convierten en ronda, uno tras otro, a @p frecuencia_hz conversiones por segundo
+ en total. En host las conversiones se generan a partir de la fuente analógica y del reloj virtual.
+ @param pines GPIO a convertir (todos del ADC1).
+ @param cantidad Cantidad de pines (máximo 8).
+ @param frecuencia_hz Conversiones por segundo (mínimo 20000 en el ESP32).
+ @return bool false si algún pin no es del ADC1 o el driver no pudo iniciarse.
+ */
+bool halAdcContinuoIniciar(const uint8_t* pines, uint8_t cantidad, uint32_t frecuencia_hz);
+
+/**
+ @brief Copia las conversiones continuas acumuladas desde la última llamada, de la más vieja a la más nueva. No bloquea.
+ @param muestras Array de salida.
+ @param maximo Capacidad de @p muestras (máximo 64).
+ @return uint16_t Conversiones copiadas; si es igual a @p maximo puede haber más pendientes.
+ */
+uint16_t halAdcContinuoLeer(HalMuestraAdc* muestras, uint16_t maximo);
+
+/**
+ @brief Conversión única por el driver del ADC2, utilizable mientras el ADC1 convierte en modo continuo.
+ @param pin GPIO con función ADC2.
+ @return uint16_t Lectura cruda (12 bits).
+ */
+uint16_t halAdcUnico(uint8_t pin);
+
+// ============================
+// TAREAS
+// ============================
+/**
+ @brief Ejecuta @p paso en un lazo sin fin dentro de una tarea fijada a un núcleo.
+ @details En el ESP32 crea una tarea FreeRTOS con `xTaskCreatePinnedToCore`. En host no hay
+ hilos: el paso se ejecuta una vez al comienzo de cada `halHostAvanzar()`, en el mismo hilo,
+ para que las simulaciones sigan siendo deterministas.
+ @param paso Una iteración de la tarea.
+ @param nucleo Núcleo donde corre la tarea (0 o 1).
+ @return void
+ */
+void halTareaNucleo(void (*paso)(), uint8_t nucleo);
+
+/**
+ @brief Ejecuta @p paso cada @p periodo_ms en una tarea de baja prioridad que solo corre cuando el control cede la CPU.
+ @details En el ESP32 es una tarea FreeRTOS de prioridad `tskIDLE_PRIORITY` en el núcleo 1, que entre
+ pasos se bloquea con `vTaskDelay` (no desactiva el watchdog). En host el paso se ejecuta una vez por
+ cada `halHostAvanzar()`, después de las tareas de núcleo.
+ @param paso Una iteración de la tarea; no debe bloquear.
+ @param periodo_ms Espera entre iteraciones.
+ @return void
+ */
+void halTareaFondo(void (*paso)(), uint32_t periodo_ms);
+
+// ============================
+// ALMACENAMIENTO NO VOLÁTIL
+// ============================
+/**
+ @brief Lee un bloque guardado con `halAlmacenEscribir()`.
+ @details En el ESP32 es una entrada de NVS (`Preferences`, espacio "seguidor"). En host es un archivo por
+ clave en el directorio fijado con `halHostAlmacen()`; sin directorio no hay almacén.
+ @param clave Nombre del bloque (máximo 15 caracteres, límite de NVS).
+ @param datos Destino.
+ @param n Tamaño esperado en bytes.
+ @return bool false si el bloque no existe o su tamaño no es @p n (y @p datos no se modifica).
+ */
+bool halAlmacenLeer(const char* clave, void* datos, size_t n);
+
+/**
+ @brief Guarda un bloque en la memoria no volátil, reemplazando el anterior de la misma clave.
+ @details Escribe en flash: no llamarla desde el lazo de control.
+ @param clave Nombre del bloque (máximo 15 caracteres).
+ @param datos Contenido.
+ @param n Tamaño en bytes.
+ @return bool false si no se pudo escribir.
+ */
+bool halAlmacenEscribir(const char* clave, const void* datos, size_t n);
+
+#ifndef ARDUINO
+// ============================
+// EXTENSIONES SOLO HOST
+// ============================
+/**
+ @name API del backend host
+ @brief Funciones para que los programas de prueba en Linux controlen el reloj virtual y observen los periféricos simulados.
+ @{
+ */
+
+/** @brief Firma de una fuente de lecturas analógicas: recibe el pin y devuelve la lectura cruda. */
+typedef uint16_t (*HalFuenteAnalogica)(uint8_t pin);
+
+/** @brief Vuelve el backend host a su estado inicial (reloj en 0, pines y canales libres, sin tareas). */
+void halHostReiniciar();
+
+/** @brief Ejecuta una vez las tareas de `halTareaNucleo()` y `halTareaFondo()` y avanza el reloj virtual @p us microsegundos. */
+void halHostAvanzar(uint32_t us);
+
+/** @brief Fija una lectura analógica constante para un pin (usada si no hay fuente registrada). */
+void halHostFijarAnalogico(uint8_t pin, uint16_t valor);
+
+/** @brief Registra una función que genera las lecturas analógicas (nullptr para volver a los valores fijos). */
+void halHostFuenteAnalogica(HalFuenteAnalogica fuente);
+
+/** @brief Simula un flanco ascendente en el pin, ejecutando su ISR si la hay. */
+void halHostDispararPin(uint8_t pin);
+
+/** @brief Último nivel escrito en un pin digital. */
+bool halHostNivelPin(uint8_t pin);
+
+/** @brief Fija el nivel que devuelve `halLeerDigital()` en un pin de entrada (por ejemplo, un botón apretado). */
+void halHostFijarDigital(uint8_t pin, bool nivel);
+
+/**
+ @brief Directorio donde se guardan los bloques de `halAlmacenEscribir()` (nullptr = sin almacén, el valor inicial).
+ @details `halHostReiniciar()` no lo cambia: como la flash, el almacén sobrevive al reinicio.
+ */
+void halHostAlmacen(const char* directorio);
+
+/** @brief Canal PWM asociado al pin, o -1 si el pin no está enrutado a ningún canal. */
+int8_t halHostCanalPin(uint8_t pin);
+
+/** @brief Último duty escrito en el canal. */
+uint32_t halHostDutyCanal(uint8_t canal);
+
+/** @brief Resolución en bits configurada para el canal. */
+uint8_t halHostResolucionCanal(uint8_t canal);
+
+/**
+ @struct HalContadores
+ @brief Llamadas a periféricos de salida recibidas por el backend host desde el último reinicio.
+ */
+struct HalContadores {
+    uint32_t escriturasDigitales;   ///< `halEscribirDigital()`.
+    uint32_t pwmAsociar;            ///< `halPwmAsociar()`.
+    uint32_t pwmDesasociar;         ///< `halPwmDesasociar()`.
+    uint32_t pwmEscrituras;         ///< `halPwmEscribir()`.
+};
+
+/** @brief Contadores de llamadas a periféricos (se ponen en cero con `halHostReiniciar()`). */
+const HalContadores& halHostContadores();
+///@}
+#endif
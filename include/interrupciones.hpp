@@ -5,7 +5,7 @@
  */
 
 #pragma once
-#include <Arduino.h>
+#include "hal.hpp"
 
 // ============================
 // FLAGS COMPARTIDOS
@@ -14,32 +14,46 @@
  @var RUN
  @brief Bandera de estado que controla si el ciclo principal del robot debe ejecutarse. El calificador `volatile` es crucial para indicar que esta variable puede ser modificada por una función de interrupción (ISR) en cualquier momento y debe ser leída directamente de la memoria en el ciclo principal (`loop`).
  */
-extern volatile bool RUN;
+extern HILO_LOCAL volatile bool RUN;
 
 /**
  @var SETPOINT
  @brief Bandera volátil que indica si el robot ha alcanzado o debe buscar el punto de consigna (setpoint).
  */
-extern volatile bool SETPOINT;
+extern HILO_LOCAL volatile bool SETPOINT;
 
 /**
- @var has_expired
- @brief Bandera de sincronización utilizada por el temporizador para indicar que un periodo de tiempo ha finalizado.
+ @var LINEA_PERDIDA
+ @brief Bandera que indica que la última lectura de la barra no vio la línea (la actualizan ACEL, CONTROL y PERDIDO).
  */
-extern volatile bool has_expired;
+extern HILO_LOCAL volatile bool LINEA_PERDIDA;
+
+/**
+ @var SINTONIA
+ @brief Bandera que pide la sintonía por relé en el próximo RUN (ver sintonia.hpp); la baja la salida de SINTONIA.
+ */
+extern HILO_LOCAL volatile bool SINTONIA;
 
 // ============================
 // TIEMPO DE CONTROL
 // ============================
+#ifndef TIEMPO_TIMER_US
+  /** @brief Periodo por defecto del tick de control; se cambia con `-D TIEMPO_TIMER_US=...` en platformio.ini. */
+  #define TIEMPO_TIMER_US 6000
+#endif
+
 /**
- @brief Periodo del temporizador de control expresado en microsegundos (us).
+ @brief Periodo del tick de control expresado en microsegundos (us): el planificador libera CONTROL con este periodo.
+ @details Es `constexpr` para que el PID en punto fijo (`PID_FIJO`) pliegue dt en sus constantes al compilar.
  */
-extern const int32_t TIEMPO_TIMER;
+constexpr int32_t TIEMPO_TIMER = TIEMPO_TIMER_US;
 
 /**
  @brief Tiempo diferencial fijo (Delta T) expresado en segundos (s) para los cálculos del PID.
  */
-extern const float FIXED_DT_S;
+constexpr float FIXED_DT_S = TIEMPO_TIMER * 1e-6f;
+
+static_assert(TIEMPO_TIMER > 0, "TIEMPO_TIMER_US debe ser positivo");
 
 // ============================
 // INICIALIZACIÓN
@@ -58,9 +72,3 @@ void IRAM_ATTR handleRun();
  @brief Función de servicio de interrupción (ISR) para detener la rutina principal. Se ejecuta cuando se detecta el evento de detención en el pin de interrupción. Esta función probablemente establece `RUN = false;`.
  */
 void IRAM_ATTR handleStop();
-
-/**
- @brief ISR del temporizador de hardware. 
- @details Se ejecuta periódicamente para gestionar tareas de tiempo real, como el refresco del cálculo PID. Utiliza `IRAM_ATTR` para máxima velocidad de respuesta.
- */
-void IRAM_ATTR timerInterrupcion();
@@ -0,0 +1,153 @@
+/**
+ @file mapa.hpp
+ @brief Mapa de curvatura de la pista aprendido en la primera vuelta y velocidad planificada para las siguientes.
+ @details Con `-D MAPA_PISTA` la FSM le pasa a `registrarMapa()` los comandos de los motores de cada
+ ejecución de ACEL y CONTROL (PERDIDO no: el giro de búsqueda no es la forma de la pista):
+ - Avance: la integral de la velocidad media de los motores (en %·ms; no hay encoders). Cada `MAPA_PASO`
+   de avance cierra un segmento de ~13 cm a la escala del simulador.
+ - Curvatura del segmento: el diferencial de los motores integrado en el segmento,
+   @f$ 128 \cdot \int (der - izq) / \int media @f$, o sea la diferencia entre ruedas relativa a la velocidad
+   media en Q7 (saturada a ±127). La posición de la línea entra a través del PID, que es quien arma el
+   diferencial.
+ - Codificación: un valor absoluto (int8) cada `MAPA_CLAVE` segmentos y en el medio diferencias de 4 bits
+   en pasos de `MAPA_PASO_DELTA`, con el error de cuantización realimentado (no se acumula). Con
+   `MAPA_SEGMENTOS = 1024` son 576 bytes para ~130 m de pista.
+ La vuelta de aprendizaje se cierra comparando los últimos `MAPA_VENTANA` segmentos con dos ventanas de
+ referencia seguidas, la primera justo antes de la primera curva: se parecen con la suma de diferencias
+ absolutas bajo `MAPA_UMBRAL` por segmento y bajo 1/`MAPA_PARECIDO` de la suma de ambas ventanas. Cada
+ referencia propone como vuelta la distancia a su mejor coincidencia, y la vuelta se acepta solo si la otra
+ referencia también coincide a esa distancia (±1): un largo que no se repite se descarta, y una referencia que
+ no se repite (la primera pasada por una curva fue distinta) se reemplaza por la siguiente. En una pista
+ simétrica cierra en la mitad, que es su período. El mapa es la última vuelta grabada. Desde ahí cada segmento
+ nuevo se vuelve a ubicar comparando la ventana reciente con el mapa a ±`MAPA_BUSQUEDA` segmentos de la
+ posición esperada, lo que corrige la deriva de la odometría en cada curva; solo se mueve con una coincidencia
+ clara y, si no la hay, sigue por odometría. Una pausa larga entre ejecuciones (la línea perdida) vacía la
+ ventana reciente, que vuelve a compararse con media ventana llena. Con media ventana seguida sin coincidir el
+ mapa queda desubicado (sin plan) hasta volver a encontrarse en una curva: con una ventana que tenga alguna
+ curva se compara contra todas las de la vuelta, `MAPA_CANDIDATOS` por ejecución y decodificando el mapa en
+ orden, así que la búsqueda tiene un costo fijo por tick aunque el mapa sea largo.
+ La velocidad planificada del segmento es el mínimo de la velocidad de curva de los próximos
+ `MAPA_ANTICIPO` segmentos, entre `velocidadRecta` y `velocidadCurva` del perfil: frena antes de la curva.
+ En ACEL la rampa tampoco la pasa. Sin la bandera el módulo se compila igual (lo usa `native_mapa`) pero
+ la FSM no lo llama.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+#ifndef MAPA_SEGMENTOS
+  /** @brief Capacidad del mapa en segmentos; se cambia con `-D MAPA_SEGMENTOS=...`. */
+  #define MAPA_SEGMENTOS 1024
+#endif
+
+/** @brief Segmentos entre valores absolutos (el resto son diferencias de 4 bits). */
+static const uint16_t MAPA_CLAVE = 16;
+
+static_assert(MAPA_SEGMENTOS >= 64 && MAPA_SEGMENTOS <= 4096 && MAPA_SEGMENTOS % MAPA_CLAVE == 0,
+              "MAPA_SEGMENTOS debe ser múltiplo de 16, entre 64 y 4096");
+
+/** @brief Avance de un segmento en %·ms de velocidad media (8192 = ~13 cm con 1.6 m/s al 100%). */
+static const int32_t MAPA_PASO = 8192;
+
+/** @brief Paso de cuantización de las diferencias de 4 bits (Q7): saltos de -64 a +56 por segmento. */
+static const int8_t MAPA_PASO_DELTA = 8;
+
+/** @brief Segmentos comparados para cerrar la vuelta y para volver a ubicarse. */
+static const uint8_t MAPA_VENTANA = 16;
+
+/** @brief Segmentos promediados en las comparaciones: una curva partida entre dos segmentos no cambia la forma. */
+static const uint8_t MAPA_SUAVIZADO = 2;
+
+/** @brief Suma de diferencias absolutas máxima por segmento (Q7) para aceptar una comparación. */
+static const int16_t MAPA_UMBRAL = 16;
+
+/** @brief Tope de la diferencia de un segmento en la comparación: un segmento raro no tira la ventana entera. */
+static const int16_t MAPA_TOPE = 64;
+
+/** @brief Para cerrar la vuelta la diferencia tiene que ser menor que la suma de las ventanas sobre este número. */
+static const int16_t MAPA_PARECIDO = 3;
+
+/** @brief |curvatura| (Q7) desde la que un segmento cuenta como curva (para elegir la primera ventana de cierre). */
+static const int8_t MAPA_CURVA_MIN = 24;
+
+/** @brief |curvatura| (Q7) con la que la velocidad planificada llega a `velocidadCurva`. */
+static const int8_t MAPA_CURVA_LLENA = 96;
+
+/** @brief Desplazamiento máximo en segmentos al volver a ubicarse. */
+static const uint8_t MAPA_BUSQUEDA = 4;
+
+/** @brief Ventanas del mapa comparadas por ejecución al buscar en toda la vuelta (una vuelta de 1024 en 32 ticks). */
+static const uint8_t MAPA_CANDIDATOS = 32;
+
+/** @brief Segmentos hacia adelante que mira la velocidad planificada. */
+static const uint8_t MAPA_ANTICIPO = 2;
+
+/**
+ @enum FaseMapa
+ @brief Estado del mapa.
+ */
+enum FaseMapa : uint8_t {
+    MAPA_APRENDIENDO,   ///< Grabando la primera vuelta.
+    MAPA_LISTO,         ///< Vuelta cerrada y ubicado: hay velocidad planificada.
+    MAPA_DESUBICADO,    ///< Vuelta cerrada pero la ventana reciente no coincide con el mapa.
+    MAPA_LLENO,         ///< Se llenó el buffer sin cerrar la vuelta (pista más larga que el mapa).
+};
+
+/**
+ @struct EstadoMapa
+ @brief Resumen del mapa para diagnóstico.
+ */
+struct EstadoMapa {
+    FaseMapa fase;          ///< Estado actual.
+    uint16_t segmentos;     ///< Segmentos grabados.
+    uint16_t largo;         ///< Segmentos de una vuelta (0 hasta cerrarla).
+    uint16_t indice;        ///< Segmento actual dentro de la vuelta (con el mapa listo).
+    uint16_t correcciones;  ///< Veces que la ubicación se movió al comparar con el mapa.
+};
+
+/**
+ @brief Incorpora una ejecución de la FSM: avance y diferencial de los motores desde la anterior.
+ @param izq Comando del motor izquierdo (%).
+ @param der Comando del motor derecho (%).
+ @return void
+ */
+void registrarMapa(int32_t izq, int32_t der);
+
+/**
+ @brief Empieza una carrera: con el mapa cerrado vuelve al segmento 0; si no, empieza a aprender de nuevo.
+ @details Supone que el robot arranca siempre en el mismo punto de la pista (la línea de largada).
+ @return void
+ */
+void arrancarMapa();
+
+/**
+ @brief Olvida el mapa: la próxima carrera vuelve a aprender.
+ @return void
+ */
+void reiniciarMapa();
+
+/**
+ @brief true si hay velocidad planificada para el segmento actual.
+ @return bool Mapa cerrado y ubicado.
+ */
+bool mapaListo();
+
+/**
+ @brief Velocidad base planificada para el segmento actual.
+ @return uint8_t Velocidad (%), entre `velocidadCurva` y `velocidadRecta`; sin mapa listo, `baseSpeed`.
+ */
+uint8_t velocidadMapa();
+
+/**
+ @brief Curvatura guardada de un segmento (decodificada).
+ @param indice Segmento, menor que `estadoMapa().segmentos`.
+ @return int8_t Curvatura en Q7.
+ */
+int8_t curvaturaMapa(uint16_t indice);
+
+/**
+ @brief Resumen del mapa.
+ @return const EstadoMapa& Fase, segmentos, largo de la vuelta, segmento actual y correcciones.
+ */
+const EstadoMapa& estadoMapa();
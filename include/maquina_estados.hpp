@@ -0,0 +1,142 @@
+/**
+ @file maquina_estados.hpp
+ @brief Máquina de estados con tabla de transiciones densa generada en compilación.
+ @details La FSM se describe con reglas {desde, recibo, hacia} en el mismo formato que las tablas
+ originales (`CUALQUIERA` cubre las entradas no listadas; gana la primera regla que coincide).
+ `generarTabla()` es `constexpr`: las reglas se resuelven al compilar en una matriz
+ `[estado][entrada]`, así que `transicionar()` es un acceso indexado sin importar cuántos estados o
+ reglas haya, y un `static_assert` con `tablaCompleta()` detecta combinaciones sin destino.
+ Cada estado tiene acción de entrada, de ejecución (en cada liberación) y de salida; las de entrada y
+ salida solo corren al cambiar de estado, lo que reemplaza a las banderas de "ejecutar una vez".
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/** @brief Valor de `recibo` que coincide con cualquier entrada. */
+static const int8_t RECIBO_CUALQUIERA = -1;
+
+/** @brief Marca de celda sin destino en la tabla generada. */
+static const uint8_t SIN_DESTINO = 0xFF;
+
+/**
+ @struct Regla
+ @brief Una fila de la descripción de la FSM.
+ */
+struct Regla {
+    int8_t desde;       ///< Estado de origen.
+    int8_t recibo;      ///< Entrada que dispara la regla (`RECIBO_CUALQUIERA` = todas).
+    int8_t hacia;       ///< Estado de destino.
+};
+
+/**
+ @struct TablaTransiciones
+ @brief Próximo estado para cada par (estado, entrada).
+ @tparam NE Cantidad de estados.
+ @tparam NI Cantidad de entradas.
+ */
+template <uint8_t NE, uint8_t NI>
+struct TablaTransiciones {
+    uint8_t prox[NE][NI];
+};
+
+/**
+ @brief Resuelve las reglas en una tabla densa (en compilación si se usa en un contexto `constexpr`).
+ @details Para cada estado y entrada toma la primera regla del estado que coincide, igual que el
+ recorrido lineal de las tablas con centinela `CUALQUIERA`.
+ @param reglas Descripción de la FSM.
+ @return TablaTransiciones<NE, NI> Tabla con `SIN_DESTINO` en las celdas que ninguna regla cubre.
+ */
+template <uint8_t NE, uint8_t NI, size_t NR>
+constexpr TablaTransiciones<NE, NI> generarTabla(const Regla (&reglas)[NR]) {
+    TablaTransiciones<NE, NI> t = {};
+    for (uint8_t e = 0; e < NE; e++) {
+        for (uint8_t i = 0; i < NI; i++) {
+            t.prox[e][i] = SIN_DESTINO;
+            for (size_t r = 0; r < NR; r++) {
+                if (reglas[r].desde != e) continue;
+                if (reglas[r].recibo != i && reglas[r].recibo != RECIBO_CUALQUIERA) continue;
+                t.prox[e][i] = (uint8_t)reglas[r].hacia;
+                break;
+            }
+        }
+    }
+    return t;
+}
+
+/**
+ @brief true si todas las celdas tienen un destino válido.
+ */
+template <uint8_t NE, uint8_t NI>
+constexpr bool tablaCompleta(const TablaTransiciones<NE, NI>& t) {
+    for (uint8_t e = 0; e < NE; e++) {
+        for (uint8_t i = 0; i < NI; i++) {
+            if (t.prox[e][i] >= NE) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ @struct AccionesEstado
+ @brief Funciones de un estado. Cualquiera puede ser nullptr.
+ */
+struct AccionesEstado {
+    void (*entrar)();       ///< Al llegar al estado desde otro (o al arrancar).
+    void (*ejecutar)();     ///< En cada liberación mientras se está en el estado.
+    void (*salir)();        ///< Al dejar el estado, antes de entrar en el siguiente.
+};
+
+/**
+ @class MaquinaEstados
+ @brief Despacho O(1) sobre una tabla generada, con acciones de entrada, ejecución y salida.
+ @tparam NE Cantidad de estados.
+ @tparam NI Cantidad de entradas.
+ */
+template <uint8_t NE, uint8_t NI>
+class MaquinaEstados {
+public:
+    /**
+     @param tabla Tabla generada con `generarTabla()` (debe vivir mientras la máquina).
+     @param acciones Acciones de cada estado, en el orden de los identificadores.
+     @param inicial Estado de arranque; su entrada corre en el primer `transicionar()`.
+     */
+    constexpr MaquinaEstados(const TablaTransiciones<NE, NI>& tabla, const AccionesEstado* acciones, uint8_t inicial)
+        : _tabla(tabla), _acciones(acciones), _actual(inicial), _pendiente(true) {}
+
+    /**
+     @brief Aplica la entrada: sale del estado actual y entra en el nuevo si cambia, y ejecuta la acción del estado resultante.
+     @param entrada Entrada (menor a NI).
+     @return uint8_t Estado resultante.
+     */
+    uint8_t transicionar(uint8_t entrada) {
+        uint8_t prox = _tabla.prox[_actual][entrada];
+
+        if (_pendiente || prox != _actual) {
+            if (!_pendiente && _acciones[_actual].salir) _acciones[_actual].salir();
+            _actual = prox;
+            _pendiente = false;
+            if (_acciones[_actual].entrar) _acciones[_actual].entrar();
+        }
+
+        if (_acciones[_actual].ejecutar) _acciones[_actual].ejecutar();
+        return _actual;
+    }
+
+    /** @brief Estado actual. */
+    uint8_t actual() const { return _actual; }
+
+    /** @brief Vuelve a @p inicial sin ejecutar acciones; la entrada corre en el próximo `transicionar()`. */
+    void reiniciar(uint8_t inicial) {
+        _actual = inicial;
+        _pendiente = true;
+    }
+
+private:
+    const TablaTransiciones<NE, NI>& _tabla;
+    const AccionesEstado* _acciones;
+    uint8_t _actual;
+    bool _pendiente;        ///< El estado actual todavía no ejecutó su entrada.
+};
@@ -5,13 +5,27 @@
  */
 
 #pragma once
+#include "hal.hpp"
 
 #ifndef DRV8833_H
 #define DRV8833_H
 
+/**
+ @enum DireccionMotor
+ @brief Enrutamiento actual de los pines IN1/IN2 de un driver.
+ */
+enum DireccionMotor : uint8_t {
+    MOTOR_SIN_CONFIGURAR,   ///< Estado desconocido (antes de `setup()`): el primer comando enruta ambos pines.
+    MOTOR_DETENIDO,         ///< IN1 e IN2 desvinculados del PWM y en LOW.
+    MOTOR_AVANCE,           ///< IN1 en el canal PWM, IN2 en LOW.
+    MOTOR_REVERSA           ///< IN2 en el canal PWM, IN1 en LOW.
+};
+
 /**
  @class Drv8833
  @brief Clase para drivers de motores DRV8833. Incluye funciones que permiten configurar sus pines, ajustar el PWM y el movimiento de los motores.
+ @details El driver recuerda su dirección y su duty: los pines solo se reenrutan cuando cambia la
+ dirección y el duty solo se escribe cuando cambia, así que un tick sin cambios no toca el hardware.
  */
 class Drv8833 {
 public:
@@ -53,13 +67,40 @@ public:
      */
     void stop();
 
+    /**
+     @brief Dirección en la que quedaron enrutados los pines.
+     @return DireccionMotor Estado actual del driver.
+     */
+    DireccionMotor direccion() const { return _direccion; }
+
+    /**
+     @brief Llamadas a la HAL hechas por el driver desde `setup()` (enrutamiento, niveles y duty).
+     @return uint32_t Cantidad acumulada.
+     */
+    uint32_t llamadasHal() const { return _llamadasHal; }
+
 private:
+    /**
+     @brief Enruta los pines para una nueva dirección, tocando solo los que cambian.
+     @param nueva Dirección a aplicar (distinta de la actual).
+     */
+    void _enrutar(DireccionMotor nueva);
+
+    /**
+     @brief Escribe el duty del canal si difiere del último escrito.
+     @param pPWM Porcentaje de potencia [0 a 100] %.
+     */
+    void _escribirDuty(uint8_t pPWM);
+
     uint8_t _pinIN1;   ///< GPIO del pin IN1.
     uint8_t _pinIN2;   ///< GPIO del pin IN2.
     uint8_t _pinSleep; ///< GPIO del pin Sleep (Habilitación).
     uint8_t _chPWM;    ///< Canal PWM configurado.
     uint32_t _freqPWM; ///< Frecuencia PWM en Hz.
     uint8_t _resPWM;   ///< Resolución PWM en bits.
+    DireccionMotor _direccion = MOTOR_SIN_CONFIGURAR;  ///< Enrutamiento actual de IN1/IN2.
+    uint32_t _duty = UINT32_MAX;    ///< Último duty escrito en el canal (UINT32_MAX = ninguno).
+    uint32_t _llamadasHal = 0;      ///< Llamadas a la HAL desde `setup()`.
 };
 #endif
 
@@ -67,13 +108,13 @@ private:
  @var motorSpeedIzq
  @brief Velocidad final del motor izquierdo calculada tras el PID. Positivo = avance, Negativo = reversa.
  */
-extern int32_t motorSpeedIzq;
+extern HILO_LOCAL int32_t motorSpeedIzq;
 
 /**
  @var motorSpeedDer
  @brief Velocidad final del motor derecho calculada tras el PID. Positivo = avance, Negativo = reversa.
  */
-extern int32_t motorSpeedDer;
+extern HILO_LOCAL int32_t motorSpeedDer;
 
 /**
  @var maxSpeed
@@ -81,6 +122,32 @@ extern int32_t motorSpeedDer;
  */
 extern const int32_t maxSpeed;
 
+/**
+ @var busquedaExterior
+ @brief Velocidad de la rueda exterior al girar hacia la línea perdida (estado PERDIDO).
+ */
+extern HILO_LOCAL int32_t busquedaExterior;
+
+/**
+ @var busquedaInterior
+ @brief Velocidad de la rueda interior al girar hacia la línea perdida; negativa para girar casi sobre el eje.
+ */
+extern HILO_LOCAL int32_t busquedaInterior;
+
+/**
+ @var prioridadGiro
+ @brief Con `-D MEZCLADOR`, true (por defecto) conserva la diferencia entre ruedas bajando la base; false
+ vuelve al recorte de cada rueda (para comparar en host).
+ */
+extern HILO_LOCAL bool prioridadGiro;
+
+/**
+ @var pisoInterior
+ @brief Velocidad mínima de la rueda interior en las curvas con `-D MEZCLADOR`: 0 no deja que retroceda,
+ -maxSpeed (por defecto) la deja ir en reversa hasta el límite.
+ */
+extern HILO_LOCAL int32_t pisoInterior;
+
 /**
  @brief Inicializa los objetos de los motores y configura sus periféricos.
  @return void
@@ -95,6 +162,14 @@ void setupMotores();
  */
 void moverMotores(int32_t motorSpeedIzq, int32_t motorSpeedDer);
 
+/**
+ @brief Llamadas a la HAL hechas por ambos drivers desde `setupMotores()`.
+ @details La diferencia entre dos ticks es el costo en periféricos de `moverMotores()`; en host se
+ puede contrastar con `halHostContadores()`.
+ @return uint32_t Cantidad acumulada.
+ */
+uint32_t llamadasHalMotores();
+
 /**
  @brief Detiene ambos motores de forma inmediata enviando una señal de parada a los drivers.
  @return void
@@ -108,6 +183,30 @@ void detenerMotores();
  */
 void controlMotores(float correcion);
 
+/**
+ @brief Velocidad base de CONTROL: `baseSpeed`, la gobernada con `GOBERNADOR` o la planificada con `MAPA_PISTA`.
+ @return float Velocidad base (%) a la que `controlMotores()` suma y resta la corrección.
+ */
+float velocidadBase();
+
+/**
+ @brief Corrección que `controlMotores()` aplica de verdad después de limitar cada motor a ±`maxSpeed`.
+ @details La mitad de la diferencia entre los motores, sin redondear a entero. Sin saturación es la misma
+ corrección; con `MEZCLADOR` también mientras el giro entre bajando la base. La usa el anti-windup del PID
+ (`saturacionPid()`).
+ @param correcion Corrección pedida por el PID.
+ @return float Corrección aplicada (%).
+ */
+float correccionAplicada(float correcion);
+
+/**
+ @brief Velocidades de búsqueda de la línea perdida: gira hacia el lado donde se la vio por última vez.
+ @details Deja `busquedaExterior`/`busquedaInterior` en `motorSpeedIzq`/`motorSpeedDer` (no mueve los motores).
+ @param pos Posición devuelta por la barra sin línea (0 o 7000).
+ @return void
+ */
+void busquedaMotores(uint16_t pos);
+
 /**
  @brief Actualiza el SetPoint (punto de referencia) del sistema de control según la posición actual del robot.
  @param pos Posición actual leída por la barra de sensores.
@@ -0,0 +1,67 @@
+/**
+ @file muestreo.hpp
+ @brief Adquisición de un cuadro completo de la barra QTR-8A: lectura directa (como QTRSensors) o continua por DMA.
+ @details La barra reparte sus sensores entre los dos ADC del ESP32: S1-S6 (GPIO36/39/34/35/32/33) son
+ canales del ADC1 y S7/S8 (GPIO27/14) del ADC2. Con `-D ADC_CONTINUO` el ADC1 convierte sin pausa por DMA
+ y cada cuadro toma las últimas conversiones de S1-S6, mientras S7/S8 se leen con conversiones únicas del
+ ADC2 que se superponen con el DMA. Sin la bandera se usa la lectura directa, idéntica a la de QTRSensors.
+ Ambos caminos pasan por la HAL, así que en host se ejercitan con la fuente analógica sintética.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+/** @brief Cantidad de sensores de la barra. */
+static const uint8_t CANT_SENSORES = 8;
+
+/**
+ @struct CuadroSensores
+ @brief Lectura cruda completa de la barra, con su marca de tiempo.
+ */
+struct CuadroSensores {
+    uint16_t crudo[CANT_SENSORES];  ///< Promedio de `FILTRO_SOBREMUESTREO` (4) conversiones por sensor (índice 0 = S8).
+    uint32_t instante_us;           ///< `halMicros()` al comenzar la adquisición.
+    uint32_t duracion_us;           ///< Tiempo que tomó completar el cuadro.
+};
+
+/**
+ @brief Configura los pines de la barra y, con `ADC_CONTINUO`, arranca el DMA del ADC1.
+ @return void
+ */
+void iniciarMuestreo();
+
+/**
+ @brief Arranca la conversión continua del ADC1 (S1-S6). La llama `iniciarMuestreo()` con `ADC_CONTINUO`.
+ @return bool false si el driver no pudo iniciarse.
+ */
+bool iniciarMuestreoContinuo();
+
+/**
+ @brief Indica si el DMA del ADC1 está convirtiendo.
+ @return bool false si `iniciarMuestreoContinuo()` falló o el DMA dejó de entregar conversiones.
+ */
+bool muestreoContinuoActivo();
+
+/**
+ @brief Cuadro por lectura directa: 4 rondas (`FILTRO_SOBREMUESTREO`) de `halLeerAnalogico()` sobre los 8 sensores (camino de QTRSensors).
+ @param cuadro Cuadro de salida.
+ @return void
+ */
+void leerCuadroDirecto(CuadroSensores& cuadro);
+
+/**
+ @brief Cuadro por conversión continua: ADC2 por conversión única y ADC1 con las últimas 4 (`FILTRO_SOBREMUESTREO`) conversiones del DMA.
+ @details Requiere `iniciarMuestreoContinuo()`. No espera al ADC1 salvo en el primer cuadro, hasta la primera ronda.
+ Si el DMA no arrancó o deja de convertir, lee con `leerCuadroDirecto()`.
+ @param cuadro Cuadro de salida.
+ @return void
+ */
+void leerCuadroContinuo(CuadroSensores& cuadro);
+
+/**
+ @brief Cuadro con el camino seleccionado por `ADC_CONTINUO`.
+ @param cuadro Cuadro de salida.
+ @return void
+ */
+void leerCuadro(CuadroSensores& cuadro);
@@ -0,0 +1,103 @@
+/**
+ @file observador.hpp
+ @brief Observador alfa-beta de la posición de la línea y de su velocidad lateral.
+ @details Con cada cuadro de la barra predice la posición con la velocidad estimada y el tiempo real entre
+ cuadros, y corrige ambas con el residuo: @f$ x \mathrel{+}= \alpha r @f$, @f$ v \mathrel{+}= \beta r / \Delta t @f$.
+ Es el filtro de Kalman de dos estados (posición y velocidad) en régimen, con las ganancias fijas. Todo es
+ entero: la posición en Q8 de las unidades de `leerLinea()` y la velocidad en Q8 por tick de `TIEMPO_TIMER`.
+ - Con `-D OBSERVADOR` el término D de `calculo_pid()` y `calculo_pid_fijo()` usa la velocidad estimada en vez
+   de la diferencia de errores entre ticks, que amplifica el ruido de la barra.
+ - Si el tick se atrasa, la predicción usa el tiempo real desde el cuadro anterior (la diferencia finita
+   divide siempre por `FIXED_DT_S`). Si no llegó un cuadro nuevo (con `DOBLE_NUCLEO`), el control usa la
+   posición predicha en vez de repetir la última.
+ Sin la bandera el módulo se compila igual (lo usa `native_observador`), pero la FSM no lo llama.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+#ifndef OBSERVADOR_ALFA
+  /** @brief Ganancia de posición por defecto; se cambia con `-D OBSERVADOR_ALFA=...`. */
+  #define OBSERVADOR_ALFA 0.9f
+#endif
+
+#ifndef OBSERVADOR_BETA
+  /**
+   @brief Ganancia de velocidad por defecto; se cambia con `-D OBSERVADOR_BETA=...`.
+   @details Con alfa = beta = 1 el observador es la diferencia finita (dividida por el tiempo real). Con ganancias
+   más bajas la velocidad tiene menos ruido pero más retardo: con 0.9 / 0.8 las vueltas del simulador salen ~0.5%
+   más lentas que con 1 / 1, y ninguna combinación probada las acorta.
+   */
+  #define OBSERVADOR_BETA 0.8f
+#endif
+
+static_assert(OBSERVADOR_ALFA > 0 && OBSERVADOR_ALFA <= 1 && OBSERVADOR_BETA > 0 && OBSERVADOR_BETA < 2,
+              "OBSERVADOR_ALFA debe estar en (0, 1] y OBSERVADOR_BETA en (0, 2)");
+
+/** @brief Bits fraccionarios de la posición y la velocidad estimadas. */
+static const uint8_t OBSERVADOR_Q = 8;
+
+/** @brief Bits fraccionarios de las ganancias alfa y beta. */
+static const uint8_t OBSERVADOR_Q_GANANCIA = 16;
+
+/** @brief Hueco máximo entre cuadros que se predice; con uno mayor el observador arranca de nuevo. */
+static const uint32_t OBSERVADOR_HUECO_MAX_US = 50000;
+
+/**
+ @struct EstadoObservador
+ @brief Estimación actual del observador.
+ */
+struct EstadoObservador {
+    int32_t posicion;       ///< Posición estimada en Q8 (0 a 7000 << 8).
+    int32_t velocidad;      ///< Velocidad estimada en Q8 por tick de `TIEMPO_TIMER` (positiva = hacia 7000).
+    uint32_t instante_us;   ///< Marca de tiempo del último cuadro incorporado.
+    bool valido;            ///< false hasta el primer cuadro con línea (y tras perderla).
+};
+
+/**
+ @brief Incorpora un cuadro y devuelve la posición que debe usar el control.
+ @details Si el cuadro es nuevo corrige la estimación y devuelve @p posicion. Si es el mismo que el anterior
+ (misma marca de tiempo) devuelve la posición predicha para el instante actual. Con la línea perdida
+ invalida la estimación y devuelve @p posicion (el extremo del último lado visto): el cuadro siguiente con
+ línea arranca de nuevo con velocidad 0, igual que tras un hueco mayor a `OBSERVADOR_HUECO_MAX_US`.
+ @param posicion Posición entregada por `lineaActual()`.
+ @param instante_us Marca de tiempo del cuadro (ver `instanteLinea()`).
+ @param enLinea false si el cuadro no vio la línea.
+ @return uint16_t Posición para el tick (0 a 7000).
+ */
+uint16_t observarLinea(uint16_t posicion, uint32_t instante_us, bool enLinea);
+
+/**
+ @brief Posición predicha para un instante, con la última estimación.
+ @details El horizonte se limita a `OBSERVADOR_HUECO_MAX_US` y el resultado a 0-7000.
+ @param instante_us Instante de la predicción (`halMicros()`).
+ @return uint16_t Posición predicha, o la última estimada si el observador no es válido.
+ */
+uint16_t predecirLinea(uint32_t instante_us);
+
+/**
+ @brief Estimación completa del observador.
+ @return const EstadoObservador& Posición y velocidad en Q8, instante y validez.
+ */
+const EstadoObservador& estadoObservador();
+
+/**
+ @brief Velocidad estimada de la línea en Q8 por tick, para el término D del PID.
+ @return int32_t Velocidad (0 si el observador no es válido).
+ */
+int32_t velocidadLinea();
+
+/**
+ @brief Cambia las ganancias del observador (las de compilación son `OBSERVADOR_ALFA` y `OBSERVADOR_BETA`).
+ @param alfa Ganancia de posición, entre 0 y 1.
+ @param beta Ganancia de velocidad, entre 0 y 2 (estable con beta < 4 - 2 alfa).
+ @return void
+ */
+void fijarGananciasObservador(float alfa, float beta);
+
+/**
+ @brief Olvida la estimación: el próximo cuadro con línea arranca de nuevo.
+ @return void
+ */
+void reiniciarObservador();
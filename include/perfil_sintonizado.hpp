@@ -0,0 +1,19 @@
+/**
+ @file perfil_sintonizado.hpp
+ @brief Perfil de corredor generado por el sintonizador automático (test/sintonizador.cpp). No editar a mano.
+ @details Se usa compilando con `-D CORREDOR=SINTONIZADO`. Perfil de partida: NIGHTFALL.
+ Tiempo de 2 vueltas en el simulador: competencia 9.807 s, ovalo 8.299 s.
+ Regenerar con: pio run -e native_sintonizador && .pio/build/native_sintonizador/program NIGHTFALL
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+constexpr float    SINTONIZADO_KP          = 0.09530438f;   ///< Ganancia Proporcional.
+constexpr float    SINTONIZADO_KI          = 0.6059756f;    ///< Ganancia Integral.
+constexpr float    SINTONIZADO_KD          = 0.001932979f;  ///< Ganancia Derivativa.
+constexpr uint8_t  SINTONIZADO_BASE_SPEED  = 90;            ///< Velocidad crucero (0-100%).
+constexpr uint16_t SINTONIZADO_ZONA_MUERTA = 15;            ///< Zona muerta alrededor del setpoint.
+constexpr float    SINTONIZADO_KU          = 0.065f;        ///< Ku del perfil de partida (para TEST_PID).
+constexpr float    SINTONIZADO_TU          = 0.35f;         ///< Tu del perfil de partida.
@@ -5,25 +5,98 @@
  */
 
 #pragma once
-#include <Arduino.h>
+#include "hal.hpp"
 
 /**
  @var setpoint
  @brief Valor de referencia (punto de consigna) que representa la posición central sobre la línea.
  */
-extern uint16_t setpoint;
+extern HILO_LOCAL uint16_t setpoint;
 
 /**
  @var zonaMuerta
  @brief Rango de error dentro del cual el controlador no realiza correcciones para evitar oscilaciones innecesarias.
  */
-extern uint16_t zonaMuerta;
+extern HILO_LOCAL uint16_t zonaMuerta;
 
 /**
  @var baseSpeed
  @brief Velocidad crucero nominal de los motores cuando el error es mayor a la zona muerta.
  */
-extern uint8_t baseSpeed;
+extern HILO_LOCAL uint8_t baseSpeed;
+
+/**
+ @name Mapa de la pista (-D MAPA_PISTA)
+ @brief Velocidades del perfil en uso para `velocidadPlanificada()` (ver mapa.hpp).
+ @{
+ */
+extern HILO_LOCAL uint8_t velocidadRecta;     ///< Velocidad planificada lejos de las curvas (%).
+extern HILO_LOCAL uint8_t velocidadCurva;     ///< Velocidad planificada en la curva más cerrada (%).
+///@}
+
+/**
+ @name Gobernador de velocidad (-D GOBERNADOR)
+ @brief Parámetros del perfil en uso para `gobernarVelocidad()` (ver gobernador.hpp).
+ @{
+ */
+extern HILO_LOCAL uint8_t rectaGobernador;    ///< Velocidad base con error y variación nulos (%).
+extern HILO_LOCAL uint8_t curvaGobernador;    ///< Velocidad base con la carga máxima (%).
+extern HILO_LOCAL float subidaGobernador;     ///< Pendiente máxima de subida de la velocidad base (%/s).
+extern HILO_LOCAL float bajadaGobernador;     ///< Pendiente máxima de bajada de la velocidad base (%/s).
+///@}
+
+// ============================
+// PERFILES DE CORREDOR
+// ============================
+/** @brief Bandas de velocidad de la tabla de ganancias (ver `programarGanancias()`). */
+static const uint8_t BANDAS_PID = 5;
+
+/** @brief Velocidad base (%) de la primera banda. */
+static const uint8_t BANDA_VELOCIDAD_MIN = 50;
+
+/** @brief Velocidad base (%) entre bandas: la última es 50 + 4·10 = 90, el `maxSpeed` de la rampa. */
+static const uint8_t BANDA_PASO = 10;
+
+/**
+ @enum AntiWindup
+ @brief Cómo deja de crecer la integral cuando los motores saturan (con `-D PID_OPCIONES`).
+ */
+enum AntiWindup : uint8_t {
+    SIN_ANTIWINDUP,             ///< Integra siempre (como sin la bandera).
+    INTEGRACION_CONDICIONAL,    ///< No integra si el tick anterior saturó y el error empuja hacia el mismo lado.
+    RETROCALCULO,               ///< Descuenta de Ki·integral lo que la saturación recortó, con constante Tu/4.
+};
+
+/**
+ @struct PerfilCorredor
+ @brief Datos de sintonización de un perfil de corredor (ver `CORREDOR` en config.hpp).
+ */
+struct PerfilCorredor {
+    const char* nombre;   ///< Nombre del perfil.
+    uint8_t baseSpeed;    ///< Velocidad crucero (0-100%).
+    float Ku;             ///< Ganancia última.
+    float Tu;             ///< Periodo último en segundos.
+    uint8_t velocidadRecta;   ///< Mapa: velocidad planificada lejos de las curvas (0-100%).
+    uint8_t velocidadCurva;   ///< Mapa: velocidad planificada en la curva más cerrada (0-100%).
+    uint8_t rectaGobernador;  ///< Gobernador: velocidad base con error nulo (0-100%).
+    uint8_t curvaGobernador;  ///< Gobernador: velocidad base con la carga máxima (0-100%).
+    float subida;             ///< Gobernador: pendiente máxima de subida (%/s).
+    float bajada;             ///< Gobernador: pendiente máxima de bajada (%/s).
+    float KuBanda[BANDAS_PID];    ///< Ganancias por velocidad: Ku en 50, 60, 70, 80 y 90%.
+    float TuBanda[BANDAS_PID];    ///< Ganancias por velocidad: Tu (s) en 50, 60, 70, 80 y 90%.
+    AntiWindup antiWindup;        ///< Opciones del PID: anti-windup ante la saturación de los motores.
+    float topeIntegral;           ///< Opciones del PID: |Ki·integral| máximo (%); 0 = sin tope.
+    bool derivadaMedicion;        ///< Opciones del PID: D sobre la posición medida en vez del error.
+};
+
+/**
+ @var perfilesCorredor
+ @brief Tabla con todos los perfiles, indexada por `CORREDOR - 1` (NIGHTFALL, ARGENTUM, DIEGO).
+ */
+extern const PerfilCorredor perfilesCorredor[];
+
+/** @brief Cantidad de perfiles en `perfilesCorredor`. */
+extern const uint8_t cantPerfiles;
 
 // ============================
 // CONTROL PID - METODO Ziegler-Nichols
@@ -32,27 +105,146 @@ extern uint8_t baseSpeed;
 /**
  @name Parámetros de Sintonización
  @brief Constantes calculadas mediante el método de Ziegler-Nichols para estabilizar el sistema.
+ @details Ku y Tu son las del perfil compilado. Las ganancias arrancan con los valores de Ziegler-Nichols 
+ de ese perfil y pueden reasignarse en tiempo de ejecución (ver `aplicarPerfil()`).
  @{
  */
 extern const float Ku; ///< Ganancia última (Ultimate Gain).
 extern const float Tu; ///< Periodo de oscilación última (Ultimate Period).
 
-extern const float Kp; ///< Constante Proporcional.
-extern const float Ki; ///< Constante Integral.
-extern const float Kd; ///< Constante Derivativa.
+extern HILO_LOCAL float Kp; ///< Constante Proporcional.
+extern HILO_LOCAL float Ki; ///< Constante Integral.
+extern HILO_LOCAL float Kd; ///< Constante Derivativa.
+///@}
+
+/**
+ @name Opciones del PID (-D PID_OPCIONES)
+ @brief Las del perfil en uso (ver `PerfilCorredor`); sin la bandera no se usan.
+ @{
+ */
+extern HILO_LOCAL AntiWindup antiWindup;    ///< Estrategia ante la saturación de los motores.
+extern HILO_LOCAL float topeIntegral;       ///< |Ki·integral| máximo (%); 0 = sin tope.
+extern HILO_LOCAL bool derivadaMedicion;    ///< D sobre la posición medida en vez del error.
 ///@}
 
+/**
+ @brief Carga la velocidad crucero de un perfil, su gobernador y sus ganancias de Ziegler-Nichols (o solo P con `TEST_PID`).
+ @param perfil Perfil a aplicar, normalmente un elemento de `perfilesCorredor`.
+ @return void
+ */
+void aplicarPerfil(const PerfilCorredor& perfil);
+
 /**
  @brief Calcula la corrección necesaria para el sistema usando la fórmula PID. 
  @details La salida es la corrección que se suma o resta de la velocidad base de los motores. 
  La fórmula general aplicada es: 
  @f[ \text{Salida} = K_p \cdot \text{Error} + K_i \cdot \int \text{Error} \, dt + K_d \cdot \frac{d\text{Error}}{dt} @f]
+ Con `-D PID_OPCIONES` se aplican las del perfil: anti-windup (ver `saturacionPid()`), tope de
+ @f$ |K_i \int \text{Error}| @f$ en `topeIntegral` y derivada de la posición en vez del error (con
+ `OBSERVADOR` la derivada ya es la velocidad de la línea observada).
  @param pos Posición actual leída por los sensores.
  @param deltaTime Tiempo transcurrido (@f$ \Delta T @f$) desde la última ejecución en segundos.
  @return float Valor de corrección PID a aplicar a las velocidades de los motores.
  */
 float calculo_pid(uint16_t pos, float deltaTime);
 
+/**
+ @struct TerminosPID
+ @brief Aporte de cada término a la última corrección, en unidades de velocidad (%).
+ */
+struct TerminosPID {
+    float p;    ///< Kp·error.
+    float i;    ///< Ki·integral.
+    float d;    ///< Kd·derivada.
+};
+
+/**
+ @brief Términos de la última llamada a `calculo_pid()` o `calculo_pid_fijo()`.
+ @details Solo se guardan con `-D CAJA_NEGRA`; sin la bandera quedan en cero y el PID no hace trabajo extra.
+ @return const TerminosPID& Términos P, I y D.
+ */
+const TerminosPID& terminosPid();
+
+// ============================
+// PID EN PUNTO FIJO (-D PID_FIJO)
+// ============================
+/** @brief Bits fraccionarios de la salida de `calculo_pid_fijo()` y de las ganancias Kp y Kd/dt plegadas. */
+static const uint8_t PID_Q = 16;
+
+/** @brief Bits fraccionarios de la ganancia Ki·dt plegada (con dt corto Ki·dt es del orden de 1e-3). */
+static const uint8_t PID_Q_I = 28;
+
+/** @brief 1.0 en el formato de salida (Q16). */
+static const int32_t PID_UNO = (int32_t)1 << PID_Q;
+
+/**
+ @brief Diferencia máxima entre `calculo_pid_fijo()` y `calculo_pid()` en unidades de velocidad (%).
+ @details Proviene del redondeo de Kp y Kd/dt a Q16: a lo sumo 0.5/65536 por unidad de |error| + |Δerror|,
+ es decir menos de 0.09 en un salto de extremo a extremo. La verifica `test/prueba_pid_fijo.cpp` para
+ todos los perfiles. No se cumple si la salida satura en ±32767 (la de los motores satura mucho antes).
+ */
+static const float PID_TOLERANCIA = 0.1f;
+
+/**
+ @brief Misma ley de control que `calculo_pid()`, pero solo con aritmética entera.
+ @details Las ganancias llegan plegadas con el dt del timer: @f$ K_p @f$ y @f$ K_d/\Delta T @f$ en Q16 y
+ @f$ K_i \cdot \Delta T @f$ en Q28, así que el tick no divide ni convierte a punto flotante. Para el perfil
+ compilado se calculan en compilación; `aplicarPerfil()` y `plegarGanancias()` las recalculan.
+ Con `-D PID_FIJO` el estado CONTROL usa esta función en lugar de `calculo_pid()`.
+ @param pos Posición actual leída por los sensores.
+ @return int32_t Corrección en Q16 (dividir por `PID_UNO` para obtener la de `calculo_pid()`).
+ */
+int32_t calculo_pid_fijo(uint16_t pos);
+
+/**
+ @brief Recalcula las ganancias enteras de `calculo_pid_fijo()` a partir de Kp, Ki, Kd y `FIXED_DT_S`.
+ @details Llamar después de modificar Kp, Ki o Kd directamente. Kp y Kd/dt se saturan al máximo
+ que no desborda 32 bits con el error más grande posible (7000).
+ @return void
+ */
+void plegarGanancias();
+
+// ============================
+// OPCIONES DEL PID (-D PID_OPCIONES)
+// ============================
+/**
+ @brief Informa al PID la corrección que los motores realmente aplicaron en el tick.
+ @details Con `INTEGRACION_CONDICIONAL` guarda hacia qué lado se recortó, para no integrar en el próximo tick
+ si el error sigue empujando hacia ese lado. Con `RETROCALCULO` descuenta de Ki·integral la fracción
+ @f$ \Delta T / T_t @f$ de lo recortado (@f$ T_t = T_u/4 = \sqrt{T_i T_d} @f$ de Ziegler-Nichols), en
+ `integral` y en la suma de errores de `calculo_pid_fijo()`. Con `-D PID_OPCIONES` la FSM la llama en cada
+ tick de CONTROL después de `controlMotores()`, con la de `correccionAplicada()`; en la zona muerta
+ (`SETPOINT`) pasa `aplicada = pedida`, porque ahí no hubo recorte.
+ @param pedida Corrección calculada por el PID (%).
+ @param aplicada Corrección que quedó después de limitar cada motor a ±`maxSpeed` (%).
+ @return void
+ */
+void saturacionPid(float pedida, float aplicada);
+
+// ============================
+// GANANCIAS POR VELOCIDAD (-D PID_BANDAS)
+// ============================
+/**
+ @brief Ajusta Kp, Ki y Kd (y las plegadas de `calculo_pid_fijo()`) a la velocidad base comandada.
+ @details El perfil trae un par Ku/Tu por banda (`KuBanda`, `TuBanda`) y `aplicarPerfil()` arma la tabla de
+ ganancias de Ziegler-Nichols de cada banda, en flotante y plegadas. Acá se interpola linealmente entre
+ las dos bandas vecinas: un índice y una fracción, sin búsqueda, así que el costo es constante. Fuera de
+ 50-90% queda en la banda del extremo. Al cambiar Ki la integral se reescala por Ki anterior / Ki nueva,
+ así el término integral (Ki·integral) no salta: el cambio de banda no golpea los motores.
+ Con `-D PID_BANDAS` la FSM la llama en cada tick de CONTROL con `velocidadBase()` antes del PID.
+ @param velocidad Velocidad base de los motores (%).
+ @return void
+ */
+void programarGanancias(float velocidad);
+
+/**
+ @brief Lleva Kp, Ki y Kd en uso a todas las bandas: con `PID_BANDAS` quedan fijas a cualquier velocidad.
+ @details Llamar después de asignar las ganancias a mano (el sintonizador, el A/B del reproductor); hasta el
+ próximo `aplicarPerfil()` la tabla del perfil no se usa.
+ @return void
+ */
+void aplanarBandas();
+
 /**
  @brief Resetea las variables internas del controlador (error acumulado y error anterior).
  @details Es fundamental llamar a esta función al reiniciar la marcha o tras una parada para evitar el "Windup" de la parte integral.
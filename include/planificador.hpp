@@ -0,0 +1,67 @@
+/**
+ @file planificador.hpp
+ @brief Planificador cooperativo con control de tasa para la máquina de estados.
+ @details Cada estado de la FSM declara el periodo de su acción (ver `periodoEstado()`). El planificador
+ libera la FSM en una grilla fija de ese periodo, evalúa la entrada (SETPOINT, RUN), ejecuta `transicionar()`
+ y entre liberaciones duerme con `halDormirHasta()` en lugar de girar en `loop()`. Por estado registra
+ ejecuciones, tiempo de ejecución, demora de arranque y vencimientos perdidos; además acumula el tiempo ocioso.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+#include "fsm.hpp"
+
+/**
+ @struct EstadisticasTarea
+ @brief Mediciones del planificador para la acción de un estado.
+ */
+struct EstadisticasTarea {
+    uint32_t ejecuciones;       ///< Veces que se ejecutó la acción.
+    uint32_t perdidas;          ///< Ejecuciones que terminaron después de la liberación siguiente.
+    uint32_t ultimo_us;         ///< Duración de la última ejecución.
+    uint32_t maximo_us;         ///< Duración máxima.
+    uint64_t total_us;          ///< Suma de duraciones (media = total_us / ejecuciones).
+    uint32_t demoraMax_us;      ///< Mayor demora entre la liberación y el comienzo de la ejecución.
+};
+
+/**
+ @brief Reinicia las estadísticas y programa la primera liberación en el instante actual.
+ @details Llamar al final de `setup()`, con la FSM ya en su estado inicial.
+ @return void
+ */
+void iniciarPlanificador();
+
+/**
+ @brief Ejecuta la FSM si llegó su liberación. No bloquea.
+ @details Tras cada ejecución la próxima liberación es la anterior más el periodo del estado resultante;
+ si el estado cambió, se cuenta desde el comienzo de esta ejecución. Si la ejecución terminó pasada la
+ próxima liberación, se registra un vencimiento perdido y se saltean las liberaciones vencidas.
+ @return uint32_t Instante (`halMicros()`) de la próxima liberación.
+ */
+uint32_t pasoPlanificador();
+
+/**
+ @brief Cuerpo de `loop()`: `pasoPlanificador()` y luego duerme hasta la próxima liberación.
+ @return void
+ */
+void ejecutarPlanificador();
+
+/**
+ @brief Estadísticas de la acción de un estado.
+ @param estado S, A, C, P o T.
+ @return const EstadisticasTarea& Mediciones acumuladas desde `iniciarPlanificador()`.
+ */
+const EstadisticasTarea& estadisticasTarea(int estado);
+
+/**
+ @brief Tiempo pasado en `halDormirHasta()` desde `iniciarPlanificador()`.
+ @return uint64_t Microsegundos ociosos.
+ */
+uint64_t tiempoOcioso();
+
+/**
+ @brief Imprime por serial una línea por estado con sus estadísticas y el porcentaje de tiempo ocioso.
+ @return void
+ */
+void imprimirPlanificador();
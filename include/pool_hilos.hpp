@@ -0,0 +1,83 @@
+/**
+ @file pool_hilos.hpp
+ @brief Pool de hilos con robo de tareas (work-stealing) para las herramientas de host.
+ @details Cada hilo tiene su propia cola: toma tareas del final de la suya (LIFO) y, cuando se queda
+ sin trabajo, roba del principio de la cola de otro hilo. Como el estado del firmware es `HILO_LOCAL`,
+ cada tarea puede correr un `Simulador` completo sin interferir con las demás.
+ @author Legion de Ohm
+ */
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ @class PoolHilos
+ @brief Ejecuta tareas independientes repartidas entre todos los núcleos.
+ */
+class PoolHilos {
+public:
+    /** @brief Función sin argumentos que ejecuta un hilo del pool. */
+    typedef std::function<void()> Tarea;
+
+    /**
+     @brief Lanza los hilos de trabajo.
+     @param hilos Cantidad de hilos (0 = uno por núcleo).
+     */
+    explicit PoolHilos(unsigned hilos = 0);
+
+    /** @brief Espera las tareas pendientes y detiene los hilos. */
+    ~PoolHilos();
+
+    PoolHilos(const PoolHilos&) = delete;
+    PoolHilos& operator=(const PoolHilos&) = delete;
+
+    /**
+     @brief Agrega una tarea. Desde un hilo del pool va a su propia cola; desde afuera, en ronda.
+     @param tarea Trabajo a ejecutar.
+     */
+    void encolar(Tarea tarea);
+
+    /** @brief Bloquea hasta que todas las tareas encoladas hayan terminado. */
+    void esperar();
+
+    /** @brief Cantidad de hilos de trabajo. */
+    unsigned hilos() const { return (unsigned)_hilos.size(); }
+
+    /** @brief Tareas que un hilo tomó de la cola de otro desde la creación del pool. */
+    uint64_t robos() const { return _robos.load(); }
+
+private:
+    /** @brief Cola de un hilo, protegida por su propio mutex. */
+    struct Cola {
+        std::mutex m;
+        std::deque<Tarea> tareas;
+    };
+
+    std::vector<std::unique_ptr<Cola>> _colas;
+    std::vector<std::thread> _hilos;
+
+    std::mutex _m;                          ///< Protege las esperas de `_hayTrabajo` y `_terminado`.
+    std::condition_variable _hayTrabajo;    ///< Despierta hilos dormidos al encolar.
+    std::condition_variable _terminado;     ///< Despierta a `esperar()` cuando no quedan tareas.
+
+    std::atomic<size_t> _enCola{0};         ///< Tareas encoladas todavía no tomadas.
+    std::atomic<size_t> _pendientes{0};     ///< Tareas encoladas todavía no terminadas.
+    std::atomic<unsigned> _siguiente{0};    ///< Cola destino de la próxima tarea externa.
+    std::atomic<uint64_t> _robos{0};
+    bool _fin = false;
+
+    void _trabajar(unsigned id);
+    bool _tomar(unsigned id, Tarea& tarea);
+};
+
+#endif
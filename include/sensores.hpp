@@ -5,7 +5,8 @@
  */
 
 #pragma once
-#include <Arduino.h>
+#include "hal.hpp"
+#include "muestreo.hpp"
 
 // ===================================
 // TIPOS DE DATOS Y CONSTANTES
@@ -23,15 +24,33 @@ enum Linea {
  @var position
  @brief Posición calculada de la línea. Es el valor de la salida del proceso (PV), usado como entrada para el controlador PID. Este valor se normaliza (ej. 0 a 4000) donde el centro es el punto de referencia (`setpoint`).
  */
-extern uint16_t position;
+extern HILO_LOCAL uint16_t position;
+
+/**
+ @struct CalibracionSensores
+ @brief Umbrales de calibración de la barra (crudos, índice 0 = S8).
+ */
+struct CalibracionSensores {
+    uint16_t minimo[CANT_SENSORES];     ///< Lectura sobre el fondo más oscuro visto por cada sensor.
+    uint16_t maximo[CANT_SENSORES];     ///< Lectura más clara vista por cada sensor.
+};
+
+/**
+ @struct EstimacionLinea
+ @brief Resultado completo de la última estimación de la posición.
+ */
+struct EstimacionLinea {
+    uint32_t posicionFina;  ///< Posición en 1/16 de la unidad de `leerLinea()` (0 a 112000).
+    uint16_t confianza;     ///< 0-1000. Con `POSICION_PICO`: altura del pico menos la lectura fuera de él; sin la bandera: 1000 o 0 (línea perdida).
+};
 
 // ===================================
 // PROTOTIPOS DE FUNCIONES
 // ===================================
 /**
- @brief Inicializa el objeto QTRSensors con los pines de entrada/salida.
- @param sensorPins Array que contiene los pines GPIO a los que están conectados los sensores.
- @param SensorCount Número total de sensores a inicializar.
+ @brief Configura los pines analógicos de la barra QTR-8A y deja la barra calibrada.
+ @details Usa la calibración guardada en la memoria no volátil si es válida. Si no hay una, o si `BTN_STOP`
+ está apretado al encender, ejecuta `calibrarSensores()` y guarda el resultado.
  @return void
  */
 void setupSensores();
@@ -43,8 +62,83 @@ void setupSensores();
 void calibrarSensores();
 
 /**
- @brief Lee los sensores y calcula la posición ponderada de la línea. Utiliza la función `readLine()` de la librería QTR para devolver un valor normalizado que indica el desplazamiento lateral respecto al centro del array.
+ @brief Descarta la calibración, la última posición vista de la línea y el historial de los filtros.
+ @details Tras llamarla, la próxima `calibrarSensores()` parte de cero. Usado por el simulador en host.
+ @return void
+ */
+void reiniciarSensores();
+
+/**
+ @brief Copia la calibración en uso.
+ @param cal Calibración de salida.
+ @return bool false si todavía no se calibró (y @p cal no se modifica).
+ */
+bool calibracionSensores(CalibracionSensores& cal);
+
+/**
+ @brief Reemplaza la calibración sin leer la barra (por ejemplo, para reproducir un registro).
+ @param cal Umbrales a usar.
+ @return void
+ */
+void fijarCalibracion(const CalibracionSensores& cal);
+
+/**
+ @brief Carga la calibración guardada con `guardarCalibracion()`.
+ @details Rechaza el bloque si falta, si es de otra versión, si no coincide la suma de verificación o si algún
+ sensor tiene mínimo mayor o igual al máximo. En ese caso la calibración en uso no cambia.
+ @return bool true si la calibración quedó fijada.
+ */
+bool cargarCalibracion();
+
+/**
+ @brief Guarda la calibración en uso en la memoria no volátil, con versión y suma de verificación.
+ @details Escribe en flash: se llama desde `setupSensores()`, nunca desde el lazo de control.
+ @return bool false si todavía no se calibró o no se pudo escribir.
+ */
+bool guardarCalibracion();
+
+/**
+ @brief Normaliza un cuadro crudo a 0-1000 con la calibración en uso (sin invertir).
+ @details Da exactamente `(crudo - min) * 1000 / (max - min)` saturado, como `QTRSensors::readCalibrated()`,
+ con recíprocos por sensor precalculados al calibrar: en el tick solo hay multiplicaciones y desplazamientos.
+ @param crudo Lecturas crudas (índice 0 = S8).
+ @param valores Lecturas normalizadas de salida; puede ser el mismo array que @p crudo.
+ @return void
+ */
+void normalizarCuadro(const uint16_t *crudo, uint16_t *valores);
+
+/**
+ @brief Lee los sensores y calcula la posición ponderada de la línea. Replica el cálculo de `readLine()` de la librería QTR para devolver un valor normalizado que indica el desplazamiento lateral respecto al centro del array.
  @return uint16_t Posición calculada de la línea (ej. 0 a 4000).
  */
 uint16_t leerLinea();
 
+/**
+ @brief Estima la posición de la línea a partir de un cuadro normalizado (el paso final de `leerLinea()`).
+ @details Por defecto es el promedio ponderado de `readLineBlack/readLineWhite()` de QTRSensors. Con
+ `-D POSICION_PICO` ajusta una parábola al sensor de mayor lectura y sus vecinos (ver sensores.cpp).
+ Actualiza `lineaDetectada()`, `estimacionLinea()` y el lado de la última posición vista.
+ @param valores Lecturas normalizadas 0-1000, sin invertir (índice 0 = S8).
+ @param invertir true para línea blanca.
+ @return uint16_t Posición entre 0 y 7000.
+ */
+uint16_t estimarPosicion(const uint16_t *valores, bool invertir);
+
+/**
+ @brief Posición con resolución fina y confianza de la última `leerLinea()`.
+ @return const EstimacionLinea& Estimación completa.
+ */
+const EstimacionLinea& estimacionLinea();
+
+/**
+ @brief Indica si la última `leerLinea()` vio la línea en algún sensor (lectura normalizada mayor a 200).
+ @details Cuando es false, `leerLinea()` devolvió el extremo (0 o 7000) del lado donde se vio la línea por última vez.
+ @return bool true si hay línea bajo la barra.
+ */
+bool lineaDetectada();
+
+/**
+ @brief Último cuadro crudo adquirido por `leerLinea()` o por la calibración.
+ @return const CuadroSensores& Lecturas crudas con la marca de tiempo y la duración de la adquisición.
+ */
+const CuadroSensores& ultimoCuadro();
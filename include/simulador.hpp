@@ -0,0 +1,187 @@
+/**
+ @file simulador.hpp
+ @brief Simulador en lazo cerrado (solo host) del seguidor de línea: pista 2D, chasis diferencial, respuesta de los motores al duty del DRV8833 y reflectancia de la barra QTR-8A.
+ @details El simulador no reimplementa el control: ejecuta el `loop()` real (`pasoPlanificador()`, que
+ libera `transicionar()` con las acciones de fsm.cpp según el periodo de cada estado) sobre el backend host
+ de la HAL. En cada paso lee el enrutamiento y duty de los canales ledc para obtener el comando de cada
+ motor, integra la dinámica y expone las lecturas de los 8 sensores como fuente analógica.
+ @author Legion de Ohm
+ */
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include <vector>
+#include "hal.hpp"
+
+// ============================
+// PISTA
+// ============================
+/**
+ @struct PuntoPista
+ @brief Punto de la línea central de la pista, en metros.
+ */
+struct PuntoPista {
+    float x;    ///< Coordenada X [m].
+    float y;    ///< Coordenada Y [m].
+};
+
+/**
+ @class Pista
+ @brief Pista cerrada descripta por tramos rectos y curvas, muestreada como polilínea.
+ */
+class Pista {
+public:
+    /**
+     @brief Crea una pista vacía que arranca en el origen apuntando hacia +X.
+     @param ancho Ancho de la línea en metros.
+     @param paso Distancia entre puntos de la polilínea en metros.
+     */
+    Pista(float ancho = 0.019f, float paso = 0.002f);
+
+    /** @brief Agrega un tramo recto de @p largo metros. */
+    void recta(float largo);
+
+    /** @brief Agrega un arco de @p radio metros y @p angulo grados (positivo = izquierda). */
+    void curva(float radio, float angulo);
+
+    /** @brief Repite los tramos cargados rotados 180°, cerrando la pista si la mitad gira 180°. */
+    void espejarMitad();
+
+    /** @brief Ovalo de 2 rectas de 1.5 m y 2 curvas de 0.4 m de radio. */
+    static Pista ovalo();
+
+    /** @brief Pista tipo competencia con curvas cerradas (r = 0.2 m) y una S. */
+    static Pista competencia();
+
+    /** @brief Esquinas casi en ángulo recto (r = 2 cm) de 90° y 135°: la barra pierde la línea en cada una. */
+    static Pista esquinas();
+
+    std::vector<PuntoPista> puntos;   ///< Polilínea de la línea central.
+    float ancho;                      ///< Ancho de la línea [m].
+    float paso;                       ///< Separación entre puntos [m].
+
+    /** @brief Largo total de la pista [m]. */
+    float largo() const { return puntos.size() * paso; }
+
+private:
+    float _x, _y, _rumbo;                  ///< Pose del extremo actual de la pista.
+    std::vector<float> _tramos;            ///< Tramos cargados (pares tipo/valor) para espejarMitad().
+
+    void _agregarPunto();
+};
+
+// ============================
+// ROBOT
+// ============================
+/**
+ @struct ParametrosRobot
+ @brief Parámetros físicos del chasis, los motores y la barra de sensores.
+ */
+struct ParametrosRobot {
+    float trocha = 0.12f;             ///< Distancia entre ruedas [m].
+    float velocidadMax = 1.6f;        ///< Velocidad de rueda con duty 100% [m/s].
+    float dutyMuerto = 0.08f;         ///< Duty mínimo que vence la fricción estática (0-1).
+    float tauMotor = 0.04f;           ///< Constante de tiempo de la rueda con el puente activo [s].
+    float tauLibre = 0.15f;           ///< Constante de tiempo en rueda libre (ambas entradas en LOW) [s].
+    float aceleracionLateralMax = 8;  ///< Límite de adherencia lateral [m/s^2].
+    float distanciaBarra = 0.08f;     ///< Distancia del eje de ruedas a la barra QTR [m].
+    float pasoSensores = 0.009525f;   ///< Separación entre sensores de la QTR-8A [m].
+    float sigmaSensor = 0.003f;       ///< Dispersión del área vista por cada sensor [m].
+    uint16_t adcBlanco = 250;         ///< Lectura del ADC sobre superficie blanca.
+    uint16_t adcNegro = 3900;         ///< Lectura del ADC sobre superficie negra.
+    uint16_t ruidoAdc = 40;           ///< Amplitud del ruido del ADC (cuentas, triangular).
+    uint32_t periodoLoopUs = 1000;    ///< Duración de una iteración de `loop()` en el robot [us].
+    uint32_t semilla = 1;             ///< Semilla del generador de ruido.
+};
+
+// ============================
+// RESULTADOS
+// ============================
+/** @brief Máximo de vueltas registradas por carrera. */
+static const uint8_t MAX_VUELTAS = 8;
+
+/**
+ @struct ResultadoCarrera
+ @brief Métricas de una carrera simulada.
+ */
+struct ResultadoCarrera {
+    uint8_t vueltas = 0;                ///< Vueltas completadas.
+    float tiempoVuelta[MAX_VUELTAS];    ///< Tiempo de cada vuelta [s].
+    float rmsError = 0;                 ///< RMS de `position - setpoint` en los ticks de control.
+    float saturacion = 0;               ///< Fracción de ticks en CONTROL con algún motor en ±maxSpeed.
+    uint32_t perdidasLinea = 0;         ///< Veces que la barra quedó completamente fuera de la línea.
+    uint32_t ticks = 0;                 ///< Ticks de control (TIEMPO_TIMER) simulados con RUN activo.
+    float tiempoSimulado = 0;           ///< Tiempo simulado desde el RUN [s].
+    bool fueraDePista = false;          ///< La carrera se abortó por salir de la pista.
+};
+
+/**
+ @brief Observador opcional llamado en cada tick de control con el estado actual de la FSM.
+ @details Permite a los programas de prueba registrar trazas sin modificar el simulador.
+ */
+typedef void (*ObservadorTick)(uint32_t tick, int estado, void* contexto);
+
+// ============================
+// SIMULADOR
+// ============================
+/**
+ @class Simulador
+ @brief Ejecuta el firmware real contra el modelo físico, más rápido que el tiempo real.
+ */
+class Simulador {
+public:
+    /**
+     @param pista Pista sobre la que se corre (debe vivir mientras dure el simulador).
+     @param robot Parámetros físicos del robot.
+     */
+    Simulador(const Pista& pista, const ParametrosRobot& robot = ParametrosRobot());
+
+    /**
+     @brief Reinicia HAL y firmware, calibra sensores barriendo la línea, presiona RUN y corre.
+     @param vueltas Vueltas a completar (máximo MAX_VUELTAS).
+     @param tiempoMax Tiempo simulado máximo desde el RUN [s].
+     @return ResultadoCarrera Métricas de la carrera.
+     */
+    ResultadoCarrera correr(uint8_t vueltas, float tiempoMax);
+
+    /** @brief Registra un observador de ticks (nullptr para quitarlo). */
+    void observar(ObservadorTick observador, void* contexto) { _observador = observador; _contexto = contexto; }
+
+    /** @brief Distancia con signo del centro de la barra a la línea [m] (positivo = línea a la izquierda). */
+    float desvioBarra() const { return _desvioBarra; }
+
+    /** @brief Velocidad de avance actual del robot [m/s]. */
+    float velocidad() const { return 0.5f * (_vIzq + _vDer); }
+
+    /** @brief Índice en `Pista::puntos` del punto más cercano al centro del eje. */
+    uint32_t puntoPista() const { return _idxCentro; }
+
+private:
+    const Pista& _pista;
+    ParametrosRobot _robot;
+
+    float _x, _y, _rumbo;               ///< Pose del centro del eje [m, m, rad].
+    float _vIzq, _vDer;                 ///< Velocidad de cada rueda [m/s].
+    uint32_t _idxCentro;                ///< Punto de pista más cercano al centro del eje.
+    uint32_t _idxSensor[8];             ///< Punto de pista más cercano a cada sensor.
+    uint16_t _lectura[8];               ///< Lectura del ADC sin ruido de cada sensor (índice 0 = S8).
+    float _cubierto[8];                 ///< Fracción del área de cada sensor sobre la línea.
+    float _desvioBarra;                 ///< Desvío con signo del centro de la barra.
+    bool _calibrando;                   ///< Durante la calibración la barra barre la línea.
+    uint32_t _lecturasCalibracion;      ///< Conversiones hechas durante la calibración.
+    uint32_t _ruido;                    ///< Estado del generador xorshift.
+    ObservadorTick _observador;
+    void* _contexto;
+
+    void _ubicarEnSalida(float desvioLateral);
+    void _pasoFisica(float dt);
+    void _actualizarSensores();
+    float _comandoMotor(uint8_t pinIN1, uint8_t pinIN2) const;
+    uint16_t _leer(uint8_t pin);
+
+    static uint16_t _fuente(uint8_t pin);
+};
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ @file sintonia.hpp
+ @brief Sintonía por relé (Åström–Hägglund) en la pista: identifica Ku y Tu sin subir Kp a mano.
+ @details Reemplaza la búsqueda con `TEST_PID`. En el estado SINTONIA la FSM no corre el PID: la corrección
+ es un relé con histéresis sobre el error, @f$ \pm d @f$ (`amplitudRele`) alrededor de `baseSpeed`, que
+ conmuta cuando el error pasa de @f$ \pm \varepsilon @f$ (`histeresisRele`). El lazo cae en un ciclo límite
+ cuyo período es, por el método de la función descriptiva, el período último del lazo:
+ - Período: entre dos conmutaciones hacia +d (el error cruza +ε subiendo), con la marca de tiempo de la
+   lectura (`instanteLinea()`).
+ - Amplitud: (máximo - mínimo) / 2 del error en el mismo ciclo, así una curva que corre el centro de la
+   oscilación no la agranda.
+ - Se descartan los primeros `SINTONIA_DESCARTE` ciclos (el transitorio del arranque) y se promedian los
+   `SINTONIA_CICLOS` siguientes; si el período más largo pasa en más de 1/`SINTONIA_DISPERSION` al más corto
+   el ciclo no es estable y se vuelve a promediar a partir del último.
+ - @f$ K_u = 4d / (\pi \sqrt{a^2 - \varepsilon^2}) @f$ en % por unidad de posición, como el Ku de los
+   perfiles, y las ganancias de Ziegler-Nichols que usa `aplicarPerfil()`: @f$ K_p = 0.6 K_u @f$,
+   @f$ K_i = 2 K_p / T_u @f$, @f$ K_d = K_p T_u / 8 @f$.
+ La histéresis atrasa el relé @f$ \arcsin(\varepsilon / a) @f$: el ciclo queda a una frecuencia algo menor que la
+ última, con Ku menor y Tu mayor (del lado seguro). Con d = 8% el ciclo queda en la parte lineal de la barra
+ (a ~150 en el simulador); con relés más grandes la amplitud pasa de un sensor y el ciclo cambia.
+ Si pasa `SINTONIA_TIEMPO_MAX_US` sin ciclo estable, o si la línea se pierde, la sintonía falla y el robot
+ se detiene. El Ku medido es el de la velocidad `baseSpeed` (con `PID_BANDAS`, el de esa banda).
+ El módulo se compila siempre (lo usan el simulador y `native_sintonia`); con `-D SINTONIA_RELE` el
+ firmware la pide por serial en STOP e imprime el resultado. Por defecto es solo identificación: 'u' y 'U'
+ informan y detienen el robot. Aplicar las ganancias medidas ('U') pide además `-D SINTONIA_APLICAR`: en el
+ simulador el relé mide un Tu de ~0.12 s contra los 0.35 s del perfil, y con ellas (Ziegler-Nichols o reglas
+ más suaves como Tyreus-Luyben) las vueltas salen más lentas que con las del perfil.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+/** @brief Ciclos del arranque que no se promedian. */
+static const uint8_t SINTONIA_DESCARTE = 1;
+
+/** @brief Ciclos promediados para Ku y Tu. */
+static const uint8_t SINTONIA_CICLOS = 3;
+
+/** @brief Dispersión de períodos admitida: el más largo no pasa al más corto en más de 1/4. */
+static const uint8_t SINTONIA_DISPERSION = 4;
+
+/** @brief Tiempo máximo de la sintonía (us): ~4 m de recta a 1.1 m/s. */
+static const uint32_t SINTONIA_TIEMPO_MAX_US = 4000000;
+
+/**
+ @enum FaseSintonia
+ @brief Estado del experimento.
+ */
+enum FaseSintonia : uint8_t {
+    SINTONIA_MIDIENDO,      ///< Relé activo, midiendo ciclos.
+    SINTONIA_LISTA,         ///< Ku, Tu y las ganancias calculadas.
+    SINTONIA_FALLIDA,       ///< Sin ciclo estable en `SINTONIA_TIEMPO_MAX_US`, o línea perdida.
+};
+
+/**
+ @struct ResultadoSintonia
+ @brief Medición del ciclo límite y ganancias que resultan.
+ */
+struct ResultadoSintonia {
+    FaseSintonia fase;      ///< Estado del experimento.
+    uint8_t ciclos;         ///< Ciclos completos medidos (incluidos los descartados).
+    float amplitud;         ///< Amplitud media del error (unidades de posición).
+    float Ku;               ///< Ganancia última (% por unidad de posición).
+    float Tu;               ///< Período último (s).
+    float Kp;               ///< Ziegler-Nichols: 0.6·Ku.
+    float Ki;               ///< Ziegler-Nichols: 2·Kp/Tu.
+    float Kd;               ///< Ziegler-Nichols: Kp·Tu/8.
+};
+
+/**
+ @name Parámetros del relé
+ @{
+ */
+extern HILO_LOCAL float amplitudRele;       ///< d: corrección del relé (%).
+extern HILO_LOCAL uint16_t histeresisRele;  ///< ε: |error| que hace conmutar el relé (unidades de posición).
+///@}
+
+/**
+ @brief Pide una sintonía para el próximo RUN (levanta la bandera `SINTONIA`).
+ @param aplicar true: al terminar usa las ganancias y sigue la carrera; false: solo las informa y se detiene.
+ @return void
+ */
+void pedirSintonia(bool aplicar);
+
+/**
+ @brief Empieza un experimento (al entrar en SINTONIA): borra las mediciones.
+ @return void
+ */
+void iniciarSintonia();
+
+/**
+ @brief Relé y detector de ciclos: una lectura de la línea.
+ @param pos Posición de la línea (0 a 7000).
+ @param instante_us Marca de tiempo de la lectura.
+ @return float Corrección del relé (±`amplitudRele`, %); 0 si el experimento ya terminó.
+ */
+float releSintonia(uint16_t pos, uint32_t instante_us);
+
+/**
+ @brief Termina el experimento como fallido (línea perdida, STOP).
+ @return void
+ */
+void abortarSintonia();
+
+/**
+ @brief Medición del último experimento.
+ @return const ResultadoSintonia& Fase, Ku, Tu y ganancias.
+ */
+const ResultadoSintonia& resultadoSintonia();
+
+/**
+ @brief true si el experimento en curso se pidió con `aplicar`.
+ @return bool Aplicar las ganancias al terminar.
+ */
+bool sintoniaAplica();
+
+/**
+ @brief Carga Kp, Ki y Kd de la sintonía (plegadas y en todas las bandas); sin sintonía lista no hace nada.
+ @return void
+ */
+void aplicarSintonia();
+
+/**
+ @brief Atiende un pedido por serial en STOP: 'u' pide una sintonía que informa, 'U' una que además aplica.
+ @details Sin `SINTONIA_APLICAR`, 'U' también pide una que solo informa.
+ @param c Caracter recibido.
+ @return void
+ */
+void comandoSintonia(char c);
+
+/**
+ @brief Imprime por serial la fase, Ku, Tu y las ganancias de Ziegler-Nichols.
+ @return void
+ */
+void imprimirSintonia();
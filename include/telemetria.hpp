@@ -0,0 +1,112 @@
+/**
+ @file telemetria.hpp
+ @brief Flujo binario de telemetría del tick de control (`-D TELEMETRIA`).
+ @details Reemplaza los `deb(Serial.printf(...))` del camino caliente: en lugar de formatear texto en
+ cada tick, ACEL, CONTROL y PERDIDO copian una trama de 16 bytes en un `AnilloSPSC` (sin bloqueos ni reserva de
+ memoria) y una tarea de baja prioridad (`halTareaFondo()`) la vacía por serial cuando el control
+ duerme. Si el anillo se llena, la trama se descarta y se cuenta; el hueco se ve en el número de
+ secuencia. Del lado de la PC, `decodificarTelemetria()` (usada por `test/decodificador_telemetria.cpp`)
+ resincroniza con el byte de sincronismo y la suma de verificación, así que el flujo puede mezclarse
+ con texto de `deb()`. Ambos extremos son little-endian.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include <cstddef>
+#include "hal.hpp"
+
+/** @brief Primer byte de cada trama. */
+static const uint8_t TELEMETRIA_SINCRO = 0xA5;
+
+/** @brief Capacidad del anillo en tramas (~380 ms de CONTROL con `TIEMPO_TIMER` de 6 ms). */
+static const uint32_t TELEMETRIA_TRAMAS = 64;
+
+/** @brief Espera de la tarea de vaciado entre pasos. */
+static const uint32_t TELEMETRIA_PERIODO_MS = 5;
+
+/**
+ @struct TramaTelemetria
+ @brief Una ejecución de ACEL, CONTROL o PERDIDO. Campos alineados a su tamaño: 16 bytes sin relleno.
+ */
+struct TramaTelemetria {
+    uint8_t  sincro;        ///< `TELEMETRIA_SINCRO`.
+    uint8_t  secuencia;     ///< Contador de tramas publicadas (los saltos son tramas descartadas).
+    uint16_t posicion;      ///< `position` (0-7000).
+    uint32_t instante_us;   ///< `halMicros()` al publicar; el dt es la diferencia entre tramas.
+    float    correccion;    ///< Salida del PID (0 en ACEL).
+    int8_t   motorIzq;      ///< Velocidad aplicada al motor izquierdo (%).
+    int8_t   motorDer;      ///< Velocidad aplicada al motor derecho (%).
+    uint8_t  estado;        ///< Estado de la FSM (A, C, P o T).
+    uint8_t  suma;          ///< Complemento de la suma de los 15 bytes anteriores.
+};
+
+static_assert(sizeof(TramaTelemetria) == 16, "La trama de telemetria debe ocupar 16 bytes");
+
+// ============================
+// DISPOSITIVO
+// ============================
+/**
+ @brief Crea la tarea de baja prioridad que vacía el anillo por serial. Se llama al final de `setup()`.
+ @return void
+ */
+void iniciarTelemetria();
+
+/**
+ @brief Arma una trama y la publica en el anillo (productor: el tick de control). No bloquea.
+ @param estado Estado de la FSM.
+ @param posicion Posición de la línea.
+ @param correccion Salida del PID.
+ @param motorIzq Velocidad del motor izquierdo.
+ @param motorDer Velocidad del motor derecho.
+ @return void
+ */
+void publicarTelemetria(uint8_t estado, uint16_t posicion, float correccion, int32_t motorIzq, int32_t motorDer);
+
+/**
+ @brief Saca la trama más antigua del anillo (consumidor).
+ @param trama Trama de salida.
+ @return bool false si el anillo está vacío.
+ */
+bool tomarTelemetria(TramaTelemetria& trama);
+
+/**
+ @brief Paso de la tarea de vaciado: escribe por serial las tramas que entran en el buffer de transmisión.
+ @return void
+ */
+void vaciarTelemetria();
+
+/**
+ @brief Tramas descartadas por anillo lleno desde el arranque.
+ @return uint32_t Cantidad.
+ */
+uint32_t tramasDescartadas();
+
+/**
+ @brief Vuelve a cero la secuencia, el contador de descartes y vacía el anillo.
+ @return void
+ */
+void reiniciarTelemetria();
+
+// ============================
+// DECODIFICACION (PC)
+// ============================
+/**
+ @brief Verifica el sincronismo y la suma de 16 bytes y los copia en una trama.
+ @param bytes Comienzo de la trama candidata (16 bytes).
+ @param trama Trama de salida (solo se escribe si es válida).
+ @return bool true si es una trama válida.
+ */
+bool validarTrama(const uint8_t* bytes, TramaTelemetria& trama);
+
+/** @brief Receptor de las tramas válidas de `decodificarTelemetria()`. */
+typedef void (*SalidaTelemetria)(const TramaTelemetria& trama, void* contexto);
+
+/**
+ @brief Recorre un flujo crudo y entrega cada trama válida; los bytes que no forman una se saltean de a uno.
+ @param datos Bytes recibidos.
+ @param n Cantidad de bytes.
+ @param salida Función llamada con cada trama.
+ @param contexto Puntero pasado a @p salida.
+ @return size_t Bytes consumidos; el resto (una trama incompleta) debe anteponerse al próximo bloque.
+ */
+size_t decodificarTelemetria(const uint8_t* datos, size_t n, SalidaTelemetria salida, void* contexto);
@@ -0,0 +1,100 @@
+/**
+ @file trazas.hpp
+ @brief Puntos de traza del tick de control con histogramas de cubetas fijas (`-D TRAZAS`).
+ @details Cada punto acumula en el dispositivo la duración, en ciclos de CPU (`halCiclos()`), de una etapa
+ del tick: demora entre la liberación del planificador y el comienzo de CONTROL, periodo real entre dos
+ CONTROL, `lineaActual()`, el cálculo del PID, los motores y el tick completo. Los histogramas tienen
+ 8 cubetas por potencia de dos (error relativo menor a 12.5%) y no reservan memoria en el tick.
+ Estando en STOP se vuelcan por serial al recibir 't' y se reinician con 'r'. Sin la bandera, las
+ llamadas quedan dentro de la macro `traza()` y no se compila nada.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include "hal.hpp"
+
+/**
+ @enum PuntoTraza
+ @brief Etapas medidas del tick de control.
+ */
+enum PuntoTraza : uint8_t {
+    TRAZA_DEMORA,       ///< Liberación del planificador → comienzo de `estadoControl()`.
+    TRAZA_PERIODO,      ///< Comienzo de un CONTROL → comienzo del siguiente (jitter del periodo).
+    TRAZA_LECTURA,      ///< `lineaActual()`.
+    TRAZA_PID,          ///< Cálculo de la corrección (flotante o `PID_FIJO`).
+    TRAZA_MOTORES,      ///< `controlMotores()` + `moverMotores()`.
+    TRAZA_TICK,         ///< `estadoControl()` completo.
+    CANT_TRAZAS
+};
+
+/** @brief Cubetas de 1 ciclo hasta 8 y luego 8 por potencia de dos hasta 2^24 ciclos (~70 ms a 240 MHz). */
+static const uint16_t CANT_CUBETAS = 176;
+
+/**
+ @struct Histograma
+ @brief Histograma de duraciones en ciclos.
+ */
+struct Histograma {
+    uint32_t cubetas[CANT_CUBETAS];   ///< Cantidad de muestras por cubeta (la última acumula el desborde).
+    uint32_t cantidad;                ///< Muestras registradas.
+    uint32_t minimo;                  ///< Menor muestra (exacta).
+    uint32_t maximo;                  ///< Mayor muestra (exacta).
+};
+
+/**
+ @brief Agrega una muestra a un histograma.
+ @param h Histograma.
+ @param ciclos Duración en ciclos.
+ @return void
+ */
+void registrarHistograma(Histograma& h, uint32_t ciclos);
+
+/**
+ @brief Percentil aproximado: límite superior de la cubeta que lo contiene, acotado por el máximo.
+ @param h Histograma.
+ @param p Fracción (0.5 = mediana, 0.99 = p99).
+ @return uint32_t Ciclos; 0 si el histograma está vacío.
+ */
+uint32_t percentilHistograma(const Histograma& h, float p);
+
+/**
+ @brief Registra la duración de una etapa medida desde @p inicio.
+ @param punto Etapa.
+ @param inicio Valor de `halCiclos()` al comenzar la etapa.
+ @return void
+ */
+void registrarTraza(PuntoTraza punto, uint32_t inicio);
+
+/**
+ @brief Registra una duración ya calculada (en ciclos).
+ @param punto Etapa.
+ @param ciclos Duración.
+ @return void
+ */
+void registrarDuracion(PuntoTraza punto, uint32_t ciclos);
+
+/**
+ @brief Histograma de una etapa.
+ @param punto Etapa.
+ @return const Histograma& Histograma acumulado desde el último reinicio.
+ */
+const Histograma& histogramaTraza(PuntoTraza punto);
+
+/**
+ @brief Vacía todos los histogramas.
+ @return void
+ */
+void reiniciarTrazas();
+
+/**
+ @brief Imprime por serial n, min, p50, p99 y max de cada etapa en microsegundos.
+ @return void
+ */
+void imprimirTrazas();
+
+/**
+ @brief Atiende un pedido por serial en STOP: 't' vuelca los histogramas, 'r' los reinicia.
+ @param c Caracter recibido.
+ @return void
+ */
+void comandoTrazas(char c);
@@ -0,0 +1,122 @@
+/**
+ @file adquisicion.cpp
+ @brief Implementación de la entrega de la posición de la línea al control.
+ @details Con `DOBLE_NUCLEO`, el productor (tarea del núcleo 0) es el único que toca el estado de
+ sensores.cpp una vez calibrado; el consumidor (control en el núcleo 1) solo lee el buzón. Así
+ la posición deja de ser una variable compartida entre núcleos.
+ @author Legion de Ohm
+ */
+
+#include "adquisicion.hpp"
+#include "sensores.hpp"
+#include "filtros.hpp"
+
+#ifdef DOBLE_NUCLEO
+
+#include "buzon_ultimo.hpp"
+
+/**
+ @brief Buzón entre la tarea de adquisición (productor) y el control (consumidor).
+ @details El productor lee sin pausa y el control toma una muestra por tick: cada cuadro reemplaza al
+ anterior, así la muestra entregada tiene a lo sumo un cuadro de antigüedad.
+ */
+static HILO_LOCAL BuzonUltimo<MuestraLinea> buzonLinea;
+
+/** @brief Última muestra tomada por el consumidor. */
+static HILO_LOCAL MuestraLinea ultima = {};
+
+/** @brief Antigüedad de `ultima` cuando se la entregó. */
+static HILO_LOCAL uint32_t edad_us = 0;
+
+/** @brief Muestras reemplazadas por una más nueva antes de que el control las tomara. */
+static HILO_LOCAL std::atomic<uint32_t> descartadas{0};
+
+/**
+ @brief Una iteración de la tarea de adquisición: lee la barra y publica la posición.
+ */
+static void pasoAdquisicion() {
+    MuestraLinea m;
+    m.posicion = leerLinea();
+    m.instante_us = ultimoCuadro().instante_us;
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) m.crudo[i] = ultimoCuadro().crudo[i];
+    m.enLinea = lineaDetectada();
+
+    if (!buzonLinea.publicar(m)) descartadas.fetch_add(1, std::memory_order_relaxed);
+}
+
+void iniciarAdquisicion() {
+    buzonLinea.vaciar();
+    descartadas.store(0, std::memory_order_relaxed);
+
+    // Primera muestra sincrónica: el control nunca arranca sin una posición válida
+    pasoAdquisicion();
+    buzonLinea.ultimo(ultima);
+    edad_us = 0;
+
+    halTareaNucleo(pasoAdquisicion, 0);
+}
+
+uint16_t lineaActual() {
+    if (buzonLinea.ultimo(ultima)) edad_us = halMicros() - ultima.instante_us;
+    return ultima.posicion;
+}
+
+const uint16_t* crudoLinea() {
+    return ultima.crudo;
+}
+
+uint32_t instanteLinea() {
+    return ultima.instante_us;
+}
+
+bool lineaVisible() {
+    return ultima.enLinea;
+}
+
+void descartarMuestras() {
+    buzonLinea.ultimo(ultima);
+}
+
+uint32_t muestrasDescartadas() {
+    return descartadas.load(std::memory_order_relaxed);
+}
+
+#else
+
+/** @brief Con la lectura en línea la muestra se usa en el mismo instante en que se toma. */
+static const uint32_t edad_us = 0;
+
+void iniciarAdquisicion() {}
+
+uint16_t lineaActual() {
+    return leerLinea();
+}
+
+const uint16_t* crudoLinea() {
+    return ultimoCuadro().crudo;
+}
+
+uint32_t instanteLinea() {
+    return ultimoCuadro().instante_us;
+}
+
+bool lineaVisible() {
+    return lineaDetectada();
+}
+
+/**
+ @details Lo viejo es el historial de la cadena de filtros: la carrera siguiente no arranca con los cuadros de la anterior.
+ */
+void descartarMuestras() {
+    if (FILTRO_ACTIVO) reiniciarFiltro();
+}
+
+uint32_t muestrasDescartadas() {
+    return 0;
+}
+
+#endif
+
+uint32_t edadLinea() {
+    return edad_us;
+}
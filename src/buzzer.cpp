@@ -4,7 +4,7 @@
  @author Legion de Ohm
  */
 
-#include <Arduino.h>
+#include "hal.hpp"
 #include "buzzer.hpp"
 #include "config.hpp"
 
@@ -24,8 +24,8 @@ Buzzer::Buzzer(uint8_t buzzerPin, uint8_t pwmChannel) {
  @param resolution Resolución en bits para el control del duty cycle.
  */
 void Buzzer::begin(uint16_t freq, uint8_t resolution) {
-  ledcSetup(channel, freq, resolution);
-  ledcAttachPin(pin, channel);
+  halPwmConfigurar(channel, freq, resolution);
+  halPwmAsociar(pin, channel);
 }
 
 /**
@@ -33,14 +33,14 @@ void Buzzer::begin(uint16_t freq, uint8_t resolution) {
  @param freq Frecuencia del tono en Hercios (Hz).
  */
 void Buzzer::play(uint16_t freq) {
-  ledcWriteTone(channel, freq);
+  halPwmTono(channel, freq);
 }
 
 /**
  @brief Detiene la generación de tono enviando una frecuencia de 0.
  */
 void Buzzer::stop() {
-  ledcWriteTone(channel, 0);
+  halPwmTono(channel, 0);
 }
 
 /**
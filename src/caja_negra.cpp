@@ -0,0 +1,138 @@
+/**
+ @file caja_negra.cpp
+ @brief Implementación de la caja negra de los últimos ticks.
+ @details Todo el módulo queda vacío sin `-D CAJA_NEGRA`.
+ @author Legion de Ohm
+ */
+
+#include "caja_negra.hpp"
+#include "config.hpp"
+
+#ifdef CAJA_NEGRA
+
+#include "adquisicion.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "sensores.hpp"
+#include <cstdio>
+
+/** @brief Registro circular. */
+static HILO_LOCAL CajaNegra caja;
+
+/** @brief Ticks registrados desde el último rearme (corre libre; se enmascara al indexar). */
+static HILO_LOCAL uint32_t escritos = 0;
+
+/** @brief Instante del registro anterior, para `dt_us`. */
+static HILO_LOCAL uint32_t anterior_us = 0;
+
+/** @brief Congelada desde la entrada en STOP. */
+static HILO_LOCAL bool congelada = false;
+
+/** @brief Término del PID en Q4, saturado a 16 bits. */
+static int16_t terminoQ4(float v) {
+    float q = v * (1 << CAJA_Q_TERMINOS);
+    return (int16_t)constrain(q, -32767.0f, 32767.0f);
+}
+
+// ============================
+// REGISTRO
+// ============================
+void registrarCajaNegra(uint8_t estado, uint16_t posicion, int32_t motorIzq, int32_t motorDer) {
+    if (congelada) return;
+
+    uint32_t ahora = halMicros();
+    uint32_t dt = escritos ? ahora - anterior_us : 0;
+    anterior_us = ahora;
+
+    uint32_t k = escritos++ & (CAJA_NEGRA_TICKS - 1);
+    const uint16_t* crudo = crudoLinea();
+    for (uint8_t s = 0; s < CANT_SENSORES; s++) caja.crudo[s][k] = crudo[s];
+
+    const TerminosPID& t = terminosPid();
+    caja.posicion[k] = posicion;
+    caja.dt_us[k] = dt < 65535 ? dt : 65535;
+    caja.p[k] = terminoQ4(t.p);
+    caja.i[k] = terminoQ4(t.i);
+    caja.d[k] = terminoQ4(t.d);
+    caja.motorIzq[k] = (int8_t)constrain(motorIzq, -127, 127);
+    caja.motorDer[k] = (int8_t)constrain(motorDer, -127, 127);
+    caja.banderas[k] = (estado & 0x03) | (SETPOINT << 2) | (RUN << 3);
+}
+
+void congelarCajaNegra() {
+    congelada = true;
+}
+
+void rearmarCajaNegra() {
+    escritos = 0;
+    congelada = false;
+}
+
+bool cajaNegraCongelada() {
+    return congelada;
+}
+
+// ============================
+// LECTURA
+// ============================
+uint32_t registrosCajaNegra() {
+    return escritos < CAJA_NEGRA_TICKS ? escritos : CAJA_NEGRA_TICKS;
+}
+
+RegistroCaja leerCajaNegra(uint32_t indice) {
+    uint32_t k = (escritos - registrosCajaNegra() + indice) & (CAJA_NEGRA_TICKS - 1);
+    const float escala = 1.0f / (1 << CAJA_Q_TERMINOS);
+
+    RegistroCaja r;
+    for (uint8_t s = 0; s < CANT_SENSORES; s++) r.crudo[s] = caja.crudo[s][k];
+    r.posicion = caja.posicion[k];
+    r.dt_us = caja.dt_us[k];
+    r.p = caja.p[k] * escala;
+    r.i = caja.i[k] * escala;
+    r.d = caja.d[k] * escala;
+    r.motorIzq = caja.motorIzq[k];
+    r.motorDer = caja.motorDer[k];
+    r.estado = caja.banderas[k] & 0x03;
+    r.setpoint = caja.banderas[k] & 0x04;
+    r.run = caja.banderas[k] & 0x08;
+    return r;
+}
+
+// ============================
+// VOLCADO
+// ============================
+/** @brief Destino por defecto del volcado. */
+static void escribirSerial(const char* linea) {
+    Serial.print(linea);
+}
+
+void volcarCajaNegra(void (*escribir)(const char* linea)) {
+    if (!escribir) escribir = escribirSerial;
+
+    char linea[160];
+    CalibracionSensores cal = {};
+    calibracionSensores(cal);
+    for (uint8_t extremo = 0; extremo < 2; extremo++) {
+        const uint16_t* v = extremo ? cal.maximo : cal.minimo;
+        snprintf(linea, sizeof(linea), "# %s,%u,%u,%u,%u,%u,%u,%u,%u\n", extremo ? "calMaximo" : "calMinimo",
+                 v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+        escribir(linea);
+    }
+
+    escribir("n,dt_us,estado,SP,RUN,S8,S7,S6,S5,S4,S3,S2,S1,posicion,P,I,D,motorIzq,motorDer\n");
+    uint32_t n = registrosCajaNegra();
+    for (uint32_t j = 0; j < n; j++) {
+        RegistroCaja r = leerCajaNegra(j);
+        snprintf(linea, sizeof(linea), "%u,%u,%c,%d,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.4f,%.4f,%.4f,%d,%d\n",
+                 (unsigned)j, r.dt_us, "SACP"[r.estado & 3], r.setpoint, r.run,
+                 r.crudo[0], r.crudo[1], r.crudo[2], r.crudo[3], r.crudo[4], r.crudo[5], r.crudo[6], r.crudo[7],
+                 r.posicion, r.p, r.i, r.d, r.motorIzq, r.motorDer);
+        escribir(linea);
+    }
+}
+
+void comandoCajaNegra(char c) {
+    if (c == 'c') volcarCajaNegra();
+}
+
+#endif
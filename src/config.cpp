@@ -51,12 +51,12 @@ const uint8_t motorPinSleep_Der = 16;  ///< Pin de habilitación (Sleep).
 // ============================
 /** @name Asignación de Pines Array QTR */
 ///@{
-const uint8_t S8 = 14;  ///< Sensor 8.
-const uint8_t S7 = 27;  ///< Sensor 7.
-const uint8_t S6 = 33;  ///< Sensor 6.
-const uint8_t S5 = 32;  ///< Sensor 5.
-const uint8_t S4 = 35;  ///< Sensor 4.
-const uint8_t S3 = 34;  ///< Sensor 3.
-const uint8_t S2 = 39;  ///< Sensor 2.
-const uint8_t S1 = 36;  ///< Sensor 1.
+const uint8_t S8 = 14;  ///< Sensor 8 (ADC2).
+const uint8_t S7 = 27;  ///< Sensor 7 (ADC2).
+const uint8_t S6 = 33;  ///< Sensor 6 (ADC1).
+const uint8_t S5 = 32;  ///< Sensor 5 (ADC1).
+const uint8_t S4 = 35;  ///< Sensor 4 (ADC1).
+const uint8_t S3 = 34;  ///< Sensor 3 (ADC1).
+const uint8_t S2 = 39;  ///< Sensor 2 (ADC1).
+const uint8_t S1 = 36;  ///< Sensor 1 (ADC1).
 ///@}
\ No newline at end of file
@@ -0,0 +1,70 @@
+/**
+ @file filtros.cpp
+ @brief Implementación de las etapas de filtrado por canal y de la cadena configurada al compilar.
+ @details Cada etapa es un lazo de 8 canales sin saltos dependientes de los datos (mínimos y máximos,
+ sumas y desplazamientos), así que el compilador lo desenrolla o lo vectoriza.
+ @author Legion de Ohm
+ */
+
+#include "filtros.hpp"
+
+/** @brief Estado de la mediana de la cadena configurada. */
+static HILO_LOCAL EtapaMediana mediana;
+
+/** @brief Estado del IIR de la cadena configurada. */
+static HILO_LOCAL EtapaIir iir;
+
+// ============================
+// ETAPAS
+// ============================
+/**
+ @details Mediana de tres como `max(min(a, b), min(max(a, b), c))`.
+ */
+void pasoMediana(EtapaMediana& etapa, uint16_t *cuadro) {
+    if (!etapa.cargada) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) etapa.anterior[i] = etapa.previo[i] = cuadro[i];
+        etapa.cargada = true;
+    }
+
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        uint16_t a = cuadro[i], b = etapa.anterior[i], c = etapa.previo[i];
+        uint16_t menor = a < b ? a : b;
+        uint16_t mayor = a < b ? b : a;
+        uint16_t medio = mayor < c ? mayor : c;
+
+        etapa.previo[i] = b;
+        etapa.anterior[i] = a;
+        cuadro[i] = menor > medio ? menor : medio;
+    }
+}
+
+/**
+ @details `suma` guarda la salida multiplicada por 2^k, así que `suma >> k` no pierde lo que un
+ `y += (x - y) >> k` entero descartaría en cada paso: en régimen `suma >> k` es exactamente la entrada.
+ Con lecturas de 16 bits y k <= 8 la suma entra en 24 bits.
+ */
+void pasoIir(EtapaIir& etapa, uint16_t *cuadro, uint8_t k) {
+    if (!etapa.cargada) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) etapa.suma[i] = (uint32_t)cuadro[i] << k;
+        etapa.cargada = true;
+    }
+
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        etapa.suma[i] += cuadro[i] - (etapa.suma[i] >> k);
+        cuadro[i] = (uint16_t)(etapa.suma[i] >> k);
+    }
+}
+
+// ============================
+// CADENA CONFIGURADA
+// ============================
+void filtrarCuadro(uint16_t *cuadro) {
+    // Primero la mediana: un pico aislado se descarta antes de que el IIR lo reparta en varios cuadros
+    if (FILTRO_MEDIANA_ACTIVA) pasoMediana(mediana, cuadro);
+    if (FILTRO_IIR > 0)        pasoIir(iir, cuadro, FILTRO_IIR);
+}
+
+void reiniciarFiltro() {
+    mediana.cargada = false;
+    iir.cargada = false;
+}
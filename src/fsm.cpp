@@ -2,96 +2,371 @@
  @file fsm.cpp
  @brief Implementación de la Máquina de Estados Finitos (FSM).
  @details Controla el flujo de operación del robot entre los estados de parada, aceleración y control PID 
- mediante tablas de transición basadas en las banderas de RUN y SETPOINT.
+ con la tabla de transiciones generada de `reglasFSM` (ver maquina_estados.hpp) sobre las banderas de RUN,
+ SETPOINT, línea perdida y sintonía, y define las acciones de entrada, ejecución y salida de cada estado.
  @author Legion de Ohm
  */
 
 #include "fsm.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "sensores.hpp"
+#include "adquisicion.hpp"
+#include "observador.hpp"
+#include "gobernador.hpp"
+#include "mapa.hpp"
+#include "motores.hpp"
+#include "planificador.hpp"
+#include "trazas.hpp"
+#include "telemetria.hpp"
+#include "caja_negra.hpp"
+#include "sintonia.hpp"
+
+/** @brief Velocidad variable para la rampa de aceleración inicial. */
+HILO_LOCAL int32_t velocidadAcel = 50;     
+
+// ===================== TABLA =====================
+
+/** @brief Acciones de entrada, ejecución y salida de cada estado, en el orden de `estados`. */
+static const AccionesEstado acciones_estado[CANT_ESTADOS] = {
+    { entrarStop,    estadoStop,    salirStop },
+    { entrarAcel,    estadoAcel,    salirAcel },
+    { entrarControl, estadoControl, nullptr },
+    { entrarPerdido, estadoPerdido, nullptr },
+    { entrarSintonia, estadoSintonia, salirSintonia },
+};
+
+/** @brief Periodo de la acción de cada estado, en el orden de `acciones_estado`. */
+const uint32_t periodos_estado[] = { PERIODO_STOP_US, PERIODO_ACEL_US, (uint32_t)TIEMPO_TIMER, PERIODO_PERDIDO_US, (uint32_t)TIEMPO_TIMER };
+
+/** @brief Máquina sobre la tabla generada de `reglasFSM`; arranca en STOP con la entrada pendiente. */
+static HILO_LOCAL MaquinaEstados<CANT_ESTADOS, CANT_ENTRADAS> maquina(tablaFSM, acciones_estado, S);
+
+// ==================== FUNCION FSM ====================
 
 /**
- @brief Función de acción nula (dummy) utilizada para transiciones que no requieren lógica adicional.
- @param c Código de entrada.
- @return int Siempre retorna 0.
+ @brief Ejecuta la lógica de transición de la máquina de estados.
+ @details Un acceso a la tabla `[estado][entrada]`; si el estado cambia corre la salida del anterior y
+ la entrada del nuevo, y después la acción del estado resultante.
+ @param entrada Valor entero que combina las señales de control para decidir la transición.
+ @return int El nuevo estado después de procesar la entrada.
  */
-int nada(int c) { return 0; }
+int transicionar(int entrada) {
+    return maquina.transicionar((uint8_t)entrada & (CANT_ENTRADAS - 1));
+}
 
 /**
- @struct estado_t
- @brief Estructura que define una fila en la tabla de transiciones de un estado.
+ @brief Devuelve el estado actual de la FSM.
  */
-typedef struct {
-    int recibo;               ///< Combinación binaria de señales de entrada (SP, RUN).
-    int (*transicion)(int);   ///< Puntero a función de acción de transición (dummy).
-    int prox_estado;          ///< Identificador del siguiente estado.
-} estado_t;
+int estadoFSM() {
+    return maquina.actual();
+}
 
-// ===================== TABLAS =====================
+/**
+ @brief Arma la entrada de 4 bits con las banderas de RUN, SETPOINT, línea perdida y sintonía pedida.
+ */
+int entradaFSM() {
+    return (SINTONIA << 3) | (LINEA_PERDIDA << 2) | (SETPOINT << 1) | RUN;
+}
 
-/** @brief Tabla de transiciones para el estado STOP (S). 
+/**
+ @brief Devuelve el periodo declarado de la acción de un estado.
  */
-estado_t stop[] = {
-    {0, nada, S},
-    {1, nada, A},
-    {2, nada, S},
-    {3, nada, A},
-    {CUALQUIERA, nada, S},
-};
+uint32_t periodoEstado(int estado) {
+    return periodos_estado[estado];
+}
 
-/** @brief Tabla de transiciones para el estado ACELERAR (A). 
+#if defined(TRAZAS) || defined(CAJA_NEGRA) || defined(SINTONIA_RELE)
+/**
+ @brief Reparte los caracteres recibidos por serial entre los módulos de diagnóstico habilitados.
  */
-estado_t acel[] = {
-    {0, nada, S},
-    {1, nada, C},
-    {2, nada, S},
-    {3, nada, A},
-    {CUALQUIERA, nada, A},
-};
+static void atenderSerial() {
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        traza(comandoTrazas(c);)
+        caja(comandoCajaNegra(c);)
+        sintonia(comandoSintonia(c);)
+    }
+}
+#endif
 
-/** @brief Tabla de transiciones para el estado CONTROL (C). 
+/**
+ @brief Reinicia el estado de la FSM y de las acciones de estado.
  */
-estado_t control[] = {
-    {0, nada, S},
-    {1, nada, C},
-    {2, nada, S},
-    {3, nada, A},
-    {CUALQUIERA, nada, C},
-};
+void reiniciarFSM() {
+    maquina.reiniciar(S);
+    velocidadAcel = 50;
+}
 
-/** @brief Tabla general que agrupa los punteros a las tablas de cada estado. 
+/**
+ @brief Fija la velocidad de la rampa de ACEL.
  */
-estado_t* tabla_de_estados[] = { stop, acel, control };
+void fijarRampaAcel(int32_t velocidad) {
+    velocidadAcel = velocidad;
+}
 
-/** @brief Punteros a las funciones de acción de cada estado, definidas externamente. 
+
+// ESTADO STOP - FUNCION DETENIDO
+/**
+ @brief Entrada en STOP (también al arrancar).
+ @details Detiene los motores, apaga los LEDs de estado y reinicia la velocidad de aceleración.
  */
-extern void (*acciones_estado[])();
+void entrarStop() {
+    deb(Serial.println("Estado: STOP");)
+
+    // Lo que llevó a la parada queda guardado hasta el próximo RUN
+    caja(congelarCajaNegra();)
+
+    // La carrera siguiente arranca sin la estimación de la anterior
+    obs(reiniciarObservador();)
+
+    halEscribirDigital(ledMotores, false);
+    halEscribirDigital(ledCalibracion, false);
+
+    detenerMotores();
+    
+    velocidadAcel = 50;
 
-/** @brief Variable estática que mantiene el rastro del estado actual de la FSM. 
+    deb(imprimirPlanificador();)
+    deb(Serial.println("\n ---------------------- \n");)
+}
+
+/**
+ @brief Acción ejecutada en el estado de parada (STOP).
  */
-static int estadoActual = S;
+void estadoStop() {
+    // Con DOBLE_NUCLEO la tarea de adquisición sigue publicando: se descarta lo viejo
+    descartarMuestras();
 
-// ==================== FUNCION FSM ====================
+#if defined(TRAZAS) || defined(CAJA_NEGRA) || defined(SINTONIA_RELE)
+    // Volcados a pedido por serial: 't' histogramas del tick, 'c' caja negra; 'u'/'U' piden la sintonía
+    atenderSerial();
+#endif
+}
 
 /**
- @brief Ejecuta la lógica de transición de la máquina de estados.
- @details Busca en la tabla del estado actual una coincidencia con la entrada proporcionada. 
- Si la encuentra, actualiza el estado y ejecuta la acción correspondiente al nuevo estado.
- @param entrada Valor entero que combina las señales de control para decidir la transición.
- @return int El nuevo estado después de procesar la entrada.
+ @brief Salida de STOP: arranca una carrera nueva.
  */
-int transicionar(int entrada) {
-    estado_t* p = tabla_de_estados[estadoActual];
+void salirStop() {
+    caja(rearmarCajaNegra();)
 
-    // busca el recibo que coincida con la entrada
-    while (p->recibo != entrada && p->recibo != CUALQUIERA) p++;
+    // Con el mapa de la vuelta ya aprendido vuelve al segmento 0 de la largada
+    mapa(arrancarMapa();)
+}
 
-    // ejecuta las funciones de transicion - dummies (como no las ejecutamos lo dejaremos comentado)
-    //(p->transicion)(entrada);
-    
-    // actualizo el estado
-    estadoActual = p->prox_estado;
 
-    // EJECUTAR ESTADO
-    acciones_estado[estadoActual]();
+// ESTADO ACEL - FUNCION ACELERAR EN LINEA
+/**
+ @brief Entrada en ACEL (desde STOP o al volver al setpoint desde CONTROL).
+ */
+void entrarAcel() {
+    // Indicador de que estamos en setpoint
+    halEscribirDigital(ledCalibracion, true);
+
+    // La velocidad de la línea arranca de nuevo, como el PID
+    obs(reiniciarObservador();)
+}
+
+/**
+ @brief Acción ejecutada en el estado de aceleración (ACEL).
+ @details Realiza un incremento progresivo de la velocidad mientras el robot se encuentre 
+ dentro del setpoint para romper la inercia de manera suave. Con una ejecución cada `PERIODO_ACEL_US`
+ la rampa tiene una pendiente fija de 1% por milisegundo.
+ */
+void estadoAcel() {
+    // Leer posicion de línea (0 = extremo izquierda, 7000 = extremo derecha)  
+    position = lineaActual();
+    LINEA_PERDIDA = !lineaVisible();
+    obs(position = observarLinea(position, instanteLinea(), !LINEA_PERDIDA);)
+
+    // Incremento suave de velocidad
+    if (velocidadAcel < maxSpeed) velocidadAcel++;
+
+    // Con el mapa listo la rampa no pasa la velocidad planificada: frena antes de la curva aunque esté centrado
+    mapa(if (mapaListo() && velocidadAcel > velocidadMapa()) velocidadAcel = velocidadMapa();)
+
+    // Mover motores con aceleracion progresiva
+    moverMotores(velocidadAcel, velocidadAcel);
+    mapa(registrarMapa(velocidadAcel, velocidadAcel);)
+
+    // Calculamos si estamos en el setpoint
+    actualizarSP(position);
+
+    // Reiniciamos las variables PID
+    reiniciar_pid();
+
+    // Trama binaria del tick (reemplaza los printf de depuracion)
+    telemetria(publicarTelemetria(A, position, 0.0f, velocidadAcel, velocidadAcel);)
+    caja(registrarCajaNegra(A, position, velocidadAcel, velocidadAcel);)
+}
+
+/**
+ @brief Salida de ACEL hacia CONTROL o PERDIDO (o STOP).
+ @details La velocidad gobernada arranca en la de la rampa, sin escalón. Al pasar por PERDIDO queda
+ congelada, como la integral: al recuperar la línea CONTROL sigue con la que tenía.
+ */
+void salirAcel() {
+    gob(iniciarGobernador(velocidadAcel);)
+}
+
+
+// ESTADO CONTROL - FUNCION CONTROL EN LINEA
+/**
+ @brief Entrada en CONTROL: los LEDs quedan fijos mientras dure el estado.
+ */
+void entrarControl() {
+    // Enceder led modo corredor
+    halEscribirDigital(ledMotores, true);
+
+    // Apagar led cal - indicamos que no estamos en Setpoint 
+    halEscribirDigital(ledCalibracion, false);
+}
+
+/**
+ @brief Acción ejecutada en el estado de control activo (CONTROL).
+ @details Ejecuta el algoritmo PID a intervalos fijos (el planificador la libera cada `TIEMPO_TIMER`)
+ para corregir la trayectoria del robot sobre la línea.
+ */
+void estadoControl() {
+    traza(uint32_t inicioTick = halCiclos();)
+
+    // Leer posicion de línea (0 = extremo izquierda, 7000 = extremo derecha)    
+    traza(uint32_t inicioEtapa = halCiclos();)
+    position = lineaActual();
+    LINEA_PERDIDA = !lineaVisible();
+    obs(position = observarLinea(position, instanteLinea(), !LINEA_PERDIDA);)
+    traza(registrarTraza(TRAZA_LECTURA, inicioEtapa);)
+
+    // calculo la correccion para los motores segun la posicion y el delta tiempo (timer isr) 
+    // Sin linea la posicion es un extremo saturado: no se integra (el proximo tick ya es PERDIDO)
+    traza(inicioEtapa = halCiclos();)
+    float correcion = 0.0f;
+    if (!LINEA_PERDIDA) {
+        // Ganancias de la velocidad base (la del gobernador es la del tick anterior)
+        bandas(programarGanancias(velocidadBase());)
+#ifdef PID_FIJO
+        correcion = calculo_pid_fijo(position) * (1.0f / PID_UNO);   // dt ya plegado en las ganancias
+#else
+        correcion = calculo_pid(position, FIXED_DT_S);
+#endif
+    }
+    traza(registrarTraza(TRAZA_PID, inicioEtapa);)
+ 
+    // Calculamos si estamos en el setpoint
+    actualizarSP(position);
+
+    // Control de motores (o giro hacia el ultimo lado visto si se perdio la linea)
+    traza(inicioEtapa = halCiclos();)
+    gob(if (!LINEA_PERDIDA) gobernarVelocidad(position);)
+    if (LINEA_PERDIDA) busquedaMotores(position);
+    else               controlMotores(correcion);
+
+    // Anti-windup: lo que los motores recortaron de la corrección. En la zona muerta no se aplica, pero
+    // tampoco se recorta: aplicada = pedida para que la integral no se descuente
+    opciones(if (!LINEA_PERDIDA) saturacionPid(correcion, SETPOINT ? correcion : correccionAplicada(correcion));)
+
+    // Mover los motores (Avanza, retrocede o para)
+    moverMotores(motorSpeedIzq, motorSpeedDer);
+    mapa(registrarMapa(motorSpeedIzq, motorSpeedDer);)
+    traza(registrarTraza(TRAZA_MOTORES, inicioEtapa);)
+
+    // Trama binaria del tick (reemplaza los printf de depuracion)
+    telemetria(publicarTelemetria(C, position, correcion, motorSpeedIzq, motorSpeedDer);)
+    caja(registrarCajaNegra(C, position, motorSpeedIzq, motorSpeedDer);)
+    traza(registrarTraza(TRAZA_TICK, inicioTick);)
+}
+
+
+// ESTADO PERDIDO - FUNCION BUSCAR LA LINEA
+/**
+ @brief Entrada en PERDIDO: ambos LEDs apagados mientras se busca la línea.
+ */
+void entrarPerdido() {
+    halEscribirDigital(ledMotores, false);
+    halEscribirDigital(ledCalibracion, false);
+}
+
+/**
+ @brief Acción ejecutada con la línea perdida (PERDIDO).
+ @details Gira hacia el lado donde se vio la línea por última vez sin ejecutar el PID, así la integral
+ queda como estaba al perder la línea. Corre cada `PERIODO_PERDIDO_US` para volver a ACEL o CONTROL
+ en cuanto algún sensor vuelve a ver la línea. Con `MAPA_PISTA` no registra en el mapa: el giro de
+ búsqueda no es la forma de la pista.
+ */
+void estadoPerdido() {
+    // Sin linea leerLinea() devuelve el extremo del ultimo lado visto
+    position = lineaActual();
+    LINEA_PERDIDA = !lineaVisible();
+    obs(position = observarLinea(position, instanteLinea(), !LINEA_PERDIDA);)
+
+    actualizarSP(position);
+
+    busquedaMotores(position);
+    moverMotores(motorSpeedIzq, motorSpeedDer);
+
+    telemetria(publicarTelemetria(P, position, 0.0f, motorSpeedIzq, motorSpeedDer);)
+    caja(registrarCajaNegra(P, position, motorSpeedIzq, motorSpeedDer);)
+}
+
+
+// ESTADO SINTONIA - FUNCION RELE PARA Ku Y Tu
+/**
+ @brief Entrada en SINTONIA (desde STOP con la sintonía pedida).
+ @details Enciende ambos LEDs mientras dura el experimento.
+ */
+void entrarSintonia() {
+    halEscribirDigital(ledMotores, true);
+    halEscribirDigital(ledCalibracion, true);
+
+    iniciarSintonia();
+    reiniciar_pid();
+}
+
+/**
+ @brief Acción ejecutada durante la sintonía por relé (SINTONIA).
+ @details Cada `TIEMPO_TIMER`, como CONTROL, para que el ciclo límite sea el del lazo que va a cerrar el PID.
+ La corrección es la del relé alrededor de `baseSpeed`, sin zona muerta ni gobernador. Con la línea perdida
+ la sintonía falla y el robot se detiene; al terminar baja `SINTONIA`, y `RUN` si no hay que seguir.
+ */
+void estadoSintonia() {
+    position = lineaActual();
+    LINEA_PERDIDA = !lineaVisible();
+    obs(position = observarLinea(position, instanteLinea(), !LINEA_PERDIDA);)
+
+    if (LINEA_PERDIDA) abortarSintonia();
+    float rele = releSintonia(position, instanteLinea());
+
+    // Al salir hacia ACEL o CONTROL la entrada tiene que reflejar el setpoint
+    actualizarSP(position);
+
+    motorSpeedIzq = constrain(baseSpeed - (int32_t)rele, -maxSpeed, maxSpeed);
+    motorSpeedDer = constrain(baseSpeed + (int32_t)rele, -maxSpeed, maxSpeed);
+    if (resultadoSintonia().fase != SINTONIA_MIDIENDO) {
+        SINTONIA = false;
+        if (resultadoSintonia().fase == SINTONIA_FALLIDA || !sintoniaAplica()) {
+            RUN = false;
+            motorSpeedIzq = motorSpeedDer = 0;
+        }
+    }
+    moverMotores(motorSpeedIzq, motorSpeedDer);
+
+    // La caja negra guarda 2 bits de estado: la sintonía no se registra
+    telemetria(publicarTelemetria(T, position, rele, motorSpeedIzq, motorSpeedDer);)
+}
+
+/**
+ @brief Salida de SINTONIA hacia ACEL o CONTROL (ganancias aplicadas) o hacia STOP.
+ @details Con las ganancias aplicadas la carrera sigue sin escalón: la rampa de ACEL y el gobernador parten
+ de `baseSpeed`. Un STOP en medio del experimento lo termina como fallido.
+ */
+void salirSintonia() {
+    abortarSintonia();
+    SINTONIA = false;
+    if (sintoniaAplica()) aplicarSintonia();
+    reiniciar_pid();
+    velocidadAcel = baseSpeed;
+    gob(iniciarGobernador(baseSpeed);)
 
-    return estadoActual;
+    sintonia(imprimirSintonia();)
 }
@@ -0,0 +1,52 @@
+/**
+ @file gobernador.cpp
+ @brief Implementación del gobernador de velocidad de CONTROL.
+ @author Legion de Ohm
+ */
+
+#include "gobernador.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "observador.hpp"
+
+/** @brief Velocidad gobernada actual (%). */
+static HILO_LOCAL float velocidad = 0;
+
+/** @brief Error del tick anterior, para la variación sin `OBSERVADOR`. */
+static HILO_LOCAL int32_t errorAnterior = 0;
+
+/** @brief false en el primer tick después de `iniciarGobernador()` (no hay error anterior). */
+static HILO_LOCAL bool conAnterior = false;
+
+void iniciarGobernador(float inicial) {
+    velocidad = inicial;
+    conAnterior = false;
+}
+
+float gobernarVelocidad(uint16_t pos) {
+    int32_t error = (int32_t)pos - setpoint;
+
+    // Variación del error por tick: la velocidad estimada si hay observador, si no la diferencia finita
+#ifdef OBSERVADOR
+    float variacion = velocidadLinea() * (1.0f / (1 << OBSERVADOR_Q));
+#else
+    float variacion = conAnterior ? (float)(error - errorAnterior) : 0.0f;
+#endif
+    errorAnterior = error;
+    conAnterior = true;
+
+    if (variacion < 0) variacion = -variacion;
+    float carga = abs(error) * (1.0f / GOBERNADOR_ERROR_MAX) + variacion * (1.0f / GOBERNADOR_VARIACION_MAX);
+    if (carga > 1) carga = 1;
+    float objetivo = rectaGobernador - (rectaGobernador - curvaGobernador) * carga;
+
+    // Pendientes limitadas: sube despacio al salir de una curva y baja rápido al entrar
+    float paso = (objetivo > velocidad ? subidaGobernador : bajadaGobernador) * FIXED_DT_S;
+    velocidad = constrain(objetivo, velocidad - paso, velocidad + paso);
+    return velocidad;
+}
+
+float velocidadGobernada() {
+    return velocidad;
+}
@@ -0,0 +1,269 @@
+/**
+ @file hal_esp32.cpp
+ @brief Backend ESP32 de la capa de abstracción de hardware.
+ @details Traduce cada función de `hal.hpp` a su equivalente del core Arduino-ESP32
+ (ledc, esp_timer, attachInterrupt, analogRead, Preferences). Solo se compila cuando `ARDUINO` está definido.
+ @author Legion de Ohm
+ */
+
+#ifdef ARDUINO
+
+#include "hal.hpp"
+#include "driver/adc.h"
+#include "esp_timer.h"
+#include <Preferences.h>
+
+// ============================
+// GPIO
+// ============================
+void halPinModo(uint8_t pin, HalModo modo) {
+    pinMode(pin, modo == HAL_SALIDA ? OUTPUT : INPUT);
+}
+
+void halEscribirDigital(uint8_t pin, bool nivel) {
+    digitalWrite(pin, nivel ? HIGH : LOW);
+}
+
+bool halLeerDigital(uint8_t pin) {
+    return digitalRead(pin) == HIGH;
+}
+
+void halInterrupcionPin(uint8_t pin, void (*isr)()) {
+    attachInterrupt(digitalPinToInterrupt(pin), isr, RISING);
+}
+
+// ============================
+// PWM (LEDC)
+// ============================
+void halPwmConfigurar(uint8_t canal, uint32_t freq, uint8_t resolucion) {
+    ledcSetup(canal, freq, resolucion);
+}
+
+void halPwmAsociar(uint8_t pin, uint8_t canal) {
+    ledcAttachPin(pin, canal);
+}
+
+void halPwmDesasociar(uint8_t pin) {
+    ledcDetachPin(pin);
+}
+
+void halPwmEscribir(uint8_t canal, uint32_t duty) {
+    ledcWrite(canal, duty);
+}
+
+void halPwmTono(uint8_t canal, uint32_t freq) {
+    ledcWriteTone(canal, freq);
+}
+
+// ============================
+// TIMER Y TIEMPO
+// ============================
+uint32_t halMicros() {
+    return micros();
+}
+
+uint32_t halCiclos() {
+    return ESP.getCycleCount();
+}
+
+uint32_t halCiclosPorUs() {
+    return getCpuFrequencyMhz();
+}
+
+/** @brief Por debajo de esta espera no conviene bloquear la tarea: la latencia de despertar es mayor. */
+static const int32_t ESPERA_ACTIVA_US = 50;
+
+/** @brief Temporizador de un disparo que despierta a la tarea dormida. */
+static esp_timer_handle_t temporizadorDespertar = NULL;
+
+/** @brief Tarea bloqueada en `halDormirHasta()`. */
+static TaskHandle_t tareaDormida = NULL;
+
+/** @brief Callback del `esp_timer`: notifica a la tarea dormida. */
+static void despertar(void* arg) {
+    xTaskNotifyGive(tareaDormida);
+}
+
+void halDormirHasta(uint32_t instante_us) {
+    int32_t falta = (int32_t)(instante_us - micros());
+
+    if (falta > ESPERA_ACTIVA_US) {
+        if (!temporizadorDespertar) {
+            esp_timer_create_args_t args = {};
+            args.callback = despertar;
+            args.name = "halDormir";
+            esp_timer_create(&args, &temporizadorDespertar);
+        }
+
+        tareaDormida = xTaskGetCurrentTaskHandle();
+        esp_timer_start_once(temporizadorDespertar, falta - ESPERA_ACTIVA_US);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    // Último tramo (y esperas cortas) de forma activa para no llegar tarde
+    while ((int32_t)(instante_us - micros()) > 0) {}
+}
+
+void halDelay(uint32_t ms) {
+    delay(ms);
+}
+
+// ============================
+// ADC
+// ============================
+uint16_t halLeerAnalogico(uint8_t pin) {
+    return analogRead(pin);
+}
+
+// ============================
+// ADC CONTINUO (DMA) Y ADC2
+// ============================
+/** @brief Pin asociado a cada canal del ADC1, para etiquetar las conversiones del DMA. */
+static uint8_t pinCanalAdc1[8];
+
+/** @brief Rondas completas por interrupción del DMA: acota la antigüedad del último dato. */
+static const uint8_t RONDAS_POR_INTERRUPCION = 4;
+
+bool halAdcContinuoIniciar(const uint8_t* pines, uint8_t cantidad, uint32_t frecuencia_hz) {
+    adc_digi_pattern_config_t patron[8];
+    uint16_t mascara = 0;
+
+    if (cantidad > 8) return false;
+
+    for (uint8_t i = 0; i < cantidad; i++) {
+        int8_t canal = digitalPinToAnalogChannel(pines[i]);
+        if (canal < 0 || canal > 7) return false;      // 0-7: ADC1, 10-19: ADC2
+
+        pinCanalAdc1[canal] = pines[i];
+        mascara |= 1 << canal;
+
+        patron[i].atten = ADC_ATTEN_DB_11;              // misma atenuación que analogRead()
+        patron[i].channel = canal;
+        patron[i].unit = 0;                             // ADC1
+        patron[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_digi_init_config_t inicio = {};
+    inicio.max_store_buf_size = 1024;
+    inicio.conv_num_each_intr = RONDAS_POR_INTERRUPCION * cantidad * SOC_ADC_DIGI_RESULT_BYTES;
+    inicio.adc1_chan_mask = mascara;
+    inicio.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&inicio) != ESP_OK) return false;
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = 1;                           // obligatorio en el ESP32
+    config.conv_limit_num = 250;
+    config.pattern_num = cantidad;
+    config.adc_pattern = patron;
+    config.sample_freq_hz = frecuencia_hz;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    if (adc_digi_controller_configure(&config) != ESP_OK) return false;
+
+    return adc_digi_start() == ESP_OK;
+}
+
+uint16_t halAdcContinuoLeer(HalMuestraAdc* muestras, uint16_t maximo) {
+    uint8_t bytes[64 * SOC_ADC_DIGI_RESULT_BYTES];
+    uint32_t leidos = 0;
+
+    if (maximo > 64) maximo = 64;
+
+    // ESP_ERR_INVALID_STATE indica que el buffer del driver se llenó, pero igual entrega datos
+    esp_err_t r = adc_digi_read_bytes(bytes, maximo * SOC_ADC_DIGI_RESULT_BYTES, &leidos, 0);
+    if (r != ESP_OK && r != ESP_ERR_INVALID_STATE) return 0;
+
+    uint16_t n = 0;
+    for (uint32_t k = 0; k + SOC_ADC_DIGI_RESULT_BYTES <= leidos; k += SOC_ADC_DIGI_RESULT_BYTES) {
+        adc_digi_output_data_t* dato = (adc_digi_output_data_t*)&bytes[k];
+        muestras[n].pin = pinCanalAdc1[dato->type1.channel & 7];
+        muestras[n].valor = dato->type1.data;
+        n++;
+    }
+    return n;
+}
+
+/** @brief Canales del ADC2 con la atenuación ya configurada. */
+static uint16_t adc2Configurado = 0;
+
+uint16_t halAdcUnico(uint8_t pin) {
+    int8_t canal = digitalPinToAnalogChannel(pin);
+    int valor = 0;
+
+    if (canal < 10) return analogRead(pin);            // ADC1: solo si no está en modo continuo
+
+    if (!(adc2Configurado & (1 << (canal - 10)))) {
+        adc2_config_channel_atten((adc2_channel_t)(canal - 10), ADC_ATTEN_DB_11);
+        adc2Configurado |= 1 << (canal - 10);
+    }
+    adc2_get_raw((adc2_channel_t)(canal - 10), ADC_WIDTH_BIT_12, &valor);
+    return (uint16_t)valor;
+}
+
+// ============================
+// TAREAS
+// ============================
+/** @brief Paso registrado para cada núcleo. */
+static void (*pasoNucleo[2])() = { nullptr, nullptr };
+
+/** @brief Cuerpo de la tarea FreeRTOS: repite el paso de su núcleo para siempre. */
+static void tareaNucleo(void* arg) {
+    void (*paso)() = pasoNucleo[(uintptr_t)arg];
+    for (;;) paso();
+}
+
+void halTareaNucleo(void (*paso)(), uint8_t nucleo) {
+    pasoNucleo[nucleo] = paso;
+
+    // La tarea nunca cede el núcleo: la IDLE de ese núcleo ya no puede alimentar al watchdog
+    if (nucleo == 0) disableCore0WDT();
+    else disableCore1WDT();
+
+    xTaskCreatePinnedToCore(tareaNucleo, "halTarea", 4096, (void*)(uintptr_t)nucleo, 1, NULL, nucleo);
+}
+
+/** @brief Paso y periodo de la tarea de fondo. */
+static void (*pasoFondo)() = nullptr;
+static uint32_t periodoFondoMs = 1;
+
+/** @brief Cuerpo de la tarea de fondo: un paso y se bloquea hasta el próximo. */
+static void tareaFondo(void* arg) {
+    for (;;) {
+        pasoFondo();
+        vTaskDelay(pdMS_TO_TICKS(periodoFondoMs));
+    }
+}
+
+void halTareaFondo(void (*paso)(), uint32_t periodo_ms) {
+    pasoFondo = paso;
+    periodoFondoMs = periodo_ms ? periodo_ms : 1;
+
+    // Misma prioridad que la IDLE: solo ocupa el núcleo 1 mientras el loop duerme en halDormirHasta()
+    xTaskCreatePinnedToCore(tareaFondo, "halFondo", 4096, NULL, tskIDLE_PRIORITY, NULL, 1);
+}
+
+// ============================
+// ALMACENAMIENTO NO VOLÁTIL
+// ============================
+/** @brief Espacio de NVS del firmware. */
+static const char* ESPACIO_NVS = "seguidor";
+
+/** @brief Acceso a NVS (se abre y se cierra en cada operación). */
+static Preferences preferencias;
+
+bool halAlmacenLeer(const char* clave, void* datos, size_t n) {
+    // Solo lectura: falla si el espacio todavía no existe (primer arranque)
+    if (!preferencias.begin(ESPACIO_NVS, true)) return false;
+    bool ok = preferencias.getBytesLength(clave) == n && preferencias.getBytes(clave, datos, n) == n;
+    preferencias.end();
+    return ok;
+}
+
+bool halAlmacenEscribir(const char* clave, const void* datos, size_t n) {
+    if (!preferencias.begin(ESPACIO_NVS, false)) return false;
+    bool ok = preferencias.putBytes(clave, datos, n) == n;
+    preferencias.end();
+    return ok;
+}
+
+#endif
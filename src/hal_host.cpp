@@ -0,0 +1,346 @@
+/**
+ @file hal_host.cpp
+ @brief Backend host (Linux) de la capa de abstracción de hardware.
+ @details Emula en memoria los periféricos usados por el control: niveles de los GPIO,
+ enrutamiento pin-canal y duty de los canales ledc, un reloj virtual en microsegundos que
+ avanza con las tareas y una fuente de lecturas analógicas configurable. El almacén no
+ volátil se guarda en archivos, así que una prueba puede "reiniciar" el robot y volver a leerlo.
+ Solo se compila cuando `ARDUINO` no está definido (entorno `native`).
+ @author Legion de Ohm
+ */
+
+#ifndef ARDUINO
+
+#include <cstdarg>
+#include <chrono>
+#include "hal.hpp"
+#include "filtros.hpp"
+
+/** @brief Cantidad de GPIO del ESP32 emulados. */
+static const uint8_t CANT_PINES = 40;
+
+/** @brief Cantidad de canales ledc del ESP32 emulados. */
+static const uint8_t CANT_CANALES = 16;
+
+// ============================
+// ESTADO EMULADO
+// ============================
+/** @brief Último nivel escrito en cada pin. */
+static HILO_LOCAL bool nivelPin[CANT_PINES];
+
+/** @brief Canal PWM enrutado a cada pin, desplazado en uno (0 = ninguno). */
+static HILO_LOCAL uint8_t canalPin[CANT_PINES];
+
+/** @brief ISR asociada al flanco ascendente de cada pin. */
+static HILO_LOCAL void (*isrPin[CANT_PINES])();
+
+/** @brief Lectura analógica fija de cada pin. */
+static HILO_LOCAL uint16_t analogico[CANT_PINES];
+
+/** @brief Fuente de lecturas analógicas registrada por el programa de prueba. */
+static HILO_LOCAL HalFuenteAnalogica fuenteAnalogica = nullptr;
+
+/** @brief Último duty escrito en cada canal. */
+static HILO_LOCAL uint32_t dutyCanal[CANT_CANALES];
+
+/** @brief Resolución configurada en cada canal. */
+static HILO_LOCAL uint8_t resolucionCanal[CANT_CANALES];
+
+/** @brief Reloj virtual en microsegundos. */
+static HILO_LOCAL uint32_t relojUs = 0;
+
+/** @brief Pines del ADC continuo, en el orden de la ronda. */
+static HILO_LOCAL uint8_t adcPines[8];
+
+/** @brief Cantidad de pines del ADC continuo (0 = detenido). */
+static HILO_LOCAL uint8_t adcCantidad = 0;
+
+/** @brief Conversiones por segundo del ADC continuo. */
+static HILO_LOCAL uint32_t adcFrecuencia = 0;
+
+/** @brief Rondas del ADC continuo que se conservan: las que promedia muestreo.cpp (al menos 4). */
+static const uint32_t RONDAS_ADC = FILTRO_SOBREMUESTREO > 4 ? FILTRO_SOBREMUESTREO : 4;
+
+/** @brief Instante del reloj virtual hasta el que ya se contaron conversiones. */
+static HILO_LOCAL uint32_t adcUltimoUs = 0;
+
+/** @brief Posición en la ronda de la próxima conversión. */
+static HILO_LOCAL uint8_t adcFase = 0;
+
+/** @brief Conversiones hechas y todavía no leídas. */
+static HILO_LOCAL uint32_t adcPendientes = 0;
+
+/** @brief Llamadas a periféricos de salida, para verificar cuánto toca el firmware el hardware. */
+static HILO_LOCAL HalContadores contadores;
+
+/** @brief Paso de la tarea registrada en cada núcleo (nullptr = sin tarea). */
+static HILO_LOCAL void (*pasoNucleo[2])();
+
+/** @brief Paso de la tarea de fondo (nullptr = sin tarea). */
+static HILO_LOCAL void (*pasoFondo)();
+
+/** @brief Directorio del almacén no volátil (nullptr = sin almacén). No lo toca `halHostReiniciar()`. */
+static HILO_LOCAL const char* directorioAlmacen = nullptr;
+
+/** @brief Sustituto de `Serial` en host. */
+HalSerialHost Serial;
+
+int HalSerialHost::printf(const char* formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    int n = std::vprintf(formato, args);
+    va_end(args);
+    return n;
+}
+
+// ============================
+// GPIO
+// ============================
+void halPinModo(uint8_t pin, HalModo modo) {
+    (void)pin;
+    (void)modo;
+}
+
+void halEscribirDigital(uint8_t pin, bool nivel) {
+    contadores.escriturasDigitales++;
+    if (pin < CANT_PINES) nivelPin[pin] = nivel;
+}
+
+bool halLeerDigital(uint8_t pin) {
+    return pin < CANT_PINES ? nivelPin[pin] : false;
+}
+
+void halInterrupcionPin(uint8_t pin, void (*isr)()) {
+    if (pin < CANT_PINES) isrPin[pin] = isr;
+}
+
+// ============================
+// PWM (LEDC)
+// ============================
+void halPwmConfigurar(uint8_t canal, uint32_t freq, uint8_t resolucion) {
+    (void)freq;
+    if (canal < CANT_CANALES) resolucionCanal[canal] = resolucion;
+}
+
+void halPwmAsociar(uint8_t pin, uint8_t canal) {
+    contadores.pwmAsociar++;
+    if (pin < CANT_PINES) canalPin[pin] = canal + 1;
+}
+
+void halPwmDesasociar(uint8_t pin) {
+    contadores.pwmDesasociar++;
+    if (pin < CANT_PINES) canalPin[pin] = 0;
+}
+
+void halPwmEscribir(uint8_t canal, uint32_t duty) {
+    contadores.pwmEscrituras++;
+    if (canal < CANT_CANALES) dutyCanal[canal] = duty;
+}
+
+void halPwmTono(uint8_t canal, uint32_t freq) {
+    // Un tono es una cuadrada al 50%: solo interesa si suena o no
+    if (canal < CANT_CANALES) dutyCanal[canal] = freq ? 1 : 0;
+}
+
+// ============================
+// TIMER Y TIEMPO
+// ============================
+uint32_t halMicros() {
+    return relojUs;
+}
+
+uint32_t halCiclos() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t halCiclosPorUs() {
+    return 1000;
+}
+
+void halDormirHasta(uint32_t instante_us) {
+    int32_t falta = (int32_t)(instante_us - relojUs);
+    if (falta > 0) halHostAvanzar((uint32_t)falta);
+}
+
+void halDelay(uint32_t ms) {
+    halHostAvanzar(ms * 1000);
+}
+
+// ============================
+// TAREAS
+// ============================
+void halTareaNucleo(void (*paso)(), uint8_t nucleo) {
+    if (nucleo < 2) pasoNucleo[nucleo] = paso;
+}
+
+void halTareaFondo(void (*paso)(), uint32_t periodo_ms) {
+    (void)periodo_ms;
+    pasoFondo = paso;
+}
+
+// ============================
+// ADC
+// ============================
+uint16_t halLeerAnalogico(uint8_t pin) {
+    if (fuenteAnalogica) return fuenteAnalogica(pin);
+    return pin < CANT_PINES ? analogico[pin] : 0;
+}
+
+/**
+ @details Las conversiones se cuentan con el reloj virtual y toman el valor de la fuente analógica al
+ momento de leerlas. Como el reloj no avanza mientras el firmware lee, se asume al menos una ronda
+ completa entre dos lecturas. Solo se conservan las últimas `RONDAS_ADC` rondas: las anteriores las
+ descartaría igual quien lee, y generarlas solo haría más lenta la simulación.
+ */
+bool halAdcContinuoIniciar(const uint8_t* pines, uint8_t cantidad, uint32_t frecuencia_hz) {
+    if (cantidad == 0 || cantidad > 8 || frecuencia_hz == 0) return false;
+
+    for (uint8_t i = 0; i < cantidad; i++) adcPines[i] = pines[i];
+    adcCantidad = cantidad;
+    adcFrecuencia = frecuencia_hz;
+    adcUltimoUs = relojUs;
+    adcFase = 0;
+    adcPendientes = 0;
+    return true;
+}
+
+uint16_t halAdcContinuoLeer(HalMuestraAdc* muestras, uint16_t maximo) {
+    if (adcCantidad == 0) return 0;
+
+    uint64_t nuevas = (uint64_t)(relojUs - adcUltimoUs) * adcFrecuencia / 1000000;
+    adcUltimoUs += (uint32_t)(nuevas * 1000000 / adcFrecuencia);
+    if (nuevas == 0 && adcPendientes == 0) nuevas = adcCantidad;
+
+    uint64_t total = adcPendientes + nuevas;
+    uint32_t limite = RONDAS_ADC * adcCantidad;
+    if (total > limite) {
+        adcFase = (adcFase + (total - limite)) % adcCantidad;
+        total = limite;
+    }
+    adcPendientes = (uint32_t)total;
+
+    uint16_t n = adcPendientes < maximo ? adcPendientes : maximo;
+    for (uint16_t k = 0; k < n; k++) {
+        muestras[k].pin = adcPines[adcFase];
+        muestras[k].valor = halLeerAnalogico(adcPines[adcFase]);
+        adcFase = (adcFase + 1) % adcCantidad;
+    }
+    adcPendientes -= n;
+    return n;
+}
+
+uint16_t halAdcUnico(uint8_t pin) {
+    return halLeerAnalogico(pin);
+}
+
+// ============================
+// ALMACENAMIENTO NO VOLÁTIL
+// ============================
+/** @brief Ruta del archivo de una clave: `<directorio>/<clave>.nvs`. */
+static bool rutaAlmacen(const char* clave, char* ruta, size_t n) {
+    if (!directorioAlmacen) return false;
+    int largo = std::snprintf(ruta, n, "%s/%s.nvs", directorioAlmacen, clave);
+    return largo > 0 && (size_t)largo < n;
+}
+
+bool halAlmacenLeer(const char* clave, void* datos, size_t n) {
+    char ruta[256];
+    if (!rutaAlmacen(clave, ruta, sizeof(ruta))) return false;
+    FILE* f = std::fopen(ruta, "rb");
+    if (!f) return false;
+
+    // Igual que NVS: el bloque se entrega solo si tiene exactamente el tamaño pedido
+    uint8_t leido[256];
+    size_t largo = n < sizeof(leido) ? std::fread(leido, 1, n + 1, f) : 0;
+    std::fclose(f);
+    if (largo != n) return false;
+    for (size_t i = 0; i < n; i++) ((uint8_t*)datos)[i] = leido[i];
+    return true;
+}
+
+bool halAlmacenEscribir(const char* clave, const void* datos, size_t n) {
+    char ruta[256];
+    if (!rutaAlmacen(clave, ruta, sizeof(ruta))) return false;
+    FILE* f = std::fopen(ruta, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(datos, 1, n, f) == n;
+    return std::fclose(f) == 0 && ok;
+}
+
+// ============================
+// EXTENSIONES SOLO HOST
+// ============================
+void halHostReiniciar() {
+    for (uint8_t i = 0; i < CANT_PINES; i++) {
+        nivelPin[i] = false;
+        canalPin[i] = 0;
+        isrPin[i] = nullptr;
+        analogico[i] = 0;
+    }
+    for (uint8_t i = 0; i < CANT_CANALES; i++) {
+        dutyCanal[i] = 0;
+        resolucionCanal[i] = 0;
+    }
+    fuenteAnalogica = nullptr;
+    relojUs = 0;
+    pasoNucleo[0] = pasoNucleo[1] = nullptr;
+    pasoFondo = nullptr;
+    adcCantidad = 0;
+    adcPendientes = 0;
+    contadores = HalContadores();
+}
+
+/**
+ @brief Avanza el reloj virtual.
+ @details Las tareas de los núcleos y la de fondo corren primero, así ven el instante actual.
+ */
+void halHostAvanzar(uint32_t us) {
+    for (uint8_t n = 0; n < 2; n++) {
+        if (pasoNucleo[n]) pasoNucleo[n]();
+    }
+    if (pasoFondo) pasoFondo();
+    relojUs += us;
+}
+
+void halHostFijarAnalogico(uint8_t pin, uint16_t valor) {
+    if (pin < CANT_PINES) analogico[pin] = valor;
+}
+
+void halHostFuenteAnalogica(HalFuenteAnalogica fuente) {
+    fuenteAnalogica = fuente;
+}
+
+void halHostDispararPin(uint8_t pin) {
+    if (pin < CANT_PINES && isrPin[pin]) isrPin[pin]();
+}
+
+bool halHostNivelPin(uint8_t pin) {
+    return pin < CANT_PINES ? nivelPin[pin] : false;
+}
+
+void halHostFijarDigital(uint8_t pin, bool nivel) {
+    if (pin < CANT_PINES) nivelPin[pin] = nivel;
+}
+
+void halHostAlmacen(const char* directorio) {
+    directorioAlmacen = directorio;
+}
+
+int8_t halHostCanalPin(uint8_t pin) {
+    return pin < CANT_PINES ? (int8_t)canalPin[pin] - 1 : -1;
+}
+
+uint32_t halHostDutyCanal(uint8_t canal) {
+    return canal < CANT_CANALES ? dutyCanal[canal] : 0;
+}
+
+uint8_t halHostResolucionCanal(uint8_t canal) {
+    return canal < CANT_CANALES ? resolucionCanal[canal] : 0;
+}
+
+const HalContadores& halHostContadores() {
+    return contadores;
+}
+
+#endif
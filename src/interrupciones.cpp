@@ -13,48 +13,29 @@
 // FLAGS
 // ============================
 /** @brief Bandera volátil que indica si el sistema está en ejecución. */
-volatile bool RUN = false;
+HILO_LOCAL volatile bool RUN = false;
 
 /** @brief Bandera volátil para la gestión del estado de setpoint. */
-volatile bool SETPOINT = true;
+HILO_LOCAL volatile bool SETPOINT = true;
 
-/** @brief Bandera volátil que señaliza el vencimiento del periodo del temporizador. */
-volatile bool has_expired = false;
+/** @brief Bandera de línea perdida (entrada de la FSM hacia PERDIDO). */
+HILO_LOCAL volatile bool LINEA_PERDIDA = false;
 
-// ============================
-// TIMER
-// ============================
-/** @brief Puntero al objeto del temporizador de hardware del ESP32. */
-static hw_timer_t *timer = NULL;
-
-/** @brief Periodo del temporizador en microsegundos (6000 us = 6ms). */
-const int32_t TIEMPO_TIMER = 6000;              
-
-/** @brief Tiempo diferencial fijo calculado en segundos para el PID. */
-const float FIXED_DT_S = TIEMPO_TIMER * 1e-6f;  
-
-// ============================
-// ISR TIMER
-// ============================
-/**
- @brief ISR del Timer.
- @details Solo señaliza que el tiempo ha expirado activando la bandera has_expired. 
- Se ejecuta en IRAM para minimizar latencias.
- */
-void IRAM_ATTR timerInterrupcion() {
-    has_expired = true;
-}
+/** @brief Bandera de sintonía pedida (entrada de la FSM hacia SINTONIA). */
+HILO_LOCAL volatile bool SINTONIA = false;
 
 // ============================
 // ISR BOTONES
 // ============================
 /**
  @brief ISR asociada al botón RUN.
- @details Activa las banderas RUN y SETPOINT para iniciar la lógica de movimiento.
+ @details Activa las banderas RUN y SETPOINT para iniciar la lógica de movimiento. La línea se
+ da por vista hasta que ACEL lea la barra.
  */
 void IRAM_ATTR handleRun() {
     RUN = true;
     SETPOINT = true;
+    LINEA_PERDIDA = false;
 }
 
 /**
@@ -69,24 +50,12 @@ void IRAM_ATTR handleStop() {
 // SETUP INTERRUPCIONES
 // ============================
 /**
- @brief Configura el hardware de interrupciones y el temporizador.
- @details Asocia los pines de los botones a sus ISR correspondientes y 
- configura el Timer 0 del ESP32 con un prescaler de 80 para contar en microsegundos.
+ @brief Configura el hardware de interrupciones.
+ @details Asocia los pines de los botones a sus ISR correspondientes. El periodo del control ya no
+ lo marca un timer de hardware sino el planificador (ver planificador.hpp).
  */
 void setupInterrupciones() {
-    // Interrupciones FISICAS de arranque y parada
-    attachInterrupt(digitalPinToInterrupt(BTN_RUN), handleRun, RISING);
-    attachInterrupt(digitalPinToInterrupt(BTN_STOP), handleStop, RISING);
-
-    // Interrupciones por TIMER - Creamos el Timer 0, dividimos los 80MHz en 80 - cada 1us
-    timer = timerBegin(0, 80, true);
-
-    // Asocia la funcion de interrupcion (ISR)
-    timerAttachInterrupt(timer, &timerInterrupcion, true);
-    
-    // Configura cada cuánto se activa la interrupcion
-    timerAlarmWrite(timer, TIEMPO_TIMER, true);
-   
-    // Enciende el timer para que empiece a generar las interrupciones
-    timerAlarmEnable(timer);
+    // Interrupciones FISICAS de arranque y parada (flanco ascendente)
+    halInterrupcionPin(BTN_RUN, handleRun);
+    halInterrupcionPin(BTN_STOP, handleStop);
 }
@@ -0,0 +1,518 @@
+/**
+ @file mapa.cpp
+ @brief Implementación del mapa de curvatura de la pista y de la velocidad planificada.
+ @details Los acumuladores del segmento son de 64 bits: con el robot casi quieto un segmento puede tardar
+ miles de ejecuciones.
+ @author Legion de Ohm
+ */
+
+#include "mapa.hpp"
+#include "config.hpp"
+#include "pid.hpp"
+
+/** @brief Mayor tiempo entre ejecuciones que se integra (una pausa más larga no es avance). */
+static const uint32_t MAPA_DT_MAX_US = 20000;
+
+/** @brief Valores absolutos, uno cada `MAPA_CLAVE` segmentos. */
+static HILO_LOCAL int8_t claves[MAPA_SEGMENTOS / MAPA_CLAVE];
+
+/** @brief Diferencias de 4 bits con signo, dos por byte (el segmento par en el nibble bajo). */
+static HILO_LOCAL uint8_t diferencias[MAPA_SEGMENTOS / 2];
+
+/** @brief Último valor reconstruido por el codificador (el que verá el decodificador). */
+static HILO_LOCAL int8_t reconstruida = 0;
+
+/** @brief Acumuladores del segmento en curso (%·us): avance, diferencial y suma de los motores. */
+static HILO_LOCAL int64_t avance = 0, diferencial = 0, suma = 0;
+
+/** @brief Instante de la ejecución anterior. */
+static HILO_LOCAL uint32_t anterior_us = 0;
+
+/** @brief false hasta la primera ejecución de la carrera (no hay instante anterior). */
+static HILO_LOCAL bool conAnterior = false;
+
+/** @brief Segmentos recientes guardados: la ventana más los anteriores que entran en el promedio del primero. */
+static const uint8_t MAPA_RECIENTES = MAPA_VENTANA + MAPA_SUAVIZADO - 1;
+
+/** @brief Curvatura de los últimos `MAPA_RECIENTES` segmentos (anillo; `recientes` cuenta los válidos). */
+static HILO_LOCAL int8_t reciente[MAPA_RECIENTES];
+static HILO_LOCAL uint8_t posReciente = 0, recientes = 0;
+
+/**
+ @struct Referencia
+ @brief Ventana grabada con la que se compara la reciente para cerrar la vuelta.
+ */
+struct Referencia {
+    int16_t inicio;     ///< Primer segmento de la ventana (-1 hasta ver la primera curva).
+    int16_t candidato;  ///< Vuelta con la mejor comparación pendiente de confirmar (-1 sin candidato).
+    int32_t suma;       ///< Suma de diferencias del candidato.
+    int16_t vuelta;     ///< Vuelta propuesta: el candidato ya confirmado como mínimo (-1 sin propuesta).
+};
+
+/** @brief Dos ventanas de cierre seguidas: la vuelta que propone la primera se acepta si la segunda la repite. */
+static HILO_LOCAL Referencia referencias[2];
+
+/** @brief Primer segmento grabado de la vuelta que quedó como mapa (múltiplo de `MAPA_CLAVE`). */
+static HILO_LOCAL uint16_t inicioVuelta = 0;
+
+/** @brief Segmentos comparados al ubicarse: `MAPA_VENTANA`, o la vuelta entera si es más corta. */
+static HILO_LOCAL uint8_t ventana = MAPA_VENTANA;
+
+/** @brief Segmentos recientes que entran en la comparación: `ventana`, o menos después de una pausa. */
+static HILO_LOCAL uint8_t comparados = MAPA_VENTANA;
+
+/** @brief Segmentos seguidos sin que la ventana reciente coincida con el mapa (con el mapa listo). */
+static HILO_LOCAL uint8_t sinCoincidir = 0;
+
+/** @brief Velocidad planificada del segmento actual. */
+static HILO_LOCAL uint8_t plan = 0;
+
+/** @brief Búsqueda en toda la vuelta en curso (mapa desubicado, repartida entre ejecuciones). */
+static HILO_LOCAL bool buscando = false;
+
+/** @brief Ventana reciente al empezar la búsqueda y ventana del mapa del candidato (anillo), ya promediadas. */
+static HILO_LOCAL int8_t buscada[MAPA_VENTANA], ventanaMapa[MAPA_VENTANA];
+static HILO_LOCAL uint8_t posVentanaMapa = 0;
+
+/** @brief Últimos segmentos del mapa decodificados en orden por la búsqueda (anillo) y su suma. */
+static HILO_LOCAL int8_t crudosBusqueda[MAPA_SUAVIZADO];
+static HILO_LOCAL uint8_t posCrudosBusqueda = 0;
+static HILO_LOCAL int16_t sumaBusqueda = 0;
+
+/** @brief Segmento final del candidato, el mejor hasta ahora, su comparación y su energía. */
+static HILO_LOCAL int32_t finBusqueda = 0, finMejor = 0, sumaMejor = 0, energiaMejor = 0;
+
+/** @brief Segmentos cerrados desde que empezó la búsqueda (el robot siguió avanzando). */
+static HILO_LOCAL uint16_t avanzados = 0;
+
+/** @brief Resumen del mapa. */
+static HILO_LOCAL EstadoMapa estado = { MAPA_APRENDIENDO, 0, 0, 0, 0 };
+
+// ============================
+// CODIFICACION
+// ============================
+/** @brief Suma con saturación a ±127 (la misma en el codificador y el decodificador). */
+static int8_t sumar(int8_t valor, int8_t delta) {
+    int16_t s = (int16_t)valor + delta;
+    return (int8_t)constrain(s, -127, 127);
+}
+
+/** @brief Diferencia de 4 bits guardada para un segmento que no es clave, ya multiplicada por el paso. */
+static int8_t diferencia(uint16_t indice) {
+    uint8_t nibble = (diferencias[indice >> 1] >> ((indice & 1) * 4)) & 0x0F;
+    return (int8_t)(((int8_t)(nibble << 4) >> 4) * MAPA_PASO_DELTA);
+}
+
+/** @brief Guarda la curvatura de un segmento nuevo (cuantizando contra lo reconstruido). */
+static void guardar(uint16_t indice, int8_t curvatura) {
+    if (indice % MAPA_CLAVE == 0) {
+        claves[indice / MAPA_CLAVE] = curvatura;
+        reconstruida = curvatura;
+        return;
+    }
+
+    int16_t error = (int16_t)curvatura - reconstruida;
+    int16_t q = (error + (error >= 0 ? MAPA_PASO_DELTA / 2 : -MAPA_PASO_DELTA / 2)) / MAPA_PASO_DELTA;
+    q = constrain(q, -8, 7);
+
+    uint8_t desplazamiento = (indice & 1) * 4;
+    uint8_t& byte = diferencias[indice >> 1];
+    byte = (uint8_t)((byte & ~(0x0F << desplazamiento)) | ((q & 0x0F) << desplazamiento));
+    reconstruida = sumar(reconstruida, (int8_t)(q * MAPA_PASO_DELTA));
+}
+
+int8_t curvaturaMapa(uint16_t indice) {
+    uint16_t clave = indice - indice % MAPA_CLAVE;
+    int8_t valor = claves[clave / MAPA_CLAVE];
+    for (uint16_t j = clave + 1; j <= indice; j++) valor = sumar(valor, diferencia(j));
+    return valor;
+}
+
+/** @brief Decodifica el segmento grabado @p indice a partir del anterior (la vuelta empieza en una clave, así que sirve al dar la vuelta). */
+static int8_t siguienteMapa(uint16_t indice, int8_t anterior) {
+    return indice % MAPA_CLAVE == 0 ? claves[indice / MAPA_CLAVE] : sumar(anterior, diferencia(indice));
+}
+
+// ============================
+// COMPARACION
+// ============================
+/** @brief Segmento reciente @p j de los últimos `comparados` (0 = el más viejo), promediado con los `MAPA_SUAVIZADO` - 1 anteriores. */
+static int8_t recienteEn(uint8_t j) {
+    uint8_t ultimo = (uint8_t)(posReciente + MAPA_RECIENTES - comparados + j);
+    int16_t suma = 0;
+    for (uint8_t s = 0; s < MAPA_SUAVIZADO; s++) suma += reciente[(ultimo - s) % MAPA_RECIENTES];
+    return (int8_t)(suma / MAPA_SUAVIZADO);
+}
+
+/** @brief Agrega la curvatura de un segmento a la ventana reciente. */
+static void recordar(int8_t curvatura) {
+    reciente[posReciente] = curvatura;
+    posReciente = (posReciente + 1) % MAPA_RECIENTES;
+    if (recientes < MAPA_RECIENTES) recientes++;
+}
+
+/** @brief Segmento grabado para el segmento @p i de la vuelta, módulo @p largo (también para los negativos). */
+static uint16_t grabado(int32_t i, int32_t largo) {
+    return (uint16_t)(inicioVuelta + ((i - inicioVuelta) % largo + largo) % largo);
+}
+
+/**
+ @brief Compara los últimos `comparados` segmentos con los del mapa que empiezan en @p desde (módulo @p largo).
+ @details Ambos lados se promedian de a `MAPA_SUAVIZADO` segmentos. El mapa se decodifica en orden: una
+ búsqueda de clave y después un paso por segmento.
+ @param energia Recibe la suma de |curvatura| de ambas ventanas.
+ @return int32_t Suma de diferencias absolutas, cada una con tope `MAPA_TOPE`.
+ */
+static int32_t comparar(int32_t desde, int32_t largo, int32_t& energia) {
+    int8_t crudos[MAPA_SUAVIZADO];
+    int16_t suma = 0;
+    int32_t primero = desde - (MAPA_SUAVIZADO - 1);
+    int8_t guardada = curvaturaMapa(grabado(primero, largo));
+    for (uint8_t s = 0; s < MAPA_SUAVIZADO; s++) {
+        if (s > 0) guardada = siguienteMapa(grabado(primero + s, largo), guardada);
+        crudos[s] = guardada;
+        suma += guardada;
+    }
+
+    int32_t total = 0;
+    energia = 0;
+    for (uint8_t j = 0; j < comparados; j++) {
+        if (j > 0) {
+            guardada = siguienteMapa(grabado(desde + j, largo), guardada);
+            uint8_t s = (uint8_t)((j + MAPA_SUAVIZADO - 1) % MAPA_SUAVIZADO);  // el más viejo
+            suma += guardada - crudos[s];
+            crudos[s] = guardada;
+        }
+        int8_t mapa = (int8_t)(suma / MAPA_SUAVIZADO);
+        int8_t propia = recienteEn(j);
+        int32_t d = abs(propia - mapa);
+        total += d < MAPA_TOPE ? d : MAPA_TOPE;
+        energia += abs(propia) + abs(mapa);
+    }
+    return total;
+}
+
+/** @brief Comparación con la ventana del mapa que termina en el segmento @p fin de la vuelta. */
+static int32_t compararHasta(int32_t fin, int32_t& energia) {
+    return comparar(fin - (comparados - 1), estado.largo, energia);
+}
+
+/** @brief true si una comparación se parece: bajo el umbral y chica contra la curvatura de las ventanas. */
+static bool parecida(int32_t total, int32_t energia) {
+    return total <= MAPA_UMBRAL * comparados && total * MAPA_PARECIDO <= energia;
+}
+
+/** @brief Velocidad de curva para una curvatura, entre `velocidadRecta` y `velocidadCurva`. */
+static uint8_t velocidadCurvatura(int8_t curvatura) {
+    int32_t k = abs(curvatura);
+    if (k > MAPA_CURVA_LLENA) k = MAPA_CURVA_LLENA;
+    return (uint8_t)(velocidadRecta - ((int32_t)(velocidadRecta - velocidadCurva) * k) / MAPA_CURVA_LLENA);
+}
+
+/** @brief Recalcula la velocidad planificada del segmento actual mirando `MAPA_ANTICIPO` segmentos adelante. */
+static void planificar() {
+    uint8_t v = velocidadRecta;
+    for (uint8_t j = 0; j <= MAPA_ANTICIPO; j++) {
+        uint8_t c = velocidadCurvatura(curvaturaMapa(grabado(estado.indice + j, estado.largo)));
+        if (c < v) v = c;
+    }
+    plan = v;
+}
+
+// ============================
+// SEGMENTOS
+// ============================
+/** @brief Vuelta a la que está comparando la referencia @p r en el segmento @p n (distancia entre ambas ventanas). */
+static int32_t vueltaComparada(const Referencia& r, uint16_t n) {
+    return (int32_t)n - (MAPA_VENTANA - 1) - r.inicio;
+}
+
+/**
+ @brief Compara la ventana reciente con la referencia @p r y sigue su mínimo.
+ @details El cierre de una referencia es el mínimo de la comparación: se propone cuando el segmento siguiente
+ ya no mejora. La vuelta más corta que se compara es media ventana (las ventanas pueden solaparse: la de
+ referencia empieza en la recta antes de la curva, así que solo coincide consigo misma en un múltiplo de la
+ vuelta).
+ @return bool true si la ventana reciente se parece a la referencia.
+ */
+static bool compararReferencia(Referencia& r, uint16_t n) {
+    int32_t vuelta = vueltaComparada(r, n);
+    if (vuelta < MAPA_VENTANA / 2) return false;
+
+    int32_t energia;
+    int32_t total = comparar(r.inicio, estado.segmentos, energia);
+    bool igual = parecida(total, energia);
+    if (r.vuelta >= 0) return igual;
+
+    if (igual && (r.candidato < 0 || total < r.suma)) {
+        r.candidato = (int16_t)vuelta;
+        r.suma = total;
+    } else if (r.candidato >= 0) {
+        r.vuelta = r.candidato;
+    }
+    return igual;
+}
+
+/** @brief Referencia nueva que empieza en @p inicio, sin candidato. */
+static Referencia referenciaEn(int32_t inicio) {
+    return Referencia{ (int16_t)inicio, -1, 0, -1 };
+}
+
+/**
+ @brief Cierra la vuelta con largo @p largo en el segmento @p n.
+ @details El mapa es la última vuelta grabada, desde una clave: la primera puede tener el arranque o un
+ desvío que no se repite.
+ */
+static void cerrarVuelta(uint16_t largo, uint16_t n) {
+    estado.largo = largo;
+    inicioVuelta = (uint16_t)((n + 1 - largo) - (n + 1 - largo) % MAPA_CLAVE);
+    estado.indice = (uint16_t)((n + 1) % largo);
+    estado.fase = MAPA_LISTO;
+    ventana = comparados = (uint8_t)(largo < MAPA_VENTANA ? largo : MAPA_VENTANA);
+    planificar();
+}
+
+/**
+ @brief Aprendizaje: compara con dos ventanas de referencia seguidas y cierra cuando ambas dan la misma vuelta.
+ @details Una sola ventana puede dar una vuelta falsa (un tramo que se parece a otro) o no repetirse nunca
+ (la primera pasada por una curva fue distinta). La vuelta que propone la primera se acepta si la segunda
+ también se parece a ±1 segmento de esa distancia; si no, se descarta y la primera sigue buscando. Si la
+ segunda propone antes, la primera no se repite en esa vuelta: se descarta y la segunda pasa a ser la
+ primera, con una nueva a continuación.
+ */
+static void aprender(uint16_t n) {
+    Referencia& primera = referencias[0];
+    Referencia& segunda = referencias[1];
+    if (primera.inicio < 0) {
+        if (abs(curvaturaMapa(n)) >= MAPA_CURVA_MIN) {
+            primera = referenciaEn(n >= 2 ? n - 2 : 0);
+            segunda = referenciaEn(primera.inicio + MAPA_VENTANA);
+        }
+        return;
+    }
+
+    compararReferencia(primera, n);
+    bool repite = compararReferencia(segunda, n);
+    int32_t vueltaSegunda = vueltaComparada(segunda, n);
+
+    if (primera.vuelta >= 0) {
+        if (repite && abs(vueltaSegunda - primera.vuelta) <= 1) {
+            cerrarVuelta((uint16_t)primera.vuelta, n);
+            return;
+        }
+        if (vueltaSegunda > primera.vuelta + 1) primera.candidato = primera.vuelta = -1;
+    }
+    if (segunda.vuelta >= 0 && primera.vuelta < 0) {
+        primera = segunda;
+        primera.candidato = -1;
+        segunda = referenciaEn(primera.inicio + MAPA_VENTANA);
+    }
+}
+
+/** @brief Con la vuelta cerrada: avanza el segmento actual y lo corrige comparando con el mapa. */
+static void ubicar() {
+    int32_t largo = estado.largo;
+    int32_t energia;
+
+    if (estado.fase == MAPA_LISTO) {
+        // Desplazamiento con la menor diferencia; ante un empate se queda con el más cercano a 0
+        int32_t energiaMejor;
+        int32_t mejor = compararHasta(estado.indice, energiaMejor), desplazamiento = 0;
+        for (int32_t d = 1; d <= MAPA_BUSQUEDA; d++) {
+            int32_t adelante = compararHasta(estado.indice + d, energia);
+            if (adelante < mejor) { mejor = adelante; desplazamiento = d; energiaMejor = energia; }
+            int32_t atras = compararHasta(estado.indice - d, energia);
+            if (atras < mejor)    { mejor = atras;    desplazamiento = -d; energiaMejor = energia; }
+        }
+        // Solo se mueve con una coincidencia clara; si no coincide sigue por odometría y se desubica recién
+        // después de media ventana seguida sin coincidir
+        bool coincide = desplazamiento == 0 ? mejor <= MAPA_UMBRAL * comparados : parecida(mejor, energiaMejor);
+        if (!coincide) {
+            if (++sinCoincidir >= ventana / 2) {
+                estado.fase = MAPA_DESUBICADO;
+                return;
+            }
+            desplazamiento = 0;
+        } else {
+            sinCoincidir = 0;
+        }
+        if (desplazamiento != 0) estado.correcciones++;
+        estado.indice = (uint16_t)(((estado.indice + desplazamiento + 1) % largo + largo) % largo);
+        planificar();
+        return;
+    }
+
+    // Desubicado: con una búsqueda en curso solo cuenta el avance
+    if (buscando) {
+        avanzados++;
+        return;
+    }
+
+    // Busca en toda la vuelta solo con una ventana que tenga alguna curva (en una recta todo coincide)
+    int32_t propia = 0;
+    for (uint8_t j = 0; j < ventana; j++) propia += abs(recienteEn(j));
+    if (propia < MAPA_CURVA_MIN * ventana / 2) return;
+
+    // La ventana de este segmento contra todas las del mapa, empezando por la que termina en el segmento 0:
+    // los segmentos de la vuelta desde `primero` hasta el 0 se decodifican en orden
+    const int32_t primero = -(int32_t)(ventana + MAPA_SUAVIZADO - 2);
+    int8_t crudo = curvaturaMapa(grabado(primero, largo));
+    sumaBusqueda = 0;
+    for (int32_t i = primero; i <= 0; i++) {
+        if (i > primero) crudo = siguienteMapa(grabado(i, largo), crudo);
+        uint8_t s = (uint8_t)((i - primero) % MAPA_SUAVIZADO);
+        if (i - primero >= MAPA_SUAVIZADO) sumaBusqueda -= crudosBusqueda[s];
+        crudosBusqueda[s] = crudo;
+        sumaBusqueda += crudo;
+        int32_t j = i - primero - (MAPA_SUAVIZADO - 1);
+        if (j >= 0) ventanaMapa[j] = (int8_t)(sumaBusqueda / MAPA_SUAVIZADO);
+    }
+    posCrudosBusqueda = (uint8_t)((1 - primero) % MAPA_SUAVIZADO);
+    for (uint8_t j = 0; j < ventana; j++) buscada[j] = recienteEn(j);
+    posVentanaMapa = 0;
+    finBusqueda = 0;
+    sumaMejor = INT32_MAX;
+    avanzados = 0;
+    buscando = true;
+}
+
+/** @brief Termina la búsqueda en toda la vuelta: si la mejor ventana se parece, vuelve a ubicar el mapa. */
+static void terminarBusqueda() {
+    buscando = false;
+    if (!parecida(sumaMejor, energiaMejor)) return;     // el próximo segmento busca de nuevo
+    estado.indice = (uint16_t)((finMejor + 1 + avanzados) % estado.largo);
+    estado.fase = MAPA_LISTO;
+    estado.correcciones++;
+    sinCoincidir = 0;
+    planificar();
+}
+
+/**
+ @brief Compara `MAPA_CANDIDATOS` ventanas del mapa con la buscada.
+ @details El mapa se recorre en orden: cada candidato decodifica un solo segmento (la clave o el anterior más
+ su diferencia), así que el costo por ejecución es fijo, O(`MAPA_CANDIDATOS` · `MAPA_VENTANA`).
+ */
+static void buscarEnVuelta() {
+    for (uint8_t k = 0; k < MAPA_CANDIDATOS; k++) {
+        int32_t total = 0, energia = 0;
+        for (uint8_t j = 0; j < ventana; j++) {
+            int8_t guardada = ventanaMapa[(posVentanaMapa + j) % ventana];
+            int32_t d = abs(buscada[j] - guardada);
+            total += d < MAPA_TOPE ? d : MAPA_TOPE;
+            energia += abs(buscada[j]) + abs(guardada);
+        }
+        if (total < sumaMejor) { sumaMejor = total; energiaMejor = energia; finMejor = finBusqueda; }
+
+        if (++finBusqueda == estado.largo) {
+            terminarBusqueda();
+            return;
+        }
+        // Desliza la ventana un segmento: decodifica solo el nuevo y actualiza la suma del promedio
+        int8_t ultimo = crudosBusqueda[(posCrudosBusqueda + MAPA_SUAVIZADO - 1) % MAPA_SUAVIZADO];
+        int8_t crudo = siguienteMapa(grabado(finBusqueda, estado.largo), ultimo);
+        sumaBusqueda += crudo - crudosBusqueda[posCrudosBusqueda];
+        crudosBusqueda[posCrudosBusqueda] = crudo;
+        posCrudosBusqueda = (posCrudosBusqueda + 1) % MAPA_SUAVIZADO;
+        ventanaMapa[posVentanaMapa] = (int8_t)(sumaBusqueda / MAPA_SUAVIZADO);
+        posVentanaMapa = (posVentanaMapa + 1) % ventana;
+    }
+}
+
+/** @brief Cierra el segmento en curso: curvatura, guardado (aprendiendo) y ubicación. */
+static void cerrarSegmento() {
+    // 128 * integral(der - izq) / integral(media) = 256 * integral(der - izq) / integral(der + izq)
+    int32_t curvatura = suma > 0 ? (int32_t)((diferencial * 256) / suma) : 0;
+    int8_t k = (int8_t)constrain(curvatura, -127, 127);
+
+    if (estado.fase == MAPA_APRENDIENDO) {
+        uint16_t n = estado.segmentos++;
+        guardar(n, k);
+        recordar(curvaturaMapa(n));     // la ventana reciente usa lo mismo que quedó en el mapa
+        aprender(n);
+        if (estado.fase == MAPA_APRENDIENDO && estado.segmentos == MAPA_SEGMENTOS) estado.fase = MAPA_LLENO;
+    } else if (estado.fase != MAPA_LLENO) {
+        recordar(k);
+        // Después de una pausa (la línea perdida) la ventana reciente se vuelve a llenar: mientras tanto, con
+        // el mapa listo, se compara la parte ya llena si tiene al menos media ventana
+        uint8_t llenos = recientes >= MAPA_SUAVIZADO ? recientes - (MAPA_SUAVIZADO - 1) : 0;
+        comparados = llenos < ventana ? llenos : ventana;
+        if (comparados == ventana || (estado.fase == MAPA_LISTO && comparados >= MAPA_VENTANA / 2)) {
+            ubicar();
+        } else {
+            // Recién largada o después de una pausa: todavía no hay ventana para comparar, se sigue por odometría
+            estado.indice = (uint16_t)((estado.indice + 1) % estado.largo);
+            planificar();
+        }
+    }
+
+    avance -= (int64_t)MAPA_PASO * 1000;
+    diferencial = suma = 0;
+}
+
+// ============================
+// INTERFAZ
+// ============================
+void registrarMapa(int32_t izq, int32_t der) {
+    uint32_t ahora = halMicros();
+    uint32_t dt = conAnterior ? ahora - anterior_us : 0;
+    anterior_us = ahora;
+    conAnterior = true;
+    if (dt > MAPA_DT_MAX_US) {
+        // Una pausa larga es la línea perdida (PERDIDO no registra): lo reciente ya no está seguido
+        dt = MAPA_DT_MAX_US;
+        if (estado.fase != MAPA_APRENDIENDO) {
+            recientes = 0;
+            buscando = false;
+        }
+    }
+
+    int32_t media = (izq + der) / 2;
+    if (media < 0) media = 0;
+    avance += (int64_t)media * dt;
+    diferencial += (int64_t)(der - izq) * dt;
+    suma += (int64_t)abs(izq + der) * dt;
+
+    if (avance >= (int64_t)MAPA_PASO * 1000) cerrarSegmento();
+    if (buscando) buscarEnVuelta();
+}
+
+void arrancarMapa() {
+    if (estado.fase != MAPA_LISTO && estado.fase != MAPA_DESUBICADO) {
+        reiniciarMapa();
+        return;
+    }
+    avance = diferencial = suma = 0;
+    conAnterior = false;
+    recientes = 0;
+    posReciente = 0;
+    buscando = false;
+    sinCoincidir = 0;
+    estado.fase = MAPA_LISTO;
+    estado.indice = 0;
+    planificar();
+}
+
+void reiniciarMapa() {
+    estado = EstadoMapa{ MAPA_APRENDIENDO, 0, 0, 0, 0 };
+    referencias[0] = referencias[1] = referenciaEn(-1);
+    inicioVuelta = 0;
+    ventana = comparados = MAPA_VENTANA;
+    sinCoincidir = 0;
+    recientes = 0;
+    posReciente = 0;
+    buscando = false;
+    avance = diferencial = suma = 0;
+    conAnterior = false;
+}
+
+bool mapaListo() {
+    return estado.fase == MAPA_LISTO;
+}
+
+uint8_t velocidadMapa() {
+    return mapaListo() ? plan : baseSpeed;
+}
+
+const EstadoMapa& estadoMapa() {
+    return estado;
+}
@@ -6,11 +6,14 @@
  @author Legion de Ohm
  */
 
-#include <Arduino.h>
+#include <cmath>
+#include "hal.hpp"
 #include "sensores.hpp"
 #include "config.hpp"
 #include "motores.hpp"
 #include "pid.hpp"
+#include "gobernador.hpp"
+#include "mapa.hpp"
 #include "interrupciones.hpp"
 
 /**
@@ -35,58 +38,92 @@ void Drv8833::setup(uint8_t pinIN1, uint8_t pinIN2, uint8_t pinSleep, uint8_t ch
     _freqPWM = freqPWM;
     _resPWM = resPWM;
 
-    pinMode(_pinIN1, OUTPUT);
-    pinMode(_pinIN2, OUTPUT);
-    pinMode(_pinSleep, OUTPUT);
+    _direccion = MOTOR_SIN_CONFIGURAR;
+    _duty = UINT32_MAX;
+    _llamadasHal = 0;
 
-    digitalWrite(_pinSleep, HIGH); // Habilitar driver
+    halPinModo(_pinIN1, HAL_SALIDA);
+    halPinModo(_pinIN2, HAL_SALIDA);
+    halPinModo(_pinSleep, HAL_SALIDA);
 
-    ledcSetup(_chPWM, _freqPWM, _resPWM);
+    halEscribirDigital(_pinSleep, true); // Habilitar driver
+
+    halPwmConfigurar(_chPWM, _freqPWM, _resPWM);
 }
 
 /**
- @brief Mueve el motor hacia adelante.
- @details Desvincula el pin IN2 del PWM y lo pone en LOW, mientras vincula IN1 al canal PWM.
- @param pPWM Porcentaje de potencia [0-100].
+ @brief Reenruta IN1/IN2 para la nueva dirección.
+ @details El pin que deja de llevar PWM se desvincula y se pone en LOW; el que pasa a llevarlo se
+ vincula al canal. Desde DETENIDO ambos pines ya están en LOW y solo hace falta vincular uno.
+ @param nueva Dirección a aplicar.
  */
-void Drv8833::forward(uint8_t pPWM) {
-    ledcDetachPin(_pinIN2); 
-    digitalWrite(_pinIN2, LOW);      
+void Drv8833::_enrutar(DireccionMotor nueva) {
+    bool desconocido = (_direccion == MOTOR_SIN_CONFIGURAR);
+
+    // Liberar el pin que llevaba el PWM (o ambos si no se conoce el estado)
+    if (desconocido || (_direccion == MOTOR_AVANCE && nueva != MOTOR_AVANCE)) {
+        halPwmDesasociar(_pinIN1);
+        halEscribirDigital(_pinIN1, false);
+        _llamadasHal += 2;
+    }
+    if (desconocido || (_direccion == MOTOR_REVERSA && nueva != MOTOR_REVERSA)) {
+        halPwmDesasociar(_pinIN2);
+        halEscribirDigital(_pinIN2, false);
+        _llamadasHal += 2;
+    }
+
+    if (nueva == MOTOR_AVANCE) {
+        halPwmAsociar(_pinIN1, _chPWM);
+        _llamadasHal++;
+    } else if (nueva == MOTOR_REVERSA) {
+        halPwmAsociar(_pinIN2, _chPWM);
+        _llamadasHal++;
+    }
 
-    ledcAttachPin(_pinIN1, _chPWM);
+    _direccion = nueva;
+}
 
+/**
+ @brief Convierte el porcentaje a cuentas del PWM y lo escribe solo si cambió.
+ @param pPWM Porcentaje de potencia [0-100].
+ */
+void Drv8833::_escribirDuty(uint8_t pPWM) {
     uint16_t maxDuty = (1 << _resPWM) - 1;
     uint16_t pwmDutyCycle = (maxDuty * pPWM) / 100;
 
-    ledcWrite(_chPWM, pwmDutyCycle);  
+    if (pwmDutyCycle == _duty) return;
+
+    halPwmEscribir(_chPWM, pwmDutyCycle);
+    _duty = pwmDutyCycle;
+    _llamadasHal++;
+}
+
+/**
+ @brief Mueve el motor hacia adelante.
+ @details Si venía en otra dirección, desvincula el pin IN2 del PWM y lo pone en LOW, y vincula IN1 al canal PWM.
+ @param pPWM Porcentaje de potencia [0-100].
+ */
+void Drv8833::forward(uint8_t pPWM) {
+    if (_direccion != MOTOR_AVANCE) _enrutar(MOTOR_AVANCE);
+    _escribirDuty(pPWM);
 }
 
 /**
  @brief Mueve el motor hacia atrás.
- @details Desvincula el pin IN1 del PWM y lo pone en LOW, mientras vincula IN2 al canal PWM.
+ @details Si venía en otra dirección, desvincula el pin IN1 del PWM y lo pone en LOW, y vincula IN2 al canal PWM.
  @param pPWM Porcentaje de potencia [0-100].
  */
 void Drv8833::reverse(uint8_t pPWM) {
-    ledcDetachPin(_pinIN1);
-    digitalWrite(_pinIN1, LOW);
-
-    ledcAttachPin(_pinIN2, _chPWM);
-
-    uint16_t maxDuty = (1 << _resPWM) - 1;
-    uint16_t pwmDutyCycle = (maxDuty * pPWM) / 100;
-
-    ledcWrite(_chPWM, pwmDutyCycle);
+    if (_direccion != MOTOR_REVERSA) _enrutar(MOTOR_REVERSA);
+    _escribirDuty(pPWM);
 }
 
 /**
  @brief Detiene el motor desvinculando ambos pines del PWM y poniéndolos en LOW.
+ @details Si ya estaba detenido no toca los pines.
  */
 void Drv8833::stop() {
-    ledcDetachPin(_pinIN1);
-    ledcDetachPin(_pinIN2);
-
-    digitalWrite(_pinIN1, LOW);
-    digitalWrite(_pinIN2, LOW);
+    if (_direccion != MOTOR_DETENIDO) _enrutar(MOTOR_DETENIDO);
 }
 
 // ============================
@@ -94,9 +131,9 @@ void Drv8833::stop() {
 // ============================
 
 /** @brief Instancia estática para el motor izquierdo. */
-static Drv8833 motorIzq;
+static HILO_LOCAL Drv8833 motorIzq;
 /** @brief Instancia estática para el motor derecho. */
-static Drv8833 motorDer;
+static HILO_LOCAL Drv8833 motorDer;
 
 /** @brief Canal PWM para motor izquierdo. */
 static const uint8_t motorPWM_Izq = 0;
@@ -108,10 +145,24 @@ static const uint32_t freqPWM = 20000;
 /** @brief Resolución del PWM (8 bits). */
 static const uint8_t  resPWM  = 8;     
 
+// VELOCIDADES  - PORCENTAJE DE PWM (0-100%)
+/** @brief Límite máximo de velocidad de los motores (PWM %). */
+const int32_t maxSpeed  = 90;  
+
+/** @brief Rueda exterior durante la búsqueda de la línea perdida (PWM %). */
+HILO_LOCAL int32_t busquedaExterior = 90;
+/** @brief Rueda interior durante la búsqueda (PWM %, negativo = reversa: gira casi sobre el eje). */
+HILO_LOCAL int32_t busquedaInterior = -30;
+
+/** @brief Con `MEZCLADOR`: la diferencia entre ruedas tiene prioridad sobre la velocidad base (false = recorte por rueda). */
+HILO_LOCAL bool prioridadGiro = true;
+/** @brief Piso de la rueda interior con `MEZCLADOR` (PWM %): 0 = sin reversa, -maxSpeed = reversa completa. */
+HILO_LOCAL int32_t pisoInterior = -maxSpeed;
+
 /** @brief Almacena la velocidad calculada para el motor izquierdo. */
-int32_t motorSpeedIzq = 0;
+HILO_LOCAL int32_t motorSpeedIzq = 0;
 /** @brief Almacena la velocidad calculada para el motor derecho. */
-int32_t motorSpeedDer = 0;
+HILO_LOCAL int32_t motorSpeedDer = 0;
 
 /**
  @brief Inicializa el hardware de ambos motores y los detiene inicialmente.
@@ -135,9 +186,6 @@ void setupMotores() {
  @param motorSpeedDer Velocidad para el motor derecho (positivo = avance).
  */
 void moverMotores(int32_t motorSpeedIzq, int32_t motorSpeedDer) {
-    deb(Serial.printf("MotorIzq=%d\n", motorSpeedIzq);)
-    deb(Serial.printf("MotorDer=%d\n", motorSpeedDer);)
-
     if      (motorSpeedIzq > 0) {   motorIzq.forward(motorSpeedIzq);        }
     else if (motorSpeedIzq < 0) {   motorIzq.reverse(abs(motorSpeedIzq));   }
     else                        {   motorIzq.stop();    }
@@ -147,6 +195,13 @@ void moverMotores(int32_t motorSpeedIzq, int32_t motorSpeedDer) {
     else                        {   motorDer.stop();    }   
 }
 
+/**
+ @brief Suma las llamadas a la HAL de ambos drivers.
+ */
+uint32_t llamadasHalMotores() {
+    return motorIzq.llamadasHal() + motorDer.llamadasHal();
+}
+
 /**
  @brief Envía la señal de parada a ambos motores.
  */
@@ -163,19 +218,92 @@ void actualizarSP(uint16_t pos) {
     SETPOINT = (abs(pos - setpoint) < zonaMuerta);
 }
 
+/**
+ @brief Fija las velocidades de búsqueda hacia el lado de la última posición vista.
+ @details Con la línea perdida `pos` es el extremo (0 o 7000) donde se la vio por última vez; la rueda de
+ ese lado va a `busquedaInterior` y la otra a `busquedaExterior`, el mismo sentido de giro que daría el PID.
+ @param pos Posición devuelta por la barra sin línea.
+ */
+void busquedaMotores(uint16_t pos) {
+    if (pos < setpoint) {
+        motorSpeedIzq = busquedaExterior;
+        motorSpeedDer = busquedaInterior;
+    } else {
+        motorSpeedIzq = busquedaInterior;
+        motorSpeedDer = busquedaExterior;
+    }
+}
+
+/**
+ @brief Velocidad base de CONTROL.
+ @details Con `GOBERNADOR` es la del gobernador (`velocidadGobernada()`) en vez de `baseSpeed`; con
+ `MAPA_PISTA` y el mapa listo, la planificada para el segmento (`velocidadMapa()`).
+ */
+float velocidadBase() {
+    float base = baseSpeed;
+    gob(base = velocidadGobernada();)
+    mapa(if (mapaListo()) base = velocidadMapa();)
+    return base;
+}
+
+/**
+ @brief Reparte la velocidad base y la corrección entre las ruedas, dentro de los límites de los motores.
+ @details Sin `MEZCLADOR` (o con `prioridadGiro` en false) cada rueda se recorta sola a ±maxSpeed. Con
+ `MEZCLADOR` la diferencia entre ruedas (2·|corrección|) tiene prioridad: si cabe entre `pisoInterior` y
+ `maxSpeed` se corre la velocidad base hasta que la rueda exterior quede en `maxSpeed` (o la interior en el
+ piso); si no cabe, exterior en `maxSpeed` e interior en el piso, el giro más fuerte posible.
+ @param base Velocidad base (%).
+ @param correcion Corrección del PID (%).
+ @param izq Velocidad del motor izquierdo (%).
+ @param der Velocidad del motor derecho (%).
+ @return float Corrección que queda aplicada: la misma si no hubo que recortar el giro.
+ */
+static inline float mezclarMotores(float base, float correcion, float& izq, float& der) {
+#ifdef MEZCLADOR
+    if (prioridadGiro) {
+        float giro = fabsf(correcion);
+        float exterior, interior;
+        if (2 * giro <= maxSpeed - pisoInterior) {
+            base = constrain(base, pisoInterior + giro, maxSpeed - giro);
+            exterior = base + giro;
+            interior = base - giro;
+        } else {
+            exterior = maxSpeed;
+            interior = pisoInterior;
+            correcion = copysignf((maxSpeed - pisoInterior) * 0.5f, correcion);
+        }
+        der = (correcion >= 0) ? exterior : interior;
+        izq = (correcion >= 0) ? interior : exterior;
+        return correcion;
+    }
+#endif
+    der = constrain(base + correcion, -maxSpeed, maxSpeed);
+    izq = constrain(base - correcion, -maxSpeed, maxSpeed);
+    if (der == base + correcion && izq == base - correcion) return correcion;
+    return (der - izq) * 0.5f;
+}
+
+/**
+ @brief Corrección efectiva después de los límites de los motores (ver `mezclarMotores()`).
+ */
+float correccionAplicada(float correcion) {
+    float izq, der;
+    return mezclarMotores(velocidadBase(), correcion, izq, der);
+}
+
 /**
  @brief Calcula las velocidades individuales aplicando la corrección diferencial.
- @details Si el robot está fuera de la zona muerta, ajusta las velocidades base 
- sumando o restando la corrección y limita los valores al rango @f$ \pm @f$maxSpeed.
+ @details Si el robot está fuera de la zona muerta, ajusta las velocidades base (`velocidadBase()`)
+ sumando o restando la corrección y limita los valores al rango @f$ \pm @f$maxSpeed (con `MEZCLADOR`,
+ bajando la base para no perder la diferencia entre ruedas).
  @param correcion Valor de corrección obtenido del PID.
  */
 void controlMotores(float correcion) {
     if ( !SETPOINT ) {
-        motorSpeedIzq = baseSpeed - correcion;
-        motorSpeedDer = baseSpeed + correcion;
-
-        motorSpeedIzq = constrain(motorSpeedIzq, -maxSpeed, maxSpeed);
-        motorSpeedDer = constrain(motorSpeedDer, -maxSpeed, maxSpeed);
+        float izq, der;
+        mezclarMotores(velocidadBase(), correcion, izq, der);
+        motorSpeedIzq = izq;
+        motorSpeedDer = der;
         return;
     }
 
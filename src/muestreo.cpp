@@ -0,0 +1,167 @@
+/**
+ @file muestreo.cpp
+ @brief Implementación de la adquisición de cuadros de la barra QTR-8A.
+ @author Legion de Ohm
+ */
+
+#include "muestreo.hpp"
+#include "filtros.hpp"
+#include "config.hpp"
+
+/** @brief Conversiones promediadas por sensor en cada cuadro: 4 como QTRSensors, o `FILTRO_SOBREMUESTREO`. */
+static const uint8_t muestrasPorSensor = FILTRO_SOBREMUESTREO;
+
+/** @brief Pines de la barra: S8 y S7 (ADC2) primero, después S6 a S1 (ADC1). */
+static const uint8_t sensorPins[CANT_SENSORES] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Sensores al comienzo de `sensorPins` que están en el ADC2. */
+static const uint8_t CANT_ADC2 = 2;
+
+/** @brief Conversiones por segundo del DMA (mínimo del ESP32): ~3300 por sensor del ADC1. */
+static const uint32_t FRECUENCIA_ADC_HZ = 20000;
+
+/** @brief Tamaño de cada lectura del DMA. */
+static const uint16_t BLOQUE_DMA = 32;
+
+/** @brief Espera máxima por una conversión de cada sensor del ADC1: tres rondas de 6 conversiones a 20 kHz. */
+static const uint32_t ESPERA_DMA_US = 1000;
+
+/** @brief El DMA del ADC1 está convirtiendo; si no, `leerCuadroContinuo()` usa la lectura directa. */
+static HILO_LOCAL bool dmaActivo = false;
+
+/** @brief Últimas conversiones de cada sensor del ADC1 (ventana circular). */
+static HILO_LOCAL uint16_t historial[CANT_SENSORES][muestrasPorSensor];
+
+/** @brief Conversiones recibidas por sensor (se satura en `muestrasPorSensor`). */
+static HILO_LOCAL uint8_t conteo[CANT_SENSORES];
+
+/** @brief Próxima posición a escribir de cada ventana. */
+static HILO_LOCAL uint8_t posicionHistorial[CANT_SENSORES];
+
+/** @brief Índice en la barra de cada GPIO, o 255 si el pin no es un sensor. */
+static HILO_LOCAL uint8_t indicePin[40];
+
+// ============================
+// INICIO
+// ============================
+void iniciarMuestreo() {
+    // Lectura analogica (ADC) - los pines de entrada no requieren configuracion adicional
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) halPinModo(sensorPins[i], HAL_ENTRADA);
+
+#ifdef ADC_CONTINUO
+    // Sin DMA el robot igual corre con la lectura directa: el aviso sale también sin DEBUG
+    if (!iniciarMuestreoContinuo()) Serial.println("ADC continuo: no se pudo iniciar el DMA, se usa la lectura directa");
+#endif
+}
+
+bool iniciarMuestreoContinuo() {
+    for (uint8_t p = 0; p < 40; p++) indicePin[p] = 255;
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        indicePin[sensorPins[i]] = i;
+        conteo[i] = 0;
+        posicionHistorial[i] = 0;
+    }
+
+    dmaActivo = halAdcContinuoIniciar(&sensorPins[CANT_ADC2], CANT_SENSORES - CANT_ADC2, FRECUENCIA_ADC_HZ);
+    return dmaActivo;
+}
+
+bool muestreoContinuoActivo() {
+    return dmaActivo;
+}
+
+// ============================
+// LECTURA DIRECTA (QTR)
+// ============================
+/**
+ @details Mismo orden de conversiones y redondeo que `QTRSensors::read()` en modo analógico.
+ */
+void leerCuadroDirecto(CuadroSensores& cuadro) {
+    uint16_t suma[CANT_SENSORES] = {0};
+    cuadro.instante_us = halMicros();
+
+    for (uint8_t j = 0; j < muestrasPorSensor; j++) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) suma[i] += halLeerAnalogico(sensorPins[i]);
+    }
+
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        cuadro.crudo[i] = (suma[i] + (muestrasPorSensor >> 1)) / muestrasPorSensor;
+    }
+    cuadro.duracion_us = halMicros() - cuadro.instante_us;
+}
+
+// ============================
+// LECTURA CONTINUA (DMA + ADC2)
+// ============================
+/**
+ @brief Vacía lo que convirtió el DMA, guardando en cada ventana las conversiones más nuevas.
+ @return bool true si todos los sensores del ADC1 tienen al menos una conversión.
+ */
+static bool vaciarDma() {
+    HalMuestraAdc bloque[BLOQUE_DMA];
+    uint16_t n;
+
+    do {
+        n = halAdcContinuoLeer(bloque, BLOQUE_DMA);
+        for (uint16_t k = 0; k < n; k++) {
+            uint8_t i = bloque[k].pin < 40 ? indicePin[bloque[k].pin] : 255;
+            if (i == 255) continue;
+
+            historial[i][posicionHistorial[i]] = bloque[k].valor;
+            posicionHistorial[i] = (posicionHistorial[i] + 1) % muestrasPorSensor;
+            if (conteo[i] < muestrasPorSensor) conteo[i]++;
+        }
+    } while (n == BLOQUE_DMA);
+
+    for (uint8_t i = CANT_ADC2; i < CANT_SENSORES; i++) {
+        if (conteo[i] == 0) return false;
+    }
+    return true;
+}
+
+/**
+ @details Si el DMA no arrancó, o deja de entregar conversiones durante `ESPERA_DMA_US`, el cuadro (y los
+ siguientes) se toman con `leerCuadroDirecto()`: la espera por el ADC1 nunca queda colgada.
+ */
+void leerCuadroContinuo(CuadroSensores& cuadro) {
+    if (!dmaActivo) {
+        leerCuadroDirecto(cuadro);
+        return;
+    }
+
+    uint16_t suma[CANT_ADC2] = {0};
+    cuadro.instante_us = halMicros();
+
+    // ADC2 (S8, S7): conversiones únicas mientras el DMA sigue llenando el ADC1
+    for (uint8_t j = 0; j < muestrasPorSensor; j++) {
+        for (uint8_t i = 0; i < CANT_ADC2; i++) suma[i] += halAdcUnico(sensorPins[i]);
+    }
+    for (uint8_t i = 0; i < CANT_ADC2; i++) {
+        cuadro.crudo[i] = (suma[i] + (muestrasPorSensor >> 1)) / muestrasPorSensor;
+    }
+
+    // ADC1 (S6 a S1): promedio de las últimas conversiones del DMA
+    while (!vaciarDma()) {
+        if (halMicros() - cuadro.instante_us > ESPERA_DMA_US) {
+            dmaActivo = false;
+            Serial.println("ADC continuo: el DMA no entrega conversiones, se usa la lectura directa");
+            leerCuadroDirecto(cuadro);
+            return;
+        }
+    }
+
+    for (uint8_t i = CANT_ADC2; i < CANT_SENSORES; i++) {
+        uint32_t total = 0;
+        for (uint8_t k = 0; k < conteo[i]; k++) total += historial[i][k];
+        cuadro.crudo[i] = (total + (conteo[i] >> 1)) / conteo[i];
+    }
+    cuadro.duracion_us = halMicros() - cuadro.instante_us;
+}
+
+void leerCuadro(CuadroSensores& cuadro) {
+#ifdef ADC_CONTINUO
+    leerCuadroContinuo(cuadro);
+#else
+    leerCuadroDirecto(cuadro);
+#endif
+}
@@ -0,0 +1,101 @@
+/**
+ @file observador.cpp
+ @brief Implementación del observador alfa-beta de la línea en punto fijo.
+ @details Las cuentas intermedias (velocidad por tiempo, ganancia por residuo) se hacen en 64 bits: con la
+ posición en Q8 (hasta ~1.8e6) y las ganancias en Q16 el producto no entra en 32.
+ @author Legion de Ohm
+ */
+
+#include "observador.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+
+/** @brief Posición máxima en Q8. */
+static const int32_t POSICION_MAX_Q = (int32_t)7000 << OBSERVADOR_Q;
+
+/** @brief Convierte una ganancia a Q16 redondeando (en compilación para las de la bandera). */
+constexpr int32_t gananciaQ(float valor) {
+    return (int32_t)(valor * (float)((int32_t)1 << OBSERVADOR_Q_GANANCIA) + 0.5f);
+}
+
+/** @brief Ganancia de posición en uso (Q16). */
+static HILO_LOCAL int32_t alfaQ = gananciaQ(OBSERVADOR_ALFA);
+
+/** @brief Ganancia de velocidad en uso (Q16). */
+static HILO_LOCAL int32_t betaQ = gananciaQ(OBSERVADOR_BETA);
+
+/** @brief Estimación actual. */
+static HILO_LOCAL EstadoObservador estado = {};
+
+/**
+ @brief Tiempo desde el último cuadro en ticks de `TIEMPO_TIMER`, en Q8.
+ @details `TIEMPO_TIMER` es constante: el compilador cambia la división por una multiplicación.
+ */
+static int32_t ticksDesde(uint32_t instante_us) {
+    uint32_t dt = instante_us - estado.instante_us;
+    if (dt > OBSERVADOR_HUECO_MAX_US) dt = OBSERVADOR_HUECO_MAX_US;
+    return (int32_t)((dt << OBSERVADOR_Q) / (uint32_t)TIEMPO_TIMER);
+}
+
+/** @brief Posición en Q8 predicha a @p dtQ ticks (Q8) del último cuadro. */
+static int32_t prediccion(int32_t dtQ) {
+    return estado.posicion + (int32_t)(((int64_t)estado.velocidad * dtQ) >> OBSERVADOR_Q);
+}
+
+/** @brief Arranca la estimación en una medición, con velocidad 0. */
+static void arrancar(uint16_t posicion, uint32_t instante_us) {
+    estado.posicion = (int32_t)posicion << OBSERVADOR_Q;
+    estado.velocidad = 0;
+    estado.instante_us = instante_us;
+    estado.valido = true;
+}
+
+uint16_t observarLinea(uint16_t posicion, uint32_t instante_us, bool enLinea) {
+    if (!enLinea) {
+        estado.valido = false;
+        return posicion;
+    }
+
+    uint32_t hueco = instante_us - estado.instante_us;
+    if (!estado.valido || hueco > OBSERVADOR_HUECO_MAX_US) {
+        arrancar(posicion, instante_us);
+        return posicion;
+    }
+
+    // Mismo cuadro que el tick anterior: no hay medición nueva, se predice hasta ahora
+    if (hueco == 0) return predecirLinea(halMicros());
+
+    // Predicción al instante del cuadro y corrección con el residuo
+    int32_t dtQ = ticksDesde(instante_us);
+    if (dtQ == 0) dtQ = 1;
+    int32_t predicha = prediccion(dtQ);
+    int32_t residuo = ((int32_t)posicion << OBSERVADOR_Q) - predicha;
+
+    estado.posicion = predicha + (int32_t)(((int64_t)alfaQ * residuo) >> OBSERVADOR_Q_GANANCIA);
+    estado.velocidad += (int32_t)((((int64_t)betaQ * residuo) >> (OBSERVADOR_Q_GANANCIA - OBSERVADOR_Q)) / dtQ);
+    estado.posicion = constrain(estado.posicion, 0, POSICION_MAX_Q);
+    estado.instante_us = instante_us;
+    return posicion;
+}
+
+uint16_t predecirLinea(uint32_t instante_us) {
+    int32_t p = estado.valido ? prediccion(ticksDesde(instante_us)) : estado.posicion;
+    return (uint16_t)((constrain(p, 0, POSICION_MAX_Q) + (1 << (OBSERVADOR_Q - 1))) >> OBSERVADOR_Q);
+}
+
+const EstadoObservador& estadoObservador() {
+    return estado;
+}
+
+int32_t velocidadLinea() {
+    return estado.valido ? estado.velocidad : 0;
+}
+
+void fijarGananciasObservador(float alfa, float beta) {
+    alfaQ = gananciaQ(alfa);
+    betaQ = gananciaQ(beta);
+}
+
+void reiniciarObservador() {
+    estado = EstadoObservador();
+}
@@ -6,38 +6,109 @@
  @author Legion de Ohm
  */
 
-#include <Arduino.h>
+#include <cmath>
+#include "hal.hpp"
 #include "config.hpp"
-//#include "drv8833.hpp"
 #include "pid.hpp"
+#include "interrupciones.hpp"
+#include "observador.hpp"
+
+#if CORREDOR == SINTONIZADO
+  #include "perfil_sintonizado.hpp"   // Generado por test/sintonizador.cpp
+#endif
+
+// SETPOINT y ZONA MUERTA
+/** @brief Valor objetivo de lectura para estar centrado sobre la línea. */
+HILO_LOCAL uint16_t setpoint = 3500;       
+
+/** @brief Margen de error aceptable alrededor del setpoint. */
+#if CORREDOR == SINTONIZADO
+HILO_LOCAL uint16_t zonaMuerta = SINTONIZADO_ZONA_MUERTA;
+#else
+HILO_LOCAL uint16_t zonaMuerta = 50;      
+#endif
 
 /** @brief Almacena el error de la iteración anterior para el cálculo de la parte derivativa. */
-float  lastError = 0;
+HILO_LOCAL float  lastError = 0;
 
 /** @brief Acumulador del error en el tiempo para el cálculo de la parte integral. */
-float  integral = 0;
+HILO_LOCAL float  integral = 0;
 
-/** @brief Almacena la marca de tiempo de la última ejecución (no utilizado en la versión actual). */
-uint32_t lastTime = 0;
+/** @brief Términos de la última corrección (solo se escriben con CAJA_NEGRA). */
+static HILO_LOCAL TerminosPID terminos = { 0, 0, 0 };
+
+
+// ===================================
+// PERFILES DE CORREDOR
+// ===================================
+/**
+ @brief Tabla de perfiles, en el orden de los identificadores NIGHTFALL (1), ARGENTUM (2) y DIEGO (3).
+ @details Bandas (`PID_BANDAS`): a 50% 1.6 veces el Ku del perfil, bajando hasta el del perfil a 90%. En
+ el simulador más ganancia baja el error a velocidad media y baja, pero a 80-90% ya hace perder tiempo y
+ con el doble a 50% se sale en `esquinas` (ver `test/prueba_bandas.cpp`). Tu queda igual en todas.
+ Opciones (`PID_OPCIONES`): integración condicional en los tres. En horquillas cerradas del simulador baja
+ el sobrepaso a la salida de la curva de 3-9 mm a 1-2 mm; el retrocálculo queda apenas peor y el tope y la
+ derivada sobre la medición no mejoran nada con el setpoint fijo (ver `test/prueba_opciones.cpp`).
+ Gobernador (`GOBERNADOR`): recta y curva propias, más bajas que las del mapa, porque frena recién cuando
+ crece el error. Con las del mapa perdía la línea en `esquinas` el doble de veces que con `baseSpeed`; con
+ estas no la pierde más que con una velocidad constante (ver `test/prueba_gobernador.cpp`).
+ */
+constexpr PerfilCorredor perfilesCorredor[] = {
+    //  nombre     base  Ku      Tu      mapa: recta curva  gobernador: recta curva subida bajada
+    //  Ku y Tu por banda:  50%     60%     70%     80%     90%
+    //  anti-windup, tope de Ki·integral, derivada sobre la medición
+    { "NIGHTFALL", 70, 0.065f, 0.350f, 90,   70,   85,   40,   500.0f,  5000.0f,
+                        { 0.104f, 0.0975f, 0.091f, 0.078f, 0.065f },
+                        { 0.350f, 0.350f, 0.350f, 0.350f, 0.350f },
+                        INTEGRACION_CONDICIONAL, 0, false },
+    { "ARGENTUM",  78, 0.05f,  0.31f,  90,   78,   90,   70,   1000.0f, 2000.0f,
+                        { 0.080f, 0.075f, 0.070f, 0.060f, 0.050f },
+                        { 0.310f, 0.310f, 0.310f, 0.310f, 0.310f },
+                        INTEGRACION_CONDICIONAL, 0, false },
+    { "DIEGO",     70, 0.05f,  0.38f,  90,   70,   90,   55,   1500.0f, 20000.0f,
+                        { 0.080f, 0.075f, 0.070f, 0.060f, 0.050f },
+                        { 0.380f, 0.380f, 0.380f, 0.380f, 0.380f },
+                        INTEGRACION_CONDICIONAL, 0, false },
+};
+
+/** @brief Cantidad de perfiles definidos. */
+const uint8_t cantPerfiles = sizeof(perfilesCorredor) / sizeof(perfilesCorredor[0]);
 
 
 // ===================================
 // SELECCION DE CORREDOR - CAMBIAR EN PLATFORMIO.INI
 // ===================================
-#if (CORREDOR == NIGHTFALL)
-    uint8_t baseSpeed = 70;         ///< Velocidad crucero para NIGHTFALL (0-100%).
-    const float Ku = 0.065;         ///< Ganancia última para NIGHTFALL.
-    const float Tu = 0.350;         ///< Periodo último para NIGHTFALL.
-#elif (CORREDOR == ARGENTUM)
-    uint8_t baseSpeed = 78;         ///< Velocidad crucero para ARGENTUM (0-100%).
-    const float Ku = 0.05;          ///< Ganancia última para ARGENTUM.
-    const float Tu = 0.31;          ///< Periodo último para ARGENTUM.
-#elif (CORREDOR == DIEGO)
-    uint8_t baseSpeed = 70;         ///< Velocidad crucero para DIEGO (0-100%).
-    const float Ku = 0.05;          ///< Ganancia última para DIEGO.
-    const float Tu = 0.38;          ///< Periodo último para DIEGO.
+#if (CORREDOR != NIGHTFALL) && (CORREDOR != ARGENTUM) && (CORREDOR != DIEGO) && (CORREDOR != SINTONIZADO)
+  #error "Valor de CORREDOR inválido. Use NIGHTFALL, ARGENTUM, DIEGO o SINTONIZADO."
+#endif
+
+#if CORREDOR == SINTONIZADO
+HILO_LOCAL uint8_t baseSpeed = SINTONIZADO_BASE_SPEED;          ///< Velocidad crucero encontrada por el sintonizador.
+constexpr float Ku = SINTONIZADO_KU;                            ///< Ganancia última del perfil de partida.
+constexpr float Tu = SINTONIZADO_TU;                            ///< Periodo último del perfil de partida.
+// El sintonizador no busca el gobernador ni el mapa: recta = curva = crucero, sin límite de pendiente, es la velocidad constante
+HILO_LOCAL uint8_t velocidadRecta = SINTONIZADO_BASE_SPEED;     ///< Mapa: velocidad lejos de las curvas.
+HILO_LOCAL uint8_t velocidadCurva = SINTONIZADO_BASE_SPEED;     ///< Mapa: velocidad en la curva más cerrada.
+HILO_LOCAL uint8_t rectaGobernador = SINTONIZADO_BASE_SPEED;    ///< Gobernador: velocidad con error nulo.
+HILO_LOCAL uint8_t curvaGobernador = SINTONIZADO_BASE_SPEED;    ///< Gobernador: velocidad con la carga máxima.
+HILO_LOCAL float subidaGobernador = 1e6f;                       ///< Gobernador: pendiente de subida (%/s).
+HILO_LOCAL float bajadaGobernador = 1e6f;                       ///< Gobernador: pendiente de bajada (%/s).
+HILO_LOCAL AntiWindup antiWindup = SIN_ANTIWINDUP;              ///< Opciones: el sintonizador no las busca.
+HILO_LOCAL float topeIntegral = 0;                              ///< Opciones: sin tope de la integral.
+HILO_LOCAL bool derivadaMedicion = false;                       ///< Opciones: D sobre el error.
 #else
-  #error "Valor de CORREDOR inválido. Use NIGHTFALL, ARGENTUM o DIEGO."
+HILO_LOCAL uint8_t baseSpeed = perfilesCorredor[CORREDOR - 1].baseSpeed;   ///< Velocidad crucero del perfil (0-100%).
+constexpr float Ku = perfilesCorredor[CORREDOR - 1].Ku;        ///< Ganancia última del perfil.
+constexpr float Tu = perfilesCorredor[CORREDOR - 1].Tu;        ///< Periodo último del perfil.
+HILO_LOCAL uint8_t velocidadRecta = perfilesCorredor[CORREDOR - 1].velocidadRecta;  ///< Mapa: velocidad lejos de las curvas.
+HILO_LOCAL uint8_t velocidadCurva = perfilesCorredor[CORREDOR - 1].velocidadCurva;  ///< Mapa: velocidad en la curva más cerrada.
+HILO_LOCAL uint8_t rectaGobernador = perfilesCorredor[CORREDOR - 1].rectaGobernador; ///< Gobernador: velocidad con error nulo.
+HILO_LOCAL uint8_t curvaGobernador = perfilesCorredor[CORREDOR - 1].curvaGobernador; ///< Gobernador: velocidad con la carga máxima.
+HILO_LOCAL float subidaGobernador = perfilesCorredor[CORREDOR - 1].subida;          ///< Gobernador: pendiente de subida (%/s).
+HILO_LOCAL float bajadaGobernador = perfilesCorredor[CORREDOR - 1].bajada;          ///< Gobernador: pendiente de bajada (%/s).
+HILO_LOCAL AntiWindup antiWindup = perfilesCorredor[CORREDOR - 1].antiWindup;       ///< Opciones: anti-windup.
+HILO_LOCAL float topeIntegral = perfilesCorredor[CORREDOR - 1].topeIntegral;        ///< Opciones: |Ki·integral| máximo (%).
+HILO_LOCAL bool derivadaMedicion = perfilesCorredor[CORREDOR - 1].derivadaMedicion; ///< Opciones: D sobre la medición.
 #endif
 
 
@@ -45,17 +116,261 @@ uint32_t lastTime = 0;
 // CONTROL PID - METODO Ziegler-Nichols
 // ============================
 #ifdef TEST_PID
-    const float Kp = Ku;            ///< Configuración de prueba: Solo P.
-    const float Ki = 0;             ///< Configuración de prueba: I desactivada.
-    const float Kd = 0;             ///< Configuración de prueba: D desactivada.
+    constexpr float KpPerfil = Ku;      ///< Configuración de prueba: Solo P.
+    constexpr float KiPerfil = 0;       ///< Configuración de prueba: I desactivada.
+    constexpr float KdPerfil = 0;       ///< Configuración de prueba: D desactivada.
+#elif CORREDOR == SINTONIZADO
+    constexpr float KpPerfil = SINTONIZADO_KP;  ///< Ganancia Proporcional del sintonizador.
+    constexpr float KiPerfil = SINTONIZADO_KI;  ///< Ganancia Integral del sintonizador.
+    constexpr float KdPerfil = SINTONIZADO_KD;  ///< Ganancia Derivativa del sintonizador.
 #else
     /** @brief Ganancia Proporcional según sintonización clásica de Ziegler-Nichols (0.6 * Ku). */
-    const float Kp = 0.6 * Ku;
+    constexpr float KpPerfil = 0.6 * Ku;
     /** @brief Ganancia Integral calculada como @f$ 2 \cdot K_p / T_u @f$. */
-    const float Ki = 2 * Kp / Tu;
+    constexpr float KiPerfil = 2 * KpPerfil / Tu;
     /** @brief Ganancia Derivativa calculada como @f$ K_p \cdot T_u / 8 @f$. */
-    const float Kd = Kp * Tu / 8;
+    constexpr float KdPerfil = KpPerfil * Tu / 8;
+#endif
+
+HILO_LOCAL float Kp = KpPerfil;     ///< Ganancia Proporcional en uso (arranca con la del perfil).
+HILO_LOCAL float Ki = KiPerfil;     ///< Ganancia Integral en uso.
+HILO_LOCAL float Kd = KdPerfil;     ///< Ganancia Derivativa en uso.
+
+
+// ============================
+// GANANCIAS EN PUNTO FIJO
+// ============================
+/**
+ @brief Convierte un real a punto fijo con `bits` fraccionarios, redondeando al más cercano.
+ @details Es `constexpr` para plegar las ganancias del perfil compilado sin costo en el arranque.
+ */
+constexpr int32_t aPuntoFijo(float valor, uint8_t bits) {
+    return (int32_t)(valor * (float)((int32_t)1 << bits) + (valor < 0 ? -0.5f : 0.5f));
+}
+
+/** @brief Mayor ganancia Q16 que multiplicada por el error máximo (7000) entra en 32 bits. */
+static const int32_t GANANCIA_MAX_Q = INT32_MAX / 7000;
+
+/** @brief Límite del acumulador de errores (deja margen para sumar un error más sin desbordar). */
+static const int32_t SUMA_MAX = (int32_t)1 << 30;
+
+constexpr int32_t KP_Q = aPuntoFijo(KpPerfil, PID_Q);                  ///< Kp del perfil en Q16.
+constexpr int32_t KD_Q = aPuntoFijo(KdPerfil / FIXED_DT_S, PID_Q);     ///< Kd/dt del perfil en Q16.
+constexpr int32_t KI_Q = aPuntoFijo(KiPerfil * FIXED_DT_S, PID_Q_I);   ///< Ki·dt del perfil en Q28.
+
+static_assert(KP_Q <= GANANCIA_MAX_Q && KD_Q <= GANANCIA_MAX_Q,
+              "Kp o Kd/dt no entran en Q16: reducir Kd o alargar TIEMPO_TIMER_US");
+static_assert(KiPerfil == 0 || KI_Q > 0, "Ki*dt es demasiado chico para Q28");
+
+HILO_LOCAL int32_t kpQ = KP_Q;      ///< Kp plegada en uso (Q16).
+HILO_LOCAL int32_t kdQ = KD_Q;      ///< Kd/dt plegada en uso (Q16).
+HILO_LOCAL int32_t kiQ = KI_Q;      ///< Ki·dt plegada en uso (Q28).
+
+/** @brief Error del tick anterior para la parte derivativa de `calculo_pid_fijo()`. */
+HILO_LOCAL int32_t lastErrorFijo = 0;
+
+/** @brief Suma de los errores de cada tick (la integral sin el factor dt, que va en kiQ). */
+HILO_LOCAL int32_t sumaErrores = 0;
+
+
+// ============================
+// OPCIONES DEL PID
+// ============================
+/** @brief Posición anterior para la derivada sobre la medición (-1 = recién reiniciado, sin anterior). */
+static HILO_LOCAL int32_t posicionAnterior = -1;
+
+/** @brief Lo mismo para `calculo_pid_fijo()`. */
+static HILO_LOCAL int32_t posicionAnteriorFijo = -1;
+
+/** @brief Lado hacia el que los motores recortaron la corrección en el último tick (+1, -1 o 0). */
+static HILO_LOCAL int8_t ladoSaturado = 0;
+
+/** @brief @f$ \Delta T / T_t @f$ con @f$ T_t = T_u/4 @f$, a lo sumo 1 (no descuenta más de lo recortado). */
+static float retroCalculoDe(float tu) {
+    return fminf(1, FIXED_DT_S * 4 / tu);
+}
+
+/** @brief Fracción de lo recortado que el retrocálculo descuenta por tick. */
+static HILO_LOCAL float retroCalculo = retroCalculoDe(Tu);
+
+/** @brief `topeIntegral` en Q16 para `calculo_pid_fijo()` (lo pliega `plegarGanancias()`). */
+#if CORREDOR == SINTONIZADO
+static HILO_LOCAL int32_t topeIntegralQ = 0;
+#else
+static HILO_LOCAL int32_t topeIntegralQ = aPuntoFijo(perfilesCorredor[CORREDOR - 1].topeIntegral, PID_Q);
+#endif
+
+
+// ============================
+// GANANCIAS POR VELOCIDAD
+// ============================
+/** @brief Ganancias de una banda de velocidad, en flotante y plegadas como las de `calculo_pid_fijo()`. */
+struct GananciasBanda {
+    float kp, ki, kd;               ///< Para `calculo_pid()`.
+    int32_t kpQ, kiQ, kdQ;          ///< Para `calculo_pid_fijo()`: Kp y Kd/dt en Q16, Ki·dt en Q28.
+};
+
+/** @brief Ganancias de todas las bandas (un arreglo envuelto para poder copiarlo y armarlo en compilación). */
+struct TablaBandas {
+    GananciasBanda banda[BANDAS_PID];
+};
+
+/** @brief Arma una banda a partir de Kp, Ki y Kd, plegando como `plegarGanancias()`. */
+constexpr GananciasBanda gananciasBanda(float kp, float ki, float kd) {
+    return { kp, ki, kd,
+             constrain(aPuntoFijo(kp, PID_Q), 0, GANANCIA_MAX_Q),
+             aPuntoFijo(ki * FIXED_DT_S, PID_Q_I),
+             constrain(aPuntoFijo(kd / FIXED_DT_S, PID_Q), 0, GANANCIA_MAX_Q) };
+}
+
+/** @brief Tabla con las ganancias de Ziegler-Nichols del Ku/Tu de cada banda del perfil (solo P con `TEST_PID`). */
+constexpr TablaBandas tablaPerfil(const PerfilCorredor& perfil) {
+    TablaBandas tabla = {};
+    for (uint8_t b = 0; b < BANDAS_PID; b++) {
+#ifdef TEST_PID
+        tabla.banda[b] = gananciasBanda(perfil.KuBanda[b], 0, 0);
+#else
+        float kp = 0.6 * perfil.KuBanda[b];
+        tabla.banda[b] = gananciasBanda(kp, 2 * kp / perfil.TuBanda[b], kp * perfil.TuBanda[b] / 8);
+#endif
+    }
+    return tabla;
+}
+
+/** @brief Tabla con las mismas ganancias en todas las bandas. */
+constexpr TablaBandas tablaPlana(float kp, float ki, float kd) {
+    TablaBandas tabla = {};
+    for (uint8_t b = 0; b < BANDAS_PID; b++) tabla.banda[b] = gananciasBanda(kp, ki, kd);
+    return tabla;
+}
+
+/** @brief Ganancias por banda del perfil en uso (el sintonizador no busca bandas: las suyas en todas). */
+#if CORREDOR == SINTONIZADO
+static HILO_LOCAL TablaBandas tablaGanancias = tablaPlana(KpPerfil, KiPerfil, KdPerfil);
+#else
+static HILO_LOCAL TablaBandas tablaGanancias = tablaPerfil(perfilesCorredor[CORREDOR - 1]);
+#endif
+
+
+/**
+ @brief Aplica un perfil de corredor en tiempo de ejecución.
+ @details Usa las mismas fórmulas de Ziegler-Nichols que la inicialización de Kp, Ki y Kd, y arma con
+ ellas la tabla de ganancias por velocidad del perfil (la usa `programarGanancias()`).
+ @param perfil Perfil con la velocidad crucero, Ku, Tu, el mapa, el gobernador y las bandas a cargar.
+ */
+void aplicarPerfil(const PerfilCorredor& perfil) {
+    baseSpeed = perfil.baseSpeed;
+    velocidadRecta = perfil.velocidadRecta;
+    velocidadCurva = perfil.velocidadCurva;
+    rectaGobernador = perfil.rectaGobernador;
+    curvaGobernador = perfil.curvaGobernador;
+    subidaGobernador = perfil.subida;
+    bajadaGobernador = perfil.bajada;
+    antiWindup = perfil.antiWindup;
+    topeIntegral = perfil.topeIntegral;
+    derivadaMedicion = perfil.derivadaMedicion;
+    retroCalculo = retroCalculoDe(perfil.Tu);
+
+#ifdef TEST_PID
+    Kp = perfil.Ku;
+    Ki = 0;
+    Kd = 0;
+#else
+    Kp = 0.6 * perfil.Ku;
+    Ki = 2 * Kp / perfil.Tu;
+    Kd = Kp * perfil.Tu / 8;
+#endif
+    plegarGanancias();
+    tablaGanancias = tablaPerfil(perfil);
+}
+
+
+/**
+ @brief Pliega las ganancias en uso con el dt del timer (y `topeIntegral` a Q16).
+ */
+void plegarGanancias() {
+    kpQ = constrain(aPuntoFijo(Kp, PID_Q), 0, GANANCIA_MAX_Q);
+    kdQ = constrain(aPuntoFijo(Kd / FIXED_DT_S, PID_Q), 0, GANANCIA_MAX_Q);
+    kiQ = aPuntoFijo(Ki * FIXED_DT_S, PID_Q_I);
+    topeIntegralQ = aPuntoFijo(topeIntegral, PID_Q);
+}
+
+
+/**
+ @brief false si la integración condicional (`-D PID_OPCIONES`) frena la integral en este tick: el tick
+ anterior los motores recortaron la corrección y el error sigue empujando hacia ese lado.
+ */
+static inline bool integrarError(int32_t error) {
+#ifdef PID_OPCIONES
+    return antiWindup != INTEGRACION_CONDICIONAL || ladoSaturado * error <= 0;
+#else
+    (void)error;
+    return true;
 #endif
+}
+
+/**
+ @brief Anti-windup con la corrección que aplicaron los motores.
+ @details El recorte es cero mientras ningún motor llega a ±`maxSpeed` (`correccionAplicada()` devuelve la
+ misma corrección). El retrocálculo en punto fijo convierte lo descontado a la suma de errores dividiendo
+ por kiQ, solo en los ticks que saturan.
+ */
+void saturacionPid(float pedida, float aplicada) {
+    float recorte = aplicada - pedida;
+    ladoSaturado = (recorte < 0) ? 1 : (recorte > 0) ? -1 : 0;
+    if (antiWindup != RETROCALCULO || recorte == 0) return;
+
+    if (Ki > 0) integral += retroCalculo * recorte / Ki;
+    if (kiQ > 0) {
+        int64_t descuentoQ = (int64_t)(retroCalculo * recorte * PID_UNO);     // Ki·integral a descontar, Q16
+        int64_t suma = sumaErrores + ((descuentoQ << (PID_Q_I - PID_Q)) / kiQ);
+        sumaErrores = (int32_t)constrain(suma, (int64_t)-SUMA_MAX, (int64_t)SUMA_MAX);
+    }
+}
+
+
+/**
+ @brief Interpola las ganancias de la tabla en la velocidad base y reescala la integral.
+ @details La posición en la tabla va en 1/256 de banda: la parte entera es la banda de abajo y el resto la
+ fracción hacia la de arriba. Las plegadas se interpolan en enteros.
+ @param velocidad Velocidad base de los motores (%).
+ */
+void programarGanancias(float velocidad) {
+    int32_t lugar = (int32_t)((velocidad - BANDA_VELOCIDAD_MIN) * (256.0f / BANDA_PASO));
+    lugar = constrain(lugar, 0, (BANDAS_PID - 1) * 256);
+    int32_t i = lugar >> 8;
+    if (i > BANDAS_PID - 2) i = BANDAS_PID - 2;     // En 90% exacto: toda la banda de arriba
+    int32_t f = lugar - (i << 8);                   // 0 a 256
+    float ff = f * (1.0f / 256);
+    const GananciasBanda& a = tablaGanancias.banda[i];
+    const GananciasBanda& b = tablaGanancias.banda[i + 1];
+
+    float kiNueva = a.ki + (b.ki - a.ki) * ff;
+    int32_t kiQNueva = a.kiQ + (((b.kiQ - a.kiQ) * f) >> 8);
+
+    // Sin golpe: Ki·integral queda igual con la ganancia nueva (con Ki nula no hay término que conservar)
+    if (kiNueva != Ki && kiNueva > 0) integral *= Ki / kiNueva;
+    if (kiQNueva != kiQ && kiQNueva > 0) {
+        int64_t producto = (int64_t)sumaErrores * kiQ;
+        int64_t reescalada = (producto + (producto < 0 ? -kiQNueva : kiQNueva) / 2) / kiQNueva;   // Al más cercano
+        sumaErrores = (int32_t)constrain(reescalada, (int64_t)-SUMA_MAX, (int64_t)SUMA_MAX);
+    }
+
+    Kp = a.kp + (b.kp - a.kp) * ff;
+    Ki = kiNueva;
+    Kd = a.kd + (b.kd - a.kd) * ff;
+    kpQ = a.kpQ + (((b.kpQ - a.kpQ) * f) >> 8);
+    kiQ = kiQNueva;
+    kdQ = a.kdQ + (((b.kdQ - a.kdQ) * f) >> 8);
+}
+
+
+/**
+ @brief Copia las ganancias en uso a todas las bandas.
+ */
+void aplanarBandas() {
+    tablaGanancias = tablaPlana(Kp, Ki, Kd);
+}
 
 
 // ============================
@@ -70,30 +385,86 @@ uint32_t lastTime = 0;
  @return float Señal de corrección resultante de la suma ponderada de los tres términos.
  */
 float calculo_pid(uint16_t pos, float deltaTime) {
-    // Calcular deltaTime (comentado en código original)
-    //float  deltaTime = (now - lastTime) / TIME_DIVISOR; 
-    deb(Serial.printf("deltaTime=%.3f\n", deltaTime);)
-
     // Calcular el error
     float  error = pos - setpoint;               
     
     // Calcular derivativo (tasa de cambio del error)
+#ifdef OBSERVADOR
+    // Velocidad de la línea estimada por el observador (Q8 por tick): sin el ruido de la diferencia finita
+    float  derivativo = velocidadLinea() * (1.0f / (1 << OBSERVADOR_Q)) / FIXED_DT_S;
+#else
     float  derivativo = (error - lastError) / deltaTime;
+  #ifdef PID_OPCIONES
+    // Sobre la medición: un cambio de setpoint no patea, y el primer tick después de reiniciar no tiene anterior
+    if (derivadaMedicion) derivativo = (posicionAnterior < 0) ? 0 : (pos - posicionAnterior) / deltaTime;
+  #endif
+#endif
 
     // Actualizar el último error proporcional
     lastError = error;
+    posicionAnterior = pos;
 
     // Calcular integral (acumulación del error)
-    integral += error * deltaTime;
+    if (integrarError((int32_t)error)) integral += error * deltaTime;
+#ifdef PID_OPCIONES
+    if (topeIntegral > 0 && Ki > 0 && fabsf(integral * Ki) > topeIntegral) {
+        integral = copysignf(topeIntegral / Ki, integral);
+    }
+#endif
 
     // Calcular la salida del PID
     float  output = (error * Kp) + (derivativo * Kd) + (integral * Ki);
+    caja(terminos.p = error * Kp; terminos.i = integral * Ki; terminos.d = derivativo * Kd;)
 
-    deb(Serial.printf("PID=%.6f\n", output);)
     return output;
 }
 
 
+/**
+ @brief Realiza el cálculo del algoritmo PID en punto fijo.
+ @details La derivada es la diferencia de errores por tick (1/dt está en kdQ), o con `OBSERVADOR` la
+ velocidad estimada por tick, y la integral la suma de errores (dt está en kiQ). P y D se multiplican en
+ 32 bits; solo el término integral (y el D con `OBSERVADOR`) usa 64.
+ @param pos Posición actual leída por el array de sensores.
+ @return int32_t Corrección en Q16.
+ */
+int32_t calculo_pid_fijo(uint16_t pos) {
+    int32_t error = (int32_t)pos - setpoint;
+
+#ifdef OBSERVADOR
+    // Velocidad estimada en Q8 por tick: el producto con Kd/dt (Q16) se hace en 64 bits
+    int32_t terminoD = (int32_t)(((int64_t)velocidadLinea() * kdQ) >> OBSERVADOR_Q);
+#else
+    int32_t terminoD = (error - lastErrorFijo) * kdQ;
+  #ifdef PID_OPCIONES
+    if (derivadaMedicion) terminoD = (posicionAnteriorFijo < 0) ? 0 : ((int32_t)pos - posicionAnteriorFijo) * kdQ;
+  #endif
+#endif
+    lastErrorFijo = error;
+    posicionAnteriorFijo = pos;
+
+    if (integrarError(error)) sumaErrores = constrain(sumaErrores + error, -SUMA_MAX, SUMA_MAX);
+#ifdef PID_OPCIONES
+    // Tope de Ki·integral: la división solo cuando recorta
+    if (topeIntegralQ > 0 && kiQ > 0) {
+        int64_t terminoI = ((int64_t)sumaErrores * kiQ) >> (PID_Q_I - PID_Q);
+        if (terminoI > topeIntegralQ || terminoI < -topeIntegralQ) {
+            int32_t tope = (int32_t)(((int64_t)topeIntegralQ << (PID_Q_I - PID_Q)) / kiQ);
+            sumaErrores = (terminoI > 0) ? tope : -tope;
+        }
+    }
+#endif
+
+    int64_t output = (int64_t)(error * kpQ) + terminoD
+                   + (((int64_t)sumaErrores * kiQ) >> (PID_Q_I - PID_Q));
+    caja(terminos.p = (float)(error * kpQ) * (1.0f / PID_UNO);
+         terminos.i = (float)(((int64_t)sumaErrores * kiQ) >> (PID_Q_I - PID_Q)) * (1.0f / PID_UNO);
+         terminos.d = (float)terminoD * (1.0f / PID_UNO);)
+
+    return (int32_t)constrain(output, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+}
+
+
 /**
  @brief Reinicia las variables de estado del controlador.
  @details Pone a cero el error previo y el acumulador integral para evitar efectos 
@@ -102,4 +473,18 @@ float calculo_pid(uint16_t pos, float deltaTime) {
 void reiniciar_pid() {
     lastError = 0; 
     integral = 0;
+    lastErrorFijo = 0;
+    sumaErrores = 0;
+    posicionAnterior = -1;
+    posicionAnteriorFijo = -1;
+    ladoSaturado = 0;
+    terminos = { 0, 0, 0 };
+}
+
+
+/**
+ @brief Devuelve los términos de la última corrección.
+ */
+const TerminosPID& terminosPid() {
+    return terminos;
 }
\ No newline at end of file
@@ -0,0 +1,139 @@
+/**
+ @file planificador.cpp
+ @brief Implementación del planificador cooperativo de la FSM.
+ @author Legion de Ohm
+ */
+
+#include "planificador.hpp"
+#include "interrupciones.hpp"
+#include "config.hpp"
+#include "trazas.hpp"
+
+/** @brief Estadísticas de la acción de cada estado. */
+static HILO_LOCAL EstadisticasTarea tareas[CANT_ESTADOS];
+
+/** @brief Instante de la próxima liberación de la FSM. */
+static HILO_LOCAL uint32_t proxima_us = 0;
+
+/** @brief Estado cuyo periodo fijó `proxima_us`. */
+static HILO_LOCAL int estadoPlanificado = S;
+
+/** @brief Instante de `iniciarPlanificador()`. */
+static HILO_LOCAL uint32_t inicio_us = 0;
+
+/** @brief Tiempo acumulado en `halDormirHasta()`. */
+static HILO_LOCAL uint64_t ocioso_us = 0;
+
+/** @brief Comienzo del último CONTROL, para la traza del periodo. */
+traza(static HILO_LOCAL uint32_t comienzoControl_us = 0;)
+
+// ============================
+// INICIO
+// ============================
+/**
+ @brief Borra las estadísticas y deja la primera liberación de la FSM en el instante actual.
+ @details El estado planificado es el actual de la FSM, así que la grilla arranca con su periodo.
+ */
+void iniciarPlanificador() {
+    for (uint8_t e = 0; e < CANT_ESTADOS; e++) tareas[e] = EstadisticasTarea();
+
+    inicio_us = halMicros();
+    proxima_us = inicio_us;
+    estadoPlanificado = estadoFSM();
+    ocioso_us = 0;
+}
+
+// ============================
+// LIBERACION DE LA FSM
+// ============================
+/**
+ @brief Corre una transición de la FSM si ya llegó su liberación y registra la duración y la demora.
+ @details Mientras el estado no cambia las liberaciones siguen una grilla fija de `periodoEstado()`; al
+ cambiar, la grilla nueva cuenta desde esta ejecución. Si la acción terminó después de la liberación
+ siguiente, esa liberación se cuenta como perdida y se salta, sin ejecutar atrasadas.
+ @return uint32_t Instante (`halMicros()`) de la próxima liberación.
+ */
+uint32_t pasoPlanificador() {
+    uint32_t comienzo = halMicros();
+    if ((int32_t)(comienzo - proxima_us) < 0) return proxima_us;
+
+    // Entrada de 4 bits (SINTONIA LINEA_PERDIDA SETPOINT RUN) → 0 a 15
+    int estado = transicionar(entradaFSM());
+    uint32_t fin = halMicros();
+
+    EstadisticasTarea& t = tareas[estado];
+    uint32_t duracion = fin - comienzo;
+    uint32_t demora = comienzo - proxima_us;
+    t.ejecuciones++;
+    t.ultimo_us = duracion;
+    t.total_us += duracion;
+    if (duracion > t.maximo_us) t.maximo_us = duracion;
+    if (demora > t.demoraMax_us) t.demoraMax_us = demora;
+
+    // Trazas de CONTROL: demora de arranque y periodo real (solo entre dos CONTROL seguidos)
+    traza(if (estado == C) {
+        registrarDuracion(TRAZA_DEMORA, demora * halCiclosPorUs());
+        if (estadoPlanificado == C) registrarDuracion(TRAZA_PERIODO, (comienzo - comienzoControl_us) * halCiclosPorUs());
+        comienzoControl_us = comienzo;
+    })
+
+    // Grilla fija mientras el estado no cambie; al cambiar, se cuenta desde esta ejecución
+    uint32_t periodo = periodoEstado(estado);
+    proxima_us = (estado == estadoPlanificado ? proxima_us : comienzo) + periodo;
+    estadoPlanificado = estado;
+
+    if ((int32_t)(fin - proxima_us) > 0) {
+        t.perdidas++;
+        while ((int32_t)(fin - proxima_us) > 0) proxima_us += periodo;
+    }
+
+    return proxima_us;
+}
+
+/**
+ @brief Un paso del planificador y luego duerme hasta la próxima liberación, sumando el tiempo ocioso.
+ */
+void ejecutarPlanificador() {
+    uint32_t proxima = pasoPlanificador();
+
+    uint32_t antes = halMicros();
+    halDormirHasta(proxima);
+    ocioso_us += halMicros() - antes;
+}
+
+// ============================
+// MEDICIONES
+// ============================
+/**
+ @brief Estadísticas acumuladas de la acción de un estado.
+ @param estado S, A, C, P o T.
+ @return const EstadisticasTarea& Ejecuciones, tiempos, demora máxima y liberaciones perdidas.
+ */
+const EstadisticasTarea& estadisticasTarea(int estado) {
+    return tareas[estado];
+}
+
+/**
+ @brief Tiempo dormido en `halDormirHasta()` desde `iniciarPlanificador()`.
+ @return uint64_t Microsegundos ociosos.
+ */
+uint64_t tiempoOcioso() {
+    return ocioso_us;
+}
+
+/**
+ @brief Imprime por serial el periodo y las estadísticas de cada estado, y el porcentaje de tiempo ocioso.
+ */
+void imprimirPlanificador() {
+    static const char* nombres[CANT_ESTADOS] = { "STOP", "ACEL", "CONTROL", "PERDIDO", "SINTONIA" };
+    uint32_t transcurrido = halMicros() - inicio_us;
+
+    for (uint8_t e = 0; e < CANT_ESTADOS; e++) {
+        const EstadisticasTarea& t = tareas[e];
+        Serial.printf("%-8s T=%5u us  n=%7u  media=%4u us  max=%4u us  demora max=%4u us  perdidas=%u\n",
+                      nombres[e], (unsigned)periodoEstado(e), (unsigned)t.ejecuciones,
+                      (unsigned)(t.ejecuciones ? t.total_us / t.ejecuciones : 0),
+                      (unsigned)t.maximo_us, (unsigned)t.demoraMax_us, (unsigned)t.perdidas);
+    }
+    Serial.printf("Ocioso: %.1f%%\n", transcurrido ? 100.0 * ocioso_us / transcurrido : 0.0);
+}
@@ -0,0 +1,106 @@
+/**
+ @file pool_hilos.cpp
+ @brief Implementación del pool de hilos con robo de tareas (solo host).
+ @author Legion de Ohm
+ */
+
+#ifndef ARDUINO
+
+#include "pool_hilos.hpp"
+
+/** @brief Índice del hilo del pool que ejecuta el código actual, o -1 fuera del pool. */
+static thread_local int hiloActual = -1;
+
+/** @brief Pool al que pertenece el hilo actual. */
+static thread_local const PoolHilos* poolActual = nullptr;
+
+PoolHilos::PoolHilos(unsigned hilos) {
+    if (hilos == 0) hilos = std::thread::hardware_concurrency();
+    if (hilos == 0) hilos = 1;
+
+    for (unsigned i = 0; i < hilos; i++) _colas.emplace_back(new Cola());
+    for (unsigned i = 0; i < hilos; i++) _hilos.emplace_back(&PoolHilos::_trabajar, this, i);
+}
+
+PoolHilos::~PoolHilos() {
+    esperar();
+    {
+        std::lock_guard<std::mutex> lock(_m);
+        _fin = true;
+    }
+    _hayTrabajo.notify_all();
+    for (std::thread& h : _hilos) h.join();
+}
+
+void PoolHilos::encolar(Tarea tarea) {
+    unsigned destino = (poolActual == this)
+        ? (unsigned)hiloActual
+        : _siguiente.fetch_add(1) % _colas.size();
+
+    _pendientes.fetch_add(1);
+    {
+        // Se cuenta antes de publicar para que _enCola nunca quede por debajo de lo que hay en las colas;
+        // se toma _m para no perder el aviso de un hilo que está por dormirse.
+        std::lock_guard<std::mutex> lock(_m);
+        _enCola.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_colas[destino]->m);
+        _colas[destino]->tareas.push_back(std::move(tarea));
+    }
+    _hayTrabajo.notify_one();
+}
+
+void PoolHilos::esperar() {
+    std::unique_lock<std::mutex> lock(_m);
+    _terminado.wait(lock, [this] { return _pendientes.load() == 0; });
+}
+
+bool PoolHilos::_tomar(unsigned id, Tarea& tarea) {
+    // Propia: del final (lo último encolado suele tener sus datos en caché)
+    {
+        Cola& c = *_colas[id];
+        std::lock_guard<std::mutex> lock(c.m);
+        if (!c.tareas.empty()) {
+            tarea = std::move(c.tareas.back());
+            c.tareas.pop_back();
+            return true;
+        }
+    }
+    // Ajena: del principio, recorriendo a partir del vecino
+    for (size_t k = 1; k < _colas.size(); k++) {
+        Cola& c = *_colas[(id + k) % _colas.size()];
+        std::lock_guard<std::mutex> lock(c.m);
+        if (!c.tareas.empty()) {
+            tarea = std::move(c.tareas.front());
+            c.tareas.pop_front();
+            _robos.fetch_add(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PoolHilos::_trabajar(unsigned id) {
+    hiloActual = (int)id;
+    poolActual = this;
+
+    for (;;) {
+        Tarea tarea;
+        if (_tomar(id, tarea)) {
+            _enCola.fetch_sub(1);
+            tarea();
+            if (_pendientes.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(_m);
+                _terminado.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_m);
+        _hayTrabajo.wait(lock, [this] { return _fin || _enCola.load() > 0; });
+        if (_fin && _enCola.load() == 0) return;
+    }
+}
+
+#endif
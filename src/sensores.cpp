@@ -1,35 +1,85 @@
 /**
  @file sensores.cpp
  @brief Implementación de la lectura y configuración de los sensores QTR-8A.
- @details Maneja el objeto de la librería QTRSensors, el proceso de calibración inicial 
+ @details Reproduce el modo analógico de la librería QTRSensors (calibración min/max, normalización
+ 0-1000 y promedio ponderado) sobre los cuadros crudos de muestreo.cpp, de modo que la misma lectura
+ se compila en el ESP32 y en host. También maneja el proceso de calibración inicial 
  y la lógica de detección de posición según el color de la línea de competencia.
  @author Legion de Ohm
  */
 
 #include "sensores.hpp"
-#include "QTRSensors.h"
+#include "muestreo.hpp"
+#include "filtros.hpp"
 #include "config.hpp"
 #include "motores.hpp"
 #include "buzzer.hpp"
+#include <stddef.h>
 
 // ============================
 // CONFIGURACIÓN QTR
 // ============================
 
-/** @brief Objeto estático para manejar los sensores QTR. */
-static QTRSensors qtr;
-
 /** @brief Número total de sensores configurados (8 en total). */
-static const uint8_t SensorCount = 8;
+static const uint8_t SensorCount = CANT_SENSORES;
+
+/** @brief Valor inicial del mínimo de calibración (QTRSensors asume un ADC de 10 bits). */
+static const uint16_t maxValorQTR = 1023;
+
+/** @brief Valores máximos de calibración de cada sensor. */
+static HILO_LOCAL uint16_t calMaximo[SensorCount];
+
+/** @brief Valores mínimos de calibración de cada sensor. */
+static HILO_LOCAL uint16_t calMinimo[SensorCount];
+
+/** @brief Rango de calibración de cada sensor, `calMaximo - calMinimo` (con la misma vuelta de 16 bits). */
+static HILO_LOCAL uint16_t calRango[SensorCount];
+
+/** @brief Recíproco de `calRango` en punto fijo: `x * 1000 * recMult >> recDesp` == `x * 1000 / calRango` (0 si el rango es 0). */
+static HILO_LOCAL uint32_t recMult[SensorCount];
+
+/** @brief Desplazamiento de `recMult` para cada sensor. */
+static HILO_LOCAL uint8_t recDesp[SensorCount];
+
+/** @brief |crudo - mínimo| desde el cual `x * 1000 / calRango` no entra en int16_t (solo con rangos muy angostos). */
+static HILO_LOCAL uint32_t calLimite[SensorCount];
+
+/** @brief Indica si ya se realizó al menos un paso de calibración. */
+static HILO_LOCAL bool calibrado = false;
 
-/** @brief Array que mapea los pines físicos S1-S8 definidos en config.hpp. */
-static const uint8_t sensorPins[SensorCount] = {S8, S7, S6, S5, S4, S3, S2, S1};
+/** @brief Última posición válida (con línea detectada), usada cuando se pierde la línea. */
+static HILO_LOCAL uint16_t ultimaPosicion = 0;
+
+/** @brief Algún sensor vio la línea en la última `calcularPosicion()`. */
+static HILO_LOCAL bool lineaVista = false;
+
+/** @brief Última estimación de la posición, con resolución fina y confianza. */
+static HILO_LOCAL EstimacionLinea estimacion;
+
+/** @brief Último cuadro crudo adquirido (índice 0 = S8, ver muestreo.cpp). */
+static HILO_LOCAL CuadroSensores cuadro;
 
 /** @brief Array para almacenar los valores brutos de lectura de cada sensor. */
-static uint16_t sensorValues[SensorCount];
+static HILO_LOCAL uint16_t sensorValues[SensorCount];
+
+/** @brief Clave de la calibración en la memoria no volátil. */
+static const char* CLAVE_CALIBRACION = "calibracion";
+
+/** @brief Versión del bloque guardado; cambiarla si cambia `CalibracionSensores` o la escala del ADC. */
+static const uint16_t VERSION_CALIBRACION = 1;
+
+/**
+ @struct BloqueCalibracion
+ @brief Calibración tal como se guarda: versión, umbrales y CRC-16 de los campos anteriores.
+ */
+struct BloqueCalibracion {
+    uint16_t version;
+    CalibracionSensores cal;
+    uint16_t crc;
+};
 
 /** @brief Variable global que almacena la última posición calculada de la línea. */
-uint16_t position;
+HILO_LOCAL uint16_t position;
 
 // ===================================
 // LINEA NEGRA o BLANCA - CAMBIAR EN PLATFORMIO.INI
@@ -49,17 +99,264 @@ uint16_t position;
 
 /**
  @brief Configura el tipo de sensor y los pines asociados.
- @details Establece el modo de lectura analógica y llama a la rutina de calibración.
+ @details Configura la adquisición (directa o continua, ver muestreo.hpp) y carga la calibración guardada;
+ si no hay una válida o se enciende con STOP apretado, llama a la rutina de calibración y la guarda.
  */
 void setupSensores() {
-    // Usaremos lectura analógica (ADC)
-    qtr.setTypeAnalog();
-    
-    // Cargamos los pines de sensores QTR
-    qtr.setSensorPins(sensorPins, SensorCount);
+    // Pines de la barra y, con ADC_CONTINUO, el DMA del ADC1
+    iniciarMuestreo();
+
+    // Calibracion guardada; STOP apretado al encender fuerza una nueva
+    if (!halLeerDigital(BTN_STOP) && cargarCalibracion()) {
+        deb(Serial.println("Calibracion cargada");)
+        return;
+    }
 
     // Calibracion inicial
     calibrarSensores();
+    if (!guardarCalibracion()) {
+        deb(Serial.println("No se pudo guardar la calibracion");)
+    }
+}
+
+// ============================
+// LECTURA Y CALIBRACIÓN QTR
+// ============================
+
+/**
+ @brief Lectura cruda de los 8 sensores.
+ @details Adquiere un cuadro completo (4 conversiones promediadas por sensor, igual que `QTRSensors::read()`)
+ y lo deja en `cuadro` con su marca de tiempo.
+ @param valores Array de salida con una lectura por sensor.
+ */
+static void leerCrudo(uint16_t *valores) {
+    leerCuadro(cuadro);
+    for (uint8_t i = 0; i < SensorCount; i++) valores[i] = cuadro.crudo[i];
+}
+
+/**
+ @brief Precalcula los recíprocos de la normalización para la calibración en uso.
+ @details Para cada rango d, con k = 26 + ceil(log2 d) y m = ceil(2^k / d), `(n * m) >> k` es exactamente
+ `n / d` para todo n < 2^26 (el error de m es menor a d, así que n * error < 2^k). Como solo se normaliza
+ con x = crudo - mínimo en (0, d), n = x * 1000 < 2^26 aun con rangos de 16 bits, m entra en 32 bits y el
+ producto en 64. Se llama cada vez que cambian `calMinimo`/`calMaximo`, nunca en el tick.
+ */
+static void calcularReciprocos() {
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        uint16_t d = calMaximo[i] - calMinimo[i];
+        calRango[i] = d;
+        calLimite[i] = (32768u * d + 999) / 1000;
+        if (d == 0) {
+            recMult[i] = 0;
+            recDesp[i] = 0;
+            continue;
+        }
+
+        uint8_t log2d = 0;
+        while ((1u << log2d) < d) log2d++;
+        uint8_t k = 26 + log2d;
+        recMult[i] = (uint32_t)((((uint64_t)1 << k) + d - 1) / d);
+        recDesp[i] = k;
+    }
+}
+
+/**
+ @brief Un paso de calibración (equivalente a `QTRSensors::calibrate()`).
+ @details Toma 10 lecturas; el máximo de calibración solo sube si el mínimo de las 10 lo supera,
+ y el mínimo solo baja si el máximo de las 10 queda por debajo. Así se filtran picos aislados.
+ */
+static void pasoCalibracion() {
+    uint16_t valores[SensorCount];
+    uint16_t maxLeido[SensorCount];
+    uint16_t minLeido[SensorCount];
+
+    if (!calibrado) {
+        for (uint8_t i = 0; i < SensorCount; i++) {
+            calMaximo[i] = 0;
+            calMinimo[i] = maxValorQTR;
+        }
+        calibrado = true;
+    }
+
+    for (uint8_t j = 0; j < 10; j++) {
+        leerCrudo(valores);
+        for (uint8_t i = 0; i < SensorCount; i++) {
+            if ((j == 0) || (valores[i] > maxLeido[i])) maxLeido[i] = valores[i];
+            if ((j == 0) || (valores[i] < minLeido[i])) minLeido[i] = valores[i];
+        }
+    }
+
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        if (minLeido[i] > calMaximo[i]) calMaximo[i] = minLeido[i];
+        if (maxLeido[i] < calMinimo[i]) calMinimo[i] = maxLeido[i];
+    }
+
+    calcularReciprocos();
+}
+
+/**
+ @brief Cálculo original de `readCalibrated()`, con la división y el cociente en int16_t.
+ @details Solo se usa cuando el cociente no entra en int16_t (rango de calibración de unas decenas de cuentas):
+ ahí el original da la vuelta y este camino lo reproduce.
+ */
+static uint16_t normalizarDesborde(int32_t x, uint16_t rango) {
+    int16_t valor = x * 1000 / rango;
+    return valor < 0 ? 0 : (valor > 1000 ? 1000 : valor);
+}
+
+/**
+ @brief Normaliza un cuadro crudo a 0-1000.
+ @details Mismo resultado que `(crudo - min) * 1000 / (max - min)` saturado de `QTRSensors::readCalibrated()`,
+ pero con multiplicación y desplazamiento: fuera del rango se satura sin calcular y dentro se usa el
+ recíproco de `calcularReciprocos()`.
+ */
+void normalizarCuadro(const uint16_t *crudo, uint16_t *valores) {
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        int32_t x = (int32_t)crudo[i] - calMinimo[i];
+        uint32_t absoluto = x < 0 ? -x : x;
+
+        if      (recMult[i] == 0)            valores[i] = 0;
+        else if (absoluto >= calLimite[i])   valores[i] = normalizarDesborde(x, calRango[i]);
+        else if (x <= 0)                     valores[i] = 0;
+        else if (x >= calRango[i])           valores[i] = 1000;
+        else valores[i] = (uint16_t)(((uint64_t)(absoluto * 1000u) * recMult[i]) >> recDesp[i]);
+    }
+}
+
+/**
+ @brief Lectura normalizada 0-1000 según la calibración (equivalente a `QTRSensors::readCalibrated()`).
+ @details Con `FILTRO_MEDIANA` o `FILTRO_IIR` el cuadro crudo pasa antes por `filtrarCuadro()`; `cuadro`
+ conserva las lecturas sin filtrar (las que registra la caja negra).
+ @param valores Array de salida con una lectura normalizada por sensor.
+ */
+static void leerCalibrado(uint16_t *valores) {
+    if (!calibrado) return;
+
+    leerCrudo(valores);
+    if (FILTRO_ACTIVO) filtrarCuadro(valores);
+    normalizarCuadro(valores, valores);
+}
+
+/**
+ @brief Posición con la línea perdida: el extremo del lado donde se vio por última vez, con confianza 0.
+ */
+static uint16_t extremoPerdido() {
+    uint16_t extremo = ultimaPosicion < (SensorCount - 1) * 1000 / 2 ? 0 : (SensorCount - 1) * 1000;
+    estimacion.posicionFina = (uint32_t)extremo << 4;
+    estimacion.confianza = 0;
+    return extremo;
+}
+
+#ifdef POSICION_PICO
+
+/**
+ @brief Posición por ajuste de una parábola al sensor de mayor lectura y sus dos vecinos.
+ @details El vértice de la parábola por (-1, a), (0, b), (1, c) está a `(a - c) / (2 (a - 2b + c))` sensores
+ del pico, siempre dentro de ±0.5 porque b es el máximo; fuera de la barra el vecino se toma como fondo (0).
+ Con una meseta de tres o más sensores saturados se usa su centro. Es una búsqueda del máximo y una sola
+ división entera, sin los ocho productos del promedio ponderado, y no se desplaza hacia los sensores lejanos
+ con ruido ni cerca de los bordes. La confianza es la altura del pico menos lo que se lee fuera de la ventana de tres sensores: baja
+ con una línea débil, con ruido o con dos líneas bajo la barra (cruces, bifurcaciones).
+ */
+uint16_t estimarPosicion(const uint16_t *valores, bool invertir) {
+    // Sensor pico sobre las lecturas sin invertir: con línea blanca es la menor
+    uint8_t pico = 0;
+    uint32_t total = 0;
+    if (invertir) {
+        for (uint8_t i = 0; i < SensorCount; i++) {
+            total += valores[i];
+            if (valores[i] < valores[pico]) pico = i;
+        }
+        total = SensorCount * 1000 - total;
+    } else {
+        for (uint8_t i = 0; i < SensorCount; i++) {
+            total += valores[i];
+            if (valores[i] > valores[pico]) pico = i;
+        }
+    }
+
+    // Mismo umbral que el promedio ponderado: algún sensor por encima de 200
+    int32_t b = invertir ? 1000 - valores[pico] : valores[pico];
+    lineaVista = b > 200;
+    if (!lineaVista) return extremoPerdido();
+
+    int32_t a = pico > 0 ? valores[pico - 1] : (invertir ? 1000 : 0);
+    int32_t c = pico < SensorCount - 1 ? valores[pico + 1] : (invertir ? 1000 : 0);
+    if (invertir) {
+        a = 1000 - a;
+        c = 1000 - c;
+    }
+
+    int32_t fina;
+    if (c == b && pico + 2 < SensorCount && valores[pico + 2] == valores[pico]) {
+        // Meseta de tres o más sensores: su centro
+        uint8_t ultimo = pico + 2;
+        while (ultimo + 1 < SensorCount && valores[ultimo + 1] == valores[pico]) ultimo++;
+        fina = ((int32_t)pico + ultimo) * 8000;
+    } else {
+        // Desplazamiento del vértice en 1/16000 de sensor (curvatura <= 0)
+        int32_t curvatura = a - 2 * b + c;
+        fina = (int32_t)pico * 16000 + (curvatura ? (a - c) * 8000 / curvatura : 0);
+        fina = constrain(fina, 0, (int32_t)(SensorCount - 1) * 16000);
+    }
+
+    int32_t fuera = (int32_t)total - (a + b + c);
+    estimacion.posicionFina = (uint32_t)fina;
+    estimacion.confianza = (uint16_t)(fuera < b ? b - fuera : 0);
+
+    ultimaPosicion = (uint16_t)((fina + 8) >> 4);
+    return ultimaPosicion;
+}
+
+#else
+
+/**
+ @brief Posición ponderada de la línea (equivalente a `QTRSensors::readLineBlack/readLineWhite()`).
+ @details Promedia `i * 1000` pesado por cada lectura mayor a 50. Si ningún sensor supera 200 
+ se considera la línea perdida y se devuelve el extremo del lado donde se vio por última vez.
+ La confianza es 1000 con la línea vista y 0 sin ella.
+ */
+uint16_t estimarPosicion(const uint16_t *valores, bool invertir) {
+    bool enLinea = false;
+    uint32_t promedio = 0;
+    uint16_t suma = 0;
+
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        uint16_t valor = valores[i];
+        if (invertir) valor = 1000 - valor;
+
+        // Detectamos si se ve la linea en algun sensor
+        if (valor > 200) enLinea = true;
+
+        // Solo se promedian valores por encima del umbral de ruido
+        if (valor > 50) {
+            promedio += (uint32_t)valor * (i * 1000);
+            suma += valor;
+        }
+    }
+
+    lineaVista = enLinea;
+
+    // Se perdio la linea: devolvemos el extremo donde se vio por ultima vez
+    if (!enLinea) return extremoPerdido();
+
+    ultimaPosicion = promedio / suma;
+    estimacion.posicionFina = (uint32_t)ultimaPosicion << 4;
+    estimacion.confianza = 1000;
+    return ultimaPosicion;
+}
+
+#endif
+
+/**
+ @brief Lee la barra calibrada y estima la posición.
+ @param valores Array donde se dejan las lecturas normalizadas (sin invertir).
+ @param invertir true para línea blanca (se invierte cada lectura antes de estimar).
+ @return uint16_t Posición entre 0 y 7000.
+ */
+static uint16_t calcularPosicion(uint16_t *valores, bool invertir) {
+    leerCalibrado(valores);
+    return estimarPosicion(valores, invertir);
 }
 
 // ============================
@@ -75,45 +372,159 @@ void calibrarSensores() {
     // Aviso sonoro de inicio de calibración (solo si mute está habilitado)
     mute(
         buzzer.play(NOTE_A4);
-        delay(150);
+        halDelay(150);
         buzzer.stop();
     );
 
     // Encendemos el LED de estado para indicar proceso de calibración
-    digitalWrite(ledCalibracion, HIGH);
+    halEscribirDigital(ledCalibracion, true);
     deb(Serial.println("Calibrando sensores..."); )
 
     // Se realizan múltiples lecturas para que la librería QTR tome
     // valores mínimo y máximo de cada sensor y ajuste su calibración
-    for (uint16_t i = 0; i < 300; i++) { qtr.calibrate(); }    
+    for (uint16_t i = 0; i < 300; i++) { pasoCalibracion(); }    
 
     // Apagamos indicador de calibración
-    digitalWrite(ledCalibracion, LOW);
+    halEscribirDigital(ledCalibracion, false);
     deb(Serial.println("Calibracion lista!");)
 
     // Aviso de final de calibración (solo si mute está habilitado)
     mute(
         buzzer.play(NOTE_C5);
-        delay(200);
+        halDelay(200);
         buzzer.stop();
     )
 }
 
 
+/**
+ @brief Olvida la calibración, la última posición válida y el historial del filtro.
+ */
+void reiniciarSensores() {
+    calibrado = false;
+    reiniciarFiltro();
+    ultimaPosicion = 0;
+    lineaVista = false;
+    estimacion = EstimacionLinea();
+}
+
+
+/**
+ @brief Copia los umbrales de calibración.
+ */
+bool calibracionSensores(CalibracionSensores& cal) {
+    if (!calibrado) return false;
+
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        cal.minimo[i] = calMinimo[i];
+        cal.maximo[i] = calMaximo[i];
+    }
+    return true;
+}
+
+
+/**
+ @brief Fija los umbrales de calibración.
+ */
+void fijarCalibracion(const CalibracionSensores& cal) {
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        calMinimo[i] = cal.minimo[i];
+        calMaximo[i] = cal.maximo[i];
+    }
+    calcularReciprocos();
+    calibrado = true;
+}
+
+
+// ============================
+// CALIBRACIÓN GUARDADA
+// ============================
+
+/**
+ @brief CRC-16/CCITT-FALSE (polinomio 0x1021, inicial 0xFFFF).
+ @param datos Bytes a verificar.
+ @param n Cantidad de bytes.
+ @return uint16_t CRC de los @p n bytes.
+ */
+static uint16_t crc16(const uint8_t* datos, size_t n) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= (uint16_t)datos[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+
+/**
+ @brief Lee, valida y fija la calibración guardada.
+ */
+bool cargarCalibracion() {
+    BloqueCalibracion bloque;
+    if (!halAlmacenLeer(CLAVE_CALIBRACION, &bloque, sizeof(bloque))) return false;
+
+    if (bloque.version != VERSION_CALIBRACION) return false;
+    if (bloque.crc != crc16((const uint8_t*)&bloque, offsetof(BloqueCalibracion, crc))) return false;
+    for (uint8_t i = 0; i < SensorCount; i++) {
+        if (bloque.cal.minimo[i] >= bloque.cal.maximo[i]) return false;
+    }
+
+    fijarCalibracion(bloque.cal);
+    return true;
+}
+
+
+/**
+ @brief Guarda la calibración en uso con su versión y CRC.
+ */
+bool guardarCalibracion() {
+    BloqueCalibracion bloque = {};
+    bloque.version = VERSION_CALIBRACION;
+    if (!calibracionSensores(bloque.cal)) return false;
+    bloque.crc = crc16((const uint8_t*)&bloque, offsetof(BloqueCalibracion, crc));
+
+    return halAlmacenEscribir(CLAVE_CALIBRACION, &bloque, sizeof(bloque));
+}
+
+
 // ============================
 // LECTURA DE POSICIÓN
 // ============================
 
 /**
  @brief Obtiene la posición relativa del robot respecto a la línea.
- @details Selecciona entre readLineWhite o readLineBlack según la variable linea_competencia.
+ @details Selecciona la lectura invertida (línea blanca) o directa (línea negra) según la variable linea_competencia.
  @return uint16_t Valor normalizado entre 0 y 7000.
  */
 uint16_t leerLinea() {
-    // Dependiendo del color de la pista, se usa lectura inversa:
-    if (linea_competencia == BLANCA)    position = qtr.readLineWhite(sensorValues);
-    else                                position = qtr.readLineBlack(sensorValues);
-
+    // Dependiendo del color de la pista, se usa lectura inversa.
+    // No escribe `position`: con DOBLE_NUCLEO esta función corre en el núcleo 0 y `position` es del control.
     // Devuelve un valor entre ~0 (izquierda) y ~7000 (derecha)
-    return position;
+    if (linea_competencia == BLANCA) return calcularPosicion(sensorValues, true);
+    else                             return calcularPosicion(sensorValues, false);
+}
+
+
+/**
+ @brief Indica si la última lectura vio la línea.
+ */
+bool lineaDetectada() {
+    return lineaVista;
+}
+
+
+/**
+ @brief Posición fina y confianza de la última lectura.
+ */
+const EstimacionLinea& estimacionLinea() {
+    return estimacion;
+}
+
+
+/**
+ @brief Último cuadro crudo usado por `leerLinea()` o por la calibración.
+ @return const CuadroSensores& Cuadro con su marca de tiempo y duración de adquisición.
+ */
+const CuadroSensores& ultimoCuadro() {
+    return cuadro;
 }
\ No newline at end of file
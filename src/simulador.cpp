@@ -0,0 +1,442 @@
+/**
+ @file simulador.cpp
+ @brief Implementación del simulador en lazo cerrado del seguidor de línea (solo host).
+ @details Modelo cinemático de tracción diferencial con límite de adherencia lateral, respuesta
+ de primer orden de cada rueda al duty aplicado por el DRV8833 (modo fast-decay: PWM en una entrada
+ y la otra en LOW) y reflectancia de cada sensor como la fracción de su área que cae sobre la línea.
+ El firmware se ejecuta sin cambios a través del backend host de la HAL.
+ @author Legion de Ohm
+ */
+
+#ifndef ARDUINO
+
+#include <cmath>
+#include "simulador.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "sensores.hpp"
+#include "adquisicion.hpp"
+#include "motores.hpp"
+#include "fsm.hpp"
+#include "planificador.hpp"
+
+/** @brief Simulador cuyo modelo responde a las lecturas analógicas de la HAL host. */
+static HILO_LOCAL Simulador* simActivo = nullptr;
+
+/** @brief Índice en la barra (0 = S8) de cada GPIO, o 255 si el pin no es un sensor. */
+static HILO_LOCAL uint8_t indicePin[40];
+
+/** @brief Tipos de tramo guardados por Pista para poder espejarlos. */
+enum TipoTramo { TRAMO_RECTA, TRAMO_CURVA };
+
+// ============================
+// PISTA
+// ============================
+Pista::Pista(float ancho, float paso)
+: ancho(ancho), paso(paso), _x(0), _y(0), _rumbo(0) {
+    _agregarPunto();
+}
+
+void Pista::_agregarPunto() {
+    puntos.push_back({_x, _y});
+}
+
+void Pista::recta(float largo) {
+    _tramos.push_back(TRAMO_RECTA);
+    _tramos.push_back(largo);
+    _tramos.push_back(0);
+
+    long n = std::lround(largo / paso);
+    if (n < 1) n = 1;
+    float d = largo / n;
+
+    for (long k = 0; k < n; k++) {
+        _x += d * std::cos(_rumbo);
+        _y += d * std::sin(_rumbo);
+        _agregarPunto();
+    }
+}
+
+void Pista::curva(float radio, float angulo) {
+    _tramos.push_back(TRAMO_CURVA);
+    _tramos.push_back(radio);
+    _tramos.push_back(angulo);
+
+    float a = angulo * (float)M_PI / 180.0f;
+    long n = std::lround(radio * std::fabs(a) / paso);
+    if (n < 1) n = 1;
+    float da = a / n;
+    float cuerda = 2 * radio * std::sin(std::fabs(da) / 2);
+
+    for (long k = 0; k < n; k++) {
+        float medio = _rumbo + da / 2;
+        _x += cuerda * std::cos(medio);
+        _y += cuerda * std::sin(medio);
+        _rumbo += da;
+        _agregarPunto();
+    }
+}
+
+void Pista::espejarMitad() {
+    std::vector<float> mitad = _tramos;
+
+    for (size_t i = 0; i + 2 < mitad.size(); i += 3) {
+        if (mitad[i] == TRAMO_RECTA) recta(mitad[i + 1]);
+        else                         curva(mitad[i + 1], mitad[i + 2]);
+    }
+
+    // El último punto coincide con el primero: la pista queda cerrada
+    const PuntoPista& a = puntos.front();
+    const PuntoPista& b = puntos.back();
+    if (std::hypot(a.x - b.x, a.y - b.y) < paso) puntos.pop_back();
+}
+
+Pista Pista::ovalo() {
+    Pista p;
+    p.recta(1.5f);
+    p.curva(0.4f, 180);
+    p.espejarMitad();
+    return p;
+}
+
+Pista Pista::competencia() {
+    Pista p;
+    p.recta(1.0f);
+    p.curva(0.30f, 90);
+    p.recta(0.30f);
+    p.curva(0.20f, -90);    // S
+    p.curva(0.20f, 90);
+    p.recta(0.20f);
+    p.curva(0.35f, 90);
+    p.espejarMitad();
+    return p;
+}
+
+Pista Pista::esquinas() {
+    Pista p;
+    p.recta(1.0f);
+    p.curva(0.02f, 90);
+    p.recta(0.40f);
+    p.curva(0.02f, 135);
+    p.recta(0.30f);
+    p.curva(0.02f, -45);
+    p.espejarMitad();
+    return p;
+}
+
+// ============================
+// GEOMETRÍA
+// ============================
+/** @brief Distancia al cuadrado de (x, y) al punto @p i de la pista. */
+static float distancia2(const Pista& pista, uint32_t i, float x, float y) {
+    float dx = pista.puntos[i].x - x;
+    float dy = pista.puntos[i].y - y;
+    return dx * dx + dy * dy;
+}
+
+/**
+ @brief Busca localmente (descenso por vecinos) el punto de pista más cercano a (x, y).
+ @param pista Pista.
+ @param idx Índice de partida (el resultado anterior).
+ @return uint32_t Índice del punto más cercano.
+ */
+static uint32_t buscarCercano(const Pista& pista, uint32_t idx, float x, float y) {
+    uint32_t n = pista.puntos.size();
+    float d = distancia2(pista, idx, x, y);
+
+    while (true) {
+        uint32_t sig = (idx + 1) % n;
+        uint32_t ant = (idx + n - 1) % n;
+        float dSig = distancia2(pista, sig, x, y);
+        float dAnt = distancia2(pista, ant, x, y);
+
+        if      (dSig < d) { idx = sig; d = dSig; }
+        else if (dAnt < d) { idx = ant; d = dAnt; }
+        else               break;
+    }
+    return idx;
+}
+
+/**
+ @brief Distancia con signo de (x, y) a los dos segmentos que rodean el punto @p idx.
+ @return float Positivo si la línea queda a la izquierda del sentido de avance de la pista.
+ */
+static float distanciaLinea(const Pista& pista, uint32_t idx, float x, float y) {
+    uint32_t n = pista.puntos.size();
+    float mejor = 1e9f;
+    float signo = 1;
+
+    for (int k = 0; k < 2; k++) {
+        const PuntoPista& a = pista.puntos[k == 0 ? (idx + n - 1) % n : idx];
+        const PuntoPista& b = pista.puntos[k == 0 ? idx : (idx + 1) % n];
+        float sx = b.x - a.x, sy = b.y - a.y;
+        float px = x - a.x,   py = y - a.y;
+        float l2 = sx * sx + sy * sy;
+        float t = l2 > 0 ? (px * sx + py * sy) / l2 : 0;
+        if (t < 0) t = 0;
+        if (t > 1) t = 1;
+
+        float ex = px - t * sx, ey = py - t * sy;
+        float d = std::sqrt(ex * ex + ey * ey);
+        if (d < mejor) {
+            mejor = d;
+            // punto a la derecha del segmento => línea a su izquierda
+            signo = (sx * py - sy * px) < 0 ? 1.0f : -1.0f;
+        }
+    }
+    return signo * mejor;
+}
+
+// ============================
+// SIMULADOR
+// ============================
+Simulador::Simulador(const Pista& pista, const ParametrosRobot& robot)
+: _pista(pista), _robot(robot), _observador(nullptr), _contexto(nullptr) {
+    const uint8_t pines[8] = {S8, S7, S6, S5, S4, S3, S2, S1};
+    for (uint8_t i = 0; i < 40; i++) indicePin[i] = 255;
+    for (uint8_t i = 0; i < 8; i++) indicePin[pines[i]] = i;
+}
+
+/**
+ @brief Ubica el robot en la salida, alineado con la pista y con la barra desplazada lateralmente.
+ @param desvioLateral Desplazamiento hacia la izquierda del eje [m].
+ */
+void Simulador::_ubicarEnSalida(float desvioLateral) {
+    const PuntoPista& a = _pista.puntos[0];
+    const PuntoPista& b = _pista.puntos[1];
+    _rumbo = std::atan2(b.y - a.y, b.x - a.x);
+    _x = a.x - desvioLateral * std::sin(_rumbo);
+    _y = a.y + desvioLateral * std::cos(_rumbo);
+    _vIzq = _vDer = 0;
+    _actualizarSensores();
+}
+
+/**
+ @brief Duty con signo que el DRV8833 aplica a un motor según el enrutamiento de sus pines.
+ @return float Fracción de duty (-1 a 1). 0 si ninguna entrada tiene PWM (rueda libre).
+ */
+float Simulador::_comandoMotor(uint8_t pinIN1, uint8_t pinIN2) const {
+    int8_t ch1 = halHostCanalPin(pinIN1);
+    int8_t ch2 = halHostCanalPin(pinIN2);
+    int8_t ch = ch1 >= 0 ? ch1 : ch2;
+    if (ch < 0) return 0;
+
+    float maxDuty = (float)((1u << halHostResolucionCanal(ch)) - 1);
+    float duty = halHostDutyCanal(ch) / maxDuty;
+    return ch1 >= 0 ? duty : -duty;
+}
+
+/**
+ @brief Integra la dinámica de ruedas y la pose durante @p dt segundos.
+ */
+void Simulador::_pasoFisica(float dt) {
+    float duty[2] = { _comandoMotor(motorPinIN1_Izq, motorPinIN2_Izq),
+                      _comandoMotor(motorPinIN1_Der, motorPinIN2_Der) };
+    float* rueda[2] = { &_vIzq, &_vDer };
+
+    for (uint8_t m = 0; m < 2; m++) {
+        float d = std::fabs(duty[m]);
+        float objetivo = 0;
+        float tau = _robot.tauLibre;
+
+        if (d > _robot.dutyMuerto) {
+            objetivo = _robot.velocidadMax * (d - _robot.dutyMuerto) / (1 - _robot.dutyMuerto);
+            if (duty[m] < 0) objetivo = -objetivo;
+            tau = _robot.tauMotor;
+        }
+        *rueda[m] += (objetivo - *rueda[m]) * (1 - std::exp(-dt / tau));
+    }
+
+    float v = 0.5f * (_vIzq + _vDer);
+    float w = (_vDer - _vIzq) / _robot.trocha;
+
+    // Límite de adherencia: la velocidad angular no puede exceder aLat / v
+    if (std::fabs(v) > 0.05f) {
+        float wMax = _robot.aceleracionLateralMax / std::fabs(v);
+        w = constrain(w, -wMax, wMax);
+    }
+
+    float medio = _rumbo + w * dt / 2;
+    _x += v * std::cos(medio) * dt;
+    _y += v * std::sin(medio) * dt;
+    _rumbo += w * dt;
+}
+
+/**
+ @brief Recalcula la lectura sin ruido de cada sensor según la pose actual.
+ @details La fracción de área sobre la línea se modela como la integral de una gaussiana
+ de dispersión `sigmaSensor` sobre el ancho de la línea.
+ */
+void Simulador::_actualizarSensores() {
+    float c = std::cos(_rumbo), s = std::sin(_rumbo);
+    float bx = _x + _robot.distanciaBarra * c;
+    float by = _y + _robot.distanciaBarra * s;
+    float k = 1.0f / (std::sqrt(2.0f) * _robot.sigmaSensor);
+    float medio = _pista.ancho / 2;
+
+    _idxCentro = buscarCercano(_pista, _idxCentro, _x, _y);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        // Sensor 0 (S8) a la derecha, sensor 7 (S1) a la izquierda
+        float lateral = (i - 3.5f) * _robot.pasoSensores;
+        float sx = bx - lateral * s;
+        float sy = by + lateral * c;
+
+        _idxSensor[i] = buscarCercano(_pista, _idxSensor[i], sx, sy);
+        float d = std::fabs(distanciaLinea(_pista, _idxSensor[i], sx, sy));
+        _cubierto[i] = 0.5f * (std::erf((medio - d) * k) + std::erf((medio + d) * k));
+
+#ifdef LINEA_NEGRA
+        _lectura[i] = _robot.adcBlanco + (_robot.adcNegro - (float)_robot.adcBlanco) * _cubierto[i];
+#else
+        _lectura[i] = _robot.adcNegro + (_robot.adcBlanco - (float)_robot.adcNegro) * _cubierto[i];
+#endif
+    }
+
+    uint32_t idxBarra = buscarCercano(_pista, _idxSensor[3], bx, by);
+    _desvioBarra = distanciaLinea(_pista, idxBarra, bx, by);
+}
+
+/**
+ @brief Lectura de un pin: valor del modelo más ruido triangular.
+ @details Durante la calibración la barra barre la línea de lado a lado (±6 cm), como se hace
+ a mano con el robot; el barrido avanza con cada lectura completa de la barra (32 conversiones).
+ */
+uint16_t Simulador::_leer(uint8_t pin) {
+    uint8_t i = pin < 40 ? indicePin[pin] : 255;
+    if (i == 255) return 0;
+
+    if (_calibrando) {
+        if (_lecturasCalibracion % 32 == 0) {
+            float fase = (_lecturasCalibracion / 32) * (2 * (float)M_PI / 200);
+            _ubicarEnSalida(0.06f * std::sin(fase));
+        }
+        _lecturasCalibracion++;
+    }
+
+    _ruido ^= _ruido << 13;
+    _ruido ^= _ruido >> 17;
+    _ruido ^= _ruido << 5;
+    float ruido = ((_ruido & 0xFFFF) + (_ruido >> 16)) / 65536.0f - 1;
+
+    int32_t valor = _lectura[i] + (int32_t)(ruido * _robot.ruidoAdc);
+    return (uint16_t)constrain(valor, 0, 4095);
+}
+
+uint16_t Simulador::_fuente(uint8_t pin) {
+    return simActivo->_leer(pin);
+}
+
+ResultadoCarrera Simulador::correr(uint8_t vueltas, float tiempoMax) {
+    ResultadoCarrera r;
+    if (vueltas > MAX_VUELTAS) vueltas = MAX_VUELTAS;
+
+    // Reinicio completo del "robot": periféricos y variables del firmware
+    halHostReiniciar();
+    reiniciarFSM();
+    reiniciar_pid();
+    reiniciarSensores();
+    motorSpeedIzq = motorSpeedDer = 0;
+    RUN = false;
+    SETPOINT = true;
+
+    simActivo = this;
+    _idxCentro = 0;
+    for (uint8_t i = 0; i < 8; i++) _idxSensor[i] = 0;
+    _ruido = _robot.semilla ? _robot.semilla : 1;
+    halHostFuenteAnalogica(_fuente);
+
+    // setup(): motores, interrupciones y calibración barriendo la línea
+    setupMotores();
+    setupInterrupciones();
+    _calibrando = true;
+    _lecturasCalibracion = 0;
+    setupSensores();
+    _calibrando = false;
+    _ubicarEnSalida(0);
+    iniciarAdquisicion();
+    iniciarPlanificador();
+
+    // Botón RUN
+    halHostDispararPin(BTN_RUN);
+
+    const uint32_t n = _pista.puntos.size();
+    const float dt = _robot.periodoLoopUs * 1e-6f;
+    const uint32_t inicioUs = halMicros();
+    uint32_t tickPrevio = inicioUs / TIEMPO_TIMER;
+    uint32_t idxPrevio = _idxCentro;
+    int64_t avance = 0;
+    float inicioVuelta = 0;
+    float tiempoPerdido = 0;
+    bool perdido = false;
+    double sumaError2 = 0;
+    uint32_t ticksError = 0, ticksControl = 0, ticksSaturados = 0;
+    int estado = S;
+
+    while (r.vueltas < vueltas && r.tiempoSimulado < tiempoMax) {
+        _pasoFisica(dt);
+        _actualizarSensores();
+        halHostAvanzar(_robot.periodoLoopUs);
+        r.tiempoSimulado = (halMicros() - inicioUs) * 1e-6f;
+
+        // loop(): la FSM corre solo cuando el planificador la libera
+        pasoPlanificador();
+        estado = estadoFSM();
+
+        // Métricas una vez por tick de control
+        uint32_t tick = halMicros() / TIEMPO_TIMER;
+        if (tick != tickPrevio) {
+            tickPrevio = tick;
+            r.ticks++;
+
+            if (estado != S) {
+                float e = (float)position - setpoint;
+                sumaError2 += e * e;
+                ticksError++;
+            }
+            if (estado == C) {
+                ticksControl++;
+                if (abs(motorSpeedIzq) >= maxSpeed || abs(motorSpeedDer) >= maxSpeed) ticksSaturados++;
+            }
+            if (_observador) _observador(r.ticks, estado, _contexto);
+        }
+
+        // Avance sobre la pista y vueltas
+        int32_t delta = (int32_t)_idxCentro - (int32_t)idxPrevio;
+        if (delta >  (int32_t)n / 2) delta -= n;
+        if (delta < -(int32_t)n / 2) delta += n;
+        idxPrevio = _idxCentro;
+        avance += delta;
+
+        if (avance >= (int64_t)n * (r.vueltas + 1)) {
+            r.tiempoVuelta[r.vueltas++] = r.tiempoSimulado - inicioVuelta;
+            inicioVuelta = r.tiempoSimulado;
+        }
+
+        // Pérdida de línea: ningún sensor sobre la línea
+        bool sinLinea = true;
+        for (uint8_t i = 0; i < 8; i++) {
+            if (_cubierto[i] > 0.2f) sinLinea = false;
+        }
+        if (sinLinea && !perdido) r.perdidasLinea++;
+        perdido = sinLinea;
+        tiempoPerdido = perdido ? tiempoPerdido + dt : 0;
+
+        // Fuera de pista: más de 1 s sin línea o lejos de ella
+        float lejos = std::sqrt(distancia2(_pista, _idxCentro, _x, _y));
+        if (tiempoPerdido > 1.0f || lejos > 0.25f) {
+            r.fueraDePista = true;
+            break;
+        }
+    }
+
+    r.rmsError = ticksError ? std::sqrt(sumaError2 / ticksError) : 0;
+    r.saturacion = ticksControl ? (float)ticksSaturados / ticksControl : 0;
+
+    halHostFuenteAnalogica(nullptr);
+    simActivo = nullptr;
+    return r;
+}
+
+#endif
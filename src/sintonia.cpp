@@ -0,0 +1,160 @@
+/**
+ @file sintonia.cpp
+ @brief Implementación de la sintonía por relé: relé con histéresis, detector de ciclos y Ziegler-Nichols.
+ @author Legion de Ohm
+ */
+
+#include "sintonia.hpp"
+#include <math.h>
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+
+HILO_LOCAL float amplitudRele = 8;
+HILO_LOCAL uint16_t histeresisRele = 20;
+
+/** @brief Resultado del último experimento. */
+static HILO_LOCAL ResultadoSintonia resultado = { SINTONIA_FALLIDA, 0, 0, 0, 0, 0, 0, 0 };
+
+/** @brief Aplicar las ganancias al terminar (la pidió 'U'). */
+static HILO_LOCAL bool aplicarAlTerminar = false;
+
+/** @brief Salida actual del relé: +1 o -1 (0 = todavía sin lectura). */
+static HILO_LOCAL int8_t lado = 0;
+
+/** @brief Inicio del experimento y de la última conmutación hacia +d (us). */
+static HILO_LOCAL uint32_t inicio = 0, inicioCiclo = 0;
+
+/** @brief false hasta la primera conmutación hacia +d (el primer ciclo empieza ahí). */
+static HILO_LOCAL bool enCiclo = false;
+
+/** @brief Máximo y mínimo del error en el ciclo en curso. */
+static HILO_LOCAL int32_t maximo = 0, minimo = 0;
+
+/** @brief Sumas de los ciclos promediados y sus períodos extremos (us). */
+static HILO_LOCAL uint32_t sumaPeriodos = 0, periodoMin = 0, periodoMax = 0;
+static HILO_LOCAL float sumaAmplitudes = 0;
+static HILO_LOCAL uint8_t promediados = 0;
+
+void pedirSintonia(bool aplicar) {
+    aplicarAlTerminar = aplicar;
+    SINTONIA = true;
+}
+
+bool sintoniaAplica() {
+    return aplicarAlTerminar;
+}
+
+void iniciarSintonia() {
+    resultado = { SINTONIA_MIDIENDO, 0, 0, 0, 0, 0, 0, 0 };
+    lado = 0;
+    enCiclo = false;
+    promediados = 0;
+}
+
+/** @brief Cierra un ciclo (conmutación hacia +d) y, con `SINTONIA_CICLOS` estables, calcula Ku y Tu. */
+static void cerrarCiclo(uint32_t periodo) {
+    resultado.ciclos++;
+    if (resultado.ciclos <= SINTONIA_DESCARTE) return;
+
+    if (promediados == 0) {
+        sumaPeriodos = 0;
+        sumaAmplitudes = 0;
+        periodoMin = periodoMax = periodo;
+    }
+    sumaPeriodos += periodo;
+    sumaAmplitudes += (maximo - minimo) * 0.5f;
+    if (periodo < periodoMin) periodoMin = periodo;
+    if (periodo > periodoMax) periodoMax = periodo;
+    if (++promediados < SINTONIA_CICLOS) return;
+
+    // Ciclo no estable: se vuelve a promediar desde el último
+    if (periodoMax - periodoMin > periodoMin / SINTONIA_DISPERSION) {
+        sumaPeriodos = periodoMin = periodoMax = periodo;
+        sumaAmplitudes = (maximo - minimo) * 0.5f;
+        promediados = 1;
+        return;
+    }
+
+    float a = sumaAmplitudes / SINTONIA_CICLOS;
+    float e = histeresisRele;
+    if (a <= e) {
+        resultado.fase = SINTONIA_FALLIDA;
+        return;
+    }
+    resultado.amplitud = a;
+    resultado.Ku = 4 * amplitudRele / ((float)M_PI * sqrtf(a * a - e * e));
+    resultado.Tu = sumaPeriodos * (1e-6f / SINTONIA_CICLOS);
+    resultado.Kp = 0.6f * resultado.Ku;
+    resultado.Ki = 2 * resultado.Kp / resultado.Tu;
+    resultado.Kd = resultado.Kp * resultado.Tu / 8;
+    resultado.fase = SINTONIA_LISTA;
+}
+
+float releSintonia(uint16_t pos, uint32_t instante_us) {
+    if (resultado.fase != SINTONIA_MIDIENDO) return 0.0f;
+    int32_t error = (int32_t)pos - setpoint;
+
+    if (lado == 0) {
+        lado = error >= 0 ? 1 : -1;
+        inicio = instante_us;
+    }
+    if ((uint32_t)(instante_us - inicio) > SINTONIA_TIEMPO_MAX_US) {
+        resultado.fase = SINTONIA_FALLIDA;
+        return 0.0f;
+    }
+
+    if (enCiclo) {
+        if (error > maximo) maximo = error;
+        if (error < minimo) minimo = error;
+    }
+
+    // Relé con histéresis: la corrección empuja hacia el centro, como Kp·error
+    if (lado < 0 && error > (int32_t)histeresisRele) {
+        lado = 1;
+        if (enCiclo) cerrarCiclo(instante_us - inicioCiclo);
+        enCiclo = true;
+        inicioCiclo = instante_us;
+        maximo = minimo = error;
+    } else if (lado > 0 && error < -(int32_t)histeresisRele) {
+        lado = -1;
+    }
+    return resultado.fase == SINTONIA_MIDIENDO ? lado * amplitudRele : 0.0f;
+}
+
+void abortarSintonia() {
+    if (resultado.fase == SINTONIA_MIDIENDO) resultado.fase = SINTONIA_FALLIDA;
+}
+
+const ResultadoSintonia& resultadoSintonia() {
+    return resultado;
+}
+
+void aplicarSintonia() {
+    if (resultado.fase != SINTONIA_LISTA) return;
+    Kp = resultado.Kp;
+    Ki = resultado.Ki;
+    Kd = resultado.Kd;
+    plegarGanancias();
+    aplanarBandas();
+}
+
+void comandoSintonia(char c) {
+    if (c == 'u') pedirSintonia(false);
+#ifdef SINTONIA_APLICAR
+    else if (c == 'U') pedirSintonia(true);
+#else
+    else if (c == 'U') pedirSintonia(false);   // Solo identifica: las ganancias medidas atrasan las vueltas
+#endif
+}
+
+void imprimirSintonia() {
+    if (resultado.fase != SINTONIA_LISTA) {
+        Serial.printf("Sintonia: %s (%u ciclos)\n", resultado.fase == SINTONIA_FALLIDA ? "fallida" : "en curso",
+                      (unsigned)resultado.ciclos);
+        return;
+    }
+    Serial.printf("Sintonia: a %.0f  Ku %.5f  Tu %.3f s  ->  Kp %.5f  Ki %.5f  Kd %.6f%s\n",
+                  resultado.amplitud, resultado.Ku, resultado.Tu, resultado.Kp, resultado.Ki, resultado.Kd,
+                  aplicarAlTerminar ? "  (aplicadas)" : "");
+}
@@ -0,0 +1,110 @@
+/**
+ @file telemetria.cpp
+ @brief Implementación del flujo binario de telemetría.
+ @details El lado del dispositivo (anillo, publicación y vaciado) queda vacío sin `-D TELEMETRIA`;
+ la decodificación se compila siempre para el decodificador de la PC.
+ @author Legion de Ohm
+ */
+
+#include "telemetria.hpp"
+#include "config.hpp"
+#include <cstring>
+
+/**
+ @brief Complemento de la suma de los primeros 15 bytes: la suma de los 16 bytes de una trama válida es 0xFF.
+ */
+static uint8_t sumaTrama(const uint8_t* bytes) {
+    uint8_t suma = 0;
+    for (uint8_t i = 0; i < sizeof(TramaTelemetria) - 1; i++) suma += bytes[i];
+    return (uint8_t)~suma;
+}
+
+#ifdef TELEMETRIA
+#include "anillo_spsc.hpp"
+
+/** @brief Tramas publicadas por el tick y todavía no enviadas. */
+static HILO_LOCAL AnilloSPSC<TramaTelemetria, TELEMETRIA_TRAMAS> anillo;
+
+/** @brief Número de secuencia de la próxima trama. */
+static HILO_LOCAL uint8_t secuencia = 0;
+
+/** @brief Tramas perdidas por anillo lleno. */
+static HILO_LOCAL uint32_t descartadas = 0;
+
+// ============================
+// PRODUCTOR (TICK DE CONTROL)
+// ============================
+void publicarTelemetria(uint8_t estado, uint16_t posicion, float correccion, int32_t motorIzq, int32_t motorDer) {
+    TramaTelemetria t;
+    t.sincro = TELEMETRIA_SINCRO;
+    t.secuencia = secuencia++;
+    t.posicion = posicion;
+    t.instante_us = halMicros();
+    t.correccion = correccion;
+    t.motorIzq = (int8_t)constrain(motorIzq, -127, 127);
+    t.motorDer = (int8_t)constrain(motorDer, -127, 127);
+    t.estado = estado;
+    t.suma = sumaTrama((const uint8_t*)&t);
+
+    if (!anillo.publicar(t)) descartadas++;
+}
+
+// ============================
+// CONSUMIDOR (TAREA DE FONDO)
+// ============================
+bool tomarTelemetria(TramaTelemetria& trama) {
+    return anillo.consumir(trama);
+}
+
+void vaciarTelemetria() {
+    // Solo lo que entra en el buffer de transmisión: Serial.write nunca bloquea a la tarea
+    TramaTelemetria t;
+    while (Serial.availableForWrite() >= (int)sizeof(TramaTelemetria) && anillo.consumir(t)) {
+        Serial.write((const uint8_t*)&t, sizeof(TramaTelemetria));
+    }
+}
+
+void iniciarTelemetria() {
+    halTareaFondo(vaciarTelemetria, TELEMETRIA_PERIODO_MS);
+}
+
+uint32_t tramasDescartadas() {
+    return descartadas;
+}
+
+void reiniciarTelemetria() {
+    anillo.vaciar();
+    secuencia = 0;
+    descartadas = 0;
+}
+
+#endif
+
+// ============================
+// DECODIFICACION
+// ============================
+bool validarTrama(const uint8_t* bytes, TramaTelemetria& trama) {
+    if (bytes[0] != TELEMETRIA_SINCRO) return false;
+    if (sumaTrama(bytes) != bytes[sizeof(TramaTelemetria) - 1]) return false;
+
+    std::memcpy(&trama, bytes, sizeof(TramaTelemetria));
+    return true;
+}
+
+size_t decodificarTelemetria(const uint8_t* datos, size_t n, SalidaTelemetria salida, void* contexto) {
+    TramaTelemetria t;
+    size_t i = 0;
+
+    while (n - i >= sizeof(TramaTelemetria)) {
+        if (validarTrama(datos + i, t)) {
+            salida(t, contexto);
+            i += sizeof(TramaTelemetria);
+        } else {
+            i++;        // resincroniza byte a byte
+        }
+    }
+
+    // La cola solo se conserva si puede ser el comienzo de una trama
+    while (i < n && datos[i] != TELEMETRIA_SINCRO) i++;
+    return i;
+}
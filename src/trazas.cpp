@@ -0,0 +1,112 @@
+/**
+ @file trazas.cpp
+ @brief Implementación de los histogramas de los puntos de traza.
+ @details Todo el módulo queda vacío sin `-D TRAZAS`.
+ @author Legion de Ohm
+ */
+
+#include "trazas.hpp"
+#include "config.hpp"
+
+#ifdef TRAZAS
+
+/** @brief Subcubetas por potencia de dos (3 bits de mantisa). */
+static const uint8_t BITS_SUB = 3;
+
+/** @brief Histograma de cada etapa. */
+static HILO_LOCAL Histograma histogramas[CANT_TRAZAS];
+
+/** @brief Nombre de cada etapa para el volcado. */
+static const char* nombresTraza[CANT_TRAZAS] = {
+    "demora", "periodo", "lineaActual", "pid", "motores", "tick"
+};
+
+// ============================
+// CUBETAS
+// ============================
+/**
+ @brief Cubeta de un valor: exacta por debajo de 8 y después 8 por octava.
+ */
+static uint16_t cubeta(uint32_t v) {
+    if (v < (1u << BITS_SUB)) return v;
+
+    uint8_t octava = 31 - __builtin_clz(v);
+    uint16_t sub = (v >> (octava - BITS_SUB)) & ((1u << BITS_SUB) - 1);
+    uint16_t i = (octava - BITS_SUB + 1) * (1u << BITS_SUB) + sub;
+    return i < CANT_CUBETAS ? i : CANT_CUBETAS - 1;
+}
+
+/**
+ @brief Mayor valor que cae en la cubeta @p i.
+ */
+static uint32_t limiteCubeta(uint16_t i) {
+    if (i < (1u << BITS_SUB)) return i;
+
+    uint8_t octava = i / (1u << BITS_SUB) + BITS_SUB - 1;
+    uint32_t sub = i % (1u << BITS_SUB);
+    uint32_t ancho = 1u << (octava - BITS_SUB);
+    return (((1u << BITS_SUB) + sub) << (octava - BITS_SUB)) + ancho - 1;
+}
+
+void registrarHistograma(Histograma& h, uint32_t ciclos) {
+    h.cubetas[cubeta(ciclos)]++;
+    if (h.cantidad == 0 || ciclos < h.minimo) h.minimo = ciclos;
+    if (ciclos > h.maximo) h.maximo = ciclos;
+    h.cantidad++;
+}
+
+uint32_t percentilHistograma(const Histograma& h, float p) {
+    if (h.cantidad == 0) return 0;
+
+    uint32_t objetivo = (uint32_t)(p * (h.cantidad - 1)) + 1;
+    uint32_t acumulado = 0;
+    for (uint16_t i = 0; i < CANT_CUBETAS; i++) {
+        acumulado += h.cubetas[i];
+        if (acumulado >= objetivo) {
+            uint32_t limite = limiteCubeta(i);
+            return limite < h.maximo ? (limite > h.minimo ? limite : h.minimo) : h.maximo;
+        }
+    }
+    return h.maximo;
+}
+
+// ============================
+// PUNTOS DE TRAZA
+// ============================
+void registrarTraza(PuntoTraza punto, uint32_t inicio) {
+    registrarHistograma(histogramas[punto], halCiclos() - inicio);
+}
+
+void registrarDuracion(PuntoTraza punto, uint32_t ciclos) {
+    registrarHistograma(histogramas[punto], ciclos);
+}
+
+const Histograma& histogramaTraza(PuntoTraza punto) {
+    return histogramas[punto];
+}
+
+void reiniciarTrazas() {
+    for (uint8_t i = 0; i < CANT_TRAZAS; i++) histogramas[i] = Histograma();
+}
+
+// ============================
+// VOLCADO POR SERIAL
+// ============================
+void imprimirTrazas() {
+    float porUs = (float)halCiclosPorUs();
+
+    Serial.printf("Trazas (us)       n       min       p50       p99       max\n");
+    for (uint8_t i = 0; i < CANT_TRAZAS; i++) {
+        const Histograma& h = histogramas[i];
+        Serial.printf("%-12s %7u %9.2f %9.2f %9.2f %9.2f\n", nombresTraza[i], (unsigned)h.cantidad,
+                      h.minimo / porUs, percentilHistograma(h, 0.50f) / porUs,
+                      percentilHistograma(h, 0.99f) / porUs, h.maximo / porUs);
+    }
+}
+
+void comandoTrazas(char c) {
+    if (c == 't') imprimirTrazas();
+    else if (c == 'r') reiniciarTrazas();
+}
+
+#endif
@@ -4,6 +4,8 @@
  @details Este test permite verificar la correcta recepción de datos de los 8 sensores, 
  comparando el modo de lectura (RC o Analógico) y visualizando la posición calculada 
  de la línea a través del monitor serial.
+ Es un sketch aparte, no lo compila ningún entorno: usa la librería QTRSensors de Pololu, que ya no está en
+ `lib_deps` (el firmware la reemplaza por sensores.cpp). Para correrlo hay que instalarla a mano.
  @author Legion de Ohm
  */
 
@@ -0,0 +1,70 @@
+/**
+ @file decodificador_telemetria.cpp
+ @brief Convierte a CSV una captura del flujo binario de telemetría (entorno `native_decodificador`).
+ @details Uso: `.pio/build/native_decodificador/program captura.bin > tick.csv` (sin argumento lee la
+ entrada estándar, por ejemplo `stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 | program`).
+ Columnas: secuencia, instante_us, dt_us, estado, posicion, correccion, motorIzq, motorDer, perdidas
+ (tramas faltantes antes de esta según la secuencia). El resumen sale por la salida de error.
+ @author Legion de Ohm
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "telemetria.hpp"
+
+/** @brief Estado del decodificador entre tramas. */
+struct Decodificador {
+    bool primera = true;
+    TramaTelemetria anterior;
+    uint32_t tramas = 0;
+    uint32_t perdidas = 0;
+};
+
+/** @brief Escribe una fila del CSV. */
+static void escribirFila(const TramaTelemetria& t, void* contexto) {
+    Decodificador& d = *(Decodificador*)contexto;
+    uint32_t dt = d.primera ? 0 : t.instante_us - d.anterior.instante_us;
+    uint8_t faltan = d.primera ? 0 : (uint8_t)(t.secuencia - d.anterior.secuencia - 1);
+
+    std::printf("%u,%u,%u,%c,%u,%.4f,%d,%d,%u\n", t.secuencia, t.instante_us, dt, "SACPT?"[t.estado < 5 ? t.estado : 5],
+                t.posicion, t.correccion, t.motorIzq, t.motorDer, faltan);
+
+    d.primera = false;
+    d.anterior = t;
+    d.tramas++;
+    d.perdidas += faltan;
+}
+
+int main(int argc, char** argv) {
+    FILE* entrada = argc > 1 ? std::fopen(argv[1], "rb") : stdin;
+    if (!entrada) {
+        std::fprintf(stderr, "No se pudo abrir %s\n", argv[1]);
+        return 1;
+    }
+
+    Decodificador d;
+    uint8_t buffer[4096];
+    size_t pendientes = 0;
+    uint64_t leidos = 0, descartados = 0;
+
+    std::printf("secuencia,instante_us,dt_us,estado,posicion,correccion,motorIzq,motorDer,perdidas\n");
+    for (;;) {
+        size_t n = std::fread(buffer + pendientes, 1, sizeof(buffer) - pendientes, entrada);
+        if (n == 0) break;
+        leidos += n;
+        n += pendientes;
+
+        uint32_t antes = d.tramas;
+        size_t consumidos = decodificarTelemetria(buffer, n, escribirFila, &d);
+        descartados += consumidos - (d.tramas - antes) * sizeof(TramaTelemetria);
+
+        // Lo que quedó (una trama incompleta) pasa al comienzo del próximo bloque
+        pendientes = n - consumidos;
+        std::memmove(buffer, buffer + consumidos, pendientes);
+    }
+    if (entrada != stdin) std::fclose(entrada);
+
+    std::fprintf(stderr, "%llu bytes, %u tramas, %u perdidas, %llu bytes fuera de trama\n",
+                 (unsigned long long)leidos, d.tramas, d.perdidas, (unsigned long long)(descartados + pendientes));
+    return 0;
+}
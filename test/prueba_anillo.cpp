@@ -0,0 +1,160 @@
+/**
+ @file prueba_anillo.cpp
+ @brief Prueba en host (entorno `native_anillo`, con `-D DOBLE_NUCLEO`) del anillo SPSC y del buzón del último
+ valor usado entre la tarea de adquisición y el control.
+ @details Un hilo productor publica muestras numeradas y un hilo consumidor las toma: del anillo con
+ `consumir()` (todas, en orden) y `ultimo()` (solo la más reciente), y del buzón. Se verifica que ninguna
+ muestra llegue rota (los dos campos deben corresponderse), que las secuencias nunca retrocedan y que con
+ `consumir()` no se pierda ninguna. Después corre la tarea de adquisición sobre el reloj virtual, un cuadro
+ cada `CUADRO_US`, con el control tomando una muestra por tick: la muestra entregada no puede tener más de
+ un cuadro de antigüedad aunque el control sea mucho más lento que el productor. Devuelve 1 si alguna
+ verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "anillo_spsc.hpp"
+#include "buzon_ultimo.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "sensores.hpp"
+#include "adquisicion.hpp"
+
+#ifndef DOBLE_NUCLEO
+  #error "prueba_anillo.cpp requiere -D DOBLE_NUCLEO (entorno native_anillo)"
+#endif
+
+/** @brief Muestras publicadas por fase. */
+static const uint32_t CANT_MUESTRAS = 1000000;
+
+/**
+ @struct Muestra
+ @brief Dato de prueba: `control` siempre debe ser el complemento de `secuencia`.
+ */
+struct Muestra {
+    uint32_t secuencia;
+    uint32_t control;
+    uint16_t relleno[4];
+};
+
+/** @brief Anillo bajo prueba (mismo tamaño que el de adquisicion.cpp). */
+static AnilloSPSC<Muestra, 32> anillo;
+
+/**
+ @brief Corre un productor y un consumidor concurrentes.
+ @param soloUltimo true = el consumidor usa `ultimo()`, false = `consumir()`.
+ @return uint32_t Cantidad de errores detectados.
+ */
+static uint32_t fase(bool soloUltimo) {
+    std::atomic<bool> fin{false};
+    anillo.vaciar();
+
+    std::thread productor([&fin] {
+        for (uint32_t s = 1; s <= CANT_MUESTRAS; s++) {
+            Muestra m = { s, ~s, { (uint16_t)s, (uint16_t)s, (uint16_t)s, (uint16_t)s } };
+            // Si está lleno se reintenta: así la última muestra siempre llega al consumidor
+            while (!anillo.publicar(m)) {
+                if (fin.load()) return;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t errores = 0, recibidas = 0, anterior = 0;
+    Muestra m;
+    while (anterior < CANT_MUESTRAS) {
+        bool hay = soloUltimo ? anillo.ultimo(m) : anillo.consumir(m);
+        if (!hay) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        recibidas++;
+        if (m.control != ~m.secuencia || m.relleno[3] != (uint16_t)m.secuencia) errores++;
+        if (m.secuencia <= anterior) errores++;
+        if (!soloUltimo && m.secuencia != anterior + 1) errores++;
+        anterior = m.secuencia;
+    }
+    fin.store(true);
+    productor.join();
+
+    std::printf("%-10s recibidas=%8u (%5.1f%%)  errores=%u\n", soloUltimo ? "ultimo()" : "consumir()",
+                recibidas, 100.0 * recibidas / CANT_MUESTRAS, errores);
+    return errores;
+}
+
+/** @brief Buzón bajo prueba (el tipo que usa adquisicion.cpp). */
+static BuzonUltimo<Muestra> buzon;
+
+/**
+ @brief Corre un productor que nunca espera y un consumidor del buzón, concurrentes.
+ @return uint32_t Cantidad de errores detectados.
+ */
+static uint32_t faseBuzon() {
+    std::thread productor([] {
+        for (uint32_t s = 1; s <= CANT_MUESTRAS; s++) {
+            Muestra m = { s, ~s, { (uint16_t)s, (uint16_t)s, (uint16_t)s, (uint16_t)s } };
+            buzon.publicar(m);
+        }
+    });
+
+    // La última publicada queda en el buzón: el consumidor siempre llega a verla
+    uint32_t errores = 0, recibidas = 0, anterior = 0;
+    Muestra m;
+    while (anterior < CANT_MUESTRAS) {
+        if (!buzon.ultimo(m)) {
+            std::this_thread::yield();
+            continue;
+        }
+        recibidas++;
+        if (m.control != ~m.secuencia || m.relleno[3] != (uint16_t)m.secuencia) errores++;
+        if (m.secuencia <= anterior) errores++;
+        anterior = m.secuencia;
+    }
+    productor.join();
+    if (buzon.ultimo(m)) errores++;
+
+    std::printf("%-10s recibidas=%8u (%5.1f%%)  errores=%u\n", "buzon", recibidas, 100.0 * recibidas / CANT_MUESTRAS, errores);
+    return errores;
+}
+
+/** @brief Duración de un cuadro de 8 canales en el robot (us): el productor lee uno tras otro. */
+static const uint32_t CUADRO_US = 100;
+
+/**
+ @brief Tarea de adquisición con el control una vez por `TIEMPO_TIMER`, ~60 cuadros por tick.
+ @return uint32_t 1 si alguna muestra entregada tiene más de un cuadro de antigüedad.
+ */
+static uint32_t faseAdquisicion() {
+    halHostReiniciar();
+    CalibracionSensores cal;
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        cal.minimo[i] = 300;
+        cal.maximo[i] = 3800;
+    }
+    fijarCalibracion(cal);
+    iniciarAdquisicion();
+
+    uint32_t peor = 0;
+    for (uint32_t tick = 0; tick < 500; tick++) {
+        for (uint32_t t = 0; t < (uint32_t)TIEMPO_TIMER; t += CUADRO_US) halHostAvanzar(CUADRO_US);
+        lineaActual();
+        if (edadLinea() > peor) peor = edadLinea();
+    }
+    std::printf("adquisicion: %u cuadros por tick, edad maxima %u us (un cuadro = %u us), %u reemplazadas\n",
+                (uint32_t)TIEMPO_TIMER / CUADRO_US, peor, CUADRO_US, muestrasDescartadas());
+    return peor <= CUADRO_US ? 0 : 1;
+}
+
+int main() {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    uint32_t errores = fase(false) + fase(true) + faseBuzon();
+
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    errores += faseAdquisicion();
+    std::printf("%u muestras en %.3f s — %s\n", 3 * CANT_MUESTRAS, s, errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
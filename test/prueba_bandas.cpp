@@ -0,0 +1,174 @@
+/**
+ @file prueba_bandas.cpp
+ @brief Prueba en host (entorno `native_bandas`) de las ganancias por velocidad (`-D PID_BANDAS`, con `GOBERNADOR`).
+ @details Llama a `programarGanancias()` con velocidades sintéticas y verifica:
+ - En cada banda (50, 60, ... 90%) las ganancias son las de Ziegler-Nichols de su Ku/Tu, en flotante y
+   plegadas; entre dos bandas, el promedio; fuera de 50-90%, las del extremo.
+ - Barriendo la velocidad de a 0.1% las ganancias no saltan en los bordes de las bandas.
+ - Cambiar de banda no cambia el término integral (Ki·integral) ni en `calculo_pid()` ni en
+   `calculo_pid_fijo()`.
+ Después corre el simulador con cada perfil a velocidad constante de 50 a 90% y con el gobernador, con la
+ tabla del perfil y con la misma ganancia en todas las bandas. Verifica que la tabla baja el error a 50-70%;
+ los tiempos de vuelta solo se informan. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+/** @brief Igualdad relativa de ganancias en flotante. */
+static bool parecida(float a, float b) {
+    return std::fabs(a - b) <= 1e-6f * std::fabs(b) + 1e-9f;
+}
+
+/** @brief El perfil con el Ku y Tu nominales en todas las bandas: lo mismo que sin `PID_BANDAS`. */
+static PerfilCorredor plano(const PerfilCorredor& perfil) {
+    PerfilCorredor p = perfil;
+    for (uint8_t b = 0; b < BANDAS_PID; b++) {
+        p.KuBanda[b] = perfil.Ku;
+        p.TuBanda[b] = perfil.Tu;
+    }
+    return p;
+}
+
+// ============================
+// TABLA
+// ============================
+/** @brief Bandas, interpolación, extremos y continuidad. */
+static void probarTabla() {
+    const PerfilCorredor& perfil = perfilesCorredor[0];
+    aplicarPerfil(perfil);
+
+    bool bandas = true;
+    for (uint8_t b = 0; b < BANDAS_PID; b++) {
+        float kp = 0.6 * perfil.KuBanda[b];
+        programarGanancias(BANDA_VELOCIDAD_MIN + b * BANDA_PASO);
+        std::printf("%3u%%: Kp %.5f Ki %.5f Kd %.6f\n", BANDA_VELOCIDAD_MIN + b * BANDA_PASO, Kp, Ki, Kd);
+        if (!parecida(Kp, kp) || !parecida(Ki, 2 * kp / perfil.TuBanda[b]) || !parecida(Kd, kp * perfil.TuBanda[b] / 8)) bandas = false;
+
+        // Las plegadas dan la misma corrección que las flotantes (como en prueba_pid_fijo)
+        reiniciar_pid();
+        for (uint16_t pos = 0; pos <= 7000; pos += 500) {
+            float fijo = calculo_pid_fijo(pos) * (1.0f / PID_UNO);
+            if (std::fabs(fijo - calculo_pid(pos, FIXED_DT_S)) > PID_TOLERANCIA) bandas = false;
+        }
+    }
+    reiniciar_pid();
+    verificar(bandas, "en cada banda: Ziegler-Nichols de su Ku/Tu, tambien plegadas");
+
+    programarGanancias(BANDA_VELOCIDAD_MIN + BANDA_PASO / 2);
+    float medio = 0.6f * (perfil.KuBanda[0] + perfil.KuBanda[1]) / 2;
+    verificar(parecida(Kp, medio), "entre dos bandas: el promedio");
+
+    programarGanancias(20);
+    float abajo = Kp;
+    programarGanancias(100);
+    float arriba = Kp;
+    verificar(parecida(abajo, 0.6f * perfil.KuBanda[0]) && parecida(arriba, 0.6f * perfil.KuBanda[BANDAS_PID - 1]),
+              "fuera de 50-90%: la banda del extremo");
+
+    // El salto entre dos pasos de 0.1% es la pendiente de la banda por 0.1%, más el redondeo a 1/256 de banda
+    float peor = 0, anterior = 0;
+    for (uint16_t k = 0; k <= 400; k++) {
+        programarGanancias(BANDA_VELOCIDAD_MIN + k * 0.1f);
+        if (k > 0 && std::fabs(Kp - anterior) > peor) peor = std::fabs(Kp - anterior);
+        anterior = Kp;
+    }
+    float pendiente = 0;
+    for (uint8_t b = 0; b + 1 < BANDAS_PID; b++) {
+        pendiente = fmaxf(pendiente, 0.6f * std::fabs(perfil.KuBanda[b + 1] - perfil.KuBanda[b]) / BANDA_PASO);
+    }
+    std::printf("barrido de 50 a 90%%: salto maximo de Kp %.6f (pendiente maxima %.6f por %%)\n", peor, pendiente);
+    verificar(peor < pendiente * 0.2f, "sin saltos en los bordes de las bandas");
+}
+
+/** @brief Término integral antes y después de pasar de 50% a 90% con la integral cargada. */
+static void probarSinGolpe() {
+    aplicarPerfil(perfilesCorredor[0]);
+
+    // Flotante: con la línea centrada dos veces seguidas la salida es solo Ki·integral
+    reiniciar_pid();
+    programarGanancias(50);
+    for (uint8_t k = 0; k < 200; k++) calculo_pid(setpoint + 800, FIXED_DT_S);
+    calculo_pid(setpoint, FIXED_DT_S);
+    float antes = calculo_pid(setpoint, FIXED_DT_S);
+    float kiAntes = Ki;
+    programarGanancias(90);
+    float despues = calculo_pid(setpoint, FIXED_DT_S);
+    std::printf("flotante: Ki %.4f -> %.4f, termino integral %.4f -> %.4f (sin reescalar seria %.4f)\n",
+                kiAntes, Ki, antes, despues, antes * Ki / kiAntes);
+    verificar(std::fabs(despues - antes) < 1e-4f * std::fabs(antes), "flotante: el cambio de banda no mueve el termino integral");
+
+    // Punto fijo: lo mismo, salvo el redondeo de la suma reescalada (medio error de un tick, Ki·dt/2 por unidad)
+    reiniciar_pid();
+    programarGanancias(50);
+    for (uint8_t k = 0; k < 200; k++) calculo_pid_fijo(setpoint + 800);
+    calculo_pid_fijo(setpoint);
+    int32_t antesQ = calculo_pid_fijo(setpoint);
+    programarGanancias(90);
+    int32_t despuesQ = calculo_pid_fijo(setpoint);
+    std::printf("punto fijo: termino integral %.4f -> %.4f\n", antesQ * (1.0f / PID_UNO), despuesQ * (1.0f / PID_UNO));
+    verificar(std::fabs((despuesQ - antesQ) * (1.0f / PID_UNO)) <= Ki * FIXED_DT_S / 2 + 1e-4f, "punto fijo: el cambio de banda no mueve el termino integral");
+    reiniciar_pid();
+}
+
+// ============================
+// SIMULADOR
+// ============================
+/**
+ @brief Corre 3 vueltas en una pista e informa la mejor vuelta y el error.
+ @param velocidad Velocidad base constante (%), o 0 para usar el gobernador del perfil.
+ @return float Error cuadrático medio de la carrera.
+ */
+static float simular(const PerfilCorredor& perfil, const Pista& pista, uint8_t velocidad) {
+    aplicarPerfil(perfil);
+    if (velocidad) {
+        // Recta = curva sin límite de pendiente: velocidad constante también con GOBERNADOR
+        baseSpeed = rectaGobernador = curvaGobernador = velocidad;
+        subidaGobernador = bajadaGobernador = 1e6f;
+    }
+    Simulador sim(pista);
+    ResultadoCarrera r = sim.correr(3, 60);
+    float mejor = 0;
+    for (uint8_t v = 0; v < r.vueltas; v++) {
+        if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+    }
+    std::printf("  %6.3f%s %6.1f", mejor, r.fueraDePista ? "!" : " ", r.rmsError);
+    return r.rmsError;
+}
+
+int main() {
+    probarTabla();
+    probarSinGolpe();
+
+    Pista pistas[3] = { Pista::competencia(), Pista::ovalo(), Pista::esquinas() };
+    std::printf("\nMejor vuelta y error rms (competencia, ovalo, esquinas), sin tabla (plano) y con la del perfil\n");
+    std::printf("%-10s %-5s %-6s %14s %14s %14s\n", "perfil", "vel", "tabla", "competencia", "ovalo", "esquinas");
+    bool menosError = true;
+    for (uint8_t p = 0; p < cantPerfiles; p++) {
+        const PerfilCorredor& perfil = perfilesCorredor[p];
+        for (uint8_t velocidad = 50; velocidad <= 100; velocidad += 10) {
+            // 100 = con el gobernador
+            uint8_t v = (velocidad > 90) ? 0 : velocidad;
+            float rms[2] = { 0, 0 };
+            for (uint8_t conTabla = 0; conTabla < 2; conTabla++) {
+                if (v) std::printf("%-10s %3u%%  %-6s", perfil.nombre, v, conTabla ? "perfil" : "plano");
+                else   std::printf("%-10s %-5s %-6s", perfil.nombre, "gob.", conTabla ? "perfil" : "plano");
+                for (uint8_t k = 0; k < 2; k++) rms[conTabla] += simular(conTabla ? perfil : plano(perfil), pistas[k], v);
+                simular(conTabla ? perfil : plano(perfil), pistas[2], v);
+                std::printf("\n");
+            }
+            if (v && v <= 70 && rms[1] >= rms[0]) menosError = false;
+        }
+    }
+    std::printf("(! = salio de la pista)\n");
+    verificar(menosError, "simulador: la tabla baja el error en competencia y ovalo a 50-70%");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
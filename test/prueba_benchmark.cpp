@@ -0,0 +1,166 @@
+/**
+ @file prueba_benchmark.cpp
+ @brief Programa de prueba en host (entorno `native`) que mide el costo del tick de control.
+ @details Compila el `fsm.cpp`, `pid.cpp`, `motores.cpp` y `sensores.cpp` reales sobre el backend
+ host de la HAL. Una fuente analógica sintética barre la línea de un lado al otro de la barra
+ QTR para que la calibración y la lectura recorran todos los caminos del código. Se mide cada
+ etapa del tick (`leerLinea()`, `calculo_pid()` y `calculo_pid_fijo()`, `controlMotores()` + `moverMotores()`) y el
+ `estadoControl()` completo, informando media, mínimo y percentil 99 en nanosegundos. También compara
+ el costo de CPU de un cuadro crudo por lectura directa (32 conversiones bloqueantes, como QTRSensors)
+ y por ADC continuo (8 conversiones del ADC2 y el vaciado del DMA); el tiempo real de conversión en el
+ ESP32 lo mide `prueba_muestreo.cpp`.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "sensores.hpp"
+#include "adquisicion.hpp"
+#include "motores.hpp"
+#include "fsm.hpp"
+
+/** @brief Cantidad de ticks medidos por etapa. */
+static const uint32_t CANT_TICKS = 200000;
+
+/** @brief Pines de la barra en el mismo orden que usa sensores.cpp (índice 0 = S8). */
+static const uint8_t pinesBarra[8] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Lectura sintética de cada pin, recalculada una vez por instante del reloj virtual. */
+static uint16_t lecturaPin[40];
+
+/** @brief Instante del reloj virtual al que corresponde `lecturaPin`. */
+static uint32_t instanteLectura = UINT32_MAX;
+
+/**
+ @brief Fuente analógica sintética: línea blanca que oscila lateralmente bajo la barra.
+ @details La posición de la línea recorre todo el ancho de la barra con un periodo de 0.5 s
+ de reloj virtual. Cada sensor devuelve ~300 sobre la línea y ~3800 sobre el fondo negro.
+ El cuadro se calcula una sola vez por instante para no cargar la medición de `leerLinea()`.
+ */
+static uint16_t fuenteSintetica(uint8_t pin) {
+    if (instanteLectura != halMicros()) {
+        instanteLectura = halMicros();
+        double t = instanteLectura * 1e-6;
+        double linea = 3.5 + 4.5 * std::sin(2.0 * M_PI * t / 0.5);   // en unidades de sensor
+
+        for (uint8_t i = 0; i < 8; i++) {
+            double d = (i - linea) / 0.8;
+            lecturaPin[pinesBarra[i]] = (uint16_t)(3800.0 - 3500.0 * std::exp(-d * d));
+        }
+    }
+    return lecturaPin[pin];
+}
+
+/**
+ @brief Acumula tiempos por llamada y muestra sus estadísticas.
+ @param nombre Etiqueta de la etapa.
+ @param muestras Duraciones en nanosegundos (se ordenan en el lugar).
+ */
+static void informar(const char* nombre, std::vector<uint32_t>& muestras) {
+    std::sort(muestras.begin(), muestras.end());
+    double suma = 0;
+    for (uint32_t m : muestras) suma += m;
+
+    std::printf("%-28s media=%8.1f ns  min=%6u ns  p99=%6u ns\n", nombre,
+                suma / muestras.size(), muestras.front(),
+                muestras[(size_t)(muestras.size() * 0.99)]);
+}
+
+/** @brief Reloj monotónico usado para medir. */
+typedef std::chrono::steady_clock reloj;
+
+/** @brief Nanosegundos entre dos instantes. */
+static uint32_t ns(reloj::time_point a, reloj::time_point b) {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+}
+
+int main() {
+    halHostReiniciar();
+    halHostFuenteAnalogica(fuenteSintetica);
+
+    setupMotores();
+    setupInterrupciones();
+    setupSensores();
+    iniciarAdquisicion();
+
+    std::vector<uint32_t> muestras(CANT_TICKS);
+    std::printf("Benchmark del tick de control (CORREDOR=%d, TIEMPO_TIMER=%d us)\n", CORREDOR, (int)TIEMPO_TIMER);
+
+    // leerLinea()
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        halHostAvanzar(TIEMPO_TIMER);
+        reloj::time_point t0 = reloj::now();
+        leerLinea();
+        muestras[i] = ns(t0, reloj::now());
+    }
+    informar("leerLinea()", muestras);
+
+    // Cuadro crudo: lectura directa (camino QTR) contra ADC continuo
+    CuadroSensores cuadro;
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        halHostAvanzar(TIEMPO_TIMER);
+        reloj::time_point t0 = reloj::now();
+        leerCuadroDirecto(cuadro);
+        muestras[i] = ns(t0, reloj::now());
+    }
+    informar("leerCuadroDirecto()", muestras);
+
+    iniciarMuestreoContinuo();
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        halHostAvanzar(TIEMPO_TIMER);
+        reloj::time_point t0 = reloj::now();
+        leerCuadroContinuo(cuadro);
+        muestras[i] = ns(t0, reloj::now());
+    }
+    informar("leerCuadroContinuo()", muestras);
+
+    // calculo_pid()
+    reiniciar_pid();
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        uint16_t pos = (uint16_t)((i * 37) % 7001);
+        reloj::time_point t0 = reloj::now();
+        volatile float c = calculo_pid(pos, FIXED_DT_S);
+        muestras[i] = ns(t0, reloj::now());
+        (void)c;
+    }
+    informar("calculo_pid()", muestras);
+
+    reiniciar_pid();
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        uint16_t pos = (uint16_t)((i * 37) % 7001);
+        reloj::time_point t0 = reloj::now();
+        volatile int32_t c = calculo_pid_fijo(pos);
+        muestras[i] = ns(t0, reloj::now());
+        (void)c;
+    }
+    informar("calculo_pid_fijo()", muestras);
+
+    // controlMotores() + moverMotores()
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        float correcion = (float)((int32_t)(i % 401) - 200);
+        SETPOINT = false;
+        reloj::time_point t0 = reloj::now();
+        controlMotores(correcion);
+        moverMotores(motorSpeedIzq, motorSpeedDer);
+        muestras[i] = ns(t0, reloj::now());
+    }
+    informar("controlMotores+moverMotores", muestras);
+
+    // estadoControl() completo, una vez por TIEMPO_TIMER de reloj virtual
+    reiniciar_pid();
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        halHostAvanzar(TIEMPO_TIMER);
+        reloj::time_point t0 = reloj::now();
+        estadoControl();
+        muestras[i] = ns(t0, reloj::now());
+    }
+    informar("estadoControl()", muestras);
+
+    return 0;
+}
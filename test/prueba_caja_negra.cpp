@@ -0,0 +1,101 @@
+/**
+ @file prueba_caja_negra.cpp
+ @brief Prueba en host (entorno `native_caja_negra`, compilado con `-D CAJA_NEGRA`) de la caja negra.
+ @details Corre una carrera en el simulador y después presiona STOP:
+ - Durante la carrera guarda cada ACEL y CONTROL; al entrar en STOP se congela y los siguientes STOP no la tocan.
+ - El último tick guardado coincide con la posición, los motores y las lecturas crudas del firmware.
+ - Los términos P, I y D reconstruyen la salida del PID (a la resolución de Q4) en los ticks de CONTROL.
+ - Los dt suman el tiempo entre el tick más viejo y el más nuevo.
+ - Un nuevo RUN la rearma.
+ Al final vuelca los últimos ticks en CSV. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "caja_negra.hpp"
+#include "interrupciones.hpp"
+#include "adquisicion.hpp"
+#include "motores.hpp"
+#include "pid.hpp"
+#include "fsm.hpp"
+#include "planificador.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+#ifndef CAJA_NEGRA
+  #error "prueba_caja_negra.cpp requiere -D CAJA_NEGRA (entorno native_caja_negra)"
+#endif
+
+int main() {
+    Pista pista = Pista::competencia();
+    Simulador sim(pista);
+    ResultadoCarrera r = sim.correr(1, 60);
+    std::printf("Carrera: %u vuelta, %.3f s, caja %zu bytes (%u ticks)\n", r.vueltas, r.tiempoSimulado,
+                sizeof(CajaNegra), (unsigned)CAJA_NEGRA_TICKS);
+    // Se rearmó en el primer ACEL: guarda todas las ejecuciones de ACEL y CONTROL, hasta llenarse
+    uint32_t ejecutados = estadisticasTarea(A).ejecuciones + estadisticasTarea(C).ejecuciones;
+    uint32_t esperados = ejecutados < CAJA_NEGRA_TICKS ? ejecutados : CAJA_NEGRA_TICKS;
+    verificar(!cajaNegraCongelada() && registrosCajaNegra() == esperados, "registrando durante la carrera");
+
+    // Estado del firmware en el último tick antes de la parada
+    uint16_t ultimaPosicion = position;
+    int32_t izq = motorSpeedIzq, der = motorSpeedDer;
+    const uint16_t* crudo = crudoLinea();
+    uint16_t ultimoCrudo[CANT_SENSORES];
+    for (uint8_t s = 0; s < CANT_SENSORES; s++) ultimoCrudo[s] = crudo[s];
+    int estadoFinal = estadoFSM();
+    uint32_t finCarrera = halMicros();
+
+    // STOP: congela
+    halHostDispararPin(BTN_STOP);
+    while (estadoFSM() != S) ejecutarPlanificador();
+    for (int k = 0; k < 50; k++) ejecutarPlanificador();
+
+    uint32_t n = registrosCajaNegra();
+    RegistroCaja u = leerCajaNegra(n - 1);
+    verificar(cajaNegraCongelada() && n == esperados, "congelada al entrar en STOP");
+
+    // El tick de la parada no registra: el último es el que dejó la carrera (en ACEL ambos motores van a velocidadAcel)
+    bool motores = estadoFinal == C ? u.motorIzq == izq && u.motorDer == der : u.motorIzq == u.motorDer;
+    bool igual = u.posicion == ultimaPosicion && motores && u.estado == estadoFinal;
+    for (uint8_t s = 0; s < CANT_SENSORES; s++) igual = igual && u.crudo[s] == ultimoCrudo[s];
+    verificar(igual && u.run, "ultimo tick = estado del firmware antes del STOP");
+
+    // P + I + D reconstruye la corrección: motorIzq = baseSpeed - corrección fuera del setpoint (sin saturar)
+    uint32_t controles = 0, coinciden = 0;
+    for (uint32_t j = 0; j < n; j++) {
+        RegistroCaja t = leerCajaNegra(j);
+        if (t.estado != C || t.setpoint) continue;
+        float correccion = t.p + t.i + t.d;
+        int32_t esperadoIzq = (int32_t)(baseSpeed - correccion);
+        if (abs(esperadoIzq) >= maxSpeed || std::fabs(correccion) > 50) continue;
+        controles++;
+        if (abs(esperadoIzq - t.motorIzq) <= 1) coinciden++;
+    }
+    std::printf("  ticks de CONTROL sin saturar: %u, reconstruidos: %u\n", controles, coinciden);
+    verificar(controles > 0 && coinciden == controles, "P + I + D reproduce el motor izquierdo");
+
+    // Suma de dt = tiempo entre el primero y el último
+    uint64_t suma = 0;
+    for (uint32_t j = 1; j < n; j++) suma += leerCajaNegra(j).dt_us;
+    std::printf("  ventana: %.3f s (fin de carrera en %.3f s)\n", suma * 1e-6, finCarrera * 1e-6);
+    verificar(suma > 0 && suma < finCarrera, "dt consistentes");
+
+    // Los últimos 5 ticks en CSV
+    std::printf("\nUltimos ticks:\n");
+    for (uint32_t j = n - 5; j < n; j++) {
+        RegistroCaja t = leerCajaNegra(j);
+        std::printf("  dt=%5u %c SP=%d pos=%4u P=%8.3f I=%7.3f D=%8.3f izq=%4d der=%4d\n", t.dt_us, "SACP"[t.estado],
+                    t.setpoint, t.posicion, t.p, t.i, t.d, t.motorIzq, t.motorDer);
+    }
+
+    // Un nuevo RUN la rearma
+    halHostDispararPin(BTN_RUN);
+    for (int k = 0; k < 3; k++) ejecutarPlanificador();
+    verificar(!cajaNegraCongelada() && registrosCajaNegra() < 10, "rearmada por el RUN");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
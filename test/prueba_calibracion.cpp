@@ -0,0 +1,158 @@
+/**
+ @file prueba_calibracion.cpp
+ @brief Prueba en host (entorno `native_calibracion`) de la calibración guardada en la memoria no volátil.
+ @details El almacén del backend host es un directorio temporal, así que cada "arranque" (`halHostReiniciar()`
+ más `setupSensores()`) ve lo que dejó el anterior, como la NVS del ESP32:
+ - Sin calibración guardada se calibra y se guarda; el arranque siguiente la carga sin leer la barra y la
+   posición leída es la misma.
+ - Un bloque alterado o truncado se rechaza y se recalibra.
+ - Con `BTN_STOP` apretado al encender se recalibra aunque haya una calibración válida, y la nueva reemplaza a la guardada.
+ - Sin almacén se calibra en cada arranque, como antes.
+ Informa el tiempo de arranque de la barra con y sin calibración guardada. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "hal.hpp"
+#include "config.hpp"
+#include "sensores.hpp"
+#include "verificar.hpp"
+
+/** @brief Pines de la barra en el mismo orden que usa sensores.cpp (índice 0 = S8). */
+static const uint8_t pinesBarra[8] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Conversiones pedidas a la fuente: cuenta cuánto se leyó la barra en cada arranque. */
+static uint32_t conversiones = 0;
+
+/** @brief Contraste de la pista simulada (cambia entre arranques para distinguir calibraciones). */
+static double contraste = 3500.0;
+
+/** @brief Línea quieta en 2.3 en vez del barrido (para comparar posiciones). */
+static bool quieta = false;
+
+/**
+ @brief Línea blanca sobre fondo negro que barre la barra de lado a lado.
+ @details El barrido avanza con cada conversión, no con el reloj virtual, para que la calibración vea toda la barra.
+ */
+static uint16_t fuente(uint8_t pin) {
+    double linea = quieta ? 2.3 : 3.5 + 4.5 * std::sin(conversiones * 1e-4);
+    conversiones++;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (pinesBarra[i] != pin) continue;
+        double d = (i - linea) / 0.8;
+        return (uint16_t)(3800.0 - contraste * std::exp(-d * d));
+    }
+    return 0;
+}
+
+/** @brief Resultado de un arranque. */
+struct Arranque {
+    uint32_t conversiones;      ///< Lecturas de la barra durante `setupSensores()`.
+    uint32_t virtual_us;        ///< Tiempo del reloj virtual (incluye los tonos del buzzer).
+    double real_us;             ///< Tiempo real en la PC.
+    CalibracionSensores cal;    ///< Calibración con la que quedó la barra.
+};
+
+/** @brief Reinicia el "robot" y corre la configuración de la barra, con o sin STOP apretado. */
+static Arranque arrancar(bool stopApretado = false) {
+    halHostReiniciar();
+    halHostFuenteAnalogica(fuente);
+    halHostFijarDigital(BTN_STOP, stopApretado);
+    reiniciarSensores();
+
+    Arranque a = {};
+    uint32_t antes = conversiones;
+    auto t0 = std::chrono::steady_clock::now();
+    setupSensores();
+    auto t1 = std::chrono::steady_clock::now();
+    a.conversiones = conversiones - antes;
+    a.virtual_us = halMicros();
+    a.real_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+    calibracionSensores(a.cal);
+    return a;
+}
+
+/** @brief Posición leída con la línea quieta en 2.3. */
+static uint16_t posicionFija() {
+    quieta = true;
+    halHostAvanzar(1000);       // Con ADC_CONTINUO, conversiones nuevas con la línea quieta
+    uint16_t p = leerLinea();
+    quieta = false;
+    return p;
+}
+
+/** @brief Altera un byte del archivo del almacén (o lo trunca si @p truncar). */
+static void alterarArchivo(const std::string& ruta, bool truncar) {
+    FILE* f = std::fopen(ruta.c_str(), "r+b");
+    if (!f) return;
+    if (truncar) {
+        if (ftruncate(fileno(f), 10) != 0) std::printf("  no se pudo truncar %s\n", ruta.c_str());
+    } else {
+        std::fseek(f, 7, SEEK_SET);
+        int c = std::fgetc(f);
+        std::fseek(f, 7, SEEK_SET);
+        std::fputc(c ^ 0x10, f);
+    }
+    std::fclose(f);
+}
+
+int main() {
+    char plantilla[] = "/tmp/prueba_calibracion_XXXXXX";
+    const char* directorio = mkdtemp(plantilla);
+    if (!directorio) {
+        std::printf("no se pudo crear el directorio del almacen\nFALLA\n");
+        return 1;
+    }
+    std::string archivo = std::string(directorio) + "/calibracion.nvs";
+    halHostAlmacen(directorio);
+
+    // Primer arranque: calibra y guarda
+    Arranque primero = arrancar();
+    uint16_t posCalibrada = posicionFija();
+    FILE* f = std::fopen(archivo.c_str(), "rb");
+    verificar(primero.conversiones > 0 && f != nullptr, "sin calibracion guardada: calibra y la guarda");
+    if (f) std::fclose(f);
+
+    // Segundo arranque: la carga sin leer la barra
+    Arranque segundo = arrancar();
+    verificar(segundo.conversiones == 0 && std::memcmp(&segundo.cal, &primero.cal, sizeof(primero.cal)) == 0,
+              "arranque siguiente: carga la misma calibracion sin leer la barra");
+    verificar(posicionFija() == posCalibrada, "misma posicion con la calibracion cargada");
+    std::printf("  arranque de la barra: calibrando %.0f us reales (%u us virtuales), cargando %.1f us reales\n",
+                primero.real_us, primero.virtual_us, segundo.real_us);
+
+    // Bloque alterado: se recalibra y se vuelve a guardar uno válido
+    alterarArchivo(archivo, false);
+    Arranque alterado = arrancar();
+    verificar(alterado.conversiones > 0, "bloque alterado: CRC invalido, recalibra");
+    verificar(arrancar().conversiones == 0, "el bloque recalibrado vuelve a cargarse");
+
+    alterarArchivo(archivo, true);
+    verificar(arrancar().conversiones > 0, "bloque truncado: recalibra");
+
+    // STOP apretado al encender: recalibra y reemplaza la calibración guardada
+    contraste = 2500.0;
+    Arranque gesto = arrancar(true);
+    Arranque despues = arrancar();
+    verificar(gesto.conversiones > 0 && std::memcmp(&gesto.cal, &primero.cal, sizeof(primero.cal)) != 0,
+              "STOP apretado al encender: recalibra con una calibracion valida");
+    verificar(despues.conversiones == 0 && std::memcmp(&despues.cal, &gesto.cal, sizeof(gesto.cal)) == 0,
+              "la calibracion nueva reemplaza a la guardada");
+
+    // Sin almacén: calibra en cada arranque
+    halHostAlmacen(nullptr);
+    Arranque sinAlmacen = arrancar();
+    verificar(sinAlmacen.conversiones > 0 && arrancar().conversiones > 0 && !guardarCalibracion(),
+              "sin almacen: calibra en cada arranque");
+
+    std::remove(archivo.c_str());
+    rmdir(directorio);
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,334 @@
+/**
+ @file prueba_filtros.cpp
+ @brief Prueba en host (entorno `native_filtros`) de la cadena de filtros por canal (filtros.hpp).
+ @details Respuesta en frecuencia de cada etapa con senoides de 1000 cuentas sobre 2000, en ciclos por muestra:
+ - Sobremuestreo (`leerCuadroDirecto()` con `FILTRO_SOBREMUESTREO` conversiones por sensor): la ganancia
+   sigue la del promedio de N conversiones, |sin(pi f N) / (N sin(pi f))|.
+ - IIR con k de 1 a 4: la ganancia sigue |a / (1 - (1 - a) e^-jw)| con a = 1/2^k, y con una entrada
+   constante (o tras un escalón) la salida llega exactamente a la entrada.
+ - Mediana de 3 (no lineal): ganancia cercana a 1 en baja frecuencia, picos aislados descartados por
+   completo y escalones retrasados un cuadro sin sobrepaso.
+ Después informa cuánto baja cada etapa el ruido de un canal y el de su diferencia entre cuadros (lo que
+ ve `derivativo`), y los ciclos por cuadro de cada etapa y de `filtrarCuadro()` (TSC en x86, nanosegundos
+ en otras arquitecturas). Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "filtros.hpp"
+#include "verificar.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  /** @brief Contador de ciclos del procesador. */
+  static uint64_t ciclos() { return __rdtsc(); }
+  static const char* UNIDAD = "ciclos";
+#else
+  static uint64_t ciclos() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static const char* UNIDAD = "ns";
+#endif
+
+/** @brief Cuadros por medición de tiempo. */
+static const uint32_t CANT_CUADROS = 2000000;
+
+/** @brief Muestras por medición de ganancia (tras descartar el transitorio): ciclos enteros de cada frecuencia. */
+static const uint32_t CANT_MUESTRAS = 4000;
+
+/** @brief Frecuencias de prueba en ciclos por muestra. */
+static const double frecuencias[] = { 0.005, 0.01, 0.02, 0.05, 0.1, 0.15, 0.2, 0.3, 0.4, 0.45 };
+static const uint8_t CANT_FRECUENCIAS = sizeof(frecuencias) / sizeof(frecuencias[0]);
+
+/** @brief Senoide de prueba: 2000 + 1000 sin(2 pi f n + fase), redondeada a cuentas. */
+static uint16_t senoide(double f, uint32_t n, double fase = 0.3) {
+    return (uint16_t)std::lround(2000.0 + 1000.0 * std::sin(2.0 * M_PI * f * n + fase));
+}
+
+/** @brief Amplitud de la componente de frecuencia @p f de @p y (proyección sobre seno y coseno). */
+static double amplitud(const double *y, uint32_t n, double f) {
+    double s = 0, c = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        s += y[k] * std::sin(2.0 * M_PI * f * k);
+        c += y[k] * std::cos(2.0 * M_PI * f * k);
+    }
+    return 2.0 * std::sqrt(s * s + c * c) / n;
+}
+
+/** @brief Desvío estándar de @p y. */
+static double desvio(const double *y, uint32_t n) {
+    double m = 0, v = 0;
+    for (uint32_t k = 0; k < n; k++) m += y[k];
+    m /= n;
+    for (uint32_t k = 0; k < n; k++) v += (y[k] - m) * (y[k] - m);
+    return std::sqrt(v / n);
+}
+
+// ============================
+// SOBREMUESTREO
+// ============================
+/** @brief Frecuencia de la fuente en ciclos por conversión. */
+static double frecuenciaFuente = 0;
+
+/** @brief Conversiones hechas por cada pin. */
+static uint32_t conversionesPin[40];
+
+/** @brief Fuente analógica: cada pin ve la senoide avanzada una muestra por conversión. */
+static uint16_t fuente(uint8_t pin) {
+    return senoide(frecuenciaFuente, conversionesPin[pin]++);
+}
+
+/**
+ @brief Ganancia del sobremuestreo: desvío de la salida (una muestra por cuadro) contra el de la senoide.
+ @details La salida queda submuestreada (alias en f N), así que se compara su desvío y no una proyección.
+ */
+static double gananciaSobremuestreo(double f) {
+    frecuenciaFuente = f;
+    for (uint8_t p = 0; p < 40; p++) conversionesPin[p] = 0;
+
+    static double y[CANT_MUESTRAS];
+    CuadroSensores cuadro;
+    for (uint32_t k = 0; k < CANT_MUESTRAS; k++) {
+        leerCuadroDirecto(cuadro);
+        y[k] = cuadro.crudo[3];
+    }
+    return desvio(y, CANT_MUESTRAS) / (1000.0 / std::sqrt(2.0));
+}
+
+static void probarSobremuestreo() {
+    const uint32_t n = FILTRO_SOBREMUESTREO;
+    std::printf("Sobremuestreo: %u conversiones por sensor\n", n);
+    std::printf("  %8s %10s %10s\n", "f", "ganancia", "teorica");
+
+    halHostReiniciar();
+    halHostFuenteAnalogica(fuente);
+    iniciarMuestreo();
+
+    bool ok = true;
+    for (uint8_t j = 0; j < CANT_FRECUENCIAS; j++) {
+        double f = frecuencias[j];
+        // f N multiplo de 1/2: la salida submuestreada depende de la fase, no de la ganancia
+        double alias = std::fmod(f * n, 0.5);
+        if (n > 1 && (alias < 0.01 || alias > 0.49)) continue;
+
+        double medida = gananciaSobremuestreo(f);
+        double teorica = n == 1 ? 1.0 : std::fabs(std::sin(M_PI * f * n) / (n * std::sin(M_PI * f)));
+        std::printf("  %8.3f %10.4f %10.4f\n", f, medida, teorica);
+        ok = ok && std::fabs(medida - teorica) < 0.01;
+    }
+    verificar(ok, "sobremuestreo: ganancia del promedio de N conversiones (+-0.01)");
+    halHostFuenteAnalogica(nullptr);
+}
+
+// ============================
+// IIR
+// ============================
+/** @brief Pasa una senoide de frecuencia @p f por un IIR de desplazamiento @p k y mide la ganancia. */
+static double gananciaIir(uint8_t k, double f) {
+    EtapaIir etapa = {};
+    static double y[CANT_MUESTRAS];
+    for (uint32_t n = 0; n < 512 + CANT_MUESTRAS; n++) {
+        uint16_t c[CANT_SENSORES];
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = senoide(f, n, 0.3 + i);
+        pasoIir(etapa, c, k);
+        if (n >= 512) y[n - 512] = c[5];
+    }
+    return amplitud(y, CANT_MUESTRAS, f) / 1000.0;
+}
+
+static void probarIir() {
+    std::printf("IIR de primer orden: ganancia medida / teorica\n");
+    std::printf("  %8s", "f");
+    for (uint8_t k = 1; k <= 4; k++) std::printf("         k=%u     ", k);
+    std::printf("\n");
+
+    bool ok = true;
+    for (uint8_t j = 0; j < CANT_FRECUENCIAS; j++) {
+        double f = frecuencias[j];
+        std::printf("  %8.3f", f);
+        for (uint8_t k = 1; k <= 4; k++) {
+            double a = 1.0 / (1 << k), w = 2.0 * M_PI * f;
+            double teorica = a / std::sqrt(1.0 - 2.0 * (1.0 - a) * std::cos(w) + (1.0 - a) * (1.0 - a));
+            double medida = gananciaIir(k, f);
+            std::printf("   %6.4f/%6.4f", medida, teorica);
+            ok = ok && std::fabs(medida - teorica) < 0.005;
+        }
+        std::printf("\n");
+    }
+    std::printf("  retardo en baja frecuencia (2^k - 1 cuadros): 1, 3, 7 y 15\n");
+    verificar(ok, "IIR: ganancia de a / (1 - (1 - a) z^-1) (+-0.005)");
+
+    // Escalones entre valores al azar: la salida llega exactamente a cada uno
+    bool exacto = true;
+    uint32_t semilla = 99;
+    for (uint8_t k = 1; k <= 8; k++) {
+        EtapaIir etapa = {};
+        for (uint32_t e = 0; e < 200; e++) {
+            semilla = semilla * 1664525u + 1013904223u;
+            uint16_t nivel = (uint16_t)((semilla >> 8) % 4096);
+            uint16_t c[CANT_SENSORES];
+            for (uint32_t n = 0; n < 40u << k; n++) {
+                for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = nivel;
+                pasoIir(etapa, c, k);
+            }
+            for (uint8_t i = 0; i < CANT_SENSORES; i++) exacto = exacto && c[i] == nivel;
+        }
+    }
+    verificar(exacto, "IIR: tras un escalon la salida llega exacta a la entrada (k 1 a 8)");
+}
+
+// ============================
+// MEDIANA
+// ============================
+static void probarMediana() {
+    std::printf("Mediana de 3 cuadros: ganancia sobre una senoide\n");
+    bool ok = true;
+    for (uint8_t j = 0; j < CANT_FRECUENCIAS; j++) {
+        double f = frecuencias[j];
+        EtapaMediana etapa = {};
+        static double y[CANT_MUESTRAS];
+        for (uint32_t n = 0; n < 16 + CANT_MUESTRAS; n++) {
+            uint16_t c[CANT_SENSORES];
+            for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = senoide(f, n, 0.3 + i);
+            pasoMediana(etapa, c);
+            if (n >= 16) y[n - 16] = c[2];
+        }
+        double g = amplitud(y, CANT_MUESTRAS, f) / 1000.0;
+        std::printf("  %8.3f %10.4f\n", f, g);
+        if (f <= 0.05) ok = ok && g > 0.99;
+    }
+    verificar(ok, "mediana: ganancia mayor a 0.99 hasta 0.05 ciclos por cuadro");
+
+    // Picos aislados de una muestra sobre una rampa lenta: desaparecen
+    EtapaMediana etapa = {};
+    bool limpio = true;
+    uint16_t anterior = 0;
+    for (uint32_t n = 0; n < 2000; n++) {
+        uint16_t base = (uint16_t)(1000 + n / 4);
+        uint16_t c[CANT_SENSORES];
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = base;
+        if (n % 7 == 3) c[n % CANT_SENSORES] = (n & 8) ? 4095 : 0;
+        pasoMediana(etapa, c);
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+            limpio = limpio && (n == 0 || (c[i] >= anterior && c[i] <= anterior + 1));
+        }
+        anterior = c[0];
+    }
+    verificar(limpio, "mediana: picos aislados de una muestra descartados");
+
+    // Escalón: un cuadro de retardo y sin sobrepaso
+    etapa = EtapaMediana();
+    bool escalon = true;
+    for (uint32_t n = 0; n < 10; n++) {
+        uint16_t c[CANT_SENSORES];
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = n < 5 ? 500 : 3500;
+        pasoMediana(etapa, c);
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) escalon = escalon && c[i] == (n < 6 ? 500 : 3500);
+    }
+    verificar(escalon, "mediana: escalon retrasado un cuadro, sin sobrepaso");
+}
+
+// ============================
+// RUIDO Y COSTO
+// ============================
+/** @brief Etapa a evaluar con ruido y a medir en ciclos. */
+enum Etapa { MEDIANA, IIR, CADENA };
+
+/** @brief Cuadros con ruido triangular de ±40 cuentas (el del simulador) sobre un nivel fijo. */
+static uint16_t cuadrosRuido[256][CANT_SENSORES];
+
+/** @brief Estados para las mediciones. */
+static EtapaMediana medianaMedida;
+static EtapaIir iirMedido;
+
+/** @brief Desplazamiento del IIR medido: el de la cadena, o 2 si la cadena no tiene IIR. */
+static const uint8_t K_MEDIDO = FILTRO_IIR > 0 ? FILTRO_IIR : 2;
+
+/** @brief Aplica una etapa a un cuadro. */
+static inline void aplicar(Etapa etapa, uint16_t *c) {
+    switch (etapa) {
+        case MEDIANA: pasoMediana(medianaMedida, c); break;
+        case IIR:     pasoIir(iirMedido, c, K_MEDIDO); break;
+        default:      filtrarCuadro(c); break;
+    }
+}
+
+/** @brief Desvío de un canal y de su diferencia entre cuadros tras una etapa. */
+static void ruido(const char* nombre, Etapa etapa, bool filtrar) {
+    static double y[CANT_MUESTRAS], d[CANT_MUESTRAS];
+    medianaMedida = EtapaMediana();
+    iirMedido = EtapaIir();
+    reiniciarFiltro();
+    double previo = 0;
+    for (uint32_t n = 0; n < CANT_MUESTRAS + 64; n++) {
+        uint16_t c[CANT_SENSORES];
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = cuadrosRuido[(n * 37 + i) & 255][i];
+        if (filtrar) aplicar(etapa, c);
+        if (n >= 64) {
+            y[n - 64] = c[4];
+            d[n - 64] = c[4] - previo;
+        }
+        previo = c[4];
+    }
+    std::printf("  %-26s desvio %6.2f  diferencia %6.2f\n", nombre, desvio(y, CANT_MUESTRAS), desvio(d, CANT_MUESTRAS));
+}
+
+/** @brief Costo medio por cuadro de una etapa. */
+static double costo(Etapa etapa) {
+    uint16_t c[CANT_SENSORES];
+    volatile uint16_t sumidero = 0;
+    uint64_t t0 = ciclos();
+    for (uint32_t k = 0; k < CANT_CUADROS; k++) {
+        const uint16_t* origen = cuadrosRuido[k & 255];
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) c[i] = origen[i];
+        aplicar(etapa, c);
+        sumidero = c[k & 7];
+    }
+    uint64_t t1 = ciclos();
+    (void)sumidero;
+    return (double)(t1 - t0) / CANT_CUADROS;
+}
+
+static void medir() {
+    uint32_t semilla = 777;
+    for (uint32_t c = 0; c < 256; c++) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+            semilla = semilla * 1664525u + 1013904223u;
+            int32_t r = (int32_t)((semilla >> 8) % 41) + (int32_t)((semilla >> 20) % 41) - 40;
+            cuadrosRuido[c][i] = (uint16_t)(2000 + r);
+        }
+    }
+
+    std::printf("Ruido triangular de +-40 cuentas en un canal fijo (y en su diferencia entre cuadros):\n");
+    ruido("sin filtro", CADENA, false);
+    ruido("mediana de 3", MEDIANA, true);
+    char nombre[32];
+    std::snprintf(nombre, sizeof(nombre), "IIR k=%u", K_MEDIDO);
+    ruido(nombre, IIR, true);
+    ruido("filtrarCuadro()", CADENA, true);
+
+    double mediana = 1e30, iir = 1e30, cadena = 1e30;
+    for (uint8_t r = 0; r < 9; r++) {
+        mediana = std::fmin(mediana, costo(MEDIANA));
+        iir = std::fmin(iir, costo(IIR));
+        cadena = std::fmin(cadena, costo(CADENA));
+    }
+    std::printf("%-28s %6.2f %s/cuadro\n", "pasoMediana()", mediana, UNIDAD);
+    std::printf("%-28s %6.2f %s/cuadro\n", "pasoIir()", iir, UNIDAD);
+    std::printf("%-28s %6.2f %s/cuadro (mediana %s, IIR k=%u)\n", "filtrarCuadro()", cadena, UNIDAD,
+                FILTRO_MEDIANA_ACTIVA ? "si" : "no", FILTRO_IIR);
+}
+
+int main() {
+    probarSobremuestreo();
+    probarIir();
+    probarMediana();
+    medir();
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
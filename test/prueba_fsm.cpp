@@ -0,0 +1,128 @@
+/**
+ @file prueba_fsm.cpp
+ @brief Prueba en host (entorno `native_fsm`) de la máquina de estados generada en compilación.
+ @details Verifica:
+ - `tablaFSM` coincide, celda por celda, con el recorrido lineal de `reglasFSM` que hacía `transicionar()`.
+ - Una máquina con acciones de registro corre la entrada del estado inicial en la primera transición, la
+   salida antes de la entrada al cambiar de estado, ninguna de las dos si no cambia, y la acción de
+   ejecución siempre.
+ - En el firmware, la entrada de STOP (motores detenidos, LEDs apagados) corre una sola vez por parada y
+   las entradas de ACEL y CONTROL dejan los LEDs como los dejaba cada tick.
+ Informa además el costo por transición de la tabla densa contra el recorrido lineal. Devuelve 1 si
+ alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "motores.hpp"
+#include "fsm.hpp"
+#include "verificar.hpp"
+
+/** @brief Recorrido lineal de las reglas del estado, como las tablas con centinela `CUALQUIERA`. */
+static int recorrerReglas(int estado, int entrada) {
+    const Regla* p = reglasFSM;
+    while (p->desde != estado) p++;
+    while (p->recibo != entrada && p->recibo != CUALQUIERA) p++;
+    return p->hacia;
+}
+
+// ============================
+// MAQUINA DE REGISTRO
+// ============================
+/** @brief Acciones ejecutadas, como texto ("+S" entrar, "S" ejecutar, "-S" salir). */
+static char registro[128];
+
+static void anotar(const char* a) {
+    std::strncat(registro, a, sizeof(registro) - std::strlen(registro) - 1);
+    std::strncat(registro, " ", sizeof(registro) - std::strlen(registro) - 1);
+}
+
+static void entrarS() { anotar("+S"); }
+static void ejecutarS() { anotar("S"); }
+static void salirS() { anotar("-S"); }
+static void entrarA() { anotar("+A"); }
+static void ejecutarA() { anotar("A"); }
+static void salirA() { anotar("-A"); }
+static void ejecutarC() { anotar("C"); }
+
+/** @brief Acciones de registro; CONTROL sin entrada ni salida. */
+static const AccionesEstado accionesRegistro[CANT_ESTADOS] = {
+    { entrarS, ejecutarS, salirS },
+    { entrarA, ejecutarA, salirA },
+    { nullptr, ejecutarC, nullptr },
+};
+
+/** @brief Aplica una secuencia de entradas y compara lo registrado. */
+static bool secuencia(MaquinaEstados<CANT_ESTADOS, CANT_ENTRADAS>& m, const char* entradas, const char* esperado) {
+    registro[0] = '\0';
+    for (const char* e = entradas; *e; e++) m.transicionar((uint8_t)(*e - '0'));
+    bool ok = std::strcmp(registro, esperado) == 0;
+    if (!ok) std::printf("    entradas %s: \"%s\" (esperado \"%s\")\n", entradas, registro, esperado);
+    return ok;
+}
+
+int main() {
+    // Tabla generada = recorrido lineal
+    bool iguales = true;
+    for (int e = 0; e < CANT_ESTADOS; e++) {
+        for (int i = 0; i < CANT_ENTRADAS; i++) iguales = iguales && tablaFSM.prox[e][i] == recorrerReglas(e, i);
+    }
+    verificar(iguales, "tablaFSM = recorrido lineal de reglasFSM");
+
+    // Orden de las acciones
+    MaquinaEstados<CANT_ESTADOS, CANT_ENTRADAS> m(tablaFSM, accionesRegistro, S);
+    verificar(secuencia(m, "00", "+S S S "), "entrada inicial pendiente, una sola vez");
+    verificar(secuencia(m, "3311", "-S +A A A -A C C "), "salida antes de entrada al cambiar");
+    verificar(secuencia(m, "30", "+A A -A +S S "), "C sin acciones de entrada/salida");
+    m.reiniciar(S);
+    verificar(secuencia(m, "1", "+A A "), "reiniciar: sin salida, entrada del destino");
+
+    // Firmware: STOP una sola vez por parada, LEDs al cambiar de estado
+    halHostReiniciar();
+    setupMotores();
+    reiniciarFSM();
+    const HalContadores& cuentas = halHostContadores();
+
+    uint32_t antes = cuentas.escriturasDigitales;
+    transicionar(0);
+    uint32_t entradaStop = cuentas.escriturasDigitales - antes;
+    for (int k = 0; k < 100; k++) transicionar(0);
+    verificar(entradaStop > 0 && cuentas.escriturasDigitales - antes == entradaStop, "entrada de STOP una vez");
+
+    transicionar(3);                                    // S -> A: LED de setpoint
+    bool acel = halHostNivelPin(ledCalibracion) && !halHostNivelPin(ledMotores);
+    transicionar(1);                                    // A -> C
+    bool control = halHostNivelPin(ledMotores) && !halHostNivelPin(ledCalibracion);
+    verificar(estadoFSM() == C && acel && control, "LEDs fijados por las entradas de ACEL y CONTROL");
+
+    antes = cuentas.escriturasDigitales;
+    transicionar(0);
+    transicionar(0);
+    verificar(estadoFSM() == S && cuentas.escriturasDigitales - antes == entradaStop, "nueva parada: entrada de STOP otra vez");
+
+    // Costo por transición (sin acciones)
+    static const AccionesEstado vacias[CANT_ESTADOS] = {};
+    MaquinaEstados<CANT_ESTADOS, CANT_ENTRADAS> rapida(tablaFSM, vacias, S);
+    const uint32_t N = 20000000;
+    volatile uint8_t sumidero = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t k = 0; k < N; k++) sumidero = rapida.transicionar((uint8_t)(k >> 3) & 3);
+    auto t1 = std::chrono::steady_clock::now();
+    int estado = S;
+    for (uint32_t k = 0; k < N; k++) sumidero = (uint8_t)(estado = recorrerReglas(estado, (int)(k >> 3) & 3));
+    auto t2 = std::chrono::steady_clock::now();
+    (void)sumidero;
+
+    double tabla_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+    double lineal_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / N;
+    std::printf("\nPor transicion: tabla %.2f ns, recorrido lineal %.2f ns\n", tabla_ns, lineal_ns);
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
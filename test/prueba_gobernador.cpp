@@ -0,0 +1,157 @@
+/**
+ @file prueba_gobernador.cpp
+ @brief Prueba en host (entorno `native_gobernador`) del gobernador de velocidad (`-D GOBERNADOR`).
+ @details Alimenta `gobernarVelocidad()` con posiciones sintéticas y verifica:
+ - Con error nulo la velocidad sube hasta `rectaGobernador` sin pasar nunca `subida` %/s.
+ - Con error máximo baja hasta `curvaGobernador` sin pasar nunca `bajada` %/s.
+ - Con la mitad de `GOBERNADOR_ERROR_MAX` quieto el objetivo queda a mitad de camino, y una línea que
+   se mueve (variación del error) baja más la velocidad.
+ Después corre el simulador con cada perfil, con la velocidad constante `baseSpeed` del perfil, con la
+ constante igual a `rectaGobernador` y con el gobernador, en la adherencia nominal y en una pista resbalosa,
+ y verifica que el gobernador no pierde la línea más veces que ninguna de las dos constantes ni se sale de la
+ pista, y que con la adherencia nominal la mejor vuelta es más corta que con `baseSpeed` en cada pista.
+ Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "gobernador.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+/** @brief Tolerancia de redondeo en las comparaciones de velocidad (%). */
+static const float TOLERANCIA = 1e-3f;
+
+/**
+ @struct Fila
+ @brief Resultado de un perfil y un modo en las tres pistas.
+ */
+struct Fila {
+    float mejor[3];         ///< Mejor vuelta en cada pista (s).
+    uint32_t perdidas[3];   ///< Veces que perdió la línea en cada pista.
+    bool fuera;             ///< Salió de la pista en alguna.
+};
+
+/**
+ @brief Corre @p ticks con la posición fija y verifica las pendientes.
+ @return float Velocidad al final.
+ */
+static float mantener(uint16_t pos, uint32_t ticks, bool& pendientes) {
+    float anterior = velocidadGobernada();
+    for (uint32_t k = 0; k < ticks; k++) {
+        float v = gobernarVelocidad(pos);
+        float paso = v - anterior;
+        if (paso > subidaGobernador * FIXED_DT_S + TOLERANCIA) pendientes = false;
+        if (-paso > bajadaGobernador * FIXED_DT_S + TOLERANCIA) pendientes = false;
+        anterior = v;
+    }
+    return anterior;
+}
+
+/** @brief Rampas de subida y bajada, objetivo intermedio y efecto de la variación. */
+static void probarLey() {
+    aplicarPerfil(perfilesCorredor[0]);
+    std::printf("NIGHTFALL: recta %u, curva %u, subida %.0f %%/s, bajada %.0f %%/s (tick de %d us)\n",
+                rectaGobernador, curvaGobernador, subidaGobernador, bajadaGobernador, (int)TIEMPO_TIMER);
+
+    // Subida desde 50 con la línea centrada: tarda (recta - 50) / subida segundos
+    bool pendientes = true;
+    iniciarGobernador(50);
+    uint32_t ticksSubida = (uint32_t)((rectaGobernador - 50) / (subidaGobernador * FIXED_DT_S));
+    float casi = mantener(setpoint, ticksSubida - 1, pendientes);
+    float arriba = mantener(setpoint, 5, pendientes);
+    std::printf("subida: %.2f antes de llegar, %.2f despues\n", casi, arriba);
+    verificar(casi < rectaGobernador && std::fabs(arriba - rectaGobernador) < TOLERANCIA,
+              "error nulo: sube a rectaGobernador con la pendiente de subida");
+
+    // Error máximo: baja a la velocidad de curva
+    float abajo = mantener(0, 100, pendientes);
+    verificar(std::fabs(abajo - curvaGobernador) < TOLERANCIA, "error maximo: baja a curvaGobernador");
+    verificar(pendientes, "nunca supera las pendientes de subida y bajada del perfil");
+
+    // Mitad del error máximo, quieto: objetivo a mitad de camino
+    uint16_t mitad = (uint16_t)(setpoint + GOBERNADOR_ERROR_MAX / 2);
+    float intermedia = mantener(mitad, 200, pendientes);
+    float esperada = rectaGobernador - (rectaGobernador - curvaGobernador) * 0.5f;
+    std::printf("error de %.0f quieto: %.2f (esperada %.2f)\n", GOBERNADOR_ERROR_MAX / 2, intermedia, esperada);
+    verificar(std::fabs(intermedia - esperada) < 0.01f, "error intermedio: velocidad intermedia");
+
+    // La misma posición media con la línea oscilando: la variación suma carga (con OBSERVADOR la variación
+    // es velocidadLinea(), que esta prueba no alimenta)
+#ifndef OBSERVADOR
+    float oscilando = 0;
+    for (uint32_t k = 0; k < 200; k++) oscilando = gobernarVelocidad((uint16_t)(mitad + ((k & 1) ? 60 : -60)));
+    std::printf("error de %.0f oscilando +-60 por tick: %.2f\n", GOBERNADOR_ERROR_MAX / 2, oscilando);
+    verificar(oscilando < intermedia - 1, "variacion del error: baja mas la velocidad");
+#endif
+}
+
+/**
+ @brief Mejor vuelta y pérdidas de línea de un perfil en las tres pistas.
+ @param modo 0 = `baseSpeed` constante, 1 = constante en `rectaGobernador`, 2 = gobernador.
+ */
+static Fila simular(uint8_t perfil, uint8_t modo, const ParametrosRobot& robot) {
+    static const char* nombresModo[3] = { "baseSpeed", "recta cte.", "gobernador" };
+    Pista pistas[3] = { Pista::competencia(), Pista::ovalo(), Pista::esquinas() };
+
+    aplicarPerfil(perfilesCorredor[perfil]);
+    uint8_t constante = (modo == 0) ? baseSpeed : rectaGobernador;
+    std::printf("%-10s %-11s %3u", perfilesCorredor[perfil].nombre, nombresModo[modo], modo == 2 ? curvaGobernador : constante);
+
+    Fila fila = {};
+    for (uint8_t k = 0; k < 3; k++) {
+        aplicarPerfil(perfilesCorredor[perfil]);
+        if (modo < 2) {
+            // Recta = curva sin límite de pendiente es la velocidad constante de antes
+            rectaGobernador = curvaGobernador = constante;
+            subidaGobernador = bajadaGobernador = 1e6f;
+        }
+        Simulador sim(pistas[k], robot);
+        ResultadoCarrera r = sim.correr(3, 60);
+        float mejor = 0;
+        for (uint8_t v = 0; v < r.vueltas; v++) {
+            if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+        }
+        std::printf("  %7.3f%s %3u", mejor, r.fueraDePista ? "!" : " ", r.perdidasLinea);
+        fila.mejor[k] = mejor;
+        fila.perdidas[k] = r.perdidasLinea;
+        fila.fuera |= r.fueraDePista;
+    }
+    std::printf("\n");
+    return fila;
+}
+
+int main() {
+    probarLey();
+
+    const float adherencias[2] = { ParametrosRobot().aceleracionLateralMax, 4 };
+    bool perdidas = true, dentro = true, rapido = true;
+    for (uint8_t a = 0; a < 2; a++) {
+        ParametrosRobot robot;
+        robot.aceleracionLateralMax = adherencias[a];
+        std::printf("\nMejor vuelta y perdidas de linea con adherencia de %.0f m/s^2 (competencia, ovalo, esquinas)\n", adherencias[a]);
+        std::printf("%-10s %-11s %3s  %12s %12s %12s\n", "perfil", "modo", "vel", "competencia", "ovalo", "esquinas");
+        for (uint8_t p = 0; p < cantPerfiles; p++) {
+            Fila filas[3];
+            for (uint8_t modo = 0; modo < 3; modo++) filas[modo] = simular(p, modo, robot);
+
+            const Fila& gobernada = filas[2];
+            dentro &= !gobernada.fuera;
+            for (uint8_t k = 0; k < 3; k++) {
+                if (gobernada.perdidas[k] > filas[0].perdidas[k] || gobernada.perdidas[k] > filas[1].perdidas[k]) perdidas = false;
+                if (a == 0 && gobernada.mejor[k] >= filas[0].mejor[k]) rapido = false;
+            }
+        }
+    }
+    std::printf("(vel = velocidad constante, o la de curva con el gobernador; ! = salio de la pista)\n");
+    verificar(perdidas, "gobernador: no pierde la linea mas que a velocidad constante");
+    verificar(dentro, "gobernador: nunca sale de la pista");
+    verificar(rapido, "gobernador: mejor vuelta mas corta que con baseSpeed (8 m/s^2)");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
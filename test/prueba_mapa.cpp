@@ -0,0 +1,239 @@
+/**
+ @file prueba_mapa.cpp
+ @brief Prueba en host (entorno `native_mapa`) del mapa de la pista y la velocidad planificada (`-D MAPA_PISTA`).
+ @details Alimenta `registrarMapa()` con comandos de motor sintéticos, un segmento de curvatura conocida
+ cada `MAPA_PASO` de avance, y verifica:
+ - Codificación: lo decodificado queda a medio paso de lo grabado, con 4 bits por segmento.
+ - Cierre: una pista sintética de 30 segmentos cierra con largo 30 y el segmento actual correcto.
+ - Ubicación: una deriva de 2 segmentos se corrige en la curva siguiente; una de 12 deja el mapa
+   desubicado y la búsqueda en toda la vuelta lo vuelve a ubicar.
+ Después corre el simulador con cada perfil en las tres pistas, con el mapa y sin él, en la adherencia
+ nominal y en una pista resbalosa. En cada carrera el mapa cierra en media vuelta (±2 segmentos) y termina
+ ubicado; solo puede quedar sin cerrar si la línea se perdió en cada media vuelta (los segmentos de una
+ media vuelta no se repiten en la siguiente), nunca con un largo equivocado. Con la adherencia nominal
+ cierran todas. Los tiempos de vuelta solo se informan.
+ Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "pid.hpp"
+#include "mapa.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+// ============================
+// SEGMENTOS SINTETICOS
+// ============================
+/** @brief Velocidad media de los segmentos sintéticos: 128 ejecuciones de 1 ms cierran un segmento. */
+static const int32_t MEDIA = MAPA_PASO / 128;
+
+/** @brief Empieza una carrera sintética (el primer registro solo toma el instante). */
+static void largar() {
+    halHostReiniciar();
+    arrancarMapa();
+    registrarMapa(0, 0);
+}
+
+/** @brief Avanza un segmento con curvatura @p curvatura (múltiplo de 4: el diferencial es entero). */
+static void segmento(int8_t curvatura) {
+    // curvatura = 128 * (der - izq) / media = 256 * d / MEDIA
+    int32_t d = curvatura * MEDIA / 256;
+    for (uint8_t k = 0; k < 128; k++) {
+        halHostAvanzar(1000);
+        registrarMapa(MEDIA - d, MEDIA + d);
+    }
+}
+
+/** @brief Largo de la pista sintética. */
+static const uint16_t PERIODO = 30;
+
+/** @brief Curvatura de la pista sintética: recta, curva larga a un lado, recta, curva corta al otro. */
+static int8_t pistaSintetica(uint32_t i) {
+    static const int8_t forma[PERIODO] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        24, 48, 72, 72, 72, 48, 24, 0, 0, 0,
+        0, 0, -40, -80, -40, 0, 0, 0, 0, 0,
+    };
+    return forma[i % PERIODO];
+}
+
+/** @brief Lo decodificado sigue a lo grabado y el buffer ocupa lo anunciado. */
+static void probarCodificacion() {
+    reiniciarMapa();
+    largar();
+
+    // Un paseo al azar con pasos de hasta 24 entre segmentos (no se repite: no cierra la vuelta), y un
+    // salto a ±120 que no entra en 4 bits
+    const uint16_t cantidad = 100;
+    int8_t grabada[cantidad];
+    uint32_t semilla = 12345;
+    int32_t v = 0;
+    for (uint16_t i = 0; i < cantidad; i++) {
+        semilla = semilla * 1103515245u + 12345u;
+        v = constrain(v + (int32_t)((semilla >> 16) % 13) * 4 - 24, -120, 120);
+        grabada[i] = (int8_t)(i == 40 ? (v > 0 ? -120 : 120) : v);
+        segmento(grabada[i]);
+    }
+
+    uint8_t peor = 0, peorDespuesSalto = 0;
+    for (uint16_t i = 0; i < cantidad; i++) {
+        uint8_t e = (uint8_t)abs(curvaturaMapa(i) - grabada[i]);
+        if (i >= 40 && i < 48) { if (e > peorDespuesSalto) peorDespuesSalto = e; continue; }
+        if (e > peor) peor = e;
+    }
+    std::printf("%u segmentos: error maximo %u (medio paso = %d), despues del salto a +-120: %u\n",
+                estadoMapa().segmentos, peor, MAPA_PASO_DELTA / 2, peorDespuesSalto);
+    verificar(estadoMapa().segmentos == cantidad, "un segmento cada MAPA_PASO de avance");
+    verificar(peor <= MAPA_PASO_DELTA / 2, "decodificado a medio paso de lo grabado");
+    verificar(peorDespuesSalto > MAPA_PASO_DELTA / 2 && curvaturaMapa(48) == grabada[48],
+              "un salto fuera de rango se arrastra solo hasta la clave siguiente");
+
+    std::printf("mapa de %u segmentos: %u bytes (%u de claves, %u de diferencias)\n", MAPA_SEGMENTOS,
+                MAPA_SEGMENTOS / MAPA_CLAVE + MAPA_SEGMENTOS / 2, MAPA_SEGMENTOS / MAPA_CLAVE, MAPA_SEGMENTOS / 2);
+}
+
+/** @brief Cierre de la vuelta, seguimiento y corrección de la deriva. */
+static void probarUbicacion() {
+    reiniciarMapa();
+    largar();
+
+    // Aprendizaje: cierra en cuanto la ventana reciente vuelve a la primera curva
+    uint32_t real = 0;
+    while (estadoMapa().fase == MAPA_APRENDIENDO && real < 4 * PERIODO) segmento(pistaSintetica(real++));
+    const EstadoMapa& e = estadoMapa();
+    std::printf("cierre despues de %lu segmentos: largo %u, segmento actual %u (real %lu)\n",
+                (unsigned long)real, e.largo, e.indice, (unsigned long)(real % PERIODO));
+    verificar(e.fase == MAPA_LISTO && e.largo == PERIODO, "cierra la vuelta con el largo de la pista");
+    verificar(e.indice == real % PERIODO, "queda en el segmento real");
+
+    // Una vuelta más: sigue sin correcciones
+    bool sigue = true;
+    for (uint16_t k = 0; k < PERIODO; k++) {
+        segmento(pistaSintetica(real++));
+        if (e.indice != real % PERIODO) sigue = false;
+    }
+    verificar(sigue && e.correcciones == 0, "sigue la pista una vuelta sin correcciones");
+
+    // La odometría se queda 2 segmentos atrás (patinó): la curva siguiente lo corrige
+    real += 2;
+    for (uint16_t k = 0; k < PERIODO; k++) segmento(pistaSintetica(real++));
+    std::printf("deriva de 2 segmentos: segmento %u (real %lu), %u correcciones\n",
+                e.indice, (unsigned long)(real % PERIODO), e.correcciones);
+    verificar(e.fase == MAPA_LISTO && e.indice == real % PERIODO && e.correcciones > 0,
+              "deriva de 2 segmentos: se corrige comparando con el mapa");
+
+    // 12 segmentos de deriva: fuera de la búsqueda cercana, queda desubicado y se vuelve a encontrar
+    real += 12;
+    bool desubicado = false;
+    for (uint16_t k = 0; k < 2 * PERIODO; k++) {
+        segmento(pistaSintetica(real++));
+        if (e.fase == MAPA_DESUBICADO) desubicado = true;
+    }
+    std::printf("deriva de 12 segmentos: segmento %u (real %lu), fase %u\n",
+                e.indice, (unsigned long)(real % PERIODO), e.fase);
+    verificar(desubicado, "deriva de 12 segmentos: queda desubicado (sin plan)");
+    verificar(e.fase == MAPA_LISTO && e.indice == real % PERIODO, "se vuelve a ubicar buscando en toda la vuelta");
+
+    // La carrera siguiente arranca en el segmento 0 con el mapa aprendido
+    largar();
+    verificar(mapaListo() && estadoMapa().indice == 0 && estadoMapa().largo == PERIODO,
+              "la carrera siguiente usa el mapa desde la largada");
+}
+
+/** @brief Velocidad planificada: frena antes de la curva y vuelve a la de recta después. */
+static void probarPlan() {
+    aplicarPerfil(perfilesCorredor[0]);
+    reiniciarMapa();
+    largar();
+    uint32_t real = 0;
+    while (estadoMapa().fase == MAPA_APRENDIENDO) segmento(pistaSintetica(real++));
+    while (real % PERIODO != 0) segmento(pistaSintetica(real++));
+
+    uint8_t plan[PERIODO];
+    for (uint16_t k = 0; k < PERIODO; k++) {
+        plan[k] = velocidadMapa();
+        segmento(pistaSintetica(real++));
+    }
+    std::printf("plan:");
+    for (uint16_t k = 0; k < PERIODO; k++) std::printf(" %u", plan[k]);
+    std::printf("\n");
+    verificar(plan[0] == velocidadRecta && plan[19] == velocidadRecta, "recta lejos de las curvas: velocidadRecta");
+    verificar(plan[10 - MAPA_ANTICIPO] < velocidadRecta, "frena MAPA_ANTICIPO segmentos antes de la curva");
+    verificar(plan[12] == velocidadRecta - (velocidadRecta - velocidadCurva) * 72 / MAPA_CURVA_LLENA && plan[22] < plan[12],
+              "en la curva: mas despacio cuanto mas cerrada");
+}
+
+// ============================
+// SIMULADOR
+// ============================
+/** @brief Observador que olvida el mapa en cada tick: la carrera corre como sin `MAPA_PISTA`. */
+static void sinMapa(uint32_t, int, void*) {
+    reiniciarMapa();
+}
+
+/**
+ @brief Corre una carrera de 4 vueltas e informa cada vuelta.
+ @return ResultadoCarrera Resultado del simulador (el mapa queda como terminó la carrera).
+ */
+static ResultadoCarrera simular(uint8_t perfil, const Pista& pista, const ParametrosRobot& robot, bool conMapa) {
+    aplicarPerfil(perfilesCorredor[perfil]);
+    reiniciarMapa();
+    Simulador sim(pista, robot);
+    if (!conMapa) sim.observar(sinMapa, nullptr);
+    ResultadoCarrera r = sim.correr(4, 60);
+
+    std::printf("  %s", conMapa ? "mapa" : "    ");
+    for (uint8_t v = 0; v < 4; v++) {
+        if (v < r.vueltas) std::printf(" %6.3f", r.tiempoVuelta[v]);
+        else               std::printf("      -");
+    }
+    std::printf("%s", r.fueraDePista ? "!" : " ");
+    return r;
+}
+
+/** @brief Segmentos de media vuelta (las pistas son dos mitades iguales). */
+static float mediaVuelta(const Pista& pista) {
+    return pista.largo() / 2 / (MAPA_PASO * 1e-5f * ParametrosRobot().velocidadMax);
+}
+
+int main() {
+    probarCodificacion();
+    probarUbicacion();
+    probarPlan();
+
+    Pista pistas[3] = { Pista::competencia(), Pista::ovalo(), Pista::esquinas() };
+    const char* nombres[3] = { "competencia", "ovalo", "esquinas" };
+    const float adherencias[2] = { ParametrosRobot().aceleracionLateralMax, 4 };
+    bool ubicados = true, nominales = true;
+
+    for (float adherencia : adherencias) {
+        ParametrosRobot robot;
+        robot.aceleracionLateralMax = adherencia;
+        std::printf("\nVueltas 1 (aprendizaje) a 4 con adherencia de %.0f m/s^2, sin mapa y con mapa\n", adherencia);
+        for (uint8_t p = 0; p < cantPerfiles; p++) {
+            for (uint8_t k = 0; k < 3; k++) {
+                std::printf("%-10s %-11s", perfilesCorredor[p].nombre, nombres[k]);
+                simular(p, pistas[k], robot, false);
+                ResultadoCarrera r = simular(p, pistas[k], robot, true);
+                uint16_t largo = estadoMapa().largo;
+                std::printf("  largo %2u (media vuelta %.1f) %s\n", largo, mediaVuelta(pistas[k]),
+                            largo == 0 ? "sin cerrar" : mapaListo() ? "" : "sin ubicar");
+                // La odometría por comando sobreestima un poco el avance y una línea perdida la acorta:
+                // tolera 2 segmentos
+                bool cerrada = largo > 0 && fabsf(largo - mediaVuelta(pistas[k])) <= 2 && mapaListo();
+                bool perdidaCadaMedia = r.perdidasLinea >= 2 * r.vueltas;
+                if (!(cerrada || (largo == 0 && perdidaCadaMedia))) ubicados = false;
+                if (adherencia == adherencias[0] && !cerrada) nominales = false;
+            }
+        }
+    }
+    std::printf("(! = salio de la pista)\n");
+    verificar(ubicados, "simulador: cierra en media vuelta y termina ubicado (o no cierra)");
+    verificar(nominales, "simulador: con la adherencia nominal cierran todas");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/**
+ @file prueba_mezclador.cpp
+ @brief Prueba en host (entorno `native_mezclador`) del mezclador con prioridad de giro (`-D MEZCLADOR`).
+ @details Llama a `controlMotores()` con bases y correcciones sintéticas y verifica:
+ - Sin saturación las ruedas son base ± corrección, como con el recorte por rueda.
+ - Con la rueda exterior saturada la diferencia entre ruedas es 2·corrección: la base baja.
+ - Sin reversa (`pisoInterior` = 0) la rueda interior no baja de 0, y con un giro que no entra queda
+   exterior en `maxSpeed` e interior en el piso; `correccionAplicada()` devuelve lo que quedó.
+ Mide el costo de `controlMotores()` con el mezclador y con el recorte por rueda (`prioridadGiro` en false).
+ Después corre el simulador con cada perfil en `competencia`, `ovalo`, `esquinas` y dos horquillas, con el
+ recorte por rueda, con el mezclador y con el mezclador sin reversa, y mide el error a la salida de las
+ curvas: el rms y el máximo del desvío de la barra en los 30 cm que siguen a cada curva (radio < 1 m).
+ Verifica que el mezclador baja el error de salida en las horquillas; los tiempos de vuelta solo se
+ informan. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "motores.hpp"
+#include "gobernador.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+/** @brief Fija la velocidad base de `controlMotores()` (con `GOBERNADOR`, también la gobernada). */
+static void fijarBase(uint8_t base) {
+    baseSpeed = base;
+    gob(iniciarGobernador(base);)
+}
+
+/** @brief Ruedas de `controlMotores()` con la base del momento. */
+static void mezclar(float correcion, int32_t& izq, int32_t& der) {
+    SETPOINT = false;
+    controlMotores(correcion);
+    izq = motorSpeedIzq;
+    der = motorSpeedDer;
+}
+
+// ============================
+// MEZCLA
+// ============================
+/** @brief Diferencia conservada, base corrida, piso de la rueda interior. */
+static void probarMezcla() {
+    aplicarPerfil(perfilesCorredor[0]);
+    fijarBase(70);
+    prioridadGiro = true;
+    pisoInterior = -maxSpeed;
+    int32_t izq, der;
+
+    // Sin saturación: lo mismo que el recorte por rueda
+    bool iguales = true;
+    for (int32_t c = -20; c <= 20; c++) {
+        mezclar(c, izq, der);
+        if (izq != 70 - c || der != 70 + c) iguales = false;
+    }
+    verificar(iguales, "sin saturacion: base +- correccion");
+
+    // Exterior saturada: la base baja y la diferencia queda
+    mezclar(40, izq, der);
+    std::printf("base 70, correccion 40: izq %ld der %ld (recorte por rueda: 30 y 90)\n", (long)izq, (long)der);
+    verificar(der == maxSpeed && der - izq == 80, "exterior saturada: diferencia 2*correccion, base mas baja");
+    mezclar(-40, izq, der);
+    verificar(izq == maxSpeed && izq - der == 80, "tambien girando hacia el otro lado");
+    mezclar(70, izq, der);
+    verificar(der == maxSpeed && izq == maxSpeed - 140, "con reversa: la interior retrocede");
+    verificar(correccionAplicada(70) == 70, "correccionAplicada: la misma si el giro entra");
+
+    // Sin reversa
+    pisoInterior = 0;
+    mezclar(40, izq, der);
+    verificar(der == maxSpeed && izq == 10, "sin reversa: mismo giro si entra sobre 0");
+    mezclar(70, izq, der);
+    std::printf("sin reversa, correccion 70: izq %ld der %ld, aplicada %.1f\n", (long)izq, (long)der, correccionAplicada(70));
+    verificar(izq == 0 && der == maxSpeed && correccionAplicada(70) == maxSpeed / 2.0f,
+              "sin reversa: interior en 0 y exterior en maxSpeed");
+    fijarBase(10);
+    mezclar(30, izq, der);
+    verificar(izq == 0 && der == 60, "base baja: sube la base para no retroceder");
+
+    pisoInterior = -maxSpeed;
+    aplicarPerfil(perfilesCorredor[0]);
+}
+
+/** @brief Reloj monotónico usado para medir. */
+typedef std::chrono::steady_clock reloj;
+
+/** @brief Media y percentil 99 de `controlMotores()` (ns) con correcciones de -200 a 200. */
+static void medir(const char* nombre) {
+    static const uint32_t CANT = 200000;
+    std::vector<uint32_t> muestras(CANT);
+    for (uint32_t i = 0; i < CANT; i++) {
+        float correcion = (float)((int32_t)(i % 401) - 200);
+        SETPOINT = false;
+        reloj::time_point t0 = reloj::now();
+        controlMotores(correcion);
+        muestras[i] = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(reloj::now() - t0).count();
+    }
+    double suma = 0;
+    for (uint32_t m : muestras) suma += m;
+    std::sort(muestras.begin(), muestras.end());
+    std::printf("%-28s media=%8.1f ns  p99=%6u ns\n", nombre, suma / CANT, muestras[(size_t)(CANT * 0.99)]);
+}
+
+// ============================
+// SIMULADOR
+// ============================
+/** @brief Curvatura (1/m) desde la que un punto de la pista cuenta como curva. */
+static const float CURVATURA_CURVA = 1.0f;
+
+/** @brief Largo (m) después de cada curva en el que se mide el error de salida. */
+static const float LARGO_SALIDA = 0.30f;
+
+/** @brief Marca los puntos de la pista que están a menos de `LARGO_SALIDA` del final de una curva. */
+static std::vector<uint8_t> salidasDeCurva(const Pista& pista) {
+    const size_t n = pista.puntos.size();
+    const size_t w = 5;    // Rumbo sobre 1 cm de pista
+    std::vector<uint8_t> curva(n), salida(n, 0);
+    for (size_t i = 0; i < n; i++) {
+        const PuntoPista& a = pista.puntos[(i + n - w) % n];
+        const PuntoPista& b = pista.puntos[i];
+        const PuntoPista& c = pista.puntos[(i + w) % n];
+        float giro = atan2f(c.y - b.y, c.x - b.x) - atan2f(b.y - a.y, b.x - a.x);
+        giro = remainderf(giro, 2 * (float)M_PI);
+        curva[i] = std::fabs(giro) / (w * pista.paso) > CURVATURA_CURVA;
+    }
+    const size_t largo = (size_t)(LARGO_SALIDA / pista.paso);
+    for (size_t i = 0; i < n; i++) {
+        if (!curva[i] || curva[(i + 1) % n]) continue;
+        for (size_t j = 1; j <= largo; j++) salida[(i + j) % n] = 1;
+    }
+    return salida;
+}
+
+/** @brief Error de salida de curva acumulado en una carrera. */
+struct ErrorSalida {
+    const Simulador* sim;
+    const std::vector<uint8_t>* salida;
+    double suma = 0;        ///< Suma de los desvíos al cuadrado (mm²).
+    uint32_t ticks = 0;     ///< Ticks a la salida de una curva.
+    float maximo = 0;       ///< Máximo |desvío| (mm).
+};
+
+/** @brief Observador del simulador: acumula el desvío de la barra a la salida de las curvas. */
+static void medirSalida(uint32_t, int, void* contexto) {
+    ErrorSalida& e = *(ErrorSalida*)contexto;
+    if (!(*e.salida)[e.sim->puntoPista()]) return;
+    float desvio = e.sim->desvioBarra() * 1000;
+    e.suma += desvio * desvio;
+    e.ticks++;
+    e.maximo = fmaxf(e.maximo, std::fabs(desvio));
+}
+
+/**
+ @brief Corre 3 vueltas e informa la mejor vuelta y el error de salida de curva.
+ @return float Error rms a la salida de las curvas (mm).
+ */
+static float simular(uint8_t perfil, const Pista& pista, const std::vector<uint8_t>& salida) {
+    aplicarPerfil(perfilesCorredor[perfil]);
+    Simulador sim(pista);
+    ErrorSalida e;
+    e.sim = &sim;
+    e.salida = &salida;
+    sim.observar(medirSalida, &e);
+    ResultadoCarrera r = sim.correr(3, 60);
+    float mejor = 0;
+    for (uint8_t v = 0; v < r.vueltas; v++) {
+        if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+    }
+    float rms = e.ticks ? std::sqrt(e.suma / e.ticks) : 0;
+    std::printf("  %6.3f%s %4.1f/%4.1f", mejor, r.fueraDePista ? "!" : " ", rms, e.maximo);
+    return rms;
+}
+
+/** @brief Horquilla: recta y media vuelta de radio @p radio, dos veces. */
+static Pista horquilla(float radio) {
+    Pista p;
+    p.recta(1.2f);
+    p.curva(radio, 180);
+    p.espejarMitad();
+    return p;
+}
+
+int main() {
+    probarMezcla();
+
+    std::printf("\n");
+    prioridadGiro = false;
+    medir("recorte por rueda");
+    prioridadGiro = true;
+    medir("mezclador");
+
+    const uint8_t cantPistas = 5;
+    Pista pistas[cantPistas] = { Pista::competencia(), Pista::ovalo(), Pista::esquinas(), horquilla(0.06f), horquilla(0.10f) };
+    std::vector<uint8_t> salidas[cantPistas];
+    for (uint8_t k = 0; k < cantPistas; k++) salidas[k] = salidasDeCurva(pistas[k]);
+
+    static const char* modos[3] = { "recorte", "mezclador", "sin rev." };
+    std::printf("\nMejor vuelta y error rms/maximo (mm) a la salida de las curvas\n");
+    std::printf("%-10s %-9s %18s %18s %18s %18s %18s\n", "perfil", "motores", "competencia", "ovalo", "esquinas",
+                "horquilla 6", "horquilla 10");
+    bool menosError = true;
+    for (uint8_t p = 0; p < cantPerfiles; p++) {
+        float horquillas[3] = { 0, 0, 0 };
+        for (uint8_t modo = 0; modo < 3; modo++) {
+            prioridadGiro = (modo > 0);
+            pisoInterior = (modo == 2) ? 0 : -maxSpeed;
+            std::printf("%-10s %-9s", perfilesCorredor[p].nombre, modos[modo]);
+            for (uint8_t k = 0; k < cantPistas; k++) {
+                float rms = simular(p, pistas[k], salidas[k]);
+                if (k >= 3) horquillas[modo] += rms;
+            }
+            std::printf("\n");
+        }
+        if (horquillas[1] >= horquillas[0]) menosError = false;
+    }
+    prioridadGiro = true;
+    pisoInterior = -maxSpeed;
+    std::printf("(! = salio de la pista)\n");
+    verificar(menosError, "simulador: el mezclador baja el error de salida en horquillas");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
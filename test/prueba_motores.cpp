@@ -0,0 +1,100 @@
+/**
+ @file prueba_motores.cpp
+ @brief Prueba en host (entorno `native_motores`) de la capa de motores con estado.
+ @details Manda a `moverMotores()` una secuencia de velocidades con tramos constantes, cambios de
+ sentido y paradas. Después de cada tick verifica en el backend host que el enrutamiento de IN1/IN2,
+ sus niveles y el duty del canal sean los que corresponden a la velocidad pedida, y que las llamadas
+ contadas por los drivers (`llamadasHalMotores()`) coincidan con las que recibió la HAL
+ (`halHostContadores()`). Informa las llamadas por tick contra las 8 que hacía el driver sin estado
+ (desvincular, escribir LOW, vincular y escribir el duty en cada motor) y repite la medición durante
+ una carrera en el simulador. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "motores.hpp"
+#include "simulador.hpp"
+
+/** @brief Ticks de la secuencia sintética. */
+static const uint32_t CANT_TICKS = 20000;
+
+/** @brief Llamadas por tick del driver anterior: 4 por motor en cualquier sentido. */
+static const uint32_t LLAMADAS_SIN_ESTADO = 8;
+
+/**
+ @brief Velocidad de un motor en el tick `i`.
+ @details Cambia cada 4 ticks (como la salida entera del PID con la línea casi quieta), pasa por
+ reversa en las curvas y se detiene 20 ticks cada 1000.
+ */
+static int32_t velocidad(uint32_t i, float fase) {
+    if (i % 1000 < 20) return 0;
+    int32_t v = (int32_t)std::lround(40 + 70 * std::sin((i / 4) * 0.02f + fase));
+    return constrain(v, -maxSpeed, maxSpeed);
+}
+
+/**
+ @brief Verifica el estado de los pines y del canal de un motor.
+ @param in1 Pin IN1 del motor.
+ @param in2 Pin IN2 del motor.
+ @param canal Canal PWM del motor (0 = izquierdo, 1 = derecho, como en motores.cpp).
+ @param v Velocidad pedida.
+ @return bool true si coincide.
+ */
+static bool verificar(uint8_t in1, uint8_t in2, uint8_t canal, int32_t v) {
+    if (v == 0) {
+        return halHostCanalPin(in1) < 0 && halHostCanalPin(in2) < 0 &&
+               !halHostNivelPin(in1) && !halHostNivelPin(in2);
+    }
+
+    uint8_t activo = v > 0 ? in1 : in2;
+    uint8_t libre  = v > 0 ? in2 : in1;
+    uint32_t maxDuty = (1u << halHostResolucionCanal(canal)) - 1;
+
+    return halHostCanalPin(activo) == canal && halHostCanalPin(libre) < 0 && !halHostNivelPin(libre) &&
+           halHostDutyCanal(canal) == maxDuty * (uint32_t)std::abs(v) / 100;
+}
+
+/** @brief Suma de las llamadas a periféricos de salida registradas por la HAL host. */
+static uint32_t llamadasHal() {
+    const HalContadores& c = halHostContadores();
+    return c.escriturasDigitales + c.pwmAsociar + c.pwmDesasociar + c.pwmEscrituras;
+}
+
+int main() {
+    uint32_t errores = 0;
+
+    halHostReiniciar();
+    setupMotores();
+    uint32_t halInicio = llamadasHal() - llamadasHalMotores();   // setup() no se cuenta en el driver
+
+    for (uint32_t i = 0; i < CANT_TICKS; i++) {
+        int32_t izq = velocidad(i, 0.0f);
+        int32_t der = velocidad(i, 1.3f);
+        moverMotores(izq, der);
+
+        if (!verificar(motorPinIN1_Izq, motorPinIN2_Izq, 0, izq)) errores++;
+        if (!verificar(motorPinIN1_Der, motorPinIN2_Der, 1, der)) errores++;
+    }
+
+    uint32_t driver = llamadasHalMotores();
+    uint32_t hal = llamadasHal() - halInicio;
+    if (driver != hal) errores++;
+
+    const HalContadores& c = halHostContadores();
+    std::printf("Secuencia: %u ticks  estado incorrecto en %u\n", CANT_TICKS, errores);
+    std::printf("  llamadas driver=%u  HAL=%u  (asociar=%u desasociar=%u digitales=%u duty=%u)\n",
+                driver, hal, c.pwmAsociar, c.pwmDesasociar, c.escriturasDigitales, c.pwmEscrituras);
+    std::printf("  por tick: %.3f (sin estado: %u)\n", (double)driver / CANT_TICKS, LLAMADAS_SIN_ESTADO);
+
+    // Carrera completa: el firmware real maneja los motores desde la FSM
+    Pista pista = Pista::competencia();
+    Simulador sim(pista);
+    ResultadoCarrera r = sim.correr(3, 60);
+    std::printf("Simulador (competencia, 3 vueltas): %u ticks  %.3f llamadas por tick (sin estado: %u)\n",
+                r.ticks, (double)llamadasHalMotores() / r.ticks, LLAMADAS_SIN_ESTADO);
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
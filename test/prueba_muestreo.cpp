@@ -0,0 +1,62 @@
+/**
+ @file prueba_muestreo.cpp
+ @brief Programa de prueba (ESP32) que compara el tiempo de adquisición por cuadro de la barra QTR-8A.
+ @details Primero mide la lectura directa (32 `analogRead`, el camino de QTRSensors) y después arranca
+ el ADC1 en modo continuo por DMA y mide la lectura continua (S7/S8 por ADC2 y S1-S6 desde el DMA).
+ Informa por serial la duración media y máxima de cada cuadro y un cuadro de ejemplo de cada camino,
+ para verificar que ambos ven los mismos valores con la barra quieta.
+ @author Legion de Ohm
+ */
+
+#include "hal.hpp"
+#include "muestreo.hpp"
+
+/** @brief Cuadros medidos por camino. */
+const uint16_t CANT_CUADROS = 1000;
+
+/**
+ @brief Mide un camino de adquisición e imprime sus estadísticas.
+ @param nombre Etiqueta del camino.
+ @param leer Función que adquiere un cuadro.
+ */
+void medir(const char* nombre, void (*leer)(CuadroSensores&)) {
+  CuadroSensores cuadro;
+  uint32_t suma = 0, maximo = 0;
+
+  for (uint16_t i = 0; i < CANT_CUADROS; i++) {
+    leer(cuadro);
+    suma += cuadro.duracion_us;
+    if (cuadro.duracion_us > maximo) maximo = cuadro.duracion_us;
+  }
+
+  Serial.printf("%-10s media=%6.1f us  max=%5u us  cuadro:", nombre, (float)suma / CANT_CUADROS, maximo);
+  for (uint8_t i = 0; i < CANT_SENSORES; i++) Serial.printf(" %4u", cuadro.crudo[i]);
+  Serial.println();
+}
+
+/**
+ @brief Configura los pines de la barra.
+ */
+void setup() {
+  Serial.begin(115200);
+  iniciarMuestreo();
+  Serial.println("Adquisicion por cuadro (S8 ... S1)");
+}
+
+/**
+ @brief Mide la lectura directa y, una vez iniciado el DMA, la continua.
+ @details El ADC1 no puede usarse con analogRead una vez que el DMA lo tomó, por eso la lectura
+ directa se mide solo en la primera pasada.
+ */
+void loop() {
+  static bool continuo = false;
+
+  if (!continuo) {
+    medir("directa", leerCuadroDirecto);
+    continuo = iniciarMuestreoContinuo();
+    if (!continuo) Serial.println("No se pudo iniciar el ADC continuo");
+  }
+  if (continuo) medir("continua", leerCuadroContinuo);
+
+  delay(1000);
+}
@@ -0,0 +1,155 @@
+/**
+ @file prueba_normalizacion.cpp
+ @brief Prueba en host (entorno `native_normalizacion`) de la normalización con recíprocos precalculados.
+ @details Compara `normalizarCuadro()` con la división de `QTRSensors::readCalibrated()` (copiada abajo tal
+ como estaba en sensores.cpp):
+ - Todos los rangos de 12 bits (1 a 4095) con todas las lecturas crudas de 12 bits.
+ - Rangos de 16 bits al azar, rango 0, máximo menor al mínimo (rango que da la vuelta) y rangos de pocas
+   cuentas, donde el cociente original no entra en int16_t.
+ Como `leerLinea()` pondera exactamente esos valores, la posición de línea blanca y negra no cambia.
+ Después mide los ciclos por cuadro de ambas versiones (TSC en x86, nanosegundos en otras arquitecturas).
+ Devuelve 1 si algún valor difiere.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include "hal.hpp"
+#include "config.hpp"
+#include "sensores.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  /** @brief Contador de ciclos del procesador. */
+  static uint64_t ciclos() { return __rdtsc(); }
+  static const char* UNIDAD = "ciclos";
+#else
+  static uint64_t ciclos() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static const char* UNIDAD = "ns";
+#endif
+
+/** @brief Cuadros por medición de tiempo. */
+static const uint32_t CANT_CUADROS = 2000000;
+
+/** @brief Calibración de referencia cargada en `fijarCalibracion()`. */
+static CalibracionSensores cal;
+
+/** @brief Normalización anterior: resta y división entera por sensor en cada tick. */
+static void normalizarDivision(const uint16_t *crudo, uint16_t *valores) {
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        uint16_t denominador = cal.maximo[i] - cal.minimo[i];
+        int16_t valor = 0;
+
+        if (denominador != 0) valor = (((int32_t)crudo[i]) - cal.minimo[i]) * 1000 / denominador;
+
+        if      (valor < 0)    valor = 0;
+        else if (valor > 1000) valor = 1000;
+
+        valores[i] = valor;
+    }
+}
+
+/** @brief Estado del generador pseudoaleatorio (LCG). */
+static uint32_t semilla = 12345;
+
+/** @brief Entero uniforme en [0, n). */
+static uint32_t azar(uint32_t n) {
+    semilla = semilla * 1664525u + 1013904223u;
+    return (semilla >> 8) % n;
+}
+
+/** @brief Cuadros comparados y diferencias encontradas. */
+static uint64_t comparados = 0, distintos = 0;
+
+/** @brief Normaliza @p crudo con ambas versiones y cuenta los sensores que difieren. */
+static void comparar(const uint16_t *crudo) {
+    uint16_t a[CANT_SENSORES], b[CANT_SENSORES];
+    normalizarDivision(crudo, a);
+    normalizarCuadro(crudo, b);
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        if (a[i] != b[i] && distintos++ < 5) {
+            std::printf("  min=%u max=%u crudo=%u: division %u, reciproco %u\n",
+                        cal.minimo[i], cal.maximo[i], crudo[i], a[i], b[i]);
+        }
+    }
+    comparados++;
+}
+
+/** @brief Recorre todas las lecturas de 0 a @p tope con la calibración actual. */
+static void barrerCrudos(uint32_t tope) {
+    fijarCalibracion(cal);
+    uint16_t crudo[CANT_SENSORES];
+    for (uint32_t v = 0; v <= tope; v++) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) crudo[i] = (uint16_t)v;
+        comparar(crudo);
+    }
+}
+
+/**
+ @brief Mide el costo medio por cuadro de una normalización.
+ @param nombre Etiqueta de la versión.
+ @param normalizar Función a medir.
+ */
+static void medir(const char* nombre, void (*normalizar)(const uint16_t*, uint16_t*)) {
+    // Barrido de la línea sobre una calibración típica (fondo ~1000, línea ~3900)
+    static uint16_t cuadros[256][CANT_SENSORES];
+    semilla = 777;      // mismos cuadros para ambas versiones
+    for (uint32_t c = 0; c < 256; c++) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) cuadros[c][i] = (uint16_t)(900 + azar(3100));
+    }
+
+    uint16_t valores[CANT_SENSORES];
+    volatile uint16_t sumidero = 0;
+    uint64_t t0 = ciclos();
+    for (uint32_t k = 0; k < CANT_CUADROS; k++) {
+        normalizar(cuadros[k & 255], valores);
+        sumidero = valores[k & 7];
+    }
+    uint64_t t1 = ciclos();
+    (void)sumidero;
+
+    std::printf("%-24s %6.2f %s/cuadro\n", nombre, (double)(t1 - t0) / CANT_CUADROS, UNIDAD);
+}
+
+int main() {
+    // Todos los rangos de 12 bits, ocho por calibración, con mínimos distintos
+    for (uint32_t d = 1; d < 4096; d += CANT_SENSORES) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+            uint32_t rango = d + i < 4096 ? d + i : 4095;
+            cal.minimo[i] = (uint16_t)azar(4096 - rango);
+            cal.maximo[i] = (uint16_t)(cal.minimo[i] + rango);
+        }
+        barrerCrudos(4095);
+    }
+    std::printf("rangos de 12 bits:        %llu cuadros, %llu valores distintos\n",
+                (unsigned long long)comparados, (unsigned long long)distintos);
+
+    // Casos fuera de lo habitual: 16 bits, rango 0, rango que da la vuelta y rangos angostos
+    for (uint32_t n = 0; n < 400; n++) {
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+            switch (n % 4) {
+                case 0:  cal.minimo[i] = (uint16_t)azar(65536); cal.maximo[i] = (uint16_t)azar(65536); break;
+                case 1:  cal.minimo[i] = cal.maximo[i] = (uint16_t)azar(4096); break;
+                case 2:  cal.maximo[i] = (uint16_t)azar(1024); cal.minimo[i] = (uint16_t)(cal.maximo[i] + 1 + azar(3000)); break;
+                default: cal.minimo[i] = (uint16_t)azar(4000); cal.maximo[i] = (uint16_t)(cal.minimo[i] + 1 + azar(40)); break;
+            }
+        }
+        barrerCrudos(n % 4 == 0 ? 65535 : 4095);
+    }
+    std::printf("con casos degenerados:    %llu cuadros, %llu valores distintos\n",
+                (unsigned long long)comparados, (unsigned long long)distintos);
+
+    // Costo por cuadro con una calibración típica
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        cal.minimo[i] = 1023;
+        cal.maximo[i] = (uint16_t)(3890 + 3 * i);
+    }
+    fijarCalibracion(cal);
+    medir("division (readCalibrated)", normalizarDivision);
+    medir("normalizarCuadro()", normalizarCuadro);
+
+    std::printf("%s\n", distintos ? "FALLA" : "OK");
+    return distintos ? 1 : 0;
+}
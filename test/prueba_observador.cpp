@@ -0,0 +1,284 @@
+/**
+ @file prueba_observador.cpp
+ @brief Prueba en host (entorno `native_observador`) del observador alfa-beta de la línea (`-D OBSERVADOR`).
+ @details Alimenta `observarLinea()` con secuencias sintéticas y verifica:
+ - Rampa: la velocidad llega a la pendiente exacta y el residuo a 0.
+ - Ruido: la velocidad estimada tiene menos ruido que la diferencia finita entre ticks.
+ - Ticks con jitter y un cuadro perdido: con las marcas de tiempo reales la velocidad de una rampa no cambia
+   (la diferencia finita por tick sí), y `predecirLinea()` da la posición del cuadro que faltó.
+ - Mismo cuadro en dos ticks: se devuelve la posición predicha para el instante actual.
+ - Línea perdida: la estimación se invalida y arranca de nuevo con velocidad 0.
+ Después mide los ciclos por cuadro (TSC en x86, nanosegundos en otras arquitecturas) y corre el simulador
+ con Kd x1, x1.5 y x2, con las ganancias por defecto y con alfa = beta = 1 (la diferencia finita), promediando
+ la mejor vuelta en `CANT_SEMILLAS` semillas del ruido del ADC. En el simulador el observador no acorta las
+ vueltas (por eso `OBSERVADOR` está desactivado por defecto); se verifica que con Kd x1 la regresión de las
+ ganancias por defecto no pase de `REGRESION_MAX`. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "observador.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  /** @brief Contador de ciclos del procesador. */
+  static uint64_t ciclos() { return __rdtsc(); }
+  static const char* UNIDAD = "ciclos";
+#else
+  static uint64_t ciclos() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static const char* UNIDAD = "ns";
+#endif
+
+/** @brief Ticks de las secuencias con ruido. */
+static const uint32_t CANT_TICKS = 20000;
+
+/** @brief Cuadros por medición de tiempo. */
+static const uint32_t CANT_CUADROS = 2000000;
+
+/** @brief Semillas del ruido del ADC del simulador que se promedian en cada pista. */
+static const uint32_t CANT_SEMILLAS = 16;
+
+/** @brief Regresión máxima aceptada de la vuelta media con las ganancias por defecto (fracción). */
+static const float REGRESION_MAX = 0.01f;
+
+/** @brief Estado del generador pseudoaleatorio (LCG). */
+static uint32_t semilla = 12345;
+
+/** @brief Ruido uniforme en [-amplitud, amplitud]. */
+static int32_t ruido(int32_t amplitud) {
+    semilla = semilla * 1664525u + 1013904223u;
+    return (int32_t)(semilla >> 8) % (2 * amplitud + 1) - amplitud;
+}
+
+/** @brief Velocidad estimada en unidades de posición por tick. */
+static double velocidad() {
+    return estadoObservador().velocidad / (double)(1 << OBSERVADOR_Q);
+}
+
+/**
+ @brief Desvío estándar de la velocidad (observador y diferencia finita) con una rampa de 10 por tick y ruido.
+ @param amplitud Ruido uniforme de la posición.
+ */
+static void ruidoVelocidad(int32_t amplitud, double& observador, double& diferencia) {
+    reiniciarObservador();
+    semilla = 999;
+    double sumaObs = 0, sumaDif = 0;
+    int32_t anterior = 0;
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < CANT_TICKS; k++) {
+        // Rampa de ida y vuelta entre 1000 y 6000
+        int32_t fase = (int32_t)(k % 1000);
+        int32_t real = fase < 500 ? 1000 + 10 * fase : 6000 - 10 * (fase - 500);
+        double pendiente = fase < 500 ? 10 : -10;
+        int32_t medida = real + ruido(amplitud);
+        observarLinea((uint16_t)medida, k * TIEMPO_TIMER, true);
+
+        // Lejos de los vértices de la rampa, para medir solo el ruido
+        if (k > 0 && fase > 20 && fase != 500 && (fase < 480 || fase > 520)) {
+            double eObs = velocidad() - pendiente;
+            double eDif = (medida - anterior) - pendiente;
+            sumaObs += eObs * eObs;
+            sumaDif += eDif * eDif;
+            n++;
+        }
+        anterior = medida;
+    }
+    observador = std::sqrt(sumaObs / n);
+    diferencia = std::sqrt(sumaDif / n);
+}
+
+/** @brief Rampa sin ruido: la velocidad llega a la pendiente exacta. */
+static void probarRampa() {
+    reiniciarObservador();
+    for (uint32_t k = 0; k < 200; k++) observarLinea((uint16_t)(1000 + 20 * k), k * TIEMPO_TIMER, true);
+    const EstadoObservador& e = estadoObservador();
+    int32_t residuo = ((int32_t)(1000 + 20 * 199) << OBSERVADOR_Q) - e.posicion;
+    std::printf("rampa de 20/tick: velocidad %.3f, residuo %d (Q8)\n", velocidad(), residuo);
+    verificar(std::abs(e.velocidad - (20 << OBSERVADOR_Q)) <= 1 && std::abs(residuo) <= 1,
+              "rampa: velocidad exacta y residuo 0 en regimen");
+}
+
+/** @brief Ticks con jitter, un cuadro perdido y el mismo cuadro repetido, sobre una rampa en tiempo real. */
+static void probarTiempos() {
+    const double porUs = 20.0 / TIEMPO_TIMER;       // 20 por tick nominal
+    reiniciarObservador();
+    semilla = 4321;
+
+    // Rampa con marcas de tiempo reales (tick de ±25%); la posición entera deja un error de redondeo
+    uint32_t t = 0;
+    double peorObs = 0, peorDif = 0;
+    uint16_t anterior = 0;
+    for (uint32_t k = 0; k < 250; k++) {
+        t += TIEMPO_TIMER + ruido(TIEMPO_TIMER / 4);
+        uint16_t medida = (uint16_t)(500 + porUs * t + 0.5);
+        observarLinea(medida, t, true);
+        if (k > 100) {
+            peorObs = std::fmax(peorObs, std::fabs(velocidad() - 20));
+            peorDif = std::fmax(peorDif, std::fabs((medida - anterior) - 20.0));
+        }
+        anterior = medida;
+    }
+    std::printf("tick con jitter de +-25%%: error max de velocidad %.2f (diferencia finita %.2f)\n", peorObs, peorDif);
+    verificar(peorObs < 0.25 * peorDif, "jitter: velocidad por tiempo real, no por tick");
+
+    // Cuadro perdido: la predicción al instante del cuadro que faltó y la corrección dos ticks después
+    uint32_t faltante = t + TIEMPO_TIMER;
+    uint16_t predicha = predecirLinea(faltante);
+    uint16_t real = (uint16_t)(500 + porUs * faltante + 0.5);
+    t += 2 * TIEMPO_TIMER;
+    observarLinea((uint16_t)(500 + porUs * t + 0.5), t, true);
+    std::printf("cuadro perdido: predicha %u, real %u, velocidad despues %.2f\n", predicha, real, velocidad());
+    verificar(std::abs(predicha - real) <= 1 && std::fabs(velocidad() - 20) < 0.5,
+              "cuadro perdido: prediccion correcta y velocidad sin salto");
+
+    // Mismo cuadro con el reloj adelantado medio tick: devuelve la predicción para ahora
+    halHostReiniciar();
+    halHostAvanzar(t + TIEMPO_TIMER / 2);
+    uint16_t repetido = observarLinea((uint16_t)(500 + porUs * t + 0.5), t, true);
+    uint16_t esperado = (uint16_t)(500 + porUs * (t + TIEMPO_TIMER / 2) + 0.5);
+    std::printf("mismo cuadro medio tick despues: %u (esperado %u)\n", repetido, esperado);
+    verificar(std::abs(repetido - esperado) <= 1, "cuadro repetido: posicion predicha para el instante actual");
+}
+
+/** @brief Línea perdida y recuperada: arranca de nuevo sin arrastrar la velocidad. */
+static void probarPerdida() {
+    reiniciarObservador();
+    for (uint32_t k = 0; k < 50; k++) observarLinea((uint16_t)(3000 + 30 * k), k * TIEMPO_TIMER, true);
+    bool conVelocidad = velocidadLinea() != 0;
+
+    uint16_t devuelta = observarLinea(7000, 50 * TIEMPO_TIMER, false);
+    bool invalidada = !estadoObservador().valido && velocidadLinea() == 0 && devuelta == 7000;
+
+    observarLinea(1200, 60 * TIEMPO_TIMER, true);
+    bool arrancada = estadoObservador().valido && velocidadLinea() == 0 &&
+                     estadoObservador().posicion == (1200 << OBSERVADOR_Q);
+    verificar(conVelocidad && invalidada && arrancada, "linea perdida: invalida y arranca con velocidad 0");
+
+    // Hueco mayor al máximo: también arranca de nuevo
+    observarLinea(1300, 60 * TIEMPO_TIMER + 1000, true);
+    observarLinea(5000, 60 * TIEMPO_TIMER + 1000 + OBSERVADOR_HUECO_MAX_US + 1, true);
+    verificar(velocidadLinea() == 0 && estadoObservador().posicion == (5000 << OBSERVADOR_Q),
+              "hueco mayor a OBSERVADOR_HUECO_MAX_US: arranca de nuevo");
+}
+
+/** @brief Posiciones para medir tiempos. */
+static uint16_t posiciones[256];
+
+/** @brief Costo medio por cuadro del observador o de la diferencia finita. */
+static double costo(bool observador) {
+    volatile int32_t sumidero = 0;
+    int32_t anterior = 0;
+    reiniciarObservador();
+    uint64_t t0 = ciclos();
+    for (uint32_t k = 0; k < CANT_CUADROS; k++) {
+        uint16_t p = posiciones[k & 255];
+        if (observador) {
+            observarLinea(p, (k + 1) * TIEMPO_TIMER, true);
+            sumidero = velocidadLinea();
+        } else {
+            sumidero = ((int32_t)p - anterior) << OBSERVADOR_Q;
+            anterior = p;
+        }
+    }
+    uint64_t t1 = ciclos();
+    (void)sumidero;
+    return (double)(t1 - t0) / CANT_CUADROS;
+}
+
+/**
+ @brief Mide el observador contra la diferencia finita.
+ @details Alterna las mediciones e informa la mejor de cada uno, para descontar interrupciones del sistema operativo.
+ */
+static void medir() {
+    semilla = 777;
+    for (uint32_t i = 0; i < 256; i++) posiciones[i] = (uint16_t)(3500 + 2000 * std::sin(i * 0.05) + ruido(30));
+
+    double diferencia = 1e30, observador = 1e30;
+    for (uint8_t r = 0; r < 9; r++) {
+        diferencia = std::fmin(diferencia, costo(false));
+        observador = std::fmin(observador, costo(true));
+    }
+    std::printf("%-28s %6.2f %s/cuadro\n", "diferencia finita", diferencia, UNIDAD);
+    std::printf("%-28s %6.2f %s/cuadro\n", "observarLinea()", observador, UNIDAD);
+}
+
+/**
+ @brief Mejor vuelta media de NIGHTFALL en cada pista con Kd multiplicado y las ganancias del observador dadas.
+ @param medias Salida: vuelta media por multiplicador de Kd (filas) y pista (columnas).
+ */
+static void simular(const char* nombre, float alfa, float beta, double medias[3][3]) {
+    Pista pistas[3] = { Pista::competencia(), Pista::ovalo(), Pista::esquinas() };
+    const float multiplicadores[3] = {1, 1.5f, 2};
+    for (uint8_t i = 0; i < 3; i++) {
+        std::printf("%-22s Kd x%.1f", nombre, multiplicadores[i]);
+        for (uint8_t k = 0; k < 3; k++) {
+            double suma = 0;
+            bool fuera = false;
+            for (uint32_t s = 1; s <= CANT_SEMILLAS; s++) {
+                aplicarPerfil(perfilesCorredor[0]);
+                Kd *= multiplicadores[i];
+                plegarGanancias();
+                fijarGananciasObservador(alfa, beta);
+
+                ParametrosRobot robot;
+                robot.semilla = s;
+                Simulador sim(pistas[k], robot);
+                ResultadoCarrera r = sim.correr(3, 60);
+                float mejor = 0;
+                for (uint8_t v = 0; v < r.vueltas; v++) {
+                    if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+                }
+                suma += mejor;
+                fuera |= r.fueraDePista;
+            }
+            medias[i][k] = suma / CANT_SEMILLAS;
+            std::printf("  %7.3f%s", medias[i][k], fuera ? "!" : " ");
+        }
+        std::printf("\n");
+    }
+}
+
+int main() {
+    std::printf("Observador alfa-beta (alfa=%.2f, beta=%.2f, TIEMPO_TIMER=%d us)\n",
+                (double)OBSERVADOR_ALFA, (double)OBSERVADOR_BETA, (int)TIEMPO_TIMER);
+
+    probarRampa();
+
+    double obs, dif;
+    ruidoVelocidad(150, obs, dif);
+    std::printf("ruido de posicion +-150: desvio de velocidad %.2f/tick (diferencia finita %.2f)\n", obs, dif);
+    verificar(obs < 0.8 * dif, "ruido: velocidad con menos ruido que la diferencia finita");
+
+    probarTiempos();
+    probarPerdida();
+
+    medir();
+
+    std::printf("\nMejor vuelta media de NIGHTFALL en %u semillas (competencia, ovalo, esquinas; ! = salio de la pista)\n",
+                (unsigned)CANT_SEMILLAS);
+    double diferencia[3][3], defecto[3][3];
+    simular("alfa=beta=1 (dif.)", 1, 1, diferencia);
+    simular("por defecto", OBSERVADOR_ALFA, OBSERVADOR_BETA, defecto);
+
+    // Sin ventaja en el simulador: solo se acota la regresión documentada
+    const char* nombres[3] = {"competencia", "ovalo", "esquinas"};
+    bool acotada = true;
+    for (uint8_t k = 0; k < 3; k++) {
+        std::printf("regresion con Kd x1 en %-12s %+.2f%%\n", nombres[k], 100 * (defecto[0][k] / diferencia[0][k] - 1));
+        if (defecto[0][k] > (1 + REGRESION_MAX) * diferencia[0][k]) acotada = false;
+    }
+    verificar(acotada, "simulador: por defecto hasta 1% mas lento que la diferencia");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
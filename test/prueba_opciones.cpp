@@ -0,0 +1,377 @@
+/**
+ @file prueba_opciones.cpp
+ @brief Prueba en host (entorno `native_opciones`) de las opciones del PID (`-D PID_OPCIONES`).
+ @details Alimenta `calculo_pid()` y `calculo_pid_fijo()` con posiciones sintéticas y verifica:
+ - Integración condicional: con los motores saturados hacia el lado del error la integral no crece, y
+   vuelve a integrar cuando el error cambia de lado.
+ - Retrocálculo: cada tick saturado descuenta de Ki·integral la fracción ΔT/Tt de lo recortado, en
+   flotante y en punto fijo.
+ - Tope: Ki·integral no pasa `topeIntegral`, en flotante y en punto fijo.
+ - Derivada sobre la medición: un cambio de setpoint no patea y el primer tick después de reiniciar no
+   tiene derivada.
+ - `correccionAplicada()` devuelve la misma corrección sin saturación y la mitad de la diferencia con ella.
+ - Zona muerta: `estadoControl()` con la línea centrada no aplica la corrección y el retrocálculo no la
+   cuenta como recortada, así que Ki·integral no cambia.
+ Después corre el simulador con cada perfil en dos horquillas cerradas y en `esquinas`, sin opciones y con
+ las del perfil, y mide el sobrepaso: el desvío máximo hacia el otro lado en los 150 ms después de volver
+ al centro desde un desvío grande. Verifica que las opciones bajan el sobrepaso medio en las horquillas; los
+ tiempos de vuelta y `esquinas` (dominada por las pérdidas de línea) solo se informan. Devuelve 1 si alguna
+ verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "sensores.hpp"
+#include "pid.hpp"
+#include "motores.hpp"
+#include "fsm.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+/** @brief El perfil con otras opciones del PID. */
+static PerfilCorredor conOpciones(const PerfilCorredor& perfil, AntiWindup antiWindup, float tope, bool medicion) {
+    PerfilCorredor p = perfil;
+    p.antiWindup = antiWindup;
+    p.topeIntegral = tope;
+    p.derivadaMedicion = medicion;
+    return p;
+}
+
+/** @brief Término integral: con la línea centrada dos veces seguidas la salida es solo Ki·integral. */
+static float terminoIntegral() {
+    calculo_pid(setpoint, FIXED_DT_S);
+    return calculo_pid(setpoint, FIXED_DT_S);
+}
+
+/** @brief Lo mismo con `calculo_pid_fijo()`, en unidades de velocidad. */
+static float terminoIntegralFijo() {
+    calculo_pid_fijo(setpoint);
+    return calculo_pid_fijo(setpoint) * (1.0f / PID_UNO);
+}
+
+// ============================
+// ANTI-WINDUP
+// ============================
+/** @brief La integral se frena mientras los motores recortan hacia el lado del error. */
+static void probarCondicional() {
+    aplicarPerfil(conOpciones(perfilesCorredor[0], INTEGRACION_CONDICIONAL, 0, false));
+    reiniciar_pid();
+
+    // Un tick libre y 100 saturados (los motores recortan 5% de lo pedido)
+    float pedida = calculo_pid(setpoint + 800, FIXED_DT_S);
+    saturacionPid(pedida, pedida - 5);
+    for (uint8_t k = 0; k < 100; k++) {
+        pedida = calculo_pid(setpoint + 800, FIXED_DT_S);
+        saturacionPid(pedida, pedida - 5);
+    }
+    float integralUnTick = Ki * 800 * FIXED_DT_S;
+    saturacionPid(0, 0);
+    float frenada = terminoIntegral();
+    std::printf("condicional: Ki*integral %.4f despues de 101 ticks saturados (un tick: %.4f)\n", frenada, integralUnTick);
+    verificar(std::fabs(frenada - integralUnTick) < 1e-5f, "condicional: saturado hacia el lado del error no integra");
+
+    // El error cambia de lado con los motores todavía recortando hacia el mismo: integra (descarga)
+    saturacionPid(10, 5);
+    calculo_pid(setpoint - 800, FIXED_DT_S);
+    saturacionPid(0, 0);
+    float descargada = terminoIntegral();
+    verificar(std::fabs(descargada) < 1e-5f, "condicional: con el error del otro lado vuelve a integrar");
+
+    // Punto fijo: lo mismo
+    reiniciar_pid();
+    for (uint8_t k = 0; k < 101; k++) {
+        int32_t pedidaQ = calculo_pid_fijo(setpoint + 800);
+        saturacionPid(pedidaQ * (1.0f / PID_UNO), pedidaQ * (1.0f / PID_UNO) - 5);
+    }
+    saturacionPid(0, 0);
+    float frenadaQ = terminoIntegralFijo();
+    verificar(std::fabs(frenadaQ - integralUnTick) < PID_TOLERANCIA, "condicional: tambien en punto fijo");
+    reiniciar_pid();
+}
+
+/** @brief Un tick saturado descuenta ΔT/Tt de lo recortado. */
+static void probarRetrocalculo() {
+    const PerfilCorredor& perfil = perfilesCorredor[0];
+    aplicarPerfil(conOpciones(perfil, RETROCALCULO, 0, false));
+    const float recorte = 10;
+    const float esperado = fminf(1, FIXED_DT_S * 4 / perfil.Tu) * recorte;
+
+    reiniciar_pid();
+    for (uint8_t k = 0; k < 200; k++) calculo_pid(setpoint + 800, FIXED_DT_S);
+    float antes = terminoIntegral();
+    saturacionPid(antes + recorte, antes);
+    float despues = terminoIntegral();
+    std::printf("retrocalculo: Ki*integral %.4f -> %.4f con %.0f%% recortado (esperado -%.4f)\n",
+                antes, despues, recorte, esperado);
+    verificar(std::fabs((antes - despues) - esperado) < 1e-4f, "retrocalculo: descuenta dt/Tt de lo recortado");
+
+    reiniciar_pid();
+    for (uint8_t k = 0; k < 200; k++) calculo_pid_fijo(setpoint + 800);
+    float antesQ = terminoIntegralFijo();
+    saturacionPid(antesQ + recorte, antesQ);
+    float despuesQ = terminoIntegralFijo();
+    verificar(std::fabs((antesQ - despuesQ) - esperado) < Ki * FIXED_DT_S + 1e-4f,
+              "retrocalculo: tambien en punto fijo (a un tick de error)");
+
+    // Sin recorte no toca nada
+    saturacionPid(despuesQ, despuesQ);
+    verificar(terminoIntegralFijo() == despuesQ, "retrocalculo: sin recorte la integral no cambia");
+    reiniciar_pid();
+}
+
+/** @brief Ki·integral queda en el tope. */
+static void probarTope() {
+    const float tope = 5;
+    aplicarPerfil(conOpciones(perfilesCorredor[0], SIN_ANTIWINDUP, tope, false));
+
+    reiniciar_pid();
+    for (uint16_t k = 0; k < 1000; k++) calculo_pid(setpoint + 800, FIXED_DT_S);
+    float arriba = terminoIntegral();
+    for (uint16_t k = 0; k < 2000; k++) calculo_pid(setpoint - 800, FIXED_DT_S);
+    float abajo = terminoIntegral();
+    std::printf("tope %.0f%%: Ki*integral %.4f y %.4f (sin tope seria %.4f)\n", tope, arriba, abajo,
+                Ki * 800 * 1000 * FIXED_DT_S);
+    verificar(std::fabs(arriba - tope) < 1e-4f && std::fabs(abajo + tope) < 1e-4f, "tope: Ki*integral no pasa topeIntegral");
+
+    reiniciar_pid();
+    for (uint16_t k = 0; k < 1000; k++) calculo_pid_fijo(setpoint + 800);
+    float arribaQ = terminoIntegralFijo();
+    verificar(std::fabs(arribaQ - tope) < PID_TOLERANCIA, "tope: tambien en punto fijo");
+    reiniciar_pid();
+}
+
+// ============================
+// DERIVADA SOBRE LA MEDICION
+// ============================
+/** @brief Corrección del tick en que el setpoint salta 500 con la línea quieta. */
+static float saltoSetpoint(bool fijo) {
+    const uint16_t original = setpoint;
+    const uint16_t pos = setpoint + 300;
+    reiniciar_pid();
+    if (fijo) calculo_pid_fijo(pos);
+    else      calculo_pid(pos, FIXED_DT_S);
+    setpoint = original + 500;
+    float salida = fijo ? calculo_pid_fijo(pos) * (1.0f / PID_UNO) : calculo_pid(pos, FIXED_DT_S);
+    setpoint = original;
+    return salida;
+}
+
+/** @brief Sin patada al cambiar el setpoint, y sin derivada en el primer tick. */
+static void probarDerivada() {
+    const PerfilCorredor& perfil = perfilesCorredor[0];
+    // Con OBSERVADOR la derivada ya es la velocidad de la línea observada (esta prueba no alimenta el observador)
+#ifndef OBSERVADOR
+    aplicarPerfil(conOpciones(perfil, SIN_ANTIWINDUP, 0, false));
+    float error = saltoSetpoint(false);
+    aplicarPerfil(conOpciones(perfil, SIN_ANTIWINDUP, 0, true));
+    float medicion = saltoSetpoint(false);
+    float medicionQ = saltoSetpoint(true);
+
+    // Sin patada queda solo -200·Kp más la integral de dos ticks
+    float sinPatada = -200 * Kp + Ki * (300 - 200) * FIXED_DT_S;
+    std::printf("setpoint +500: sobre el error %.3f, sobre la medicion %.3f (punto fijo %.3f), sin patada %.3f\n",
+                error, medicion, medicionQ, sinPatada);
+    verificar(std::fabs(medicion - sinPatada) < 1e-4f && std::fabs(error - sinPatada) > 10,
+              "medicion: cambiar el setpoint no patea");
+    verificar(std::fabs(medicionQ - medicion) < PID_TOLERANCIA, "medicion: tambien en punto fijo");
+#else
+    aplicarPerfil(conOpciones(perfil, SIN_ANTIWINDUP, 0, true));
+#endif
+
+    // Primer tick: solo P e I aunque la posición venga de lejos
+    reiniciar_pid();
+    float primero = calculo_pid(setpoint + 2000, FIXED_DT_S);
+    verificar(std::fabs(primero - (2000 * Kp + Ki * 2000 * FIXED_DT_S)) < 1e-4f,
+              "medicion: sin derivada en el primer tick despues de reiniciar");
+    reiniciar_pid();
+}
+
+/** @brief La corrección aplicada por los motores. */
+static void probarAplicada() {
+    aplicarPerfil(perfilesCorredor[0]);
+    const float base = velocidadBase();
+    bool exacta = true;
+    for (float c = -(maxSpeed - base); c <= maxSpeed - base; c += 0.37f) {
+        if (correccionAplicada(c) != c) exacta = false;
+    }
+    verificar(exacta, "sin saturacion: la misma correccion");
+
+    // base + (maxSpeed - base + 20) recorta 20 en el motor derecho (y el izquierdo en -maxSpeed si la base es
+    // baja): la mitad de la diferencia
+    const float pedida = maxSpeed - base + 20;
+    const float esperada = (maxSpeed - fmaxf(base - pedida, -maxSpeed)) / 2;
+    std::printf("base %.0f, correccion %.0f: aplicada %.2f (esperada %.2f)\n", base, pedida, correccionAplicada(pedida), esperada);
+    verificar(std::fabs(correccionAplicada(pedida) - esperada) < 1e-5f && std::fabs(correccionAplicada(-pedida) + esperada) < 1e-5f,
+              "con saturacion: la mitad de la diferencia entre motores");
+}
+
+// ============================
+// ZONA MUERTA
+// ============================
+/** @brief Pines de la barra en el mismo orden que usa sensores.cpp (índice 0 = S8). */
+static const uint8_t pinesBarra[8] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Posición de la línea en unidades de sensor (3.5 = centro de la barra). */
+static double lineaFija = 3.5;
+
+/** @brief Línea blanca (~300) sobre fondo negro (~3800) en `lineaFija`, como la de `prueba_perdida.cpp`. */
+static uint16_t fuenteLinea(uint8_t pin) {
+    for (uint8_t i = 0; i < 8; i++) {
+        if (pinesBarra[i] != pin) continue;
+        double d = (i - lineaFija) / 0.8;
+        return (uint16_t)(3800.0 - 3500.0 * std::exp(-d * d));
+    }
+    return 0;
+}
+
+/** @brief En la zona muerta no se aplica la corrección: el retrocálculo no la descuenta como recortada. */
+static void probarZonaMuerta() {
+    halHostReiniciar();
+    halHostFuenteAnalogica(fuenteLinea);
+    setupMotores();
+    CalibracionSensores cal;
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        cal.minimo[i] = 300;
+        cal.maximo[i] = 3800;
+    }
+    fijarCalibracion(cal);
+    aplicarPerfil(conOpciones(perfilesCorredor[0], RETROCALCULO, 0, false));
+    reiniciar_pid();
+
+    // Carga la integral con la línea a la derecha, fuera de la zona muerta
+    lineaFija = 5.0;
+    for (uint8_t k = 0; k < 100; k++) {
+        halHostAvanzar(TIEMPO_TIMER);
+        estadoControl();
+    }
+    bool fuera = !SETPOINT;
+
+    // Línea centrada: ticks en la zona muerta con la corrección que pide la integral
+    lineaFija = 3.5;
+    halHostAvanzar(TIEMPO_TIMER);
+    estadoControl();
+    float antes = terminoIntegral();
+    bool adentro = true;
+    for (uint8_t k = 0; k < 50; k++) {
+        halHostAvanzar(TIEMPO_TIMER);
+        estadoControl();
+        if (!SETPOINT) adentro = false;
+    }
+    float despues = terminoIntegral();
+    std::printf("zona muerta: Ki*integral %.4f -> %.4f en 50 ticks (posicion %u, setpoint %u)\n",
+                antes, despues, position, setpoint);
+    verificar(fuera && adentro && antes > 1, "zona muerta: la integral cargada y la linea adentro");
+    verificar(std::fabs(despues - antes) < 1e-4f, "zona muerta: la integral no cambia (nada recortado)");
+
+    halHostFuenteAnalogica(nullptr);
+    reiniciar_pid();
+}
+
+// ============================
+// SIMULADOR
+// ============================
+/** @brief Desvío (mm) desde el que una salida del centro cuenta para medir el sobrepaso. */
+static const float DESVIO_GRANDE = 6;
+
+/** @brief Ventana (us) después de cruzar el centro en la que se busca el sobrepaso. */
+static const uint32_t VENTANA_SOBREPASO = 150000;
+
+/** @brief Sobrepasos medidos en una carrera. */
+struct Sobrepaso {
+    Simulador* sim;
+    int8_t lado = 0;            ///< Lado del último desvío grande (0 = ninguno).
+    bool midiendo = false;      ///< Dentro de la ventana después de cruzar el centro.
+    uint32_t inicio = 0;        ///< Instante del cruce.
+    float pico = 0;             ///< Sobrepaso de la ventana en curso (mm).
+    float suma = 0;             ///< Suma de los sobrepasos (mm).
+    uint16_t cantidad = 0;      ///< Ventanas medidas.
+};
+
+/** @brief Observador del simulador: desvío grande, cruce del centro y máximo hacia el otro lado. */
+static void medirSobrepaso(uint32_t, int, void* contexto) {
+    Sobrepaso& s = *(Sobrepaso*)contexto;
+    float desvio = s.sim->desvioBarra() * 1000;
+    uint32_t ahora = halMicros();
+    if (s.midiendo) {
+        s.pico = fmaxf(s.pico, -desvio * s.lado);
+        if (ahora - s.inicio < VENTANA_SOBREPASO) return;
+        s.midiendo = false;
+        s.suma += s.pico;
+        s.cantidad++;
+        s.lado = 0;
+    }
+    if (std::fabs(desvio) > DESVIO_GRANDE) {
+        s.lado = (desvio > 0) ? 1 : -1;
+    } else if (s.lado && desvio * s.lado < 0) {
+        s.midiendo = true;
+        s.inicio = ahora;
+        s.pico = 0;
+    }
+}
+
+/**
+ @brief Corre 3 vueltas e informa la mejor vuelta y el sobrepaso medio.
+ @return float Sobrepaso medio (mm).
+ */
+static float simular(const PerfilCorredor& perfil, const Pista& pista) {
+    aplicarPerfil(perfil);
+    Simulador sim(pista);
+    Sobrepaso s;
+    s.sim = &sim;
+    sim.observar(medirSobrepaso, &s);
+    ResultadoCarrera r = sim.correr(3, 60);
+    float mejor = 0;
+    for (uint8_t v = 0; v < r.vueltas; v++) {
+        if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+    }
+    float medio = s.cantidad ? s.suma / s.cantidad : 0;
+    std::printf("  %6.3f%s %5.1f", mejor, r.fueraDePista ? "!" : " ", medio);
+    return medio;
+}
+
+/** @brief Horquilla: recta y media vuelta de radio @p radio, dos veces. */
+static Pista horquilla(float radio) {
+    Pista p;
+    p.recta(1.2f);
+    p.curva(radio, 180);
+    p.espejarMitad();
+    return p;
+}
+
+int main() {
+#ifdef MEZCLADOR
+    // Las opciones se miden contra el recorte por rueda, el que satura seguido
+    prioridadGiro = false;
+#endif
+    probarCondicional();
+    probarRetrocalculo();
+    probarTope();
+    probarDerivada();
+    probarAplicada();
+    probarZonaMuerta();
+
+    Pista pistas[3] = { horquilla(0.06f), horquilla(0.10f), Pista::esquinas() };
+    std::printf("\nMejor vuelta y sobrepaso medio (mm) en horquillas de 6 y 10 cm y en esquinas\n");
+    std::printf("%-10s %-9s %14s %14s %14s\n", "perfil", "opciones", "horquilla 6", "horquilla 10", "esquinas");
+    bool menosSobrepaso = true;
+    for (uint8_t p = 0; p < cantPerfiles; p++) {
+        const PerfilCorredor& perfil = perfilesCorredor[p];
+        float sobrepaso[2] = { 0, 0 };
+        for (uint8_t conOpc = 0; conOpc < 2; conOpc++) {
+            std::printf("%-10s %-9s", perfil.nombre, conOpc ? "perfil" : "ninguna");
+            PerfilCorredor usado = conOpc ? perfil : conOpciones(perfil, SIN_ANTIWINDUP, 0, false);
+            for (uint8_t k = 0; k < 2; k++) sobrepaso[conOpc] += simular(usado, pistas[k]);
+            simular(usado, pistas[2]);
+            std::printf("\n");
+        }
+        if (sobrepaso[1] >= sobrepaso[0]) menosSobrepaso = false;
+    }
+    std::printf("(! = salio de la pista)\n");
+    verificar(menosSobrepaso, "simulador: las opciones del perfil bajan el sobrepaso en horquillas");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+/**
+ @file prueba_perdida.cpp
+ @brief Prueba en host (entorno `native_perdida`) del estado PERDIDO de la FSM.
+ @details Corre el `loop()` real sobre el reloj virtual con una fuente analógica sintética que ubica la
+ línea bajo la barra o la saca por completo:
+ - Perdida desde CONTROL (línea a la derecha) y desde ACEL (por la izquierda): la FSM pasa a PERDIDO y
+   gira hacia el último lado visto con `busquedaExterior`/`busquedaInterior`.
+ - PERDIDO se ejecuta cada `PERIODO_PERDIDO_US` y vuelve a CONTROL o a ACEL en cuanto la línea reaparece.
+ - La integral queda congelada: el primer CONTROL tras recuperar la línea da los mismos motores que una
+   carrera igual en la que la línea nunca se perdió, tras la misma cantidad de llamadas al PID.
+ - STOP con la línea perdida detiene el robot.
+ Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "sensores.hpp"
+#include "adquisicion.hpp"
+#include "motores.hpp"
+#include "pid.hpp"
+#include "fsm.hpp"
+#include "planificador.hpp"
+#include "verificar.hpp"
+
+/** @brief Pines de la barra en el mismo orden que usa sensores.cpp (índice 0 = S8). */
+static const uint8_t pinesBarra[8] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Durante la calibración la línea barre la barra de lado a lado. */
+static bool barrer = true;
+
+/** @brief Posición de la línea en unidades de sensor fuera de la calibración (lejos de 0-7 = perdida). */
+static double lineaFija = 3.5;
+
+/** @brief Línea fuera de la barra. */
+static const double SIN_LINEA = 30.0;
+
+/** @brief Línea blanca (~300) sobre fondo negro (~3800), como la de `prueba_planificador.cpp`. */
+static uint16_t fuente(uint8_t pin) {
+    double linea = barrer ? 3.5 + 4.5 * std::sin(2.0 * M_PI * halMicros() * 1e-6 / 0.5) : lineaFija;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (pinesBarra[i] != pin) continue;
+        double d = (i - linea) / 0.8;
+        return (uint16_t)(3800.0 - 3500.0 * std::exp(-d * d));
+    }
+    return 0;
+}
+
+/** @brief Límites para cambiar de estado: la lectura que lo dispara, la transición y una muestra atrasada. */
+static const uint32_t LIMITE_CONTROL_US = 3 * TIEMPO_TIMER;
+static const uint32_t LIMITE_ACEL_US = 3 * PERIODO_ACEL_US;
+static const uint32_t LIMITE_PERDIDO_US = 4 * PERIODO_PERDIDO_US;
+
+/** @brief Ejecuta el loop() hasta llegar a @p estado o agotar @p limite_us. */
+static bool esperarEstado(int estado, uint32_t limite_us) {
+    uint32_t t0 = halMicros();
+    while (estadoFSM() != estado && halMicros() - t0 < limite_us) ejecutarPlanificador();
+    return estadoFSM() == estado;
+}
+
+/** @brief Ejecuta el loop() durante @p us microsegundos. */
+static void correrDurante(uint32_t us) {
+    uint32_t t0 = halMicros();
+    while (halMicros() - t0 < us) ejecutarPlanificador();
+}
+
+/** @brief Ejecuta el loop() hasta que CONTROL acumule @p n ejecuciones más. */
+static void correrControles(uint32_t n) {
+    uint32_t objetivo = estadisticasTarea(C).ejecuciones + n;
+    while (estadisticasTarea(C).ejecuciones < objetivo) ejecutarPlanificador();
+}
+
+/** @brief RUN con la línea centrada y después desplazada a la derecha hasta entrar en CONTROL. */
+static void arrancarEnControl() {
+    lineaFija = 3.5;
+    halHostDispararPin(BTN_RUN);
+    correrDurante(20000);
+    lineaFija = 5.0;
+    esperarEstado(C, 100000);
+}
+
+/** @brief STOP y espera la parada. */
+static void parar() {
+    halHostDispararPin(BTN_STOP);
+    esperarEstado(S, 100000);
+}
+
+int main() {
+    halHostReiniciar();
+    halHostFuenteAnalogica(fuente);
+
+    // setup()
+    setupMotores();
+    setupInterrupciones();
+    setupSensores();
+    barrer = false;
+    iniciarAdquisicion();
+    iniciarPlanificador();
+
+    // Carrera de referencia: CONTROL con la línea a la derecha, sin perderla; motores tras cada ejecución
+    const uint32_t REFERENCIAS = 40;
+    int32_t refIzq[REFERENCIAS], refDer[REFERENCIAS];
+    arrancarEnControl();
+    for (uint32_t k = 1; k < REFERENCIAS; k++) {
+        correrControles(1);
+        refIzq[k] = motorSpeedIzq;
+        refDer[k] = motorSpeedDer;
+    }
+    parar();
+
+    // Misma carrera, pero la línea desaparece después de 20 CONTROL. Con DOBLE_NUCLEO la muestra llega
+    // tarde (en host el productor corre una vez por espera): los límites dejan margen para eso.
+    arrancarEnControl();
+    uint32_t base = estadisticasTarea(C).ejecuciones;
+    correrControles(20);
+    lineaFija = SIN_LINEA;
+    verificar(esperarEstado(P, LIMITE_CONTROL_US), "CONTROL -> PERDIDO");
+    verificar(motorSpeedIzq == busquedaInterior && motorSpeedDer == busquedaExterior, "gira hacia la derecha (ultimo lado visto)");
+    // El último CONTROL vio la línea perdida y no llamó al PID
+    uint32_t controles = estadisticasTarea(C).ejecuciones - base;
+
+    uint32_t antes = estadisticasTarea(P).ejecuciones;
+    correrDurante(50000);
+    uint32_t ejecuciones = estadisticasTarea(P).ejecuciones - antes;
+    std::printf("  PERDIDO: %u ejecuciones en 50 ms\n", ejecuciones);
+    verificar(estadoFSM() == P && ejecuciones == 50000 / PERIODO_PERDIDO_US, "PERDIDO cada PERIODO_PERDIDO_US");
+
+    lineaFija = 5.0;
+    verificar(esperarEstado(C, LIMITE_PERDIDO_US), "linea recuperada: PERDIDO -> CONTROL");
+    // Mismas llamadas al PID que la referencia tras `controles` ejecuciones
+    std::printf("  primer CONTROL: izq=%d der=%d (referencia izq=%d der=%d)\n", motorSpeedIzq, motorSpeedDer,
+                refIzq[controles], refDer[controles]);
+    verificar(motorSpeedIzq == refIzq[controles] && motorSpeedDer == refDer[controles],
+              "integral congelada mientras estuvo perdida");
+    parar();
+
+    // Perdida desde ACEL (línea apenas a la izquierda, dentro de la zona muerta), recuperada en el setpoint
+    lineaFija = 3.49;
+    halHostDispararPin(BTN_RUN);
+    correrDurante(20000);
+    bool enAcel = estadoFSM() == A && position < setpoint;
+    // La línea sale por la izquierda de a poco: un salto directo mezclaría en un cuadro de ADC_CONTINUO
+    // conversiones con y sin línea y podría ubicarla a la derecha
+    for (lineaFija = 3.3; lineaFija > -1.5; lineaFija -= 0.3) ejecutarPlanificador();
+    lineaFija = -SIN_LINEA;
+    bool perdida = esperarEstado(P, LIMITE_CONTROL_US);
+    verificar(enAcel && perdida && motorSpeedIzq == busquedaExterior && motorSpeedDer == busquedaInterior,
+              "perdida por la izquierda desde ACEL: gira a la izquierda");
+    // Un primer cuadro mezclado puede caer fuera de la zona muerta: PERDIDO -> CONTROL -> ACEL
+    lineaFija = 3.5;
+    verificar(esperarEstado(A, LIMITE_PERDIDO_US + LIMITE_CONTROL_US), "linea recuperada en el setpoint: vuelve a ACEL");
+
+    // STOP sin línea
+    lineaFija = SIN_LINEA;
+    esperarEstado(P, LIMITE_ACEL_US);
+    halHostDispararPin(BTN_STOP);
+    bool parado = esperarEstado(S, LIMITE_PERDIDO_US);
+    bool detenidos = halHostCanalPin(motorPinIN1_Izq) < 0 && halHostCanalPin(motorPinIN2_Izq) < 0 &&
+                     halHostCanalPin(motorPinIN1_Der) < 0 && halHostCanalPin(motorPinIN2_Der) < 0;
+    verificar(parado && detenidos, "STOP con la linea perdida detiene los motores");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+/**
+ @file prueba_pid_fijo.cpp
+ @brief Prueba en host (entorno `native_pid_fijo`) del PID en punto fijo contra el PID en flotante.
+ @details Para cada perfil de `perfilesCorredor` y para el perfil compilado alimenta `calculo_pid()` y
+ `calculo_pid_fijo()` con las mismas secuencias de posición (barrido senoidal con ruido, escalones y
+ línea quieta fuera del centro, que hace crecer la integral) y verifica que la diferencia nunca supere
+ `PID_TOLERANCIA`. Informa también cuántos ticks cambiarían el comando entero de los motores. Después mide
+ los ciclos por llamada de ambas versiones (TSC en x86, nanosegundos en otras arquitecturas).
+ Compilar con `-D TIEMPO_TIMER_US=...` para verificar un tick más corto. Devuelve 1 si se excede la tolerancia.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  /** @brief Contador de ciclos del procesador. */
+  static uint64_t ciclos() { return __rdtsc(); }
+  static const char* UNIDAD = "ciclos";
+#else
+  static uint64_t ciclos() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static const char* UNIDAD = "ns";
+#endif
+
+/** @brief Ticks de cada secuencia (2 minutos con el tick de 6 ms). */
+static const uint32_t CANT_TICKS = 20000;
+
+/** @brief Llamadas por medición de tiempo. */
+static const uint32_t CANT_LLAMADAS = 2000000;
+
+/** @brief Estado del generador pseudoaleatorio (LCG) para el ruido de posición. */
+static uint32_t semilla = 12345;
+
+/** @brief Ruido uniforme en [-amplitud, amplitud]. */
+static int32_t ruido(int32_t amplitud) {
+    semilla = semilla * 1664525u + 1013904223u;
+    return (int32_t)(semilla >> 8) % (2 * amplitud + 1) - amplitud;
+}
+
+/**
+ @brief Posición de la secuencia `s` en el tick `i`.
+ @param s 0 = barrido senoidal con ruido, 1 = escalones entre extremos, 2 = línea quieta a 300 del centro.
+ @details La tercera secuencia carga la integral sin llegar a saturar la salida Q16 (±32767) con ninguna
+ ganancia de la tabla ni del sintonizador.
+ */
+static uint16_t posicion(uint8_t s, uint32_t i) {
+    int32_t p;
+    switch (s) {
+        case 0:  p = 3500 + (int32_t)(3400 * std::sin(i * 0.004)) + ruido(150); break;
+        case 1:  p = ((i / 250) % 3) * 3500; break;
+        default: p = 3800 + ruido(20); break;
+    }
+    return (uint16_t)constrain(p, 0, 7000);
+}
+
+/**
+ @brief Corre las tres secuencias con las ganancias cargadas y compara ambas versiones.
+ @param nombre Etiqueta del perfil.
+ @return bool true si la diferencia máxima está dentro de `PID_TOLERANCIA`.
+ */
+static bool comparar(const char* nombre) {
+    float maxDif = 0;
+    uint32_t comandosDistintos = 0;
+
+    for (uint8_t s = 0; s < 3; s++) {
+        reiniciar_pid();
+        for (uint32_t i = 0; i < CANT_TICKS; i++) {
+            uint16_t pos = posicion(s, i);
+            float flotante = calculo_pid(pos, FIXED_DT_S);
+            float fijo = calculo_pid_fijo(pos) * (1.0f / PID_UNO);
+
+            float dif = std::fabs(fijo - flotante);
+            if (dif > maxDif) maxDif = dif;
+            if ((int32_t)(baseSpeed - flotante) != (int32_t)(baseSpeed - fijo)) comandosDistintos++;
+        }
+    }
+
+    bool ok = maxDif <= PID_TOLERANCIA;
+    std::printf("%-12s Kp=%.5f Ki=%.5f Kd=%.6f  dif. max=%.5f  comandos distintos=%5.3f%%  %s\n",
+                nombre, Kp, Ki, Kd, maxDif, 100.0 * comandosDistintos / (3 * CANT_TICKS), ok ? "OK" : "FALLA");
+    return ok;
+}
+
+/**
+ @brief Mide el costo medio por llamada de un cálculo del PID.
+ @param nombre Etiqueta de la versión.
+ @param fijo true = `calculo_pid_fijo()`, false = `calculo_pid()`.
+ */
+static void medir(const char* nombre, bool fijo) {
+    volatile float sumidero = 0;
+    reiniciar_pid();
+
+    uint64_t t0 = ciclos();
+    for (uint32_t i = 0; i < CANT_LLAMADAS; i++) {
+        uint16_t pos = (uint16_t)((i * 37) % 7001);
+        if (fijo) sumidero = calculo_pid_fijo(pos);
+        else      sumidero = calculo_pid(pos, FIXED_DT_S);
+    }
+    uint64_t t1 = ciclos();
+    (void)sumidero;
+
+    std::printf("%-20s %6.2f %s/llamada\n", nombre, (double)(t1 - t0) / CANT_LLAMADAS, UNIDAD);
+}
+
+int main() {
+    std::printf("PID en punto fijo (TIEMPO_TIMER=%d us, tolerancia=%.3f)\n", (int)TIEMPO_TIMER, PID_TOLERANCIA);
+
+    // Perfil compilado: ganancias plegadas en compilación
+    bool ok = comparar("compilado");
+
+    for (uint8_t p = 0; p < cantPerfiles; p++) {
+        aplicarPerfil(perfilesCorredor[p]);
+        ok = comparar(perfilesCorredor[p].nombre) && ok;
+    }
+
+    medir("calculo_pid()", false);
+    medir("calculo_pid_fijo()", true);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+/**
+ @file prueba_planificador.cpp
+ @brief Prueba en host (entorno `native_planificador`) del planificador cooperativo de la FSM.
+ @details Corre el `loop()` real (`ejecutarPlanificador()`) sobre el reloj virtual, con una fuente
+ analógica sintética que ubica la línea bajo la barra:
+ - Línea centrada tras el RUN: la FSM queda en ACEL y la rampa debe subir 1% cada `PERIODO_ACEL_US`
+   hasta `maxSpeed`.
+ - Línea desplazada: CONTROL debe ejecutarse exactamente una vez cada `TIEMPO_TIMER`, sin vencimientos perdidos.
+ - Botón STOP: la FSM pasa a STOP y se ejecuta cada `PERIODO_STOP_US`.
+ En host la ejecución no consume reloj virtual, así que el tiempo ocioso debe ser el total.
+ Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "sensores.hpp"
+#include "adquisicion.hpp"
+#include "motores.hpp"
+#include "fsm.hpp"
+#include "planificador.hpp"
+#include "verificar.hpp"
+
+/** @brief Pines de la barra en el mismo orden que usa sensores.cpp (índice 0 = S8). */
+static const uint8_t pinesBarra[8] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Durante la calibración la línea barre la barra de lado a lado. */
+static bool barrer = true;
+
+/** @brief Posición fija de la línea, en unidades de sensor, fuera de la calibración. */
+static double lineaFija = 3.5;
+
+/** @brief Línea blanca (~300) sobre fondo negro (~3800), como la fuente del benchmark. */
+static uint16_t fuente(uint8_t pin) {
+    double linea = barrer ? 3.5 + 4.5 * std::sin(2.0 * M_PI * halMicros() * 1e-6 / 0.5) : lineaFija;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (pinesBarra[i] != pin) continue;
+        double d = (i - linea) / 0.8;
+        return (uint16_t)(3800.0 - 3500.0 * std::exp(-d * d));
+    }
+    return 0;
+}
+
+int main() {
+    halHostReiniciar();
+    halHostFuenteAnalogica(fuente);
+
+    // setup()
+    setupMotores();
+    setupInterrupciones();
+    setupSensores();
+    barrer = false;
+    iniciarAdquisicion();
+    iniciarPlanificador();
+
+    // Rampa de ACEL con la línea centrada
+    halHostDispararPin(BTN_RUN);
+    uint32_t dutyMax = 255 * maxSpeed / 100;
+    uint32_t t0 = halMicros();
+    ejecutarPlanificador();
+    uint32_t inicioRampa = halMicros();
+    while (halHostDutyCanal(0) < dutyMax && halMicros() - t0 < 1000000) ejecutarPlanificador();
+    uint32_t rampa = halMicros() - inicioRampa;
+
+    std::printf("Rampa ACEL: %u us\n", rampa);
+    verificar(estadoFSM() == A, "la linea centrada mantiene ACEL");
+    // La primera ejecución deja 51% y la última maxSpeed: maxSpeed - 51 periodos entre ambas
+    verificar(rampa == (uint32_t)(maxSpeed - 51) * PERIODO_ACEL_US, "1% por PERIODO_ACEL_US");
+
+    // CONTROL con la línea desplazada durante 1 s
+    lineaFija = 1.0;
+    while (estadoFSM() != C) ejecutarPlanificador();
+    uint32_t antes = estadisticasTarea(C).ejecuciones;
+    uint32_t t1 = halMicros();
+    while (halMicros() - t1 < 1000000) ejecutarPlanificador();
+    uint32_t ticks = estadisticasTarea(C).ejecuciones - antes;
+
+    std::printf("CONTROL: %u ejecuciones en 1 s\n", ticks);
+    verificar(estadoFSM() == C, "la linea desplazada mantiene CONTROL");
+    verificar(ticks == 1000000 / TIEMPO_TIMER || ticks == 1000000 / TIEMPO_TIMER + 1, "una ejecucion por TIEMPO_TIMER");
+    verificar(estadisticasTarea(C).perdidas == 0, "sin vencimientos perdidos");
+
+    // STOP
+    halHostDispararPin(BTN_STOP);
+    while (estadoFSM() != S) ejecutarPlanificador();
+    uint32_t parada = estadisticasTarea(S).ejecuciones;
+    uint32_t t2 = halMicros();
+    while (halMicros() - t2 < 100000) ejecutarPlanificador();
+
+    verificar(estadisticasTarea(S).ejecuciones - parada == 100000 / PERIODO_STOP_US, "STOP cada PERIODO_STOP_US");
+    verificar(halHostCanalPin(motorPinIN1_Izq) < 0 && halHostCanalPin(motorPinIN1_Der) < 0, "motores detenidos");
+    verificar(tiempoOcioso() == halMicros() - t0, "CPU ociosa entre liberaciones");
+
+    imprimirPlanificador();
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+/**
+ @file prueba_posicion.cpp
+ @brief Prueba en host (entorno `native_posicion`) del estimador de posición por parábola (`-D POSICION_PICO`).
+ @details Genera cuadros normalizados sintéticos con el mismo modelo de barra del simulador (línea de 19 mm,
+ sensores cada 9.525 mm, área vista con dispersión gaussiana), con y sin ruido, para la línea en toda la barra,
+ y compara `estimarPosicion()` con el promedio ponderado de QTRSensors (copiado abajo):
+ - Error RMS y máximo contra la posición real, en toda la barra y en el primer y último sensor.
+ - La línea perdida se detecta en los mismos cuadros (mismo umbral de 200).
+ - Confianza alta con una línea limpia, baja con dos líneas bajo la barra (cruce) y 0 sin línea.
+ Sin `POSICION_PICO` verifica que `estimarPosicion()` sea exactamente el promedio ponderado.
+ Después mide los ciclos por cuadro de ambos (TSC en x86, nanosegundos en otras arquitecturas).
+ Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "sensores.hpp"
+#include "verificar.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  /** @brief Contador de ciclos del procesador. */
+  static uint64_t ciclos() { return __rdtsc(); }
+  static const char* UNIDAD = "ciclos";
+#else
+  static uint64_t ciclos() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static const char* UNIDAD = "ns";
+#endif
+
+/** @brief Cuadros por medición de tiempo. */
+static const uint32_t CANT_CUADROS = 2000000;
+
+/** @brief Estado del generador pseudoaleatorio (LCG). */
+static uint32_t semilla = 12345;
+
+/** @brief Ruido uniforme en [-amplitud, amplitud]. */
+static int32_t ruido(int32_t amplitud) {
+    semilla = semilla * 1664525u + 1013904223u;
+    return (int32_t)(semilla >> 8) % (2 * amplitud + 1) - amplitud;
+}
+
+/** @brief Fracción de un sensor sobre una línea a @p distancia sensores (modelo de `simulador.cpp`). */
+static double cubierto(double distancia) {
+    const double paso = 9.525, medio = 19.0 / 2, k = 1.0 / (std::sqrt(2.0) * 3.0);
+    double d = std::fabs(distancia * paso);
+    return 0.5 * (std::erf((medio - d) * k) + std::erf((medio + d) * k));
+}
+
+/**
+ @brief Cuadro normalizado de línea negra (sin invertir) con la línea en @p linea sensores.
+ @param segunda Posición de una segunda línea (cruce), o un valor fuera de la barra si no hay.
+ */
+static void cuadro(double linea, double segunda, int32_t amplitudRuido, uint16_t *valores) {
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        double c = cubierto(i - linea) + cubierto(i - segunda);
+        int32_t v = (int32_t)(1000 * c) + (amplitudRuido ? ruido(amplitudRuido) : 0);
+        valores[i] = (uint16_t)constrain(v, 0, 1000);
+    }
+}
+
+/** @brief Lado de la última posición vista por el promedio de referencia. */
+static uint16_t ultimaReferencia = 0;
+
+/** @brief Promedio ponderado de `readLineBlack/readLineWhite()` de QTRSensors, como estaba en sensores.cpp. */
+static __attribute__((noinline)) uint16_t promedioPonderado(const uint16_t *valores, bool invertir) {
+    bool enLinea = false;
+    uint32_t promedio = 0;
+    uint16_t suma = 0;
+    for (uint8_t i = 0; i < CANT_SENSORES; i++) {
+        uint16_t valor = valores[i];
+        if (invertir) valor = 1000 - valor;
+        if (valor > 200) enLinea = true;
+        if (valor > 50) {
+            promedio += (uint32_t)valor * (i * 1000);
+            suma += valor;
+        }
+    }
+    if (!enLinea) return ultimaReferencia < 3500 ? 0 : 7000;
+    ultimaReferencia = promedio / suma;
+    return ultimaReferencia;
+}
+
+/** @brief Errores acumulados de un estimador. */
+struct Error {
+    double cuadrados = 0, bordes = 0, maximo = 0;
+    uint32_t n = 0, nBordes = 0;
+    double rms() const { return std::sqrt(cuadrados / n); }
+    double rmsBordes() const { return std::sqrt(bordes / nBordes); }
+    void sumar(double linea, double estimada) {
+        double e = estimada - linea * 1000;
+        cuadrados += e * e;
+        n++;
+        if (linea < 1 || linea > 6) { bordes += e * e; nBordes++; }
+        if (std::fabs(e) > maximo) maximo = std::fabs(e);
+    }
+};
+
+/** @brief Cuadros de línea blanca (la de competencia por defecto) para medir tiempos. */
+static uint16_t cuadrosMedicion[256][CANT_SENSORES];
+
+/** @brief Costo medio por cuadro de un estimador sobre `cuadrosMedicion`. */
+static double costo(bool referencia) {
+    volatile uint16_t sumidero = 0;
+    uint64_t t0 = ciclos();
+    for (uint32_t k = 0; k < CANT_CUADROS; k++) {
+        const uint16_t* c = cuadrosMedicion[k & 255];
+        sumidero = referencia ? promedioPonderado(c, true) : estimarPosicion(c, true);
+    }
+    uint64_t t1 = ciclos();
+    (void)sumidero;
+    return (double)(t1 - t0) / CANT_CUADROS;
+}
+
+/**
+ @brief Mide ambos estimadores con línea blanca.
+ @details Alterna las mediciones e informa la mejor de cada uno, para descontar interrupciones del sistema operativo.
+ */
+static void medir() {
+    semilla = 777;
+    for (uint32_t c = 0; c < 256; c++) {
+        cuadro(c * 7.0 / 255, 99, 15, cuadrosMedicion[c]);
+        for (uint8_t i = 0; i < CANT_SENSORES; i++) cuadrosMedicion[c][i] = 1000 - cuadrosMedicion[c][i];
+    }
+
+    double referencia = 1e30, estimador = 1e30;
+    for (uint8_t r = 0; r < 9; r++) {
+        referencia = std::fmin(referencia, costo(true));
+        estimador = std::fmin(estimador, costo(false));
+    }
+    std::printf("%-28s %6.2f %s/cuadro\n", "promedio ponderado", referencia, UNIDAD);
+    std::printf("%-28s %6.2f %s/cuadro\n", "estimarPosicion()", estimador, UNIDAD);
+}
+
+int main() {
+    reiniciarSensores();
+
+    const int32_t amplitudes[2] = {0, 15};
+    for (int32_t amplitud : amplitudes) {
+        Error ref, est, fina;
+        bool iguales = true, mismaPerdida = true, enRango = true;
+
+        // Línea de -0.5 a 7.5 sensores: incluye cuadros sin línea a ambos lados
+        for (int32_t k = -500; k <= 7500; k++) {
+            double linea = k / 1000.0;
+            uint16_t v[CANT_SENSORES];
+            cuadro(linea, 99, amplitud, v);
+
+            uint16_t r = promedioPonderado(v, false);
+            bool refVista = false;
+            for (uint8_t i = 0; i < CANT_SENSORES; i++) refVista = refVista || v[i] > 200;
+            uint16_t p = estimarPosicion(v, false);
+
+            iguales = iguales && p == r;
+            mismaPerdida = mismaPerdida && lineaDetectada() == refVista;
+            enRango = enRango && p <= 7000;
+            if (!refVista || linea < 0 || linea > 7) continue;
+            ref.sumar(linea, r);
+            est.sumar(linea, p);
+            fina.sumar(linea, estimacionLinea().posicionFina / 16.0);
+        }
+
+        std::printf("ruido +-%d: RMS promedio ponderado %.1f (bordes %.1f, max %.0f), estimador %.1f (bordes %.1f, max %.0f), fina %.1f\n",
+                    amplitud, ref.rms(), ref.rmsBordes(), ref.maximo, est.rms(), est.rmsBordes(), est.maximo, fina.rms());
+        verificar(mismaPerdida, "linea perdida en los mismos cuadros que el promedio");
+        verificar(enRango, "posicion entre 0 y 7000");
+#ifdef POSICION_PICO
+        verificar(est.rms() < 0.7 * ref.rms() && est.rmsBordes() < 0.7 * ref.rmsBordes() && est.maximo < ref.maximo,
+                  "parabola: menos error que el promedio, tambien en los bordes");
+        verificar(fina.rms() <= est.rms(), "posicion fina sin error de redondeo extra");
+#else
+        verificar(iguales, "sin POSICION_PICO: igual al promedio ponderado");
+#endif
+    }
+
+    // Confianza: línea limpia, cruce (dos líneas) y sin línea
+    uint16_t v[CANT_SENSORES];
+    cuadro(3.3, 99, 0, v);
+    estimarPosicion(v, false);
+    uint16_t limpia = estimacionLinea().confianza;
+    cuadro(1.5, 5.5, 0, v);
+    estimarPosicion(v, false);
+    uint16_t cruce = estimacionLinea().confianza;
+    cuadro(30, 99, 0, v);
+    estimarPosicion(v, false);
+    uint16_t sinLinea = estimacionLinea().confianza;
+    std::printf("confianza: linea limpia %u, cruce %u, sin linea %u\n", limpia, cruce, sinLinea);
+#ifdef POSICION_PICO
+    verificar(limpia > 800 && cruce < 300 && sinLinea == 0, "confianza: alta, baja con un cruce, 0 sin linea");
+#else
+    verificar(limpia == 1000 && sinLinea == 0, "confianza: 1000 con linea, 0 sin linea");
+#endif
+
+    medir();
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+/**
+ @file prueba_simulador.cpp
+ @brief Programa de prueba en host que corre el firmware real en el simulador de pista.
+ @details Para cada perfil de corredor (NIGHTFALL, ARGENTUM, DIEGO) y cada pista simula varias
+ vueltas y muestra el tiempo de vuelta, el RMS de `position - setpoint`, la fracción de ticks de
+ control con algún motor saturado y las pérdidas de línea. Al final informa cuántas veces más
+ rápido que el tiempo real corrió la simulación.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include "simulador.hpp"
+#include "config.hpp"
+#include "pid.hpp"
+
+/** @brief Vueltas simuladas por carrera. */
+static const uint8_t VUELTAS = 3;
+
+/** @brief Tiempo simulado máximo por carrera [s]. */
+static const float TIEMPO_MAX = 60;
+
+int main() {
+    Pista pistas[3] = { Pista::competencia(), Pista::ovalo(), Pista::esquinas() };
+    const char* nombres[3] = { "competencia", "ovalo", "esquinas" };
+    double simulado = 0;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    std::printf("%-10s %-12s %7s %8s %8s %8s %7s %6s\n",
+                "perfil", "pista", "vueltas", "vuelta1", "mejor", "rms", "sat%", "perd");
+
+    for (uint8_t p = 0; p < cantPerfiles; p++) {
+        for (uint8_t k = 0; k < 3; k++) {
+            aplicarPerfil(perfilesCorredor[p]);
+
+            Simulador sim(pistas[k]);
+            ResultadoCarrera r = sim.correr(VUELTAS, TIEMPO_MAX);
+            simulado += r.tiempoSimulado;
+
+            float mejor = 0;
+            for (uint8_t v = 0; v < r.vueltas; v++) {
+                if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+            }
+
+            std::printf("%-10s %-12s %5u%s %8.3f %8.3f %8.1f %7.1f %6u\n",
+                        perfilesCorredor[p].nombre, nombres[k], r.vueltas, r.fueraDePista ? "!" : " ",
+                        r.vueltas ? r.tiempoVuelta[0] : 0.0f, mejor,
+                        r.rmsError, 100 * r.saturacion, r.perdidasLinea);
+        }
+    }
+
+    double real = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("\nSimulados %.1f s en %.3f s de reloj (%.0fx tiempo real)\n", simulado, real, simulado / real);
+    std::printf("(!) = carrera abortada por salir de la pista\n");
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ @file prueba_sintonia.cpp
+ @brief Prueba en host (entorno `native_sintonia`) de la sintonía por relé (`-D SINTONIA_RELE`).
+ @details Llama a `releSintonia()` con la salida de una planta sintética, tres polos iguales
+ @f$ K / (\tau s + 1)^3 @f$ con @f$ K_u = 8/K @f$ y @f$ T_u = 2\pi\tau/\sqrt{3} @f$ exactos, y verifica:
+ - Con histéresis chica el ciclo límite da Ku y Tu a menos de 10% de los exactos (la función descriptiva
+   es una aproximación) y las ganancias son las de Ziegler-Nichols de ese par.
+ - Con la histéresis por defecto el Ku sale menor y el Tu mayor que los exactos.
+ - Ruido por debajo de la histéresis no cambia el ciclo ni hace conmutar el relé.
+ - Sin oscilación la sintonía falla a los `SINTONIA_TIEMPO_MAX_US`.
+ Después corre el simulador con cada perfil con la sintonía pedida en la largada. Verifica que 'U' sin
+ `SINTONIA_APLICAR` solo identifica, que la que solo informa termina en STOP con las ganancias del perfil, y
+ que la que aplica (`pedirSintonia(true)`, lo que hace 'U' con la bandera) sigue la carrera con las medidas y
+ completa las vueltas en `competencia` y `ovalo`. Los tiempos de vuelta con las ganancias medidas se informan
+ contra los del perfil: salen más lentos, por eso aplicarlas no es el defecto. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "interrupciones.hpp"
+#include "pid.hpp"
+#include "fsm.hpp"
+#include "sintonia.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+/** @brief Diferencia relativa. */
+static float relativa(float a, float b) {
+    return std::fabs(a - b) / std::fabs(b);
+}
+
+// ============================
+// PLANTA SINTETICA
+// ============================
+/** @brief Ganancia de la planta: unidades de posición por % de corrección. */
+static const float K_PLANTA = 150;
+
+/** @brief Constante de tiempo de cada polo (s). */
+static const float TAU_PLANTA = 0.05f;
+
+/** @brief Paso de integración (us) y lecturas del relé cada tantos pasos (1 ms). */
+static const uint32_t PASO_US = 100;
+static const uint32_t PASOS_LECTURA = 10;
+
+/**
+ @brief Corre el relé sobre la planta hasta que la sintonía termina (o 10 s).
+ @param ruido Amplitud del ruido de la lectura (unidades de posición), alternado en cada lectura.
+ */
+static void cerrarLazo(float ruido) {
+    float x[3] = { 0, 0, 0 };
+    float u = 0;
+    uint32_t t = 0;
+    iniciarSintonia();
+    for (uint32_t k = 0; k < 100000 && resultadoSintonia().fase == SINTONIA_MIDIENDO; k++) {
+        if (k % PASOS_LECTURA == 0) {
+            float medido = x[2] + ((k / PASOS_LECTURA) % 2 ? ruido : -ruido);
+            // La salida del relé empuja hacia el centro: la planta la ve con el signo cambiado
+            u = -releSintonia((uint16_t)(setpoint + medido), t);
+        }
+        float dt = PASO_US * 1e-6f;
+        x[0] += (K_PLANTA * u - x[0]) * dt / TAU_PLANTA;
+        x[1] += (x[0] - x[1]) * dt / TAU_PLANTA;
+        x[2] += (x[1] - x[2]) * dt / TAU_PLANTA;
+        t += PASO_US;
+    }
+}
+
+/** @brief Ku y Tu de la planta sintética contra los exactos. */
+static void probarPlanta() {
+    const float kuExacto = 8 / K_PLANTA;
+    const float tuExacto = 2 * (float)M_PI * TAU_PLANTA / std::sqrt(3.0f);
+
+    // Con poca histéresis el ciclo queda en el punto último
+    const uint16_t histeresis = histeresisRele;
+    histeresisRele = 5;
+    cerrarLazo(0);
+    const ResultadoSintonia& r = resultadoSintonia();
+    std::printf("planta 150/(0.05s+1)^3, histeresis 5: a %.0f, Ku %.4f (exacto %.4f), Tu %.4f s (exacto %.4f), %u ciclos\n",
+                r.amplitud, r.Ku, kuExacto, r.Tu, tuExacto, r.ciclos);
+    verificar(r.fase == SINTONIA_LISTA, "la sintonia termina");
+    verificar(relativa(r.Ku, kuExacto) < 0.1f && relativa(r.Tu, tuExacto) < 0.1f, "Ku y Tu a menos de 10% de los exactos");
+    verificar(r.Kp == 0.6f * r.Ku && r.Ki == 2 * r.Kp / r.Tu && r.Kd == r.Kp * r.Tu / 8, "ganancias de Ziegler-Nichols");
+
+    // Con la histéresis por defecto el relé se atrasa: Ku menor y Tu mayor, del lado seguro
+    histeresisRele = histeresis;
+    cerrarLazo(0);
+    float kuSinRuido = r.Ku;
+    std::printf("histeresis %u: Ku %.4f, Tu %.4f s\n", histeresisRele, r.Ku, r.Tu);
+    verificar(r.Ku < kuExacto && r.Tu > tuExacto, "histeresis: Ku menor y Tu mayor que los exactos");
+    cerrarLazo(histeresisRele * 0.75f);
+    std::printf("histeresis %u, ruido de +-%.0f: Ku %.4f, Tu %.4f s\n", histeresisRele, histeresisRele * 0.75f, r.Ku, r.Tu);
+    verificar(r.fase == SINTONIA_LISTA && relativa(r.Ku, kuSinRuido) < 0.1f, "ruido bajo la histeresis: el mismo ciclo");
+
+    // Ruido sin planta: el relé no conmuta
+    iniciarSintonia();
+    float primera = releSintonia(setpoint + 5, 0);
+    bool quieto = true;
+    for (uint32_t k = 1; k < 200; k++) {
+        uint16_t pos = (uint16_t)(setpoint + (k % 2 ? -1 : 1) * (int32_t)(histeresisRele - 1));
+        if (releSintonia(pos, k * 1000) != primera) quieto = false;
+    }
+    verificar(quieto && primera == amplitudRele, "ruido bajo la histeresis: el rele no conmuta");
+
+    // Sin oscilación: falla por tiempo
+    iniciarSintonia();
+    uint32_t t = 0;
+    while (resultadoSintonia().fase == SINTONIA_MIDIENDO && t < 2 * SINTONIA_TIEMPO_MAX_US) {
+        releSintonia(setpoint + 500, t);
+        t += 1000;
+    }
+    verificar(resultadoSintonia().fase == SINTONIA_FALLIDA && t > SINTONIA_TIEMPO_MAX_US, "sin ciclo: falla a los SINTONIA_TIEMPO_MAX_US");
+}
+
+// ============================
+// SIMULADOR
+// ============================
+/** @brief Observador: ticks en SINTONIA. */
+static void contarSintonia(uint32_t, int estado, void* contexto) {
+    if (estado == T) (*(uint32_t*)contexto)++;
+}
+
+/** @brief Mejor vuelta de una carrera. */
+static float mejorVuelta(const ResultadoCarrera& r) {
+    float mejor = 0;
+    for (uint8_t v = 0; v < r.vueltas; v++) {
+        if (v == 0 || r.tiempoVuelta[v] < mejor) mejor = r.tiempoVuelta[v];
+    }
+    return mejor;
+}
+
+/** @brief 'U' por serial: sin `SINTONIA_APLICAR` pide una sintonía que solo informa. */
+static void probarComando() {
+    comandoSintonia('u');
+    bool informa = SINTONIA && !sintoniaAplica();
+    SINTONIA = false;
+    comandoSintonia('U');
+#ifdef SINTONIA_APLICAR
+    bool mayuscula = SINTONIA && sintoniaAplica();
+#else
+    bool mayuscula = SINTONIA && !sintoniaAplica();
+#endif
+    SINTONIA = false;
+    verificar(informa && mayuscula, "'U' aplica solo con SINTONIA_APLICAR");
+}
+
+int main() {
+    probarPlanta();
+    probarComando();
+
+    Pista pistas[2] = { Pista::competencia(), Pista::ovalo() };
+    std::printf("\nSintonia en la largada y mejor vuelta (competencia, ovalo) con las ganancias del perfil y las medidas\n");
+    std::printf("(las medidas se aplican solo con SINTONIA_APLICAR: se informan, no se exige que no atrasen)\n");
+    bool informa = true, aplica = true;
+    for (uint8_t p = 0; p < cantPerfiles; p++) {
+        const PerfilCorredor& perfil = perfilesCorredor[p];
+
+        // Solo informa: se detiene al terminar y quedan las ganancias del perfil
+        aplicarPerfil(perfil);
+        float kpPerfil = Kp;
+        uint32_t ticks = 0;
+        Simulador sim(pistas[0]);
+        sim.observar(contarSintonia, &ticks);
+        pedirSintonia(false);
+        sim.correr(1, 3);
+        const ResultadoSintonia& r = resultadoSintonia();
+        if (r.fase != SINTONIA_LISTA || SINTONIA || RUN || estadoFSM() != S || Kp != kpPerfil) informa = false;
+        std::printf("%-10s a %4.0f  Ku %.4f Tu %.3f s (perfil %.4f %.3f s) en %.2f s\n", perfil.nombre, r.amplitud,
+                    r.Ku, r.Tu, perfil.Ku, perfil.Tu, ticks * TIEMPO_TIMER * 1e-6f);
+
+        for (uint8_t k = 0; k < 2; k++) {
+            aplicarPerfil(perfil);
+            Simulador base(pistas[k]);
+            ResultadoCarrera rp = base.correr(3, 60);
+
+            aplicarPerfil(perfil);
+            Simulador medida(pistas[k]);
+            pedirSintonia(true);
+            ResultadoCarrera rs = medida.correr(3, 60);
+            if (resultadoSintonia().fase != SINTONIA_LISTA || Kp != resultadoSintonia().Kp || rs.vueltas < 3 || rs.fueraDePista) aplica = false;
+            std::printf("    %-12s perfil %6.3f%s  sintonia %6.3f%s\n", k ? "ovalo" : "competencia",
+                        mejorVuelta(rp), rp.fueraDePista ? "!" : " ", mejorVuelta(rs), rs.fueraDePista ? "!" : " ");
+        }
+    }
+    std::printf("(! = salio de la pista)\n");
+    verificar(informa, "simulador: informa y se detiene con las ganancias del perfil");
+    verificar(aplica, "simulador: pedida con aplicar, completa las vueltas");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+/**
+ @file prueba_telemetria.cpp
+ @brief Prueba en host (entorno `native_telemetria`, compilado con `-D TELEMETRIA`) del flujo binario del tick.
+ @details
+ - Ida y vuelta: las tramas publicadas se decodifican iguales aunque el flujo tenga texto intercalado
+   y una trama corrupta (que se descarta sin perder la sincronía).
+ - Anillo lleno: sin consumidor se aceptan `TELEMETRIA_TRAMAS` tramas y el resto se cuenta como descartado.
+ - Costo: tiempo por trama de `publicarTelemetria()` contra formatear con `snprintf` los mismos valores
+   que imprimían los `deb()` del tick (sin contar la transmisión serial, que en el ESP32 era lo más caro).
+ - Carrera simulada: vaciando el anillo en cada tick no se pierde ninguna trama y hay una por cada
+   ejecución de ACEL y CONTROL.
+ En host los tiempos son nanosegundos reales. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cstring>
+#include <vector>
+#include "hal.hpp"
+#include "config.hpp"
+#include "telemetria.hpp"
+#include "interrupciones.hpp"
+#include "fsm.hpp"
+#include "planificador.hpp"
+#include "simulador.hpp"
+#include "verificar.hpp"
+
+#ifndef TELEMETRIA
+  #error "prueba_telemetria.cpp requiere -D TELEMETRIA (entorno native_telemetria)"
+#endif
+
+/** @brief Flujo "serial" simulado y tramas decodificadas. */
+struct Captura {
+    std::vector<uint8_t> bytes;
+    std::vector<TramaTelemetria> tramas;
+};
+
+/** @brief Pasa al flujo todas las tramas pendientes del anillo. */
+static void vaciarEn(Captura& c) {
+    TramaTelemetria t;
+    while (tomarTelemetria(t)) {
+        const uint8_t* b = (const uint8_t*)&t;
+        c.bytes.insert(c.bytes.end(), b, b + sizeof(t));
+    }
+}
+
+static void guardarTrama(const TramaTelemetria& t, void* contexto) {
+    ((Captura*)contexto)->tramas.push_back(t);
+}
+
+static void observarTick(uint32_t, int, void* contexto) {
+    vaciarEn(*(Captura*)contexto);
+}
+
+/** @brief Cantidad de saltos en la secuencia de una lista de tramas. */
+static uint32_t saltos(const std::vector<TramaTelemetria>& tramas) {
+    uint32_t n = 0;
+    for (size_t i = 1; i < tramas.size(); i++) {
+        if ((uint8_t)(tramas[i].secuencia - tramas[i - 1].secuencia) != 1) n++;
+    }
+    return n;
+}
+
+int main() {
+    // Ida y vuelta con ruido en el flujo
+    reiniciarTelemetria();
+    Captura c;
+    const char* texto = "Calibrando sensores...\n";
+    for (int i = 0; i < 10; i++) {
+        publicarTelemetria(C, 3500 + 100 * i, -12.5f * i, 40 + i, 40 - i);
+        vaciarEn(c);
+        if (i == 3) c.bytes.insert(c.bytes.end(), texto, texto + std::strlen(texto));
+    }
+    c.bytes[5 * sizeof(TramaTelemetria) + std::strlen(texto) + 6] ^= 0x10;   // trama 5 corrupta
+
+    size_t consumidos = decodificarTelemetria(c.bytes.data(), c.bytes.size(), guardarTrama, &c);
+    std::printf("Ida y vuelta: %zu bytes, %zu tramas validas\n", c.bytes.size(), c.tramas.size());
+    verificar(c.tramas.size() == 9 && consumidos == c.bytes.size(), "texto intercalado y trama corrupta descartados");
+    verificar(c.tramas[4].secuencia == 4 && c.tramas[5].secuencia == 6, "la secuencia muestra la trama perdida");
+    verificar(c.tramas[9 - 1].posicion == 4400 && c.tramas[9 - 1].correccion == -112.5f &&
+              c.tramas[9 - 1].motorIzq == 49 && c.tramas[9 - 1].motorDer == 31 && c.tramas[9 - 1].estado == C,
+              "campos decodificados iguales a los publicados");
+
+    // Anillo lleno sin consumidor
+    reiniciarTelemetria();
+    for (int i = 0; i < 100; i++) publicarTelemetria(C, 0, 0, 0, 0);
+    verificar(tramasDescartadas() == 100 - TELEMETRIA_TRAMAS, "anillo lleno: descarta y cuenta");
+
+    // Costo por trama contra los printf de depuración
+    const uint32_t N = 1000000;
+    TramaTelemetria t;
+    volatile float correccion = 3.25f;
+    reiniciarTelemetria();
+    uint32_t inicio = halCiclos();
+    for (uint32_t i = 0; i < N; i++) {
+        publicarTelemetria(C, (uint16_t)(i & 0x1FFF), correccion, 60, 40);
+        if ((i & 31) == 31) while (tomarTelemetria(t)) {}
+    }
+    float porTrama = (float)(halCiclos() - inicio) / N;
+
+    char linea[128];
+    volatile int largo = 0;
+    inicio = halCiclos();
+    for (uint32_t i = 0; i < N; i++) {
+        largo += std::snprintf(linea, sizeof(linea), "Posicion=%d\ndeltaTime=%.3f\nPID=%.6f\nMotorIzq=%d\nMotorDer=%d\n",
+                               (int)(i & 0x1FFF), FIXED_DT_S, correccion, 60, 40);
+    }
+    float porTexto = (float)(halCiclos() - inicio) / N;
+    std::printf("\nCosto en el tick: trama %.1f ns (16 bytes), texto %.1f ns (%d bytes por tick)\n",
+                porTrama, porTexto, largo / (int)N);
+    verificar(tramasDescartadas() == 0, "sin descartes vaciando cada 32 tramas");
+
+    // Carrera simulada vaciando en cada tick
+    Pista pista = Pista::competencia();
+    Simulador sim(pista);
+    Captura carrera;
+    reiniciarTelemetria();
+    sim.observar(observarTick, &carrera);
+    ResultadoCarrera r = sim.correr(2, 60);
+    vaciarEn(carrera);
+    decodificarTelemetria(carrera.bytes.data(), carrera.bytes.size(), guardarTrama, &carrera);
+
+    uint32_t esperadas = estadisticasTarea(A).ejecuciones + estadisticasTarea(C).ejecuciones;
+    std::printf("\nCarrera: %u vueltas, %zu tramas (%zu bytes, %.0f bytes/s)\n", r.vueltas, carrera.tramas.size(),
+                carrera.bytes.size(), carrera.bytes.size() / r.tiempoSimulado);
+    verificar(carrera.tramas.size() == esperadas, "una trama por ejecucion de ACEL y CONTROL");
+    verificar(saltos(carrera.tramas) == 0 && tramasDescartadas() == 0, "sin tramas perdidas");
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+/**
+ @file prueba_trazas.cpp
+ @brief Prueba en host (entorno `native_trazas`, compilado con `-D TRAZAS`) de los histogramas del tick.
+ @details Primero verifica los histogramas con datos conocidos: mínimo y máximo exactos y percentiles
+ con error relativo menor a 12.5% (una cubeta). Después corre una carrera en el simulador y vuelca los
+ histogramas de cada etapa del tick. En host la demora y el periodo salen del reloj virtual y las
+ etapas de nanosegundos reales, por lo que solo los valores del ESP32 sirven para dimensionar
+ `TIEMPO_TIMER`. Devuelve 1 si alguna verificación falla.
+ @author Legion de Ohm
+ */
+
+#include <cmath>
+#include "hal.hpp"
+#include "config.hpp"
+#include "trazas.hpp"
+#include "interrupciones.hpp"
+#include "simulador.hpp"
+
+#ifndef TRAZAS
+  #error "prueba_trazas.cpp requiere -D TRAZAS (entorno native_trazas)"
+#endif
+
+/** @brief Errores encontrados. */
+static uint32_t errores = 0;
+
+/** @brief Verifica que un percentil esté dentro de una cubeta del valor exacto. */
+static void verificarPercentil(const Histograma& h, float p, uint32_t exacto) {
+    uint32_t v = percentilHistograma(h, p);
+    bool ok = v >= exacto && v <= exacto + exacto / 8 + 1;
+    std::printf("  p%-4.1f exacto=%7u histograma=%7u  %s\n", p * 100, exacto, v, ok ? "OK" : "FALLA");
+    if (!ok) errores++;
+}
+
+int main() {
+    // Valores 1..100000: percentiles conocidos
+    static Histograma h;
+    for (uint32_t v = 1; v <= 100000; v++) registrarHistograma(h, v);
+
+    std::printf("Histograma 1..100000\n");
+    if (h.minimo != 1 || h.maximo != 100000 || h.cantidad != 100000) errores++;
+    verificarPercentil(h, 0.50f, 50000);
+    verificarPercentil(h, 0.99f, 99000);
+    verificarPercentil(h, 0.999f, 99900);
+
+    // Valores chicos: cubetas exactas
+    static Histograma chico;
+    for (uint32_t v = 0; v < 8; v++) registrarHistograma(chico, v);
+    if (percentilHistograma(chico, 0.5f) != 3) errores++;
+
+    // Carrera completa con las trazas del firmware real
+    Pista pista = Pista::competencia();
+    Simulador sim(pista);
+    reiniciarTrazas();
+    ResultadoCarrera r = sim.correr(2, 60);
+    std::printf("\nCarrera: %u vueltas, %u ticks (TIEMPO_TIMER=%d us)\n", r.vueltas, r.ticks, (int)TIEMPO_TIMER);
+    imprimirTrazas();
+
+    const Histograma& tick = histogramaTraza(TRAZA_TICK);
+    const Histograma& periodo = histogramaTraza(TRAZA_PERIODO);
+    if (tick.cantidad == 0 || histogramaTraza(TRAZA_PID).cantidad != tick.cantidad) errores++;
+    if (periodo.minimo != (uint32_t)TIEMPO_TIMER * halCiclosPorUs()) errores++;
+
+    std::printf("%s\n", errores ? "FALLA" : "OK");
+    return errores ? 1 : 0;
+}
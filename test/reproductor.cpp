@@ -0,0 +1,335 @@
+/**
+ @file reproductor.cpp
+ @brief Reproductor determinista de registros de la caja negra (entorno `native_reproductor`).
+ @details Toma el CSV que vuelca la caja negra ('c' por serial en STOP) y pasa cada cuadro crudo, tick por
+ tick, por el firmware real: `leerLinea()` con la calibración del registro, la FSM, `calculo_pid()` (o
+ `calculo_pid_fijo()`), `actualizarSP()`, `controlMotores()` y `moverMotores()`. La caja negra del propio
+ reproductor guarda lo que produjo el firmware y se compara campo por campo con el registro: estado,
+ posición, términos P/I/D (Q4), SETPOINT y motores. Así un cambio de código se valida contra datos reales
+ de pista (debe dar 0 diferencias) y un cambio de ganancias se compara A/B.
+
+ El registro puede empezar a mitad de carrera (la caja es circular): la reproducción arranca en el primer
+ ACEL, donde el PID se reinicia, con la rampa y los motores tomados del propio registro. Con `FILTRO_MEDIANA`
+ o `FILTRO_IIR` los cuadros anteriores rearman el historial de la cadena de filtros. Con `MAPA_PISTA` el mapa
+ aprendido no está en la caja: la autoprueba y la reproducción corren sin él (se olvida en cada tick), y un
+ registro de pista con el mapa listo difiere donde la velocidad planificada limitó los motores. Con
+ `PID_BANDAS` las ganancias de `-k` quedan en todas las bandas (`aplanarBandas()`).
+
+ Uso:
+ ```
+ program registro.csv [-k Kp,Ki,Kd] [-r repeticiones] [-o reproducido.csv]
+ program              # autoprueba: registra una vuelta simulada y la reproduce
+ ```
+ `-r` repite la reproducción para medir el camino de control (ticks por segundo). Sin `-k` devuelve 1 si
+ hay alguna diferencia.
+ @author Legion de Ohm
+ */
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "hal.hpp"
+#include "config.hpp"
+#include "caja_negra.hpp"
+#include "interrupciones.hpp"
+#include "sensores.hpp"
+#include "filtros.hpp"
+#include "motores.hpp"
+#include "pid.hpp"
+#include "fsm.hpp"
+#include "mapa.hpp"
+#include "simulador.hpp"
+
+#ifndef CAJA_NEGRA
+  #error "reproductor.cpp requiere -D CAJA_NEGRA (entorno native_reproductor)"
+#endif
+#if defined(ADC_CONTINUO) || defined(DOBLE_NUCLEO)
+  #error "El reproductor entrega cada cuadro por la lectura directa: compilar sin ADC_CONTINUO ni DOBLE_NUCLEO"
+#endif
+
+/**
+ @struct Registro
+ @brief Contenido de un CSV de la caja negra.
+ */
+struct Registro {
+    CalibracionSensores cal;
+    std::vector<RegistroCaja> ticks;
+};
+
+/**
+ @struct Comparacion
+ @brief Resultado de una reproducción.
+ */
+struct Comparacion {
+    uint32_t ticks = 0;         ///< Ticks reproducidos.
+    uint32_t distintos = 0;     ///< Ticks con algún campo distinto.
+    uint32_t motores = 0;       ///< Ticks con algún motor distinto.
+    int64_t primero = -1;       ///< Índice del primer tick distinto.
+};
+
+// ============================
+// LECTURA DEL CSV
+// ============================
+/** @brief Interpreta una línea del volcado; devuelve false si no es de datos ni de calibración. */
+static bool leerLinea(const char* linea, Registro& r) {
+    unsigned v[19];
+    char estado;
+
+    if (linea[0] == '#') {
+        char nombre[16];
+        if (std::sscanf(linea, "# %15[^,],%u,%u,%u,%u,%u,%u,%u,%u", nombre,
+                        &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) != 9) return false;
+        uint16_t* destino = std::strcmp(nombre, "calMinimo") == 0 ? r.cal.minimo : r.cal.maximo;
+        for (uint8_t s = 0; s < CANT_SENSORES; s++) destino[s] = v[s];
+        return true;
+    }
+
+    RegistroCaja t;
+    int sp, run, izq, der;
+    if (std::sscanf(linea, "%u,%u,%c,%d,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%f,%f,%f,%d,%d", &v[0], &v[1], &estado, &sp, &run,
+                    &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9], &v[10], &t.p, &t.i, &t.d, &izq, &der) != 19) {
+        return false;
+    }
+    for (uint8_t s = 0; s < CANT_SENSORES; s++) t.crudo[s] = v[2 + s];
+    t.dt_us = v[1];
+    t.posicion = v[10];
+    t.estado = estado == 'A' ? A : estado == 'C' ? C : estado == 'P' ? P : S;
+    t.setpoint = sp;
+    t.run = run;
+    t.motorIzq = izq;
+    t.motorDer = der;
+    r.ticks.push_back(t);
+    return true;
+}
+
+// ============================
+// REPRODUCCION
+// ============================
+/** @brief Pines de la barra en el orden del cuadro crudo (índice 0 = S8). */
+static const uint8_t pinesBarra[CANT_SENSORES] = {S8, S7, S6, S5, S4, S3, S2, S1};
+
+/** @brief Cuadro que ve el firmware en el tick actual. */
+static const RegistroCaja* tickActual = nullptr;
+
+/** @brief Fuente analógica: cada conversión devuelve la lectura registrada del sensor. */
+static uint16_t fuente(uint8_t pin) {
+    for (uint8_t s = 0; s < CANT_SENSORES; s++) {
+        if (pinesBarra[s] == pin) return tickActual->crudo[s];
+    }
+    return 0;
+}
+
+/** @brief Ganancias a usar (-k); negativas = las del perfil compilado. */
+static float gananciasAB[3] = { -1, -1, -1 };
+
+/** @brief true si dos ticks coinciden en todo lo que produce el firmware. */
+static bool iguales(const RegistroCaja& a, const RegistroCaja& b) {
+    return a.estado == b.estado && a.posicion == b.posicion && a.setpoint == b.setpoint &&
+           a.p == b.p && a.i == b.i && a.d == b.d && a.motorIzq == b.motorIzq && a.motorDer == b.motorDer;
+}
+
+/** @brief Imprime un tick del registro y el reproducido. */
+static void mostrar(uint32_t j, const RegistroCaja& a, const RegistroCaja& b) {
+    std::printf("  tick %5u  registro:    %c SP=%d pos=%4u P=%9.4f I=%8.4f D=%9.4f izq=%4d der=%4d\n", j,
+                "SACP"[a.estado & 3], a.setpoint, a.posicion, a.p, a.i, a.d, a.motorIzq, a.motorDer);
+    std::printf("              reproducido: %c SP=%d pos=%4u P=%9.4f I=%8.4f D=%9.4f izq=%4d der=%4d\n",
+                "SACP"[b.estado & 3], b.setpoint, b.posicion, b.p, b.i, b.d, b.motorIzq, b.motorDer);
+}
+
+/**
+ @brief Pasa el registro por el firmware y compara tick por tick.
+ @param mostrarDistintos Cantidad de diferencias a imprimir.
+ */
+static Comparacion reproducir(const Registro& r, uint32_t mostrarDistintos) {
+    Comparacion c;
+
+    // El PID se reinicia en ACEL: es el primer tick con estado conocido. Los motores que
+    // controlMotores() conserva dentro del setpoint salen del último CONTROL anterior.
+    size_t inicio = r.ticks.size();
+    int32_t izq = 0, der = 0;
+    bool vioControl = false;
+    for (size_t j = 0; j < r.ticks.size() && inicio == r.ticks.size(); j++) {
+        if (r.ticks[j].estado == C) { izq = r.ticks[j].motorIzq; der = r.ticks[j].motorDer; vioControl = true; }
+        else if (r.ticks[j].estado == A && vioControl) inicio = j;
+    }
+
+    // Sin CONTROL previo (registro desde el RUN): primer ACEL con los motores en 0
+    for (size_t j = 0; j < r.ticks.size() && !vioControl; j++) {
+        if (r.ticks[j].estado == A) { inicio = j; break; }
+    }
+    if (inicio == r.ticks.size()) return c;
+
+    // Firmware recién arrancado, con la calibración del registro y sin leer la barra
+    halHostReiniciar();
+    reiniciarFSM();
+    reiniciar_pid();
+    reiniciarSensores();
+    setupMotores();
+    iniciarMuestreo();
+    fijarCalibracion(r.cal);
+    halHostFuenteAnalogica(fuente);
+
+    // Con FILTRO_MEDIANA o FILTRO_IIR la caja guarda los cuadros sin filtrar: los anteriores al primer ACEL
+    // reconstruyen el historial de la cadena (exacto si el registro empieza en el RUN, que la reinicia)
+    for (size_t j = 0; FILTRO_ACTIVO && j < inicio; j++) {
+        uint16_t crudo[CANT_SENSORES];
+        for (uint8_t s = 0; s < CANT_SENSORES; s++) crudo[s] = r.ticks[j].crudo[s];
+        filtrarCuadro(crudo);
+    }
+
+    if (gananciasAB[0] >= 0) {
+        Kp = gananciasAB[0];
+        Ki = gananciasAB[1];
+        Kd = gananciasAB[2];
+        plegarGanancias();
+        aplanarBandas();      // Con PID_BANDAS, las mismas a cualquier velocidad
+    }
+
+    int32_t rampa = r.ticks[inicio].motorIzq;
+    fijarRampaAcel(rampa < maxSpeed ? rampa - 1 : rampa);
+    motorSpeedIzq = izq;
+    motorSpeedDer = der;
+    RUN = true;
+    SETPOINT = true;
+    LINEA_PERDIDA = false;
+    rearmarCajaNegra();
+
+    for (size_t j = inicio; j < r.ticks.size(); j++) {
+        tickActual = &r.ticks[j];
+        RUN = tickActual->run;
+        // Reloj del registro: el observador (-D OBSERVADOR) usa el tiempo entre cuadros
+        halHostAvanzar(tickActual->dt_us);
+        mapa(reiniciarMapa();)
+        transicionar(entradaFSM());
+
+        RegistroCaja producido = leerCajaNegra(registrosCajaNegra() - 1);
+        c.ticks++;
+        if (iguales(*tickActual, producido)) continue;
+
+        if (c.primero < 0) c.primero = j;
+        if (c.distintos < mostrarDistintos) mostrar(j, *tickActual, producido);
+        c.distintos++;
+        if (producido.motorIzq != tickActual->motorIzq || producido.motorDer != tickActual->motorDer) c.motores++;
+    }
+    return c;
+}
+
+// ============================
+// AUTOPRUEBA
+// ============================
+/** @brief Volcado en memoria. */
+static std::string volcado;
+
+static void aMemoria(const char* linea) {
+    volcado += linea;
+}
+
+#ifdef MAPA_PISTA
+/** @brief Observador del simulador que olvida el mapa en cada tick (la reproducción no lo tiene). */
+static void sinMapa(uint32_t, int, void*) {
+    reiniciarMapa();
+}
+#endif
+
+/** @brief Registra una vuelta simulada con la caja negra y la pasa por el formato CSV. */
+static Registro registrarVuelta() {
+    Pista pista = Pista::competencia();
+    Simulador sim(pista);
+    mapa(sim.observar(sinMapa, nullptr);)
+    ResultadoCarrera res = sim.correr(1, 60);
+    std::printf("Autoprueba: vuelta simulada de %.3f s, %u ticks en la caja\n", res.tiempoSimulado,
+                registrosCajaNegra());
+
+    volcado.clear();
+    volcarCajaNegra(aMemoria);
+
+    Registro r;
+    size_t desde = 0;
+    while (desde < volcado.size()) {
+        size_t fin = volcado.find('\n', desde);
+        leerLinea(volcado.substr(desde, fin - desde).c_str(), r);
+        desde = fin + 1;
+    }
+    return r;
+}
+
+// ============================
+// PROGRAMA
+// ============================
+/** @brief Archivo de salida de `-o`. */
+static FILE* salida = nullptr;
+
+static void aArchivo(const char* linea) {
+    std::fputs(linea, salida);
+}
+
+int main(int argc, char** argv) {
+    const char* archivo = nullptr;
+    const char* archivoSalida = nullptr;
+    uint32_t repeticiones = 1;
+
+    for (int a = 1; a < argc; a++) {
+        if (std::strcmp(argv[a], "-k") == 0 && a + 1 < argc) {
+            std::sscanf(argv[++a], "%f,%f,%f", &gananciasAB[0], &gananciasAB[1], &gananciasAB[2]);
+        } else if (std::strcmp(argv[a], "-r") == 0 && a + 1 < argc) {
+            repeticiones = std::strtoul(argv[++a], nullptr, 10);
+        } else if (std::strcmp(argv[a], "-o") == 0 && a + 1 < argc) {
+            archivoSalida = argv[++a];
+        } else {
+            archivo = argv[a];
+        }
+    }
+
+    Registro r;
+    bool autoprueba = !archivo;
+    if (autoprueba) {
+        r = registrarVuelta();
+        if (repeticiones == 1) repeticiones = 200;
+    } else {
+        FILE* f = std::fopen(archivo, "r");
+        if (!f) {
+            std::fprintf(stderr, "No se pudo abrir %s\n", archivo);
+            return 1;
+        }
+        char linea[256];
+        while (std::fgets(linea, sizeof(linea), f)) leerLinea(linea, r);
+        std::fclose(f);
+    }
+
+    // Reproducción y comparación
+    Comparacion c = reproducir(r, 5);
+    std::printf("Reproduccion: %zu ticks en el registro, %u reproducidos, %u distintos (%u en motores)",
+                r.ticks.size(), c.ticks, c.distintos, c.motores);
+    if (c.primero >= 0) std::printf(", primero en el tick %lld", (long long)c.primero);
+    std::printf("\n");
+
+    if (archivoSalida) {
+        salida = std::fopen(archivoSalida, "w");
+        if (salida) {
+            volcarCajaNegra(aArchivo);
+            std::fclose(salida);
+        }
+    }
+
+    // Rendimiento del camino de control
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t ticks = 0;
+    for (uint32_t k = 0; k < repeticiones; k++) ticks += reproducir(r, 0).ticks;
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("Rendimiento: %llu ticks en %.3f s = %.0f ticks/s (%.0f ns por tick, con caja negra)\n",
+                (unsigned long long)ticks, segundos, ticks / segundos, 1e9 * segundos / ticks);
+
+    // A/B en la autoprueba: otras ganancias deben cambiar los comandos
+    bool ok = c.ticks > 0 && (c.distintos == 0 || gananciasAB[0] >= 0);
+    if (autoprueba) {
+        gananciasAB[0] = Kp * 1.2f;
+        gananciasAB[1] = Ki;
+        gananciasAB[2] = Kd;
+        Comparacion ab = reproducir(r, 0);
+        std::printf("A/B con Kp x1.2: %u de %u ticks distintos (%u en motores)\n", ab.distintos, ab.ticks, ab.motores);
+        ok = ok && ab.motores > 0;
+        std::printf("%s\n", ok ? "OK" : "FALLA");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,338 @@
+/**
+ @file sintonizador.cpp
+ @brief Sintonizador automático en host: busca Kp, Ki, Kd, `baseSpeed` y `zonaMuerta` en el simulador de pista.
+ @details Reemplaza la búsqueda manual con `TEST_PID` en la pista. Parte de las ganancias de
+ Ziegler-Nichols de un perfil de `perfilesCorredor` y busca en dos fases:
+ 1. Grilla completa de `niveles`^5 candidatos (ganancias en escala logarítmica alrededor de ZN).
+ 2. Nelder-Mead desde los mejores candidatos de la grilla, una búsqueda por tarea.
+ Cada candidato corre el firmware real en las pistas de competencia y óvalo; el costo es la suma de
+ los tiempos de vuelta, con penalización si no completa las vueltas. Las evaluaciones se reparten en
+ todos los núcleos con `PoolHilos` (cada hilo tiene su propio estado de firmware, ver `HILO_LOCAL`).
+ El ganador se escribe como `perfil_sintonizado.hpp`, que pid.cpp incluye con `-D CORREDOR=SINTONIZADO`.
+
+ Uso: `program [perfil] [niveles] [salida] [hilos]`
+ - perfil: nombre del perfil de partida (por defecto el de CORREDOR o NIGHTFALL).
+ - niveles: puntos de la grilla por parámetro (por defecto 4).
+ - salida: cabecera a generar (por defecto `include/perfil_sintonizado.hpp`).
+ - hilos: hilos de trabajo (por defecto uno por núcleo).
+ @author Legion de Ohm
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "simulador.hpp"
+#include "pool_hilos.hpp"
+#include "config.hpp"
+#include "pid.hpp"
+
+/** @brief Parámetros buscados: Kp, Ki, Kd, baseSpeed y zonaMuerta. */
+static const uint8_t DIM = 5;
+
+/** @brief Vueltas por pista en cada evaluación. */
+static const uint8_t VUELTAS = 2;
+
+/** @brief Tiempo simulado máximo por pista [s]. */
+static const float TIEMPO_MAX = 25;
+
+/** @brief Búsquedas de Nelder-Mead lanzadas desde los mejores puntos de la grilla. */
+static const uint8_t REINICIOS = 8;
+
+/** @brief Iteraciones de cada búsqueda de Nelder-Mead. */
+static const uint16_t ITERACIONES_NM = 60;
+
+/**
+ @struct Rango
+ @brief Intervalo de un parámetro; con `logaritmico` el punto medio es la media geométrica.
+ */
+struct Rango {
+    float minimo;
+    float maximo;
+    bool logaritmico;
+};
+
+/**
+ @struct Candidato
+ @brief Punto del espacio de búsqueda (coordenadas normalizadas 0..1) y su evaluación.
+ */
+struct Candidato {
+    float u[DIM];               ///< Coordenadas normalizadas.
+    float Kp, Ki, Kd;           ///< Ganancias resultantes.
+    uint8_t baseSpeed;          ///< Velocidad crucero resultante.
+    uint16_t zonaMuerta;        ///< Zona muerta resultante.
+    float tiempo[2];            ///< Tiempo total en cada pista [s] (0 si no completó).
+    float costo;                ///< Costo a minimizar.
+};
+
+/** @brief Pistas de evaluación (solo lectura, compartidas por todos los hilos). */
+static const Pista pistas[2] = { Pista::competencia(), Pista::ovalo() };
+
+/** @brief Nombres de las pistas de evaluación. */
+static const char* nombresPista[2] = { "competencia", "ovalo" };
+
+/** @brief Rangos de búsqueda; las ganancias se escalan con las de ZN del perfil de partida. */
+static Rango rangos[DIM] = {
+    { 0.25f, 2.5f, true  },    // Kp (x KpZN)
+    { 0.05f, 3.0f, true  },    // Ki (x KiZN)
+    { 0.10f, 4.0f, true  },    // Kd (x KdZN)
+    { 40,    90,   false },    // baseSpeed
+    { 0,     300,  false },    // zonaMuerta
+};
+
+/** @brief Ganancias de Ziegler-Nichols del perfil de partida. */
+static float KpZN, KiZN, KdZN;
+
+/** @brief Evaluaciones realizadas (todas las fases, todos los hilos). */
+static std::atomic<uint32_t> evaluaciones{0};
+
+/** @brief Lleva una coordenada normalizada al valor del parámetro. */
+static float desnormalizar(uint8_t d, float u) {
+    u = constrain(u, 0.0f, 1.0f);
+    const Rango& r = rangos[d];
+    if (r.logaritmico) return r.minimo * std::pow(r.maximo / r.minimo, u);
+    return r.minimo + u * (r.maximo - r.minimo);
+}
+
+/** @brief Lleva el valor de un parámetro a su coordenada normalizada. */
+static float normalizar(uint8_t d, float valor) {
+    const Rango& r = rangos[d];
+    float u = r.logaritmico ? std::log(valor / r.minimo) / std::log(r.maximo / r.minimo)
+                            : (valor - r.minimo) / (r.maximo - r.minimo);
+    return constrain(u, 0.0f, 1.0f);
+}
+
+/**
+ @brief Corre el firmware con los parámetros del candidato en ambas pistas y calcula su costo.
+ @details Se ejecuta en cualquier hilo del pool: las variables del control son `HILO_LOCAL`.
+ El costo es la suma de los tiempos de vuelta; una pista sin completar cuesta el doble del tiempo
+ máximo más 20 s por vuelta faltante. RMS y pérdidas de línea solo desempatan.
+ */
+static void evaluar(Candidato& c) {
+    for (uint8_t d = 0; d < DIM; d++) c.u[d] = constrain(c.u[d], 0.0f, 1.0f);
+    c.Kp = KpZN * desnormalizar(0, c.u[0]);
+    c.Ki = KiZN * desnormalizar(1, c.u[1]);
+    c.Kd = KdZN * desnormalizar(2, c.u[2]);
+    c.baseSpeed = (uint8_t)std::lround(desnormalizar(3, c.u[3]));
+    c.zonaMuerta = (uint16_t)std::lround(desnormalizar(4, c.u[4]));
+    c.costo = 0;
+
+    for (uint8_t k = 0; k < 2; k++) {
+        Kp = c.Kp;
+        Ki = c.Ki;
+        Kd = c.Kd;
+        plegarGanancias();
+        aplanarBandas();      // Con PID_BANDAS, las mismas a cualquier velocidad
+        baseSpeed = c.baseSpeed;
+        zonaMuerta = c.zonaMuerta;
+
+        Simulador sim(pistas[k]);
+        ResultadoCarrera r = sim.correr(VUELTAS, TIEMPO_MAX);
+
+        if (r.vueltas == VUELTAS && !r.fueraDePista) {
+            c.tiempo[k] = 0;
+            for (uint8_t v = 0; v < VUELTAS; v++) c.tiempo[k] += r.tiempoVuelta[v];
+            c.costo += c.tiempo[k];
+        } else {
+            c.tiempo[k] = 0;
+            c.costo += 2 * TIEMPO_MAX + 20.0f * (VUELTAS - r.vueltas);
+        }
+        c.costo += 0.001f * r.rmsError + 0.2f * r.perdidasLinea;
+    }
+    evaluaciones.fetch_add(1);
+}
+
+/**
+ @brief Minimiza el costo con Nelder-Mead partiendo de @p inicio (se ejecuta dentro de una tarea).
+ @return Candidato El mejor vértice encontrado.
+ */
+static Candidato nelderMead(const Candidato& inicio) {
+    const float alfa = 1, gamma = 2, rho = 0.5f, sigma = 0.5f;
+    Candidato simplex[DIM + 1];
+
+    simplex[0] = inicio;
+    for (uint8_t i = 0; i < DIM; i++) {
+        simplex[i + 1] = inicio;
+        float& u = simplex[i + 1].u[i];
+        u += (u < 0.85f) ? 0.15f : -0.15f;
+        evaluar(simplex[i + 1]);
+    }
+
+    for (uint16_t it = 0; it < ITERACIONES_NM; it++) {
+        std::sort(simplex, simplex + DIM + 1,
+                  [](const Candidato& a, const Candidato& b) { return a.costo < b.costo; });
+
+        float centro[DIM] = {0};
+        for (uint8_t i = 0; i < DIM; i++) {
+            for (uint8_t d = 0; d < DIM; d++) centro[d] += simplex[i].u[d] / DIM;
+        }
+
+        Candidato& peor = simplex[DIM];
+        Candidato reflejado = peor;
+        for (uint8_t d = 0; d < DIM; d++) reflejado.u[d] = centro[d] + alfa * (centro[d] - peor.u[d]);
+        evaluar(reflejado);
+
+        if (reflejado.costo < simplex[0].costo) {
+            Candidato expandido = peor;
+            for (uint8_t d = 0; d < DIM; d++) expandido.u[d] = centro[d] + gamma * (reflejado.u[d] - centro[d]);
+            evaluar(expandido);
+            peor = (expandido.costo < reflejado.costo) ? expandido : reflejado;
+        } else if (reflejado.costo < simplex[DIM - 1].costo) {
+            peor = reflejado;
+        } else {
+            Candidato contraido = peor;
+            for (uint8_t d = 0; d < DIM; d++) contraido.u[d] = centro[d] + rho * (peor.u[d] - centro[d]);
+            evaluar(contraido);
+
+            if (contraido.costo < peor.costo) {
+                peor = contraido;
+            } else {
+                for (uint8_t i = 1; i <= DIM; i++) {
+                    for (uint8_t d = 0; d < DIM; d++) {
+                        simplex[i].u[d] = simplex[0].u[d] + sigma * (simplex[i].u[d] - simplex[0].u[d]);
+                    }
+                    evaluar(simplex[i]);
+                }
+            }
+        }
+    }
+
+    return *std::min_element(simplex, simplex + DIM + 1,
+                             [](const Candidato& a, const Candidato& b) { return a.costo < b.costo; });
+}
+
+/** @brief Muestra un candidato en una línea. */
+static void mostrar(const char* etiqueta, const Candidato& c) {
+    std::printf("%-10s Kp=%.5f Ki=%.5f Kd=%.6f base=%u zona=%u  %s=%.3f s  %s=%.3f s  costo=%.3f\n",
+                etiqueta, c.Kp, c.Ki, c.Kd, c.baseSpeed, c.zonaMuerta,
+                nombresPista[0], c.tiempo[0], nombresPista[1], c.tiempo[1], c.costo);
+}
+
+/**
+ @brief Escribe el perfil ganador como cabecera incluible por pid.cpp.
+ @return bool false si no se pudo abrir el archivo.
+ */
+static bool escribirCabecera(const char* ruta, const PerfilCorredor& base, const Candidato& c) {
+    FILE* f = std::fopen(ruta, "w");
+    if (!f) return false;
+
+    std::fprintf(f,
+        "/**\n"
+        " @file perfil_sintonizado.hpp\n"
+        " @brief Perfil de corredor generado por el sintonizador automático (test/sintonizador.cpp). No editar a mano.\n"
+        " @details Se usa compilando con `-D CORREDOR=SINTONIZADO`. Perfil de partida: %s.\n"
+        " Tiempo de %u vueltas en el simulador: %s %.3f s, %s %.3f s.\n"
+        " Regenerar con: pio run -e native_sintonizador && .pio/build/native_sintonizador/program %s\n"
+        " @author Legion de Ohm\n"
+        " */\n"
+        "\n"
+        "#pragma once\n"
+        "#include \"hal.hpp\"\n"
+        "\n",
+        base.nombre, VUELTAS, nombresPista[0], c.tiempo[0], nombresPista[1], c.tiempo[1], base.nombre);
+
+    char valor[32];
+    std::snprintf(valor, sizeof(valor), "%.7gf;", c.Kp);
+    std::fprintf(f, "constexpr float    SINTONIZADO_KP          = %-14s ///< Ganancia Proporcional.\n", valor);
+    std::snprintf(valor, sizeof(valor), "%.7gf;", c.Ki);
+    std::fprintf(f, "constexpr float    SINTONIZADO_KI          = %-14s ///< Ganancia Integral.\n", valor);
+    std::snprintf(valor, sizeof(valor), "%.7gf;", c.Kd);
+    std::fprintf(f, "constexpr float    SINTONIZADO_KD          = %-14s ///< Ganancia Derivativa.\n", valor);
+    std::snprintf(valor, sizeof(valor), "%u;", c.baseSpeed);
+    std::fprintf(f, "constexpr uint8_t  SINTONIZADO_BASE_SPEED  = %-14s ///< Velocidad crucero (0-100%%).\n", valor);
+    std::snprintf(valor, sizeof(valor), "%u;", c.zonaMuerta);
+    std::fprintf(f, "constexpr uint16_t SINTONIZADO_ZONA_MUERTA = %-14s ///< Zona muerta alrededor del setpoint.\n", valor);
+    std::snprintf(valor, sizeof(valor), "%.7gf;", base.Ku);
+    std::fprintf(f, "constexpr float    SINTONIZADO_KU          = %-14s ///< Ku del perfil de partida (para TEST_PID).\n", valor);
+    std::snprintf(valor, sizeof(valor), "%.7gf;", base.Tu);
+    std::fprintf(f, "constexpr float    SINTONIZADO_TU          = %-14s ///< Tu del perfil de partida.\n", valor);
+
+    std::fclose(f);
+    return true;
+}
+
+/** @brief Reloj monotónico usado para medir. */
+typedef std::chrono::steady_clock reloj;
+
+int main(int argc, char** argv) {
+    // Perfil de partida
+    const PerfilCorredor* base = &perfilesCorredor[(CORREDOR <= cantPerfiles) ? CORREDOR - 1 : 0];
+    if (argc > 1) {
+        base = nullptr;
+        for (uint8_t p = 0; p < cantPerfiles; p++) {
+            if (std::strcmp(argv[1], perfilesCorredor[p].nombre) == 0) base = &perfilesCorredor[p];
+        }
+        if (!base) {
+            std::printf("Perfil desconocido: %s\n", argv[1]);
+            return 1;
+        }
+    }
+    int niveles = (argc > 2) ? std::atoi(argv[2]) : 4;
+    const char* salida = (argc > 3) ? argv[3] : "include/perfil_sintonizado.hpp";
+    unsigned cantHilos = (argc > 4) ? (unsigned)std::atoi(argv[4]) : 0;
+    if (niveles < 2) niveles = 2;
+
+    KpZN = 0.6f * base->Ku;
+    KiZN = 2 * KpZN / base->Tu;
+    KdZN = KpZN * base->Tu / 8;
+
+    PoolHilos pool(cantHilos);
+    std::printf("Sintonizando desde %s con %u hilos (grilla %d^%u)\n", base->nombre, pool.hilos(), niveles, DIM);
+    reloj::time_point t0 = reloj::now();
+
+    // Referencia: el perfil tal como está en perfilesCorredor
+    Candidato referencia;
+    referencia.u[0] = normalizar(0, 1);
+    referencia.u[1] = normalizar(1, 1);
+    referencia.u[2] = normalizar(2, 1);
+    referencia.u[3] = normalizar(3, base->baseSpeed);
+    referencia.u[4] = normalizar(4, 50);
+    pool.encolar([&referencia] { evaluar(referencia); });
+
+    // Fase 1: grilla
+    size_t total = 1;
+    for (uint8_t d = 0; d < DIM; d++) total *= niveles;
+    std::vector<Candidato> grilla(total);
+
+    for (size_t i = 0; i < total; i++) {
+        size_t resto = i;
+        for (uint8_t d = 0; d < DIM; d++) {
+            grilla[i].u[d] = (float)(resto % niveles) / (niveles - 1);
+            resto /= niveles;
+        }
+        pool.encolar([&grilla, i] { evaluar(grilla[i]); });
+    }
+    pool.esperar();
+
+    double tGrilla = std::chrono::duration<double>(reloj::now() - t0).count();
+    std::sort(grilla.begin(), grilla.end(),
+              [](const Candidato& a, const Candidato& b) { return a.costo < b.costo; });
+    std::printf("Grilla: %zu candidatos en %.2f s\n", total, tGrilla);
+    mostrar("referencia", referencia);
+    mostrar("grilla", grilla[0]);
+
+    // Fase 2: Nelder-Mead desde los mejores de la grilla
+    size_t reinicios = std::min<size_t>(REINICIOS, grilla.size());
+    std::vector<Candidato> refinados(reinicios);
+    for (size_t i = 0; i < reinicios; i++) {
+        pool.encolar([&grilla, &refinados, i] { refinados[i] = nelderMead(grilla[i]); });
+    }
+    pool.esperar();
+
+    Candidato mejor = *std::min_element(refinados.begin(), refinados.end(),
+                                        [](const Candidato& a, const Candidato& b) { return a.costo < b.costo; });
+    if (grilla[0].costo < mejor.costo) mejor = grilla[0];
+
+    double tTotal = std::chrono::duration<double>(reloj::now() - t0).count();
+    mostrar("ganador", mejor);
+    std::printf("%u evaluaciones en %.2f s (%.1f eval/s, %llu tareas robadas)\n",
+                evaluaciones.load(), tTotal, evaluaciones.load() / tTotal, (unsigned long long)pool.robos());
+
+    if (!escribirCabecera(salida, *base, mejor)) {
+        std::printf("No se pudo escribir %s\n", salida);
+        return 1;
+    }
+    std::printf("Perfil escrito en %s (compilar con -D CORREDOR=SINTONIZADO)\n", salida);
+    return 0;
+}
@@ -0,0 +1,19 @@
+/**
+ @file verificar.hpp
+ @brief Contador de errores y verificación que comparten los programas de prueba en host.
+ @details Cada programa incluye este archivo una sola vez y termina devolviendo 1 si `errores` no es 0.
+ @author Legion de Ohm
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+/** @brief Errores encontrados. */
+static uint32_t errores = 0;
+
+/** @brief Informa una verificación y cuenta la falla. */
+static void verificar(bool ok, const char* que) {
+    std::printf("  %-60s %s\n", que, ok ? "OK" : "FALLA");
+    if (!ok) errores++;
+}